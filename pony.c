@@ -1,1527 +1,7787 @@
-// Feb-2020
-//
-// PONY core source code
-
-#include <stdlib.h>
-#include <math.h>
-
-#include "pony.h"
-
-
-// core functions to be used in host application
-	// basic
-char pony_add_plugin(void(*newplugin)(void)	);	// add plugin to the plugin execution list,		input: pointer to plugin function,				output: OK/not OK (1/0)
-char pony_init      (char*					);	// initialize the bus, except for core,			input: configuration string (see description),	output: OK/not OK (1/0)
-char pony_step      (void					);	// step through the plugin execution list,														output: OK/not OK (1/0)
-char pony_terminate (void					);	// terminate operation,																			output: OK/not OK (1/0)
-	// advanced scheduling
-char pony_remove_plugin		(void(*   plugin)(void)							);	// remove all instances of the plugin from the plugin execution list,	input: pointer to plugin function,							output: OK/not OK (1/0)
-char pony_replace_plugin	(void(*oldplugin)(void), void(*newplugin)(void)	);	// replace all instances of the plugin by another one,					input: pointers to old and new plugin functions,			output: OK/not OK (1/0)
-char pony_schedule_plugin	(void(*newplugin)(void), int cycle, int shift	);	// add scheduled plugin to the plugin execution list,					input: pointer to plugin function, cycle, shift,			output: OK/not OK (1/0)
-char pony_reschedule_plugin	(void(*   plugin)(void), int cycle, int shift	);	// reschedule all instances of the plugin in the plugin execution list,	input: pointer to plugin function, new cycle, new shift,	output: OK/not OK (1/0)
-char pony_suspend_plugin	(void(*   plugin)(void)							);	// suspend all instances of the plugin in the plugin execution list,	input: pointer to plugin function,							output: OK/not OK (1/0)
-char pony_resume_plugin		(void(*   plugin)(void)							);	// resume all instances of the plugin in the plugin execution list,		input: pointer to plugin function,							output: OK/not OK (1/0)
-
-// bus instance
-pony_struct pony_bus = {
-	pony_bus_version,			// ver
-	pony_add_plugin,			// add_plugin
-	pony_init,					// init
-	pony_step,					// step
-	pony_terminate,				// terminate
-	pony_remove_plugin,			// remove_plugin
-	pony_replace_plugin,		// replace_plugin
-	pony_schedule_plugin,		// schedule_plugin
-	pony_reschedule_plugin,		// reschedule_plugin
-	pony_suspend_plugin,		// suspend plugin
-	pony_resume_plugin,			// resume plugin
-	{ NULL, 0, 0, -1, 0 } };		// core.plugins, core.plugin_count, core.exit_plugin_id, core.host_termination
-
-pony_struct *pony = &pony_bus;
-
-
-
-
-
-// service subroutines
-
-	// locate parameter group within a configuration string
-	// input:
-	// char* groupname	-	group identifier (see documentation)
-	//						or 
-	//						empty string to locate a substring that is outside of any group
-	// char* cfgstr	-	configuration string to parse
-	// int cfglen		-	number of characters in cfgstr to parse
-	//
-	// output:
-	// char** groupptr	-	reference to a pointer to the starting character of the group contents within a configuration string
-	// int* grouplen	-	reference to a number of characters in the group contents
-	//
-	// return value:		1 if the requested group found and grouplen > 0
-	//						0 otherwise
-	//
-	// working example:
-	// groupname = "gnss:"
-	// cfgstr = "{gnss: {gps: eph_in="gpsa.nav", obs_in="gpsa.obs"}}, out="sol.txt""
-	// cfglen = 66
-char pony_locatecfggroup(const char* groupname, char* cfgstr, const int cfglen, char** groupptr, int* grouplen)
-{
-	int i, j;
-	int group_layer;
-	char group_found = 0;
-
-	*groupptr = NULL;
-	*grouplen = 0;
-
-	if (cfgstr == NULL)
-		return 0;
-
-	// locate configuration substring that is outside of any group
-	if (groupname[0] == '\0') {
-		for (i = 0; i < cfglen && cfgstr[i]; i++) {
-			// skip all non-printable characters, blank spaces and commas between groups
-			for (; cfgstr[i] && (cfgstr[i] <= ' ' || cfgstr[i] == ',') && i < cfglen; i++); 
-			// if no group started at this point
-			if (cfgstr[i] != '{')
-				break;
-			// if a group started
-			else {
-				group_layer = 1;
-				while (group_layer > 0 && cfgstr[i] && i < cfglen) {
-					i++;
-					if (cfgstr[i] == '{')
-						group_layer++;
-					if (cfgstr[i] == '}')
-						group_layer--;
-				}
-			}
-		}
-
-		// skip all non-printable characters, blank spaces and commas between groups
-		for (; i < cfglen && cfgstr[i] && (cfgstr[i] <= ' ' || cfgstr[i] == ','); i++);
-		// start from this point
-		*groupptr = cfgstr + i;
-
-		// determine the length, counting until the end of the string or when a group started or ended
-		for (; (*groupptr)[*grouplen] && (*groupptr)[*grouplen] != '{' && (*groupptr)[*grouplen] != '}'; (*grouplen)++);
-	}
-
-	// locate configuration substring inside a requested group
-	else {
-		for (i = 0; i < cfglen && cfgstr[i] && !group_found; i++) {
-			// skip all non-printable characters, blank spaces and commas between groups
-			for (; cfgstr[i] && (cfgstr[i] <= ' ' || cfgstr[i] == ',') && i < cfglen; i++); 
-			// if a group started
-			if (cfgstr[i] == '{') {
-				group_layer = 1;
-				// skip all non-printable characters and blank spaces at the beginning of the group
-				for (i++; cfgstr[i] && (cfgstr[i] <= ' ') && i < cfglen; i++); 
-
-				// check if the group is the one that has been requested
-				group_found = 1;
-				for (j = 0; cfgstr[i] && groupname[j] && i < cfglen; i++, j++)
-					if (cfgstr[i] != groupname[j]) {
-						group_found = 0;
-						break;
-					}
-				// if did not reach the last character of groupname
-				if (groupname[j])
-					group_found = 0;
-
-				if (group_found)
-					// start from this point
-					*groupptr = cfgstr + i;
-
-				// go through the rest of the group
-				while (group_layer > 0 && cfgstr[i] && i < cfglen) {
-					if (cfgstr[i] == '{')
-						group_layer++;
-					if (cfgstr[i] == '}')
-						group_layer--;
-					i++;
-					// count if inside the requested group, except for the last symbol
-					if (group_found && group_layer > 0)
-						(*grouplen)++;
-				}
-			}
-		}
-	}
-
-	return (*groupptr == NULL) ? 0 : 1;
-}
-
-
-
-
-// initialize epoch
-void pony_init_epoch(pony_time_epoch *epoch)
-{
-	epoch->Y = 0;
-	epoch->M = 0;
-	epoch->D = 0;
-	epoch->h = 0;
-	epoch->m = 0;
-	epoch->s = 0;
-}
-
-
-
-
-// initialize solution
-void pony_init_solution(pony_sol *sol)
-{
-	int i;
-
-	// pos & vel
-	for (i = 0; i < 3; i++) {
-		sol->x[i]	= 0;
-		sol->llh[i]	= 0;
-		sol->v[i]	= 0;
-	}
-	sol->x_valid	= 0;
-	sol->llh_valid	= 0;
-	sol->v_valid	= 0;
-	// attitude
-	for (i = 0; i < 4; i++)
-		sol->q[i]	= 0; // quaternion
-	sol->q_valid	= 0;
-	for (i = 0; i < 9; i++)
-		sol->L[i]	= 0; // attitude matrix
-	sol->L_valid	= 0;
-	for (i = 0; i < 3; i++)
-		sol->rpy[i]	= 0; // attitude angles
-	sol->rpy_valid	= 0;
-	// clock
-	sol->dt			= 0;
-	sol->dt_valid	= 0;
-
-}
-
-
-
-
-// imu data handling subroutines
-	// initialize inertial navigation constants
-void pony_init_imu_const()
-{
-	pony->imu_const.pi		= 3.14159265358979323846264338327950288;	// pi with maximum quad-precision floating point digits as in IEEE 754-2008 (binary128)
-	pony->imu_const.rad2deg	= 180/pony->imu_const.pi;					// 180/pi
-	// Earth parameters as in Section 4 of GRS-80 by H. Moritz // Journal of Geodesy (2000) 74 (1): pp. 128162
-	pony->imu_const.u		= 7.292115e-5;			// Earth rotation rate, rad/s
-	pony->imu_const.a		= 6378137.0;			// Earth ellipsoid semi-major axis, m
-	pony->imu_const.e2		= 6.6943800229e-3;		// Earth ellipsoid first eccentricity squared
-	pony->imu_const.ge		= 9.7803267715;			// Earth normal gravity at the equator, m/s^2
-	pony->imu_const.fg		= 5.302440112e-3;		// Earth normal gravity flattening
-}
-
-	// initialize imu structure
-char pony_init_imu(pony_imu *imu)
-{
-	int i;
-
-	// validity flags
-	imu->w_valid = 0;
-	imu->f_valid = 0;
-	imu->W_valid = 0;
-	imu->t = 0;
-	for (i = 0; i < 3; i++) {
-		imu->w[i]	= 0;
-		imu->f[i]	= 0;
-		imu->W[i]	= 0;
-	}
-	// default gravity acceleration vector
-	imu->g[0] = 0;
-	imu->g[1] = 0;
-	imu->g[2] = -pony->imu_const.ge*(1 + pony->imu_const.fg/2); // middle value
-	// drop the solution
-	pony_init_solution( &(imu->sol) );
-
-	return 1;
-}
-
-	// free imu memory
-void pony_free_imu(void)
-{
-	if (pony->imu == NULL)
-		return;
-	free(pony->imu);
-	pony->imu = NULL;
-}
-
-
-
-
-// gnss data handling subroutines
-	// initialize gnss settings
-char pony_init_gnss_settings(pony_gnss *gnss)
-{
-	int i;
-
-	pony_locatecfggroup( "", gnss->cfg, gnss->cfglength, &(gnss->cfg_settings), &(gnss->settings_length) );
-
-	gnss->settings.sinEl_mask = 0;
-	gnss->settings.code_sigma = 20;
-	gnss->settings.phase_sigma = 0.01;
-	for (i = 0; i < 3; i++)
-		gnss->settings.ant_pos[i] = 0;
-	gnss->settings.ant_pos_tol = -1;
-	gnss->settings.leap_sec_def = 0;
-
-	return 1;
-}
-
-	// initialize gnss gps constants
-void pony_init_gnss_gps_const(pony_gps_const *gps_const)
-{
-	gps_const->mu	=  3.986005e14;			// Earth gravity constant as in IS-GPS-200J (22 May 2018), m^3/s^2
-	gps_const->u	=  7.2921151467e-5;		// Earth rotation rate as in IS-GPS-200J (22 May 2018), rad/s
-	gps_const->a	=  6378137.0;			// Earth ellipsoid semi-major axis as in WGS-84(G1762) 2014-07-08, m
-	gps_const->e2	=  6.694379990141e-3;	// Earth ellipsoid first eccentricity squared as in WGS-84(G1762) 2014-07-08
-	gps_const->F	= -4.442807633e-10;		// relativistic correction constant as in IS-GPS-200J (22 May 2018), s/sqrt(m)
-	gps_const->F1	=  1575.42e6;			// nominal frequency for L1 signal as in IS-GPS-200J (22 May 2018)
-	gps_const->L1	= pony->gnss_const.c/gps_const->F1;		// nominal wavelength for L1 signal
-	gps_const->F2	=  1227.60e6;			// nominal frequency for L2 signal as in IS-GPS-200J (22 May 2018)
-	gps_const->L2	= pony->gnss_const.c/gps_const->F2;		// nominal wavelength for L2 signal
-}
-
-	// initialize gnss gps structure
-char pony_init_gnss_gps(pony_gnss_gps *gps, const int max_sat_count, const int max_eph_count)
-{
-	int i;
-
-	gps->sat = NULL;
-	gps->max_sat_count = 0;
-	gps->max_eph_count = 0;
-
-	// try to allocate memory for satellite data
-	gps->sat = (pony_gnss_sat*)calloc( max_sat_count, sizeof(pony_gnss_sat) );
-	if (gps->sat == NULL)
-		return 0;
-	gps->max_sat_count = max_sat_count;
-
-	// initialize satellite data
-	for (i = 0; i < gps->max_sat_count; i++) {
-		gps->sat[i].eph			= NULL;
-		gps->sat[i].eph_valid	= 0;
-		gps->sat[i].obs			= NULL;
-		gps->sat[i].obs_valid	= NULL;
-		gps->sat[i].x_valid		= 0;
-		gps->sat[i].v_valid		= 0;
-		gps->sat[i].t_em_valid	= 0;
-		gps->sat[i].sinEl_valid	= 0;
-	}
-
-	// try to allocate memory for each satellite ephemeris
-	for (i = 0; i < gps->max_sat_count; i++) {
-		gps->sat[i].eph = (double *)calloc( max_eph_count, sizeof(double) );
-		if (gps->sat[i].eph == NULL)
-			return 0;
-	}
-	gps->max_eph_count = max_eph_count;
-
-	// observation types
-	gps->obs_types = NULL;
-	gps->obs_count = 0;
-
-	// validity flags
-	gps->iono_valid = 0;
-	gps->clock_corr_valid = 0;
-
-	return 1;
-}
-
-	// free gnss gps memory
-void pony_free_gnss_gps(pony_gnss_gps *gps)
-{
-	int i;
-
-	if (gps == NULL)
-		return;
-
-	// satellites
-	if (gps->sat != NULL) 
-	{
-		for (i = 0; i < gps->max_sat_count; i++) 
-			// ephemeris
-			if (gps->sat[i].eph != NULL)
-			{
-				free(gps->sat[i].eph);
-				gps->sat[i].eph = NULL;
-			}
-	
-		free(gps->sat);
-		gps->sat = NULL;
-	}
-
-	// gnss_gps structure
-	free(gps);
-}
-
-	// initialize gnss glonass constants
-void pony_init_gnss_glo_const(pony_glo_const *glo_const)
-{
-	glo_const->mu	= 398600.4418e9;	// Earth gravity constant as in PZ-90.11 (2014), m^3/s^2
-	glo_const->J02	= 1082.62575e-6;	// second degree zonal harmonic coefficient of normal potential as in PZ-90.11 (2014)
-	glo_const->u	= 7.292115e-5;		// Earth rotation rate as in PZ-90.11 (2014), rad/s
-	glo_const->a	= 6378136.0;		// Earth ellipsoid semi-major axis as in PZ-90.11 (2014), m
-	glo_const->e2	= 0.0066943662;		// Earth ellipsoid first eccentricity squared as in PZ-90.11 (2014)
-	glo_const->F01	= 1602e6;			// nominal centre frequency for L1 signal as in ICD GLONASS Edition 5.1 2008, Hz
-	glo_const->dF1	= 562.5e3;			// nominal channel separation for L1 signal as in ICD GLONASS Edition 5.1 2008, Hz
-	glo_const->F02	= 1246e6;			// nominal centre frequency for L2 signal as in ICD GLONASS Edition 5.1 2008, Hz
-	glo_const->dF2	= 437.5e3;			// nominal channel separation for L2 signal as in ICD GLONASS Edition 5.1 2008, Hz
-}
-
-	// initialize gnss glonass structure
-char pony_init_gnss_glo(pony_gnss_glo *glo, const int max_sat_count, const int max_eph_count)
-{
-	int i;
-
-	glo->sat = NULL;
-	glo->freq_slot = NULL;
-	glo->max_sat_count = 0;
-	glo->max_eph_count = 0;
-
-	// try to allocate memory for satellite data
-	glo->sat = (pony_gnss_sat *)calloc( max_sat_count, sizeof(pony_gnss_sat) );
-	if (glo->sat == NULL)
-		return 0;
-	glo->freq_slot = (int *)calloc( max_sat_count, sizeof(int) );
-	glo->max_sat_count = max_sat_count;
-
-	// initialize satellite data
-	for (i = 0; i < glo->max_sat_count; i++) {
-		glo->sat[i].eph			= NULL;
-		glo->sat[i].eph_valid	= 0;
-		glo->sat[i].obs			= NULL;
-		glo->sat[i].obs_valid	= NULL;
-		glo->sat[i].x_valid		= 0;
-		glo->sat[i].v_valid		= 0;
-		glo->sat[i].t_em_valid	= 0;
-		glo->sat[i].sinEl_valid	= 0;
-	}
-
-	// try to allocate memory for each satellite ephemeris
-	for (i = 0; i < glo->max_sat_count; i++) {
-		glo->sat[i].eph = (double *)calloc( max_eph_count, sizeof(double) );
-		if (glo->sat[i].eph == NULL)
-			return 0;
-	}
-	glo->max_eph_count = max_eph_count;
-
-	// observation types
-	glo->obs_types = NULL;
-	glo->obs_count = 0;
-
-	return 1;
-}
-
-	// free gnss glonass memory
-void pony_free_gnss_glo(pony_gnss_glo *glo)
-{
-	int i;
-
-	if (glo == NULL)
-		return;
-
-	// satellites
-	if (glo->sat != NULL) 
-	{
-		for (i = 0; i < glo->max_sat_count; i++) 
-			// ephemeris
-			if (glo->sat[i].eph != NULL)
-			{
-				free(glo->sat[i].eph);
-				glo->sat[i].eph = NULL;
-			}
-	
-		free(glo->sat);
-		glo->sat = NULL;
-	}
-	if (glo->freq_slot != NULL) {
-		free(glo->freq_slot);
-		glo->freq_slot = NULL;
-	}
-
-	// gnss glonass structure
-	free(glo);
-}
-
-	// initialize gnss galileo constants
-void pony_init_gnss_gal_const(pony_gal_const *gal_const)
-{
-	gal_const->mu	=  3.986004418e14;		// Earth gravity constant as in Galileo OS SIS ICD Issue 1.2 (November 2015), m^3/s^2
-	gal_const->u	=  7.2921151467e-5;		// Earth rotation rate as in Galileo OS SIS ICD Issue 1.2 (November 2015), rad/s
-	gal_const->a	=  6378137.0;			// Earth ellipsoid semi-major axis as in GRS-80 // JoG March 2000 vol. 74 issue 1, m
-	gal_const->e2	=  6.69438002290e-3;	// Earth ellipsoid first eccentricity squared as in GRS-80 // JoG March 2000 vol. 74 issue 1
-	gal_const->F	= -4.442807309e-10;		// relativistic correction constant as in Galileo OS SIS ICD Issue 1.2 (November 2015), s/sqrt(m)
-	gal_const->F1	=  1575.42e6;			// nominal frequency for E1 signal as in Galileo OS SIS ICD Issue 1.2 (November 2015)
-	gal_const->L1	= pony->gnss_const.c/gal_const->F1;		// nominal wavelength for E1 signal
-	gal_const->F5a	=  1176.45e6;			// nominal frequency for E5a signal as in Galileo OS SIS ICD Issue 1.2 (November 2015)
-	gal_const->L5a	= pony->gnss_const.c/gal_const->F5a;	// nominal wavelength for E5a signal
-	gal_const->F5b	=  1207.14e6;			// nominal frequency for E5b signal as in Galileo OS SIS ICD Issue 1.2 (November 2015)
-	gal_const->L5b	= pony->gnss_const.c/gal_const->F5b;	// nominal wavelength for E5b signal
-	gal_const->F6	=  1278.75e6;			// nominal frequency for E6 signal as in Galileo OS SIS ICD Issue 1.2 (November 2015)
-	gal_const->L6	= pony->gnss_const.c/gal_const->F6;		// nominal wavelength for E6 signal
-}
-
-	// initialize gnss galileo structure
-char pony_init_gnss_gal(pony_gnss_gal *gal, const int max_sat_count, const int max_eph_count)
-{
-	int i;
-
-	gal->sat = NULL;
-	gal->max_sat_count = 0;
-	gal->max_eph_count = 0;
-
-	// try to allocate memory for satellite data
-	gal->sat = (pony_gnss_sat*)calloc( max_sat_count, sizeof(pony_gnss_sat) );
-	if (gal->sat == NULL)
-		return 0;
-	gal->max_sat_count = max_sat_count;
-
-	// initialize satellite data
-	for (i = 0; i < gal->max_sat_count; i++) {
-		gal->sat[i].eph			= NULL;
-		gal->sat[i].eph_valid	= 0;
-		gal->sat[i].obs			= NULL;
-		gal->sat[i].obs_valid	= NULL;
-		gal->sat[i].x_valid		= 0;
-		gal->sat[i].v_valid		= 0;
-		gal->sat[i].t_em_valid	= 0;
-		gal->sat[i].sinEl_valid	= 0;
-	}
-
-	// try to allocate memory for each satellite ephemeris
-	for (i = 0; i < gal->max_sat_count; i++) {
-		gal->sat[i].eph = (double *)calloc( max_eph_count, sizeof(double) );
-		if (gal->sat[i].eph == NULL)
-			return 0;
-	}
-	gal->max_eph_count = max_eph_count;
-
-	// observation types
-	gal->obs_types = NULL;
-	gal->obs_count = 0;
-
-	// validity flags
-	gal->iono_valid = 0;
-	gal->clock_corr_valid = 0;
-
-	return 1;
-}
-
-	// free gnss galileo memory
-void pony_free_gnss_gal(pony_gnss_gal *gal)
-{
-	int i;
-
-	if (gal == NULL)
-		return;
-
-	// satellites
-	if (gal->sat != NULL) 
-	{
-		for (i = 0; i < gal->max_sat_count; i++)
-			//ephemeris
-			if (gal->sat[i].eph != NULL)
-			{
-				free(gal->sat[i].eph);
-				gal->sat[i].eph = NULL;
-			}
-	
-		free(gal->sat);
-		gal->sat = NULL;
-	}
-
-	// gnss galileo structure
-	free(gal);
-}
-
-	// initialize gnss beidou constants
-void pony_init_gnss_bds_const(pony_bds_const *bds_const)
-{
-	bds_const->mu			=  3.986004418e14;			// Earth gravity constant as in BeiDou SIS ICD OSS Version 2.1 (November 2016), m^3/s^2
-	bds_const->u			=  7.292115e-5;				// Earth rotation rate as in BeiDou SIS ICD OSS Version 2.1 (November 2016), rad/s
-	bds_const->a			=  6378137.0;				// Earth ellipsoid semi-major axis as in BeiDou SIS ICD OSS Version 2.1 (November 2016), m
-	bds_const->e2			=  6.6943800229008e-3;		// Earth ellipsoid first eccentricity squared derived from flattening as in BeiDou SIS ICD OSS Version 2.1 (November 2016)
-	bds_const->F			= -4.442807309043977e-10;	// relativistic correction constant derived from Earth gravity as in BeiDou SIS ICD OSS Version 2.1 (November 2016), s/sqrt(m)
-	bds_const->leap_sec		=  14;						// leap seconds between BeiDou time and GPS time as of 01-Jan-2006
-	bds_const->B1			=  1561.098e6;				// nominal frequency for B1 signal as in BeiDou SIS ICD OSS Version 2.1 (November 2016)
-	bds_const->L1			= pony->gnss_const.c/bds_const->B1;		// nominal wavelength for B1 signal
-	bds_const->B2			=  1207.140e6;				// nominal frequency for B2 signal as in BeiDou SIS ICD OSS Version 2.1 (November 2016)
-	bds_const->L2			= pony->gnss_const.c/bds_const->B2;		// nominal wavelength for B2 signal
-}
-
-	// initialize gnss beidou structure
-char pony_init_gnss_bds(pony_gnss_bds *bds, const int max_sat_count, const int max_eph_count)
-{
-	int i;
-
-	bds->sat = NULL;
-	bds->max_sat_count = 0;
-	bds->max_eph_count = 0;
-
-	// try to allocate memory for satellite data
-	bds->sat = (pony_gnss_sat*)calloc( max_sat_count, sizeof(pony_gnss_sat) );
-	if (bds->sat == NULL)
-		return 0;
-	bds->max_sat_count = max_sat_count;
-
-	// initialize satellite data
-	for (i = 0; i < bds->max_sat_count; i++) {
-		bds->sat[i].eph			= NULL;
-		bds->sat[i].eph_valid	= 0;
-		bds->sat[i].obs			= NULL;
-		bds->sat[i].obs_valid	= NULL;
-		bds->sat[i].x_valid		= 0;
-		bds->sat[i].v_valid		= 0;
-		bds->sat[i].t_em_valid	= 0;
-		bds->sat[i].sinEl_valid	= 0;
-	}
-
-	// try to allocate memory for each satellite ephemeris
-	for (i = 0; i < bds->max_sat_count; i++) {
-		bds->sat[i].eph = (double *)calloc( max_eph_count, sizeof(double) );
-		if (bds->sat[i].eph == NULL)
-			return 0;
-	}
-	bds->max_eph_count = max_eph_count;
-
-	// observation types
-	bds->obs_types = NULL;
-	bds->obs_count = 0;
-
-	// validity flags
-	bds->iono_valid = 0;
-	bds->clock_corr_valid = 0;
-
-	return 1;
-}
-
-	// free gnss beidou memory
-void pony_free_gnss_bds(pony_gnss_bds *bds)
-{
-	int i;
-
-	if (bds == NULL)
-		return;
-
-	// satellites
-	if (bds->sat != NULL) 
-	{
-		for (i = 0; i < bds->max_sat_count; i++)
-			//ephemeris
-			if (bds->sat[i].eph != NULL)
-			{
-				free(bds->sat[i].eph);
-				bds->sat[i].eph = NULL;
-			}
-	
-		free(bds->sat);
-		bds->sat = NULL;
-	}
-
-	// gnss beidou structure
-	free(bds);
-}
-
-	// initialize gnss constants
-void pony_init_gnss_const()
-{
-	pony->gnss_const.pi			= 3.1415926535898;		// pi, circumference to diameter ratio, as in as in IS-GPS-200J, Galileo OS SIS ICD Issue 1.2 (November 2015), BeiDou SIS ICD OSS Version 2.1 (November 2016)
-	pony->gnss_const.c			= 299792458;			// speed of light as in IS-GPS-200J (22 May 2018), ICD GLONASS Edition 5.1 2008, Galileo OS SIS ICD Issue 1.2 (November 2015), BeiDou SIS ICD OSS Version 2.1 (November 2016), m/s
-	pony->gnss_const.sec_in_w	= 604800;				// seconds in a week
-	pony->gnss_const.sec_in_d	= 86400;				// seconds in a day
-
-	// constellation-specific constants
-	pony_init_gnss_gps_const(&(pony->gnss_const.gps));
-	pony_init_gnss_glo_const(&(pony->gnss_const.glo));
-	pony_init_gnss_gal_const(&(pony->gnss_const.gal));
-	pony_init_gnss_bds_const(&(pony->gnss_const.bds));
-
-}
-
-	// initialize gnss structure
-char pony_init_gnss(pony_gnss *gnss)
-{
-	// memory allocation limitations
-	enum		system_id				{gps,	glo,	gal,	bds	};
-	const int	max_sat_count[] =		{36,	36,		36,		64	},
-				max_eph_count[] =		{36,	24,		36,		36	};
-
-	int grouplen;
-	char* groupptr;
-
-	if (gnss == NULL)
-		return 0;
-
-	// gps
-	gnss->gps = NULL;
-	if ( pony_locatecfggroup("gps:", gnss->cfg, gnss->cfglength, &groupptr, &grouplen) )
-	{
-		gnss->gps = (pony_gnss_gps*)calloc( 1, sizeof(pony_gnss_gps) );
-		if (gnss->gps == NULL)
-			return 0;
-		gnss->gps->cfg = groupptr;
-		gnss->gps->cfglength = grouplen;
-
-		if ( !pony_init_gnss_gps(gnss->gps, max_sat_count[gps], max_eph_count[gps]) )
-			return 0;
-	}
-
-	// glonass
-	gnss->glo = NULL;
-	if (pony_locatecfggroup( "glo:", gnss->cfg, gnss->cfglength, &groupptr, &grouplen) )
-	{
-		gnss->glo = (pony_gnss_glo*)calloc( 1, sizeof(pony_gnss_glo) );
-		if (gnss->glo == NULL)
-			return 0;
-		gnss->glo->cfg = groupptr;
-		gnss->glo->cfglength = grouplen;
-
-		if ( !pony_init_gnss_glo(gnss->glo, max_sat_count[glo], max_eph_count[glo]) )
-			return 0;
-	}
-
-	// galileo
-	gnss->gal = NULL;
-	if ( pony_locatecfggroup("gal:", gnss->cfg, gnss->cfglength, &groupptr, &grouplen) )
-	{
-		gnss->gal = (pony_gnss_gal*)calloc( 1, sizeof(pony_gnss_gal) );
-		if (gnss->gal == NULL)
-			return 0;
-		gnss->gal->cfg = groupptr;
-		gnss->gal->cfglength = grouplen;
-
-		if ( !pony_init_gnss_gal(gnss->gal, max_sat_count[gal], max_eph_count[gal]) )
-			return 0;
-	}
-
-	// beidou
-	gnss->bds = NULL;
-	if ( pony_locatecfggroup("bds:", gnss->cfg, gnss->cfglength, &groupptr, &grouplen) )
-	{
-		gnss->bds = (pony_gnss_bds*)calloc( 1, sizeof(pony_gnss_bds) );
-		if (gnss->bds == NULL)
-			return 0;
-		gnss->bds->cfg = groupptr;
-		gnss->bds->cfglength = grouplen;
-
-		if ( !pony_init_gnss_bds(gnss->bds, max_sat_count[bds], max_eph_count[bds]) )
-			return 0;
-	}
-
-	// gnss settings
-	pony_init_gnss_settings(gnss);
-
-	// gnss solution
-	pony_init_solution( &(gnss->sol) );
-
-	// gnss epoch
-	pony_init_epoch( &(gnss->epoch) );
-
-	gnss->leap_sec = 0;
-	gnss->leap_sec_valid = 0;
-
-	return 1;
-}
-
-	// free gnss memory
-void pony_free_gnss(pony_gnss *gnss)
-{
-	if (gnss == NULL)
-		return;
-
-	pony_free_gnss_gps(gnss->gps);
-	gnss->gps = NULL;
-
-	pony_free_gnss_glo(gnss->glo);
-	gnss->glo = NULL;
-
-	pony_free_gnss_glo(gnss->glo);
-	gnss->glo = NULL;
-}
-
-
-
-
-// general handling routines
-	// free all alocated memory and set pointers and counters to NULL
-void pony_free()
-{
-	int i;
-
-	// core
-	if (pony->core.plugins != NULL)
-		free(pony->core.plugins);
-	pony->core.plugins = NULL;
-	pony->core.plugin_count = 0;
-
-	// configuration string
-	if (pony->cfg != NULL)
-		free(pony->cfg);
-	pony->cfg = NULL;
-	pony->cfglength = 0;
-
-	// imu
-	pony_free_imu();
-
-	// gnss
-	if (pony->gnss != NULL)
-	{
-		for (i = 0; i < pony->gnss_count; i++)
-			pony_free_gnss( &(pony->gnss[i]) );
-		free(pony->gnss);
-		pony->gnss = NULL;
-	}
-	pony->gnss_count = 0;
-
-}
-
-
-
-
-
-
-
-
-
-
-
-///
-///     Core pony functions for host application
-///
-
-
-
-	// basic functions
-
-		// add plugin to the plugin execution list
-		//	input: 
-		//		newplugin - pointer to plugin function (no arguments, no return value)
-		//	output: 
-		//		1 - OK
-		//		0 - not OK (failed to allocate/realocate memory)
-char pony_add_plugin( void(*newplugin)(void) )
-{
-	pony_plugin *reallocated_pointer;
-
-	reallocated_pointer = (pony_plugin *)realloc( (void *)(pony->core.plugins), (pony->core.plugin_count + 1) * sizeof(pony_plugin) );
-
-	if (reallocated_pointer == NULL)	// failed to allocate/realocate memory
-	{
-		pony_free();
-		return 0;
-	}
-	else
-		pony->core.plugins = reallocated_pointer;
-
-	pony->core.plugins[pony->core.plugin_count].func  = newplugin;
-	pony->core.plugins[pony->core.plugin_count].cycle = 1;
-	pony->core.plugins[pony->core.plugin_count].shift = 0;
-	pony->core.plugins[pony->core.plugin_count].tick  = 0;
-	pony->core.plugin_count++;
-
-	return 1;
-}
-
-
-		// initialize the bus, except for core
-		//	input: 
-		//		cfg - configuration string (see pony description)
-		//	output: 
-		//		1 - OK
-		//		0 - not OK (memory allocation or partial init failed)
-char pony_init(char* cfg)
-{
-	const int max_gnss_count = 10;
-	
-	char multi_gnss_token[] = "gnss[0]:";
-	const int multi_gnss_index_position = 5;
-
-	int grouplen;
-	char* groupptr;
-
-	pony_gnss *reallocated_pointer;
-
-	int i;
-
-	// determine configuration string length
-	for (pony->cfglength = 0; cfg[pony->cfglength]; pony->cfglength++);
-
-	// assign configuration string
-	pony->cfg = (char *)malloc( sizeof(char) * (pony->cfglength + 1) );
-	if (pony->cfg == NULL)
-		return 0;
-	for (i = 0; i < pony->cfglength; i++)
-		pony->cfg[i] = cfg[i];
-	pony->cfg[pony->cfglength] = '\0';
-
-	// fetch a part of configuration that is outside of any group
-	pony->cfg_settings = NULL;
-	pony->settings_length = 0;
-	pony_locatecfggroup("", pony->cfg, pony->cfglength, &pony->cfg_settings, &pony->settings_length);
-	
-	// imu init
-	pony_init_imu_const();
-	pony->imu = NULL;
-	if ( pony_locatecfggroup("imu:", pony->cfg, pony->cfglength, &groupptr, &grouplen) ) // if the group found in configuration
-	{
-		// try to allocate memory
-		pony->imu = (pony_imu*)calloc( 1, sizeof(pony_imu) );
-		if (pony->imu == NULL) {
-			pony_free();
-			return 0;
-		}
-
-		// set configuration pointer
-		pony->imu->cfg = groupptr;
-		pony->imu->cfglength = grouplen;
-
-		// try to init
-		if ( !pony_init_imu(pony->imu) ) {
-			pony_free();
-			return 0;
-		}
-	}
-
-	// gnss init
-	pony_init_gnss_const();
-	pony->gnss = NULL;
-	pony->gnss_count = 0;
-		// multiple gnss mode support
-	for (i = 0; i < max_gnss_count; i++)
-	{
-		multi_gnss_token[multi_gnss_index_position] = '0' + (char)i;
-
-		if ( (i == 0 && pony_locatecfggroup("gnss:", pony->cfg, pony->cfglength, &groupptr, &grouplen) ) ||
-			pony_locatecfggroup(multi_gnss_token, pony->cfg, pony->cfglength, &groupptr, &grouplen) ) {
-			if (i >= pony->gnss_count) {
-				// try to allocate/reallocate memory
-				reallocated_pointer = (pony_gnss*)realloc(pony->gnss, sizeof(pony_gnss)*(i+1));
-				if (reallocated_pointer == NULL) {
-					pony_free();
-					return 0;
-				}
-				else
-					pony->gnss = reallocated_pointer;
-				// try to init new instances, except the i-th one
-				for ( ; pony->gnss_count < i; pony->gnss_count++) {
-					pony->gnss[pony->gnss_count].cfg = NULL;
-					pony->gnss[pony->gnss_count].cfglength = 0;
-					pony_init_gnss( &(pony->gnss[pony->gnss_count]) );
-				}
-				pony->gnss_count = i+1;
-			}
-
-			// set configuration pointer
-			pony->gnss[i].cfg = groupptr;
-			pony->gnss[i].cfglength = grouplen;
-
-			// try to init
-			if ( !pony_init_gnss( &(pony->gnss[i]) ) ) {
-				pony_free();
-				return 0;
-			}
-		}
-	}
-
-	// system time, operation mode and solution
-	pony->t = 0;
-	pony->mode = 0;
-	pony_init_solution( &(pony->sol) );
-	
-	return 1;
-}
-
-
-
-		// step through the plugin execution list, to be called by host application in a main loop
-		//	output: 
-		//		1 - OK (either staying in regular operation mode, or a termination is properly detected)
-		//		0 - not OK (otherwise)
-char pony_step(void)
-{
-	int i;
-
-	// loop through plugin execution list
-	for (pony->core.current_plugin_id = 0; pony->core.current_plugin_id < pony->core.plugin_count; pony->core.current_plugin_id++)
-	{
-		i = pony->core.current_plugin_id;
-		
-		if (pony->mode == 0 || (pony->core.plugins[i].cycle > 0 && pony->core.plugins[i].tick == pony->core.plugins[i].shift))	// check if the scheduled tick has come, or init mode
-			pony->core.plugins[i].func();																// execute the current plugin
-
-		pony->core.plugins[i].tick++;									// current tick increment
-		if (pony->core.plugins[i].tick >= pony->core.plugins[i].cycle)	// check to stay within the cycle
-			pony->core.plugins[i].tick = 0;								// reset tick
-
-
-		if (pony->core.exit_plugin_id == i)	// if termination was initiated by the current plugin on the previous loop
-		{
-			pony->core.exit_plugin_id = -1;		// set to default
-			pony->core.host_termination = 0;		// set to default
-			pony_init_solution(&(pony->sol));	// drop the solution
-			pony_free();						// free memory
-			break;
-		}
-
-		if ((pony->mode < 0 || pony->core.host_termination == 1) && pony->core.exit_plugin_id == -1)	// if termination was initiated by the current plugin on the current loop
-		{
-			if (pony->mode > 0)
-				pony->mode = -1;					// set mode to -1 for external termination cases
-
-			if (pony->mode != 0)
-				pony->core.exit_plugin_id = i;	// set the index to use in the next loop
-
-		}
-	}
-
-	if (pony->mode == 0)		// if initialization ended
-		pony->mode = 1;		// set operation mode to regular
-
-							// success if either staying in regular operation mode, or a termination properly detected
-	return (pony->mode >= 0) || (pony->core.exit_plugin_id >= 0);
-}
-
-
-		// terminate operation
-		//	output: 
-		//		1 - OK (termination is due in the next step)
-		//		0 - not OK (had been already terminated by host or by plugin)
-char pony_terminate(void)
-{
-	if (pony->mode >= 0 && pony->core.host_termination != 1)
-	{
-		pony->core.host_termination = 1;
-
-		return 1; // termination is due in the next step
-	}
-
-	return 0; // had been already terminated by host or by plugin 
-}
-
-
-	// advanced functions
-
-		// remove all instances of a given plugin from the plugin execution list,	
-		//	input: 
-		//		plugin - pointer to plugin function to remove from execution list
-		//	output: 
-		//		>0 - number of plugin instances found, limited to 255
-		//		 0 - no instances found, or memory reallocation somehow failed
-char pony_remove_plugin(void(*plugin)(void))
-{
-	int i, j;
-	char flag = 0;
-
-	for (i = 0; i < pony->core.plugin_count; i++) { // go through the execution list
-		if (pony->core.plugins[i].func != plugin) // if not the requested plugin, do nothing
-			continue;
-		// otherwise, remove the current plugin from the execution list
-		for (j = i+1; j < pony->core.plugin_count; j++) // move all succeeding plugins one position lower
-			pony->core.plugins[j-1] = pony->core.plugins[j];
-		// reset the last one
-		j--;
-		pony->core.plugins[j].func = NULL;
-		pony->core.plugins[j].cycle = 0;
-		pony->core.plugins[j].shift = 0;
-		pony->core.plugins[j].tick  = 0;
-		pony->core.plugin_count--;
-		if (flag < 0xff)
-			flag++;
-	}
-
-	// reallocate memory
-	pony->core.plugins = (pony_plugin *)realloc( (void *)(pony->core.plugins), pony->core.plugin_count*sizeof(pony_plugin) );
-	if (pony->core.plugin_count > 0 &&  pony->core.plugins == NULL) { // memory reallocation somehow failed
-		pony_free();
-		return 0;
-	}
-
-	return flag;
-}
-
-
-		// replace all instances of the given plugin to another one in the plugin execution list,
-		//	input: 
-		//		oldplugin - pointer to plugin function to be replaced
-		//		newplugin - pointer to plugin function to replace with
-		//	output: 
-		//		number of plugin instances found, limited to 255
-char pony_replace_plugin(void(*oldplugin)(void), void(*newplugin)(void)) 
-{
-
-	int i;
-	char flag = 0;
-
-	for (i = 0; i < pony->core.plugin_count; i++) {
-		if (pony->core.plugins[i].func != oldplugin)
-			continue;
-		pony->core.plugins[i].func = newplugin;
-		if (flag < 0xff)
-			flag++;
-	}
-
-	return flag;
-}
-
-
-		// add scheduled plugin to the plugin execution list
-		//	input: 
-		//		newplugin	- pointer to plugin function
-		//		cycle		- repeating cycle (in ticks of main cycle), 
-		//					  negative for suspended plugin, 
-		//					  zero for the plugin to be turned off (for further rescheduling)
-		//		shift		- shift from the beginning of the cycle, automatically shrunk to [0..cycle-1]
-		//	output: 
-		//		1 - OK
-		//		0 - not OK (failed to allocate/realocate memory)
-char pony_schedule_plugin(void(*newplugin)(void), int cycle, int shift)
-{
-	int abs_cycle;
-
-	// add to the execution list
-	if (!pony_add_plugin(newplugin))
-		return 0;
-	// shrink shift to [0..cycle-1]
-	abs_cycle = abs(cycle);
-	if (abs_cycle) {
-		while (shift >= abs_cycle)
-			shift -= abs_cycle;
-		while (shift < 0)
-			shift += abs_cycle;
-	}
-	else
-		shift = 0;
-	// set scheduling parameters
-	pony->core.plugins[pony->core.plugin_count-1].cycle = cycle;
-	pony->core.plugins[pony->core.plugin_count-1].shift = shift;
-	pony->core.plugins[pony->core.plugin_count-1].tick  = 0;
-
-	return 1;
-}
-
-
-		// reschedule all instances of the plugin in the plugin execution list
-		//	input: 
-		//		plugin	- pointer to plugin function
-		//		cycle	- new repeating cycle (in ticks of main cycle), 
-		//				  negative for suspended plugin, 
-		//				  zero for the plugin to be turned off (for further rescheduling)
-		//		shift	- new shift from the beginning of the cycle, automatically shrunk to [0..cycle-1]
-		//	output: 
-		//		1 - OK
-		//		0 - not OK (plugin not found in the execution list)
-char pony_reschedule_plugin(void(*plugin)(void), int cycle, int shift)
-{
-	int i, abs_cycle;
-	char flag = 0;
-	// shrink shift to [0..cycle-1]
-	abs_cycle = abs(cycle);
-	if (abs_cycle) {
-		while (shift >= abs_cycle)
-			shift -= abs_cycle;
-		while (shift < 0)
-			shift += abs_cycle;
-	}
-	else
-		shift = 0;
-	// go through execution list and set scheduling parameters, if found the plugin
-	for (i = 0; i < pony->core.plugin_count; i++) 
-		if (pony->core.plugins[i].func == plugin) {
-			pony->core.plugins[i].cycle = cycle;
-			pony->core.plugins[i].shift = shift;
-			pony->core.plugins[i].tick  = 0;
-			flag = 1;
-		}
-
-	return flag;
-}
-
-
-		// suspend all instances of the plugin in the plugin execution list
-		//	input: 
-		//		plugin - pointer to plugin function,							
-		//	output: 
-		//		1 - OK
-		//		0 - not OK (plugin not found)
-char pony_suspend_plugin(void(*   plugin)(void))
-{
-	int i, cycle;
-	char flag = 0;
-	// go through execution list and set cycle to negative, if found the plugin
-	for (i = 0; i < pony->core.plugin_count; i++) 
-		if (pony->core.plugins[i].func == plugin) {
-			cycle = pony->core.plugins[i].cycle;
-			if (cycle > 0)
-				pony->core.plugins[i].cycle = -cycle;
-			flag = 1;
-		}
-
-	return flag;
-}
-
-
-		// resume all instances of the plugin in the plugin execution list	
-		//	input: 
-		//		plugin - pointer to plugin function,							
-		//	output: 
-		//		1 - OK
-		//		0 - not OK (plugin not found)
-char pony_resume_plugin(void(*   plugin)(void))
-{
-	int i, cycle;
-	char flag = 0;
-	// go through execution list and set cycle to positive, if found the plugin
-	for (i = 0; i < pony->core.plugin_count; i++) 
-		if (pony->core.plugins[i].func == plugin) {
-			cycle = pony->core.plugins[i].cycle;
-			if (cycle < 0)
-				pony->core.plugins[i].cycle = -cycle;
-			flag = 1;
-		}
-
-	return flag;
-}
-
-
-
-
-
-
-
-
-
-
-
-// basic parsing
-	//	locate a token in a configuration string
-	//	skips groups enclosed in braces {...} and strings within quotes ("...")
-	//	input:
-	//		token - token to be found and located, only non-blank characters
-	//		src - source string to search and locate in
-	//		len - maximum length to search and locate within
-	//		delim - mandatory delimiter to look for after the token found (if any), ignored if zero character
-	//	output:
-	//		NULL - if the token or delimiter (if delim != 0) not found, or token is invalid
-	//		pointer to the next character after the token or delimiter (if delim != 0)
-char * pony_locate_token(const char *token, char *src, const int len, const char delim) {
-
-	const char quote = '"', brace_open = '{', brace_close = '}';
-
-	int i, j, k, n, len1;
-
-	for (n = 0; token[n]; n++); // determine token length
-	if (n == 0) // invalid token
-		return NULL; 
-	len1 = len - n;
-
-	// look for the token
-	for (i = 0, j = 0, k = 0; i < len1 && src[i]; i++) // go throughout the string
-		if (src[i] == quote) // skip quoted values
-			for (i++; src[i] && i < len1 && src[i] != quote; i++);
-		else if (src[i] == brace_open) // skip groups
-			for (i++; src[i] && i < len1 && src[i] != brace_close; i++);
-		else {
-			for (j = 0, k = i; j < n && src[k] == token[j]; j++, k++); 
-			if (j == n) // token found
-				break;
-		}
-	if (j < n) // token not found
-		return NULL;
-
-	if (!delim)
-		return (src + k + 1);
-
-	// check for delimiter
-	for (i = k+1; i < len && src[i] && src[i] <= ' '; i++); // skip all non-printables		
-	if (i >= len || src[i] != delim) // no delimiter found
-		return NULL;
-	else
-		return (src + i + 1);
-}
-
-
-
-
-
-
-
-// time routines
-	// days elapsed from one date to another, based on Rata Die serial date from day one on 0001/01/01
-	// input:
-	//		epoch_from	- starting epoch, only Y, M and D are used
-	//		epoch_to	- ending epoch, only Y, M and D are used
-	// output:
-	//		number of days elapsed from starting epoch to the ending one 
-int pony_time_days_between_dates(pony_time_epoch epoch_from, pony_time_epoch epoch_to) {
-
-	if (epoch_to.M		< 3) 
-		epoch_to.Y--,	epoch_to.M		+= 12;
-	if (epoch_from.M	< 3) 
-		epoch_from.Y--,	epoch_from.M	+= 12;
-    return 
-		(365*epoch_to.Y		+ epoch_to.Y/4		- epoch_to.Y/100	+ epoch_to.Y/400	+ (153*epoch_to.M	- 457)/5	+ epoch_to.D	- 306) - 
-		(365*epoch_from.Y	+ epoch_from.Y/4	- epoch_from.Y/100	+ epoch_from.Y/400	+ (153*epoch_from.M	- 457)/5	+ epoch_from.D	- 306);
-
-}
-
-
-
-
-
-
-
-
-
-
-
-// linear algebra functions
-	// conventional operations
-		// dot product
-double pony_linal_dot(double *u, double *v, const int m) {
-	double res;
-	int i;
-
-	for (i = 1, res = u[0]*v[0]; i < m; i++)
-		res += u[i]*v[i];
-
-	return res;
-}
-
-		// l2 vector norm, i.e. sqrt(u^T*u)
-double pony_linal_vnorm(double *u, const int m) {
-	return sqrt(pony_linal_dot(u, u, m));
-}
-
-		// cross product for 3x1 vectors
-void pony_linal_cross3x1(double *res, double *u, double *v) {
-	res[0] = u[1]*v[2] - u[2]*v[1];
-	res[1] = u[2]*v[0] - u[0]*v[2];
-	res[2] = u[0]*v[1] - u[1]*v[0];
-}
-
-		// matrix multiplication res = a*b, a is n x n1, b is n1 x m, res is n x m
-void pony_linal_mmul(double *res,  double *a, double *b, const int n, const int n1, const int m) {
-	int i, j, k, k0, ka, kb, p;
-
-	for (i = 0, k = 0, k0 = 0; i < n; i++, k0 += n1)
-		for (j = 0; j < m; j++, k++) {
-			ka = k0;
-			kb = j;
-			res[k] = a[ka]*b[kb];
-			for (ka++, kb += m, p = 1; p < n1; ka++, kb += m, p++)
-				res[k] += a[ka]*b[kb];
-		}
-}
-
-		// matrix multiplication with the second argument transposed res = a*b^T, a is n x m, b is n1 x m, res is n x n1
-void pony_linal_mmul2T(double *res,  double *a, double *b, const int n, const int m, const int n1) {
-	int i, j, k, k0, ka, kb, p;
-
-	for (i = 0, k = 0, k0 = 0; i < n; i++, k0 += m)
-		for (j = 0; j < n1; j++, k++) {
-			ka = k0;
-			kb = j*m;
-			res[k] = a[ka]*b[kb];
-			for (ka++, kb++, p = 1; p < m; ka++, kb++, p++)
-				res[k] += a[ka]*b[kb];
-		}
-}
-
-		// quaternion multiplication for 4x1 quaternions res = q x r, with res0, q0, r0 being scalar parts
-void pony_linal_qmul(double *res, double *q, double *r) {
-	res[0] = q[0]*r[0] - q[1]*r[1] - q[2]*r[2] - q[3]*r[3];
-	res[1] = q[0]*r[1] + q[1]*r[0] + q[2]*r[3] - q[3]*r[2];
-	res[2] = q[0]*r[2] + q[2]*r[0] + q[3]*r[1] - q[1]*r[3];
-	res[3] = q[0]*r[3] + q[3]*r[0] + q[1]*r[2] - q[2]*r[1];
-}
-
-
-
-
-/*	// space rotation representation
-		// 3x3 attitude matrix R to quaternion q with q0 being scalar part
-void pony_linal_mat2quat(double *q, double *R) {
-
-	int i, i1, i3;
-
-	q[0] = 1 + R[0] + R[4] + R[8];
-	q[1] = 1 + R[0] - R[4] - R[8];
-	q[2] = 1 - R[0] + R[4] - R[8];
-	q[3] = 1 - R[0] - R[4] + R[8];
-
-	for (i = 0; i < 4; i++)
-		if (q[i] > 0)
-			q[i] = sqrt(q[i])/2;
-		else
-			q[i] = 0;
-	
-
-	// this part does not always work !! -- revise
-
-	for (i = 1; i < 4; i++) {
-		// copysign function implemented for q[i], R[x]-R[y] arguments 
-		i1 = (i+1)%3;
-		i3 = (i+3)%3;
-		if ( (q[i]>0) == (R[i1*3+i3] < R[i3*3+i1]) ) // R[7]vs.R[5] for i=1, R[2]vs.R[6] for i=2, R[3]vs.R[1] for i=3.
-			q[i] = -q[i];
-	}
-	//q[1] = _copysign(q[1], R[7] - R[5]);
-	//q[2] = _copysign(q[2], R[2] - R[6]);
-	//q[3] = _copysign(q[3], R[3] - R[1]);
-}*/
-
-
-
-
-	// routines for m x m upper-triangular matrices lined up in a single-dimension array
-		// index conversion for upper-triangular matrix lined up in a single-dimension array: (i,j) -> k
-void pony_linal_u_ij2k(int *k, const int i, const int j, const int m) {
-	*k = ( i*(2*m - 1 - i) )/2 + j;
-}
-
-		// index conversion for upper-triangular matrix lined up in a single-dimension array: k -> (i,j)
-void pony_linal_u_k2ij(int *i, int *j, const int k, const int m) {
-	double onehalf_plus_m = 0.5+m;
-	*i = (int)(floor( onehalf_plus_m - sqrt(onehalf_plus_m*onehalf_plus_m - 2.0*k) ) + 0.5);
-	*j = k - ( ( 2*m - 1 - (*i) )*(*i) )/2;
-}
-
-		// upper-triangular matrix lined up in a single-dimension array multiplication: res = U*v
-			// overwriting input (double *res = double *v) allowed
-void pony_linal_u_mul(double *res, double *u, double *v, const int n, const int m) {
-	int i, j, k, p, p0, mn;
-
-	mn = m*n;
-	for (j = 0; j < m; j++)
-		for (i = 0, k = 0, p0 = j; i < n; i++, p0 += m) {
-			res[p0] = u[k]*v[p0];
-			for (p = p0+m, k++; p < mn; p += m, k++)
-				res[p0] += u[k]*v[p];
-		}
-}
-
-		// upper-triangular matrix lined up in a single-dimension array of m(m+1)/2 x 1, transposed, multiplication by vector: res = U^T*v
-void pony_linal_uT_mul_v(double *res, double *u, double *v, const int m) {
-	int i, j, k;
-
-	for (i = 0; i < m; i++)
-		res[i] = u[i]*v[0];
-	for (j = 1, k = m; j < m; j++)
-		for (i = j; i < m; i++, k++)
-			res[i] += u[k]*v[j];
-}
-
-		// inversion of upper-triangular matrix lined up in a single-dimension array of m(m+1)/2 x 1: res = U^-1
-			// overwriting input (double *res = double *u) allowed
-void pony_linal_u_inv(double *res, double *u, const int m) {
-
-	int i, j, k, k0, p, q, p0, r;
-	double s;
-
-	for (j = 0, k0 = (m+2)*(m-1)/2; j < m; k0 -= j+2, j++) {
-		res[k0] = 1/u[k0]; // division by zero if matrix is not invertible
-		for (i = j+1, k = k0-j-1; i < m; k -= i+1, i++) {
-			p0 = k-(i-j);
-			for (p = k, q = k0, r = 0, s = 0; q > k; p--, q -= j+r+1, r++)
-				s += u[p]*res[q];
-			res[k] = -s/u[p0]; // division by zero if matrix is not invertible
-		}
-	}
-
-}
-
-		// square (with transposition) of upper-triangular matrix lined up in a single-dimension array of m(m+1)/2 x 1: res = U U^T
-			// overwriting input (double *res = double *u) allowed
-void pony_linal_uuT(double *res, double *u, const int m) {
-
-	int i, j, k, p, q, r;
-
-	for (i = 0, k = 0; i < m; i++)
-		for (j = i; j < m; j++, k++) {
-			pony_linal_u_ij2k(&p, j,j, m);
-			res[k] = u[k]*u[p];
-			for (q = k+1, p++, r = j+1; r < m; q++, p++, r++)
-				res[k] += u[q]*u[p];
-		}
-
-}
-
-	// Cholesky upper-triangular factorization P = S*S^T, where P is symmetric positive-definite matrix
-		// input:	P - upper-triangular part of symmetric m-by-m positive-definite R lined in a single-dimension array m(m+1)/2 x 1
-		// output:	S - upper-triangular part of a Cholesky factor S lined in a single-dimension array m(m+1)/2 x 1
-		// overwriting input (double *P == double *S) allowed
-void pony_linal_chol(double *S, double *P, const int m) {
-
-	int i, j, k, k0, p, q, p0;
-	double s;
-
-	for (j = 0, k0 = (m+2)*(m-1)/2; j < m; k0 -= j+2, j++) {
-		p0 = k0+j;
-		for (p = k0+1, s = 0; p <= p0; p++)
-			s += S[p]*S[p];
-		S[k0] = sqrt(P[k0] - s);
-		for (i = j+1, k = k0-j-1; i < m; k -= i+1, i++) {
-			for (p = k0+1, q = k+1, s = 0; p <= p0; p++, q++)
-				s += S[p]*S[q];
-			S[k] = (S[k0] == 0)? 0 : (P[k] - s)/S[k0];
-		}
-	}
-
-}
-
-	// square root Kalman filtering
-	//	input: 
-	//		x - current estimate of m x 1 state vector
-	//		S - upper-truangular part of a Cholesky factor of current covariance matrix, lined in a single-dimension array m(m+1)/2 x 1
-	//		z - scalar measurement value
-	//		h - linear measurement model matrix, so that z = h*x + r
-	//		sigma - measurement error a priori standard deviation, so that sigma = sqrt(E[r^2])
-	//	output:
-	//		x - updated estimate of state vector
-	//		S - upper-truangular part of a Cholesky factor of updated covariance matrix, lined in a single-dimension array m(m+1)/2 x 1
-	//		K - Kalman gain
-double pony_linal_kalman_update(double *x, double *S, double *K, double z, double *h, double sigma, const int m) {
-
-	double d, d1, sdd1, f, e;
-	int i, j, k;
-
-	// e0 stored in K
-	for (i = 0; i < m; i++)
-		K[i] = 0;
-
-	// d0
-	d = sigma*sigma;
-
-	// S
-	for (i = 0; i < m; i++) {
-		// f = S^T*h
-		f = S[i]*h[0];
-		for (j = 1, k = i+m-1; j <= i; j++, k += m-j)
-			f += S[k]*h[j];
-		// d
-		d1 = d + f*f;
-		sdd1 = sqrt(d*d1);
-		// S^+, e
-		for (j = 0, k = i; j <= i; j++, k += m-j) {
-			e = K[j];
-			K[j] += S[k]*f;
-			S[k] = (S[k]*d - e*f)/sdd1; // sigma = 0 not allowed
-		}
-		d = d1;
-	}
-
-	// dz
-	for (i = 0; i < m; i++)
-		z -= h[i]*x[i];
-
-	// K, x
-	for (i = 0; i < m; i++) {
-		K[i] /= d; // sigma = 0 not allowed
-		x[i] += K[i]*z;
-	}
-
-	return z;
-}
+// Feb-2020
+//
+// PONY core source code
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L	// monotonic clock for plugin timing
+#endif
+
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <stdio.h>
+
+#if !defined(_WIN32)		// memory-mapped input files
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define PONY_MMAP
+#endif
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))				// time stamp counter for plugin timing
+#include <intrin.h>
+#define PONY_RDTSC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define PONY_RDTSC
+#endif
+
+#if !defined(PONY_NO_SIMD) && (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))	// vector kernels for linear algebra, unless disabled
+#include <immintrin.h>
+#define PONY_SIMD
+#define PONY_SIMD_TARGET(isa) __attribute__((target(isa)))
+#elif !defined(PONY_NO_SIMD) && defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <immintrin.h>
+#include <intrin.h>
+#define PONY_SIMD
+#define PONY_SIMD_TARGET(isa)
+#endif
+
+#ifdef PONY_THREADS			// worker thread pool for parallel plugin execution, requires POSIX threads
+#include <pthread.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)	// acquire loads and release stores for lock-free imu sample ring indices
+#define PONY_LOAD_ACQUIRE(p)		__atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define PONY_STORE_RELEASE(p, v)	__atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else										// volatile accesses, acquire/release with MSVC defaults on x86/x64
+#define PONY_LOAD_ACQUIRE(p)		(*(volatile unsigned long *)(p))
+#define PONY_STORE_RELEASE(p, v)	(*(volatile unsigned long *)(p) = (v))
+#endif
+
+#include "pony.h"
+
+
+// core functions to be used in host application
+	// basic
+char pony_add_plugin(void(*newplugin)(void)	);	// add plugin to the plugin execution list,		input: pointer to plugin function,				output: OK/not OK (1/0)
+char pony_add_gnss_plugin(void(*newplugin)(void));	// add plugin to be called for each gnss instance,	input: pointer to plugin function,			output: OK/not OK (1/0)
+char pony_init      (char*					);	// initialize the bus, except for core,			input: configuration string (see description),	output: OK/not OK (1/0)
+char pony_step      (void					);	// step through the plugin execution list,														output: OK/not OK (1/0)
+char pony_terminate (void					);	// terminate operation,																			output: OK/not OK (1/0)
+	// advanced scheduling
+char pony_remove_plugin		(void(*   plugin)(void)							);	// remove all instances of the plugin from the plugin execution list,	input: pointer to plugin function,							output: OK/not OK (1/0)
+char pony_replace_plugin	(void(*oldplugin)(void), void(*newplugin)(void)	);	// replace all instances of the plugin by another one,					input: pointers to old and new plugin functions,			output: OK/not OK (1/0)
+char pony_schedule_plugin	(void(*newplugin)(void), int cycle, int shift	);	// add scheduled plugin to the plugin execution list,					input: pointer to plugin function, cycle, shift,			output: OK/not OK (1/0)
+char pony_reschedule_plugin	(void(*   plugin)(void), int cycle, int shift	);	// reschedule all instances of the plugin in the plugin execution list,	input: pointer to plugin function, new cycle, new shift,	output: OK/not OK (1/0)
+char pony_suspend_plugin	(void(*   plugin)(void)							);	// suspend all instances of the plugin in the plugin execution list,	input: pointer to plugin function,							output: OK/not OK (1/0)
+char pony_resume_plugin		(void(*   plugin)(void)							);	// resume all instances of the plugin in the plugin execution list,		input: pointer to plugin function,							output: OK/not OK (1/0)
+char pony_declare_plugin	(void(*   plugin)(void), unsigned long reads, unsigned long writes);	// declare bus data sections accessed by all instances of the plugin,	input: pointer to plugin function, sections read and written,	output: OK/not OK (1/0)
+	// instrumentation
+char pony_enable_stats		(char enable, double overrun					);	// enable (resetting) or disable plugin timing statistics,				input: 1/0, call duration to count as overrun (s, 0 if none),	output: OK/not OK (1/0)
+const pony_plugin_stats *pony_get_stats(int id							);	// get timing statistics of a plugin,									input: plugin index in the execution list,					output: pointer to statistics, NULL if disabled or no such plugin
+
+// bus instance
+pony_struct pony_bus = {
+	pony_bus_version,			// ver
+	pony_add_plugin,			// add_plugin
+	pony_add_gnss_plugin,		// add_gnss_plugin
+	pony_init,					// init
+	pony_step,					// step
+	pony_terminate,				// terminate
+	pony_remove_plugin,			// remove_plugin
+	pony_replace_plugin,		// replace_plugin
+	pony_schedule_plugin,		// schedule_plugin
+	pony_reschedule_plugin,		// reschedule_plugin
+	pony_suspend_plugin,		// suspend plugin
+	pony_resume_plugin,			// resume plugin
+	pony_declare_plugin,		// declare plugin
+	pony_enable_stats,			// enable stats
+	pony_get_stats,				// get stats
+	{ NULL, 0, -1, -1, 0, NULL, NULL, 0, 0, 0, NULL, 0, 0, NULL, 0, 0 } };		// core.plugins, core.plugin_count, core.current_plugin_id, core.exit_plugin_id, core.host_termination, core.pool, core.batch, core.batch_size, core.batch_gnss_count, core.tick, core.wheel, core.wheel_size, core.wheel_version, core.stats, core.stats_overrun, core.stats_scale
+
+PONY_THREAD_LOCAL pony_struct *pony = &pony_bus;
+PONY_THREAD_LOCAL pony_gnss *pony_gnss_current = NULL;
+
+
+
+// re-entrant bus instances
+	// set up a caller-owned bus instance, to be called before init
+	//	input: 
+	//		bus - pointer to bus structure allocated by the caller
+	//	output: 
+	//		1 - OK
+	//		0 - not OK (NULL pointer)
+char pony_bus_setup(pony_struct *bus)
+{
+	if (bus == NULL)
+		return 0;
+
+	// version and functions, same as in the default bus instance
+	bus->ver				= pony_bus_version;
+	bus->add_plugin			= pony_add_plugin;
+	bus->add_gnss_plugin	= pony_add_gnss_plugin;
+	bus->init				= pony_init;
+	bus->step				= pony_step;
+	bus->terminate			= pony_terminate;
+	bus->remove_plugin		= pony_remove_plugin;
+	bus->replace_plugin		= pony_replace_plugin;
+	bus->schedule_plugin	= pony_schedule_plugin;
+	bus->reschedule_plugin	= pony_reschedule_plugin;
+	bus->suspend_plugin		= pony_suspend_plugin;
+	bus->resume_plugin		= pony_resume_plugin;
+	bus->declare_plugin		= pony_declare_plugin;
+	bus->enable_stats		= pony_enable_stats;
+	bus->get_stats			= pony_get_stats;
+
+	// core
+	bus->core.plugins			= NULL;
+	bus->core.plugin_count		= 0;
+	bus->core.current_plugin_id	= -1;
+	bus->core.exit_plugin_id	= -1;
+	bus->core.host_termination	= 0;
+	bus->core.pool				= NULL;
+	bus->core.batch				= NULL;
+	bus->core.batch_size		= 0;
+	bus->core.batch_gnss_count	= 0;
+	bus->core.tick				= 0;
+	bus->core.wheel				= NULL;
+	bus->core.wheel_size		= 0;
+	bus->core.wheel_version		= 0;
+	bus->core.stats				= NULL;
+	bus->core.stats_overrun		= 0;
+	bus->core.stats_scale		= 0;
+
+	// configuration and data pointers
+	bus->cfg				= NULL;
+	bus->cfglength			= 0;
+	bus->cfg_settings		= NULL;
+	bus->settings_length	= 0;
+	bus->cfg_tree.cfg			= NULL;
+	bus->cfg_tree.cfglength		= 0;
+	bus->cfg_tree.node			= NULL;
+	bus->cfg_tree.node_count	= 0;
+	bus->cfg_tree.name_table	= NULL;
+	bus->cfg_tree.ptr_table		= NULL;
+	bus->cfg_tree.table_size	= 0;
+	bus->imu				= NULL;
+	bus->gnss				= NULL;
+	bus->gnss_count			= 0;
+	bus->t					= 0;
+	bus->mode				= 0;
+
+	return 1;
+}
+
+	// select a bus instance for plugins and bus functions called from the current thread
+	//	input: 
+	//		bus - pointer to bus instance, NULL for the default one
+	//	output: 
+	//		pointer to the bus instance previously selected for the current thread
+pony_struct *pony_bus_select(pony_struct *bus)
+{
+	pony_struct *prev = pony;
+
+	pony = (bus == NULL) ? &pony_bus : bus;
+
+	return prev;
+}
+
+
+
+
+
+// service subroutines
+
+	// locate parameter group within a configuration string by scanning it
+	// input:
+	// char* groupname	-	group identifier (see documentation)
+	//						or 
+	//						empty string to locate a substring that is outside of any group
+	// char* cfgstr	-	configuration string to parse
+	// int cfglen		-	number of characters in cfgstr to parse
+	//
+	// output:
+	// char** groupptr	-	reference to a pointer to the starting character of the group contents within a configuration string
+	// int* grouplen	-	reference to a number of characters in the group contents
+	//
+	// return value:		1 if the requested group found and grouplen > 0
+	//						0 otherwise
+	//
+	// working example:
+	// groupname = "gnss:"
+	// cfgstr = "{gnss: {gps: eph_in="gpsa.nav", obs_in="gpsa.obs"}}, out="sol.txt""
+	// cfglen = 66
+char pony_cfg_scan_group(const char* groupname, char* cfgstr, const int cfglen, char** groupptr, int* grouplen)
+{
+	int i, j;
+	int group_layer;
+	char group_found = 0;
+
+	*groupptr = NULL;
+	*grouplen = 0;
+
+	if (cfgstr == NULL)
+		return 0;
+
+	// locate configuration substring that is outside of any group
+	if (groupname[0] == '\0') {
+		for (i = 0; i < cfglen && cfgstr[i]; i++) {
+			// skip all non-printable characters, blank spaces and commas between groups
+			for (; cfgstr[i] && (cfgstr[i] <= ' ' || cfgstr[i] == ',') && i < cfglen; i++); 
+			// if no group started at this point
+			if (cfgstr[i] != '{')
+				break;
+			// if a group started
+			else {
+				group_layer = 1;
+				while (group_layer > 0 && cfgstr[i] && i < cfglen) {
+					i++;
+					if (cfgstr[i] == '{')
+						group_layer++;
+					if (cfgstr[i] == '}')
+						group_layer--;
+				}
+			}
+		}
+
+		// skip all non-printable characters, blank spaces and commas between groups
+		for (; i < cfglen && cfgstr[i] && (cfgstr[i] <= ' ' || cfgstr[i] == ','); i++);
+		// start from this point
+		*groupptr = cfgstr + i;
+
+		// determine the length, counting until the end of the string or when a group started or ended
+		for (; (*groupptr)[*grouplen] && (*groupptr)[*grouplen] != '{' && (*groupptr)[*grouplen] != '}'; (*grouplen)++);
+	}
+
+	// locate configuration substring inside a requested group
+	else {
+		for (i = 0; i < cfglen && cfgstr[i] && !group_found; i++) {
+			// skip all non-printable characters, blank spaces and commas between groups
+			for (; cfgstr[i] && (cfgstr[i] <= ' ' || cfgstr[i] == ',') && i < cfglen; i++); 
+			// if a group started
+			if (cfgstr[i] == '{') {
+				group_layer = 1;
+				// skip all non-printable characters and blank spaces at the beginning of the group
+				for (i++; cfgstr[i] && (cfgstr[i] <= ' ') && i < cfglen; i++); 
+
+				// check if the group is the one that has been requested
+				group_found = 1;
+				for (j = 0; cfgstr[i] && groupname[j] && i < cfglen; i++, j++)
+					if (cfgstr[i] != groupname[j]) {
+						group_found = 0;
+						break;
+					}
+				// if did not reach the last character of groupname
+				if (groupname[j])
+					group_found = 0;
+
+				if (group_found)
+					// start from this point
+					*groupptr = cfgstr + i;
+
+				// go through the rest of the group
+				while (group_layer > 0 && cfgstr[i] && i < cfglen) {
+					if (cfgstr[i] == '{')
+						group_layer++;
+					if (cfgstr[i] == '}')
+						group_layer--;
+					i++;
+					// count if inside the requested group, except for the last symbol
+					if (group_found && group_layer > 0)
+						(*grouplen)++;
+				}
+			}
+		}
+	}
+
+	return (*groupptr == NULL) ? 0 : 1;
+}
+
+
+
+
+// configuration tree
+	// check if a character belongs to a word, i.e. a key or an unquoted value
+char pony_cfg_word_char(const char c)
+{
+	return (c > ' ' && c != ',' && c != '=' && c != ':' && c != '"' && c != '{' && c != '}') ? 1 : 0;
+}
+
+	// hash of a name within a scope
+unsigned long pony_cfg_hash(const char *name, const int namelength, const int scope)
+{
+	unsigned long h;
+	int i;
+
+	// FNV-1a
+	for (i = 0, h = 2166136261UL ^ (unsigned long)(scope+1); i < namelength; i++)
+		h = (h ^ (unsigned char)name[i]) * 16777619UL;
+
+	return h;
+}
+
+	// find the first node with a given name within a scope
+	// output:
+	//		node index, -1 if not found
+int pony_cfg_tree_find(pony_cfg_tree *tree, const int scope, const char *name, const int namelength)
+{
+	int i, k, mask;
+	pony_cfg_node *node;
+
+	if (tree->table_size == 0)
+		return -1;
+
+	mask = tree->table_size - 1;
+	for (k = (int)(pony_cfg_hash(name, namelength, scope) & mask); tree->name_table[k] >= 0; k = (k+1) & mask) {
+		node = &(tree->node[tree->name_table[k]]);
+		if (node->scope != scope || node->namelength != namelength)
+			continue;
+		for (i = 0; i < namelength && node->name[i] == name[i]; i++);
+		if (i == namelength)
+			return tree->name_table[k];
+	}
+
+	return -1;
+}
+
+	// find a group or settings node by its contents, groups go first when coincide with settings
+	// output:
+	//		node index, -1 if not found or the pointer is outside the configuration string
+int pony_cfg_tree_scope(pony_cfg_tree *tree, const char *ptr, const int length)
+{
+	int k, mask;
+
+	if (tree->table_size == 0 || ptr < tree->cfg || ptr > tree->cfg + tree->cfglength)
+		return -1;
+
+	mask = tree->table_size - 1;
+	for (k = (int)( ((unsigned long)(ptr - tree->cfg) * 2654435761UL) & mask ); tree->ptr_table[k] >= 0; k = (k+1) & mask)
+		if (tree->node[tree->ptr_table[k]].ptr == ptr && tree->node[tree->ptr_table[k]].length == length)
+			return tree->ptr_table[k];
+
+	return -1;
+}
+
+	// free configuration tree memory
+void pony_cfg_tree_free(pony_cfg_tree *tree)
+{
+	if (tree->node != NULL)
+		free(tree->node);
+	tree->node = NULL;
+	tree->node_count = 0;
+	if (tree->name_table != NULL)
+		free(tree->name_table);
+	tree->name_table = NULL;
+	tree->ptr_table = NULL;		// allocated together with name_table
+	tree->table_size = 0;
+	tree->cfg = NULL;
+	tree->cfglength = 0;
+}
+
+	// add a node to configuration tree
+	// output:
+	//		index of the new node, -1 if failed to allocate memory
+int pony_cfg_tree_add(pony_cfg_tree *tree, const char type, char *name, const int namelength, const int scope, char *ptr, const int length)
+{
+	pony_cfg_node *reallocated_pointer;
+	int n;
+
+	// grow the node array twice when full
+	n = tree->node_count;
+	if ( (n & (n-1)) == 0 ) {
+		reallocated_pointer = (pony_cfg_node *)realloc( (void *)(tree->node), (n == 0 ? 1 : 2*n) * sizeof(pony_cfg_node) );
+		if (reallocated_pointer == NULL)
+			return -1;
+		tree->node = reallocated_pointer;
+	}
+
+	tree->node[n].type			= type;
+	tree->node[n].name			= name;
+	tree->node[n].namelength	= namelength;
+	tree->node[n].scope			= scope;
+	tree->node[n].ptr			= ptr;
+	tree->node[n].length		= length;
+	tree->node[n].settings		= n;
+	tree->node[n].next			= -1;
+	tree->node_count++;
+
+	return n;
+}
+
+	// parse contents of a group node into subgroups and words, recursively
+	// braces are counted the same way as in pony_cfg_scan_group, words are skipped within quotes
+	// output:
+	//		1 - OK
+	//		0 - not OK (failed to allocate memory)
+char pony_cfg_tree_parse(pony_cfg_tree *tree, const int scope)
+{
+	char *s, *settings;
+	int len, settings_length, i, j, k, layer, node;
+
+	s	= tree->node[scope].ptr;
+	len	= tree->node[scope].length;
+
+	// settings part, as located by scanning, unless it coincides with the whole group
+	pony_cfg_scan_group("", s, len, &settings, &settings_length);
+	if (settings != s || settings_length != len) {
+		node = pony_cfg_tree_add(tree, 's', settings, 0, scope, settings, settings_length);
+		if (node < 0)
+			return 0;
+		tree->node[scope].settings = node;
+	}
+
+	for (i = 0; i < len && s[i]; )
+		// skip quoted values
+		if (s[i] == '"') {
+			for (i++; i < len && s[i] && s[i] != '"'; i++);
+			i++;
+		}
+		// subgroup
+		else if (s[i] == '{') {
+			// skip all non-printable characters and blank spaces at the beginning of the group
+			for (i++; i < len && s[i] && s[i] <= ' '; i++);
+			// group identifier, up to and including a colon
+			for (j = i; j < len && pony_cfg_word_char(s[j]); j++);
+			if (j < len && s[j] == ':')
+				j++;
+			// group contents, up to the matching brace
+			for (k = j, layer = 1; k < len && s[k]; k++) {
+				if (s[k] == '{')
+					layer++;
+				if (s[k] == '}' && --layer == 0)
+					break;
+			}
+			node = pony_cfg_tree_add(tree, 'g', s+i, j-i, scope, s+j, k-j);
+			if (node < 0 || !pony_cfg_tree_parse(tree, node))
+				return 0;
+			i = k+1;
+		}
+		// word
+		else if (pony_cfg_word_char(s[i])) {
+			for (j = i; j < len && pony_cfg_word_char(s[j]); j++);
+			if (pony_cfg_tree_add(tree, 'w', s+i, j-i, scope, s+j, 0) < 0)
+				return 0;
+			i = j;
+		}
+		else
+			i++;
+
+	return 1;
+}
+
+	// build configuration tree for a configuration string: parse groups and words, then fill hash tables
+	// output:
+	//		1 - OK
+	//		0 - not OK (failed to allocate memory)
+char pony_cfg_tree_build(pony_cfg_tree *tree, char *cfg, const int cfglength)
+{
+	int i, k, prev, mask;
+	unsigned long h;
+
+	pony_cfg_tree_free(tree);
+
+	// nodes
+	tree->cfg = cfg;
+	tree->cfglength = cfglength;
+	if ( pony_cfg_tree_add(tree, 'g', cfg, 0, -1, cfg, cfglength) < 0 || !pony_cfg_tree_parse(tree, 0) ) {
+		pony_cfg_tree_free(tree);
+		return 0;
+	}
+
+	// hash tables, at most half full
+	for (tree->table_size = 4; tree->table_size < 2*tree->node_count; tree->table_size *= 2);
+	tree->name_table = (int *)malloc( 2 * tree->table_size * sizeof(int) );
+	if (tree->name_table == NULL) {
+		pony_cfg_tree_free(tree);
+		return 0;
+	}
+	tree->ptr_table = tree->name_table + tree->table_size;
+	for (i = 0; i < 2*tree->table_size; i++)
+		tree->name_table[i] = -1;
+	mask = tree->table_size - 1;
+
+	for (i = 0; i < tree->node_count; i++) {
+		// groups and words by scope and name, repeated names are chained in the order of appearance
+		if (tree->node[i].scope >= 0 && tree->node[i].type != 's') {
+			prev = pony_cfg_tree_find(tree, tree->node[i].scope, tree->node[i].name, tree->node[i].namelength);
+			if (prev >= 0) {
+				for (; tree->node[prev].next >= 0; prev = tree->node[prev].next);
+				tree->node[prev].next = i;
+			}
+			else {
+				h = pony_cfg_hash(tree->node[i].name, tree->node[i].namelength, tree->node[i].scope);
+				for (k = (int)(h & mask); tree->name_table[k] >= 0; k = (k+1) & mask);
+				tree->name_table[k] = i;
+			}
+		}
+		// groups and settings by contents starting character
+		if (tree->node[i].type != 'w') {
+			h = (unsigned long)(tree->node[i].ptr - cfg) * 2654435761UL;
+			for (k = (int)(h & mask); tree->ptr_table[k] >= 0; k = (k+1) & mask);
+			tree->ptr_table[k] = i;
+		}
+	}
+
+	return 1;
+}
+
+	// locate parameter group using configuration tree, see pony_locatecfggroup
+	// output:
+	//		1 - group found
+	//		0 - group not found
+	//		-1 - the tree is not applicable: the string is not a group within the configuration, or group identifier has no trailing colon
+int pony_cfg_tree_group(pony_cfg_tree *tree, const char* groupname, char* cfgstr, const int cfglen, char** groupptr, int* grouplen)
+{
+	int scope, node, n;
+
+	scope = pony_cfg_tree_scope(tree, cfgstr, cfglen);
+	if (scope < 0 || tree->node[scope].type != 'g')
+		return -1;
+
+	// part outside of any group
+	if (groupname[0] == '\0') {
+		node = tree->node[scope].settings;
+		*groupptr = tree->node[node].ptr;
+		*grouplen = tree->node[node].length;
+		return 1;
+	}
+
+	// group identifier
+	for (n = 0; groupname[n]; n++);
+	if (groupname[n-1] != ':')
+		return -1;
+
+	node = pony_cfg_tree_find(tree, scope, groupname, n);
+	if (node < 0) {
+		*groupptr = NULL;
+		*grouplen = 0;
+		return 0;
+	}
+	*groupptr = tree->node[node].ptr;
+	*grouplen = tree->node[node].length;
+	return 1;
+}
+
+	// locate a token using configuration tree, see pony_locate_token
+	// the token is matched against whole words, a token may be followed by non-word characters to be matched literally (e.g. "eph_in=")
+	// output:
+	//		1 - lookup done, the result is in res
+	//		0 - the tree is not applicable: the string is not a group (or its settings part) within the configuration, or no word at the beginning of the token
+char pony_cfg_tree_token(pony_cfg_tree *tree, const char *token, char *src, const int len, const char delim, char **res)
+{
+	int scope, node, n, tokenlength, i;
+	char *name;
+
+	*res = NULL;
+
+	scope = pony_cfg_tree_scope(tree, src, len);
+	if (scope < 0)
+		return 0;
+	if (tree->node[scope].type == 's')
+		scope = tree->node[scope].scope;
+
+	// word part of the token
+	for (n = 0; token[n] && pony_cfg_word_char(token[n]); n++);
+	for (tokenlength = n; token[tokenlength]; tokenlength++);
+	if (n == 0)
+		return 0;
+
+	for (node = pony_cfg_tree_find(tree, scope, token, n); node >= 0; node = tree->node[node].next) {
+		name = tree->node[node].name;
+		if (name < src)	// before the settings part
+			continue;
+		if (name - src >= len - tokenlength)
+			break;
+		// the rest of the token
+		for (i = n; i < tokenlength && name[i] == token[i]; i++);
+		if (i < tokenlength)
+			continue;
+
+		if (!delim)
+			*res = name + tokenlength + 1;
+		else {
+			// check for delimiter
+			for (i = (int)(name - src) + tokenlength; i < len && src[i] && src[i] <= ' '; i++); // skip all non-printables
+			if (i < len && src[i] == delim)
+				*res = src + i + 1;
+		}
+		break;
+	}
+
+	return 1;
+}
+
+	// locate parameter group within a configuration string
+	// uses the configuration tree of the bus selected for the current thread, when the string is a group (or the root) within the bus configuration,
+	// otherwise scans the string (see pony_cfg_scan_group for details)
+	// input:
+	// char* groupname	-	group identifier (see documentation)
+	//						or 
+	//						empty string to locate a substring that is outside of any group
+	// char* cfgstr	-	configuration string to parse
+	// int cfglen		-	number of characters in cfgstr to parse
+	//
+	// output:
+	// char** groupptr	-	reference to a pointer to the starting character of the group contents within a configuration string
+	// int* grouplen	-	reference to a number of characters in the group contents
+	//
+	// return value:		1 if the requested group found and grouplen > 0
+	//						0 otherwise
+char pony_locatecfggroup(const char* groupname, char* cfgstr, const int cfglen, char** groupptr, int* grouplen)
+{
+	int res;
+
+	res = pony_cfg_tree_group(&(pony->cfg_tree), groupname, cfgstr, cfglen, groupptr, grouplen);
+	if (res >= 0)
+		return res;
+
+	return pony_cfg_scan_group(groupname, cfgstr, cfglen, groupptr, grouplen);
+}
+
+
+
+
+// initialize epoch
+void pony_init_epoch(pony_time_epoch *epoch)
+{
+	epoch->Y = 0;
+	epoch->M = 0;
+	epoch->D = 0;
+	epoch->h = 0;
+	epoch->m = 0;
+	epoch->s = 0;
+}
+
+	// continuous time of the epoch, not computed yet
+void pony_init_time(pony_time *time)
+{
+	int i;
+
+	pony_init_epoch( &(time->epoch) );
+	time->scale = pony_time_gps;
+	time->epoch_scale = pony_time_gps;
+	time->day = 0;
+	time->sec = 0;
+	for (i = 0; i < pony_time_scales; i++) {
+		time->offset[i] = 0;
+		time->offset_valid[i] = 0;
+	}
+	time->leap_sec = -1;
+	time->valid = 0;
+}
+
+
+
+
+// initialize solution
+void pony_init_solution(pony_sol *sol)
+{
+	int i;
+
+	// pos & vel
+	for (i = 0; i < 3; i++) {
+		sol->x[i]	= 0;
+		sol->llh[i]	= 0;
+		sol->v[i]	= 0;
+	}
+	sol->x_valid	= 0;
+	sol->llh_valid	= 0;
+	sol->v_valid	= 0;
+	// attitude
+	for (i = 0; i < 4; i++)
+		sol->q[i]	= 0; // quaternion
+	sol->q_valid	= 0;
+	for (i = 0; i < 9; i++)
+		sol->L[i]	= 0; // attitude matrix
+	sol->L_valid	= 0;
+	for (i = 0; i < 3; i++)
+		sol->rpy[i]	= 0; // attitude angles
+	sol->rpy_valid	= 0;
+	// clock
+	sol->dt			= 0;
+	sol->dt_valid	= 0;
+
+}
+
+
+
+
+// imu data handling subroutines
+	// initialize inertial navigation constants
+void pony_init_imu_const(pony_struct *bus)
+{
+	bus->imu_const.pi		= 3.14159265358979323846264338327950288;	// pi with maximum quad-precision floating point digits as in IEEE 754-2008 (binary128)
+	bus->imu_const.rad2deg	= 180/bus->imu_const.pi;					// 180/pi
+	// Earth parameters as in Section 4 of GRS-80 by H. Moritz // Journal of Geodesy (2000) 74 (1): pp. 128–162
+	bus->imu_const.u		= 7.292115e-5;			// Earth rotation rate, rad/s
+	bus->imu_const.a		= 6378137.0;			// Earth ellipsoid semi-major axis, m
+	bus->imu_const.e2		= 6.6943800229e-3;		// Earth ellipsoid first eccentricity squared
+	bus->imu_const.ge		= 9.7803267715;			// Earth normal gravity at the equator, m/s^2
+	bus->imu_const.fg		= 5.302440112e-3;		// Earth normal gravity flattening
+}
+
+	// initialize imu structure
+char pony_init_imu(pony_imu *imu, const pony_imu_const *imu_const)
+{
+	char *value;
+	unsigned long size;
+	int i;
+
+	// validity flags
+	imu->w_valid = 0;
+	imu->f_valid = 0;
+	imu->W_valid = 0;
+	imu->t = 0;
+	for (i = 0; i < 3; i++) {
+		imu->w[i]	= 0;
+		imu->f[i]	= 0;
+		imu->W[i]	= 0;
+	}
+	// default gravity acceleration vector
+	imu->g[0] = 0;
+	imu->g[1] = 0;
+	imu->g[2] = -imu_const->ge*(1 + imu_const->fg/2); // middle value
+	// drop the solution
+	pony_init_solution( &(imu->sol) );
+
+	// sample ring, if requested, rounded up to a power of two
+	imu->ring = NULL;
+	value = (imu->cfg == NULL) ? NULL : pony_locate_token("ring_size", imu->cfg, imu->cfglength, '=');
+	if (value != NULL && atol(value) > 0) {
+		for (size = 1; size < (unsigned long)atol(value); size <<= 1);
+		imu->ring = (pony_imu_ring *)calloc(1, sizeof(pony_imu_ring));
+		if (imu->ring == NULL)
+			return 0;
+		imu->ring->sample = (pony_imu_sample *)calloc(size, sizeof(pony_imu_sample));
+		if (imu->ring->sample == NULL)
+			return 0;
+		imu->ring->mask = size - 1;
+	}
+
+	// pre-integration, if requested
+	imu->preint = NULL;
+	value = (imu->cfg == NULL) ? NULL : pony_locate_token("preint_interval", imu->cfg, imu->cfglength, '=');
+	if (value != NULL && atof(value) > 0) {
+		imu->preint = (pony_imu_preint *)calloc(1, sizeof(pony_imu_preint));
+		if (imu->preint == NULL)
+			return 0;
+		imu->preint->interval = atof(value);
+		pony_imu_preint_reset(imu->preint);
+	}
+
+	return 1;
+}
+
+	// free imu memory
+void pony_free_imu(pony_struct *bus)
+{
+	if (bus->imu == NULL)
+		return;
+	if (bus->imu->ring != NULL) {
+		free(bus->imu->ring->sample);
+		free(bus->imu->ring);
+	}
+	free(bus->imu->preint);
+	free(bus->imu);
+	bus->imu = NULL;
+}
+
+
+
+
+// gnss data handling subroutines
+	// initialize gnss settings
+char pony_init_gnss_settings(pony_gnss *gnss)
+{
+	int i;
+
+	pony_locatecfggroup( "", gnss->cfg, gnss->cfglength, &(gnss->cfg_settings), &(gnss->settings_length) );
+
+	gnss->settings.sinEl_mask = 0;
+	gnss->settings.code_sigma = 20;
+	gnss->settings.phase_sigma = 0.01;
+	for (i = 0; i < 3; i++)
+		gnss->settings.ant_pos[i] = 0;
+	gnss->settings.ant_pos_tol = -1;
+	gnss->settings.leap_sec_def = 0;
+
+	return 1;
+}
+
+	// allocate a single aligned block for constellation satellite storage
+	// parts follow each other aligned to cache lines: satellites, ephemeris, observables, frequency slots, observables validity flags, satellite SoA view, orbit caches
+	// input:
+	//		max_sat_count - maximum number of satellites
+	//		max_eph_count - maximum number of ephemeris parameters per satellite
+	//		max_obs_count - number of observables reserved per satellite, zero to leave obs and obs_valid for runtime allocation
+	//		freq_slot - frequency slot array pointer to be assigned, NULL if not needed
+	//		orbit - orbit integration cache pointer to be assigned, NULL if not needed
+	//		cheb - Chebyshev orbit cache to be assigned
+	// output:
+	//		sat - satellite array, with ephemeris and observables assigned and validity flags reset
+	//		soa - structure-of-arrays view of satellites, zeroed
+	//		freq_slot - frequency slot array, if requested
+	//		orbit - orbit integration cache of pony_gnss_orbit_cache_size x max_sat_count, zeroed, if requested
+	//		cheb - Chebyshev orbit cache segments of pony_gnss_cheb_size x max_sat_count, zeroed, i.e. not fitted
+	//		pointer to the block to be freed as a whole, NULL if failed
+void *pony_gnss_arena_alloc(pony_gnss_sat **sat, pony_gnss_sat_soa *soa, int **freq_slot, double **orbit, pony_gnss_cheb *cheb, const int max_sat_count, const int max_eph_count, const int max_obs_count)
+{
+	const size_t align = 64;
+
+	size_t size_sat, size_eph, size_obs, size_slot, size_valid, size_soa, size_mask, size_orbit, size_cheb;
+	char *arena, *base, *part;
+	int i;
+
+	// part sizes rounded up to alignment
+	size_sat	= (sizeof(pony_gnss_sat)*max_sat_count				+ align-1)/align*align;
+	size_eph	= (sizeof(double)*max_sat_count*max_eph_count		+ align-1)/align*align;
+	size_obs	= (sizeof(double)*max_sat_count*max_obs_count		+ align-1)/align*align;
+	size_slot	= (freq_slot == NULL) ? 0 : (sizeof(int)*max_sat_count + align-1)/align*align;
+	size_valid	= (sizeof(char)*max_sat_count*max_obs_count		+ align-1)/align*align;
+	size_soa	= (sizeof(double)*max_sat_count						+ align-1)/align*align;	// for each of 9 arrays
+	size_mask	= (sizeof(unsigned int)*((max_sat_count+31)/32)		+ align-1)/align*align;	// for each of 5 masks
+	size_orbit	= (orbit == NULL) ? 0 : (sizeof(double)*max_sat_count*pony_gnss_orbit_cache_size + align-1)/align*align;
+	size_cheb	= (sizeof(double)*max_sat_count*pony_gnss_cheb_size	+ align-1)/align*align;
+
+	// try to allocate memory, with a margin for alignment
+	arena = (char *)calloc( size_sat + size_eph + size_obs + size_slot + size_valid + 9*size_soa + 5*size_mask + size_orbit + size_cheb + align, sizeof(char) );
+	if (arena == NULL)
+		return NULL;
+	base = arena + (align - (size_t)arena%align)%align;
+
+	// assign parts
+	*sat = (pony_gnss_sat *)base;
+	if (freq_slot != NULL)
+		*freq_slot = (int *)(base + size_sat + size_eph + size_obs);
+	for (i = 0; i < max_sat_count; i++) {
+		(*sat)[i].eph			= (double *)(base + size_sat) + i*max_eph_count;
+		(*sat)[i].eph_valid		= 0;
+		(*sat)[i].obs			= (max_obs_count > 0) ? (double *)(base + size_sat + size_eph) + i*max_obs_count : NULL;
+		(*sat)[i].obs_valid		= (max_obs_count > 0) ? base + size_sat + size_eph + size_obs + size_slot + i*max_obs_count : NULL;
+		(*sat)[i].x_valid		= 0;
+		(*sat)[i].v_valid		= 0;
+		(*sat)[i].t_em_valid	= 0;
+		(*sat)[i].sinEl_valid	= 0;
+	}
+	part = base + size_sat + size_eph + size_obs + size_slot + size_valid;
+	soa->count			= max_sat_count;
+	soa->x				= (double *)part;	part += size_soa;
+	soa->y				= (double *)part;	part += size_soa;
+	soa->z				= (double *)part;	part += size_soa;
+	soa->vx				= (double *)part;	part += size_soa;
+	soa->vy				= (double *)part;	part += size_soa;
+	soa->vz				= (double *)part;	part += size_soa;
+	soa->sinEl			= (double *)part;	part += size_soa;
+	soa->t_em			= (double *)part;	part += size_soa;
+	soa->Deltatsv		= (double *)part;	part += size_soa;
+	soa->eph_valid		= (unsigned int *)part;	part += size_mask;
+	soa->x_valid		= (unsigned int *)part;	part += size_mask;
+	soa->v_valid		= (unsigned int *)part;	part += size_mask;
+	soa->t_em_valid		= (unsigned int *)part;	part += size_mask;
+	soa->sinEl_valid	= (unsigned int *)part;	part += size_mask;
+	if (orbit != NULL)
+		*orbit = (double *)part;
+	cheb->seg = (double *)(part + size_orbit);
+
+	return arena;
+}
+
+	// read constellation storage limits from its configuration, keeping defaults for those not found
+void pony_init_gnss_limits(char *cfg, const int cfglength, int *max_sat_count, int *max_eph_count, int *max_obs_count)
+{
+	char *value;
+
+	if (cfg == NULL)
+		return;
+	value = pony_locate_token("max_sat_count", cfg, cfglength, '=');
+	if (value != NULL && atoi(value) >= 0)
+		*max_sat_count = atoi(value);
+	value = pony_locate_token("max_eph_count", cfg, cfglength, '=');
+	if (value != NULL && atoi(value) >= 0)
+		*max_eph_count = atoi(value);
+	value = pony_locate_token("max_obs_count", cfg, cfglength, '=');
+	if (value != NULL && atoi(value) >= 0)
+		*max_obs_count = atoi(value);
+}
+
+	// initialize Chebyshev orbit cache settings from constellation configuration: orbit_cache_tol - position accuracy bound, m
+void pony_init_gnss_cheb(pony_gnss_cheb *cheb, char *cfg, const int cfglength)
+{
+	const double tol = 1e-3, span = 300;	// defaults
+
+	char *value;
+
+	cheb->tol = tol;
+	cheb->span = span;
+	if (cfg == NULL)
+		return;
+	value = pony_locate_token("orbit_cache_tol", cfg, cfglength, '=');
+	if (value != NULL && atof(value) > 0)
+		cheb->tol = atof(value);
+}
+
+	// initialize gnss gps constants
+void pony_init_gnss_gps_const(pony_gps_const *gps_const, const double c)
+{
+	gps_const->mu	=  3.986005e14;			// Earth gravity constant as in IS-GPS-200J (22 May 2018), m^3/s^2
+	gps_const->u	=  7.2921151467e-5;		// Earth rotation rate as in IS-GPS-200J (22 May 2018), rad/s
+	gps_const->a	=  6378137.0;			// Earth ellipsoid semi-major axis as in WGS-84(G1762) 2014-07-08, m
+	gps_const->e2	=  6.694379990141e-3;	// Earth ellipsoid first eccentricity squared as in WGS-84(G1762) 2014-07-08
+	gps_const->F	= -4.442807633e-10;		// relativistic correction constant as in IS-GPS-200J (22 May 2018), s/sqrt(m)
+	gps_const->F1	=  1575.42e6;			// nominal frequency for L1 signal as in IS-GPS-200J (22 May 2018)
+	gps_const->L1	= c/gps_const->F1;		// nominal wavelength for L1 signal
+	gps_const->F2	=  1227.60e6;			// nominal frequency for L2 signal as in IS-GPS-200J (22 May 2018)
+	gps_const->L2	= c/gps_const->F2;		// nominal wavelength for L2 signal
+}
+
+	// initialize gnss gps structure
+char pony_init_gnss_gps(pony_gnss_gps *gps, const int max_sat_count, const int max_eph_count, const int max_obs_count)
+{
+	gps->sat = NULL;
+	gps->max_sat_count = 0;
+	gps->max_eph_count = 0;
+	gps->max_obs_count = 0;
+
+	// try to allocate a single block for satellite data, ephemeris and observables
+	gps->arena = pony_gnss_arena_alloc(&(gps->sat), &(gps->soa), NULL, NULL, &(gps->cheb), max_sat_count, max_eph_count, max_obs_count);
+	if (gps->arena == NULL)
+		return 0;
+	pony_init_gnss_cheb(&(gps->cheb), gps->cfg, gps->cfglength);
+	gps->max_sat_count = max_sat_count;
+	gps->max_eph_count = max_eph_count;
+	gps->max_obs_count = max_obs_count;
+
+	// observation types
+	gps->obs_types = NULL;
+	gps->obs_count = 0;
+
+	// validity flags
+	gps->iono_valid = 0;
+	gps->clock_corr_valid = 0;
+
+	return 1;
+}
+
+	// free gnss gps memory
+void pony_free_gnss_gps(pony_gnss_gps *gps)
+{
+	if (gps == NULL)
+		return;
+
+	// satellites, ephemeris and observables
+	free(gps->arena);
+	gps->arena = NULL;
+	gps->sat = NULL;
+	gps->soa.count = 0;
+	gps->cheb.seg = NULL;
+
+	// gnss_gps structure
+	free(gps);
+}
+
+	// initialize gnss glonass constants
+void pony_init_gnss_glo_const(pony_glo_const *glo_const)
+{
+	glo_const->mu	= 398600.4418e9;	// Earth gravity constant as in PZ-90.11 (2014), m^3/s^2
+	glo_const->J02	= 1082.62575e-6;	// second degree zonal harmonic coefficient of normal potential as in PZ-90.11 (2014)
+	glo_const->u	= 7.292115e-5;		// Earth rotation rate as in PZ-90.11 (2014), rad/s
+	glo_const->a	= 6378136.0;		// Earth ellipsoid semi-major axis as in PZ-90.11 (2014), m
+	glo_const->e2	= 0.0066943662;		// Earth ellipsoid first eccentricity squared as in PZ-90.11 (2014)
+	glo_const->F01	= 1602e6;			// nominal centre frequency for L1 signal as in ICD GLONASS Edition 5.1 2008, Hz
+	glo_const->dF1	= 562.5e3;			// nominal channel separation for L1 signal as in ICD GLONASS Edition 5.1 2008, Hz
+	glo_const->F02	= 1246e6;			// nominal centre frequency for L2 signal as in ICD GLONASS Edition 5.1 2008, Hz
+	glo_const->dF2	= 437.5e3;			// nominal channel separation for L2 signal as in ICD GLONASS Edition 5.1 2008, Hz
+}
+
+	// initialize gnss glonass structure
+char pony_init_gnss_glo(pony_gnss_glo *glo, const int max_sat_count, const int max_eph_count, const int max_obs_count)
+{
+	glo->sat = NULL;
+	glo->freq_slot = NULL;
+	glo->orbit = NULL;
+	glo->max_sat_count = 0;
+	glo->max_eph_count = 0;
+	glo->max_obs_count = 0;
+
+	// try to allocate a single block for satellite data, ephemeris and observables
+	glo->arena = pony_gnss_arena_alloc(&(glo->sat), &(glo->soa), &(glo->freq_slot), &(glo->orbit), &(glo->cheb), max_sat_count, max_eph_count, max_obs_count);
+	if (glo->arena == NULL)
+		return 0;
+	pony_init_gnss_cheb(&(glo->cheb), glo->cfg, glo->cfglength);
+	glo->max_sat_count = max_sat_count;
+	glo->max_eph_count = max_eph_count;
+	glo->max_obs_count = max_obs_count;
+
+	// observation types
+	glo->obs_types = NULL;
+	glo->obs_count = 0;
+
+	return 1;
+}
+
+	// free gnss glonass memory
+void pony_free_gnss_glo(pony_gnss_glo *glo)
+{
+	if (glo == NULL)
+		return;
+
+	// satellites, ephemeris and observables
+	free(glo->arena);
+	glo->arena = NULL;
+	glo->sat = NULL;
+	glo->soa.count = 0;
+	glo->cheb.seg = NULL;
+	glo->freq_slot = NULL;
+	glo->orbit = NULL;
+
+	// gnss glonass structure
+	free(glo);
+}
+
+	// initialize gnss galileo constants
+void pony_init_gnss_gal_const(pony_gal_const *gal_const, const double c)
+{
+	gal_const->mu	=  3.986004418e14;		// Earth gravity constant as in Galileo OS SIS ICD Issue 1.2 (November 2015), m^3/s^2
+	gal_const->u	=  7.2921151467e-5;		// Earth rotation rate as in Galileo OS SIS ICD Issue 1.2 (November 2015), rad/s
+	gal_const->a	=  6378137.0;			// Earth ellipsoid semi-major axis as in GRS-80 // JoG March 2000 vol. 74 issue 1, m
+	gal_const->e2	=  6.69438002290e-3;	// Earth ellipsoid first eccentricity squared as in GRS-80 // JoG March 2000 vol. 74 issue 1
+	gal_const->F	= -4.442807309e-10;		// relativistic correction constant as in Galileo OS SIS ICD Issue 1.2 (November 2015), s/sqrt(m)
+	gal_const->F1	=  1575.42e6;			// nominal frequency for E1 signal as in Galileo OS SIS ICD Issue 1.2 (November 2015)
+	gal_const->L1	= c/gal_const->F1;		// nominal wavelength for E1 signal
+	gal_const->F5a	=  1176.45e6;			// nominal frequency for E5a signal as in Galileo OS SIS ICD Issue 1.2 (November 2015)
+	gal_const->L5a	= c/gal_const->F5a;	// nominal wavelength for E5a signal
+	gal_const->F5b	=  1207.14e6;			// nominal frequency for E5b signal as in Galileo OS SIS ICD Issue 1.2 (November 2015)
+	gal_const->L5b	= c/gal_const->F5b;	// nominal wavelength for E5b signal
+	gal_const->F6	=  1278.75e6;			// nominal frequency for E6 signal as in Galileo OS SIS ICD Issue 1.2 (November 2015)
+	gal_const->L6	= c/gal_const->F6;		// nominal wavelength for E6 signal
+}
+
+	// initialize gnss galileo structure
+char pony_init_gnss_gal(pony_gnss_gal *gal, const int max_sat_count, const int max_eph_count, const int max_obs_count)
+{
+	gal->sat = NULL;
+	gal->max_sat_count = 0;
+	gal->max_eph_count = 0;
+	gal->max_obs_count = 0;
+
+	// try to allocate a single block for satellite data, ephemeris and observables
+	gal->arena = pony_gnss_arena_alloc(&(gal->sat), &(gal->soa), NULL, NULL, &(gal->cheb), max_sat_count, max_eph_count, max_obs_count);
+	if (gal->arena == NULL)
+		return 0;
+	pony_init_gnss_cheb(&(gal->cheb), gal->cfg, gal->cfglength);
+	gal->max_sat_count = max_sat_count;
+	gal->max_eph_count = max_eph_count;
+	gal->max_obs_count = max_obs_count;
+
+	// observation types
+	gal->obs_types = NULL;
+	gal->obs_count = 0;
+
+	// validity flags
+	gal->iono_valid = 0;
+	gal->clock_corr_valid = 0;
+
+	return 1;
+}
+
+	// free gnss galileo memory
+void pony_free_gnss_gal(pony_gnss_gal *gal)
+{
+	if (gal == NULL)
+		return;
+
+	// satellites, ephemeris and observables
+	free(gal->arena);
+	gal->arena = NULL;
+	gal->sat = NULL;
+	gal->soa.count = 0;
+	gal->cheb.seg = NULL;
+
+	// gnss galileo structure
+	free(gal);
+}
+
+	// initialize gnss beidou constants
+void pony_init_gnss_bds_const(pony_bds_const *bds_const, const double c)
+{
+	bds_const->mu			=  3.986004418e14;			// Earth gravity constant as in BeiDou SIS ICD OSS Version 2.1 (November 2016), m^3/s^2
+	bds_const->u			=  7.292115e-5;				// Earth rotation rate as in BeiDou SIS ICD OSS Version 2.1 (November 2016), rad/s
+	bds_const->a			=  6378137.0;				// Earth ellipsoid semi-major axis as in BeiDou SIS ICD OSS Version 2.1 (November 2016), m
+	bds_const->e2			=  6.6943800229008e-3;		// Earth ellipsoid first eccentricity squared derived from flattening as in BeiDou SIS ICD OSS Version 2.1 (November 2016)
+	bds_const->F			= -4.442807309043977e-10;	// relativistic correction constant derived from Earth gravity as in BeiDou SIS ICD OSS Version 2.1 (November 2016), s/sqrt(m)
+	bds_const->leap_sec		=  14;						// leap seconds between BeiDou time and GPS time as of 01-Jan-2006
+	bds_const->B1			=  1561.098e6;				// nominal frequency for B1 signal as in BeiDou SIS ICD OSS Version 2.1 (November 2016)
+	bds_const->L1			= c/bds_const->B1;		// nominal wavelength for B1 signal
+	bds_const->B2			=  1207.140e6;				// nominal frequency for B2 signal as in BeiDou SIS ICD OSS Version 2.1 (November 2016)
+	bds_const->L2			= c/bds_const->B2;		// nominal wavelength for B2 signal
+}
+
+	// initialize gnss beidou structure
+char pony_init_gnss_bds(pony_gnss_bds *bds, const int max_sat_count, const int max_eph_count, const int max_obs_count)
+{
+	bds->sat = NULL;
+	bds->max_sat_count = 0;
+	bds->max_eph_count = 0;
+	bds->max_obs_count = 0;
+
+	// try to allocate a single block for satellite data, ephemeris and observables
+	bds->arena = pony_gnss_arena_alloc(&(bds->sat), &(bds->soa), NULL, NULL, &(bds->cheb), max_sat_count, max_eph_count, max_obs_count);
+	if (bds->arena == NULL)
+		return 0;
+	pony_init_gnss_cheb(&(bds->cheb), bds->cfg, bds->cfglength);
+	bds->max_sat_count = max_sat_count;
+	bds->max_eph_count = max_eph_count;
+	bds->max_obs_count = max_obs_count;
+
+	// observation types
+	bds->obs_types = NULL;
+	bds->obs_count = 0;
+
+	// validity flags
+	bds->iono_valid = 0;
+	bds->clock_corr_valid = 0;
+
+	return 1;
+}
+
+	// free gnss beidou memory
+void pony_free_gnss_bds(pony_gnss_bds *bds)
+{
+	if (bds == NULL)
+		return;
+
+	// satellites, ephemeris and observables
+	free(bds->arena);
+	bds->arena = NULL;
+	bds->sat = NULL;
+	bds->soa.count = 0;
+	bds->cheb.seg = NULL;
+
+	// gnss beidou structure
+	free(bds);
+}
+
+	// initialize gnss constants
+void pony_init_gnss_const(pony_struct *bus)
+{
+	bus->gnss_const.pi			= 3.1415926535898;		// pi, circumference to diameter ratio, as in as in IS-GPS-200J, Galileo OS SIS ICD Issue 1.2 (November 2015), BeiDou SIS ICD OSS Version 2.1 (November 2016)
+	bus->gnss_const.c			= 299792458;			// speed of light as in IS-GPS-200J (22 May 2018), ICD GLONASS Edition 5.1 2008, Galileo OS SIS ICD Issue 1.2 (November 2015), BeiDou SIS ICD OSS Version 2.1 (November 2016), m/s
+	bus->gnss_const.sec_in_w	= 604800;				// seconds in a week
+	bus->gnss_const.sec_in_d	= 86400;				// seconds in a day
+
+	// constellation-specific constants
+	pony_init_gnss_gps_const(&(bus->gnss_const.gps), bus->gnss_const.c);
+	pony_init_gnss_glo_const(&(bus->gnss_const.glo));
+	pony_init_gnss_gal_const(&(bus->gnss_const.gal), bus->gnss_const.c);
+	pony_init_gnss_bds_const(&(bus->gnss_const.bds), bus->gnss_const.c);
+
+}
+
+	// initialize gnss structure
+char pony_init_gnss(pony_gnss *gnss)
+{
+	// memory allocation limitations
+	enum		system_id				{gps,	glo,	gal,	bds	};
+	const int	max_sat_count[] =		{36,	36,		36,		64	},
+				max_eph_count[] =		{36,	24,		36,		36	},
+				max_obs_count[] =		{0,		0,		0,		0	};	// observables allocated at runtime by default
+
+	int grouplen;
+	int sat_count, eph_count, obs_count;
+	char* groupptr;
+
+	if (gnss == NULL)
+		return 0;
+
+	// gps
+	gnss->gps = NULL;
+	if ( pony_locatecfggroup("gps:", gnss->cfg, gnss->cfglength, &groupptr, &grouplen) )
+	{
+		gnss->gps = (pony_gnss_gps*)calloc( 1, sizeof(pony_gnss_gps) );
+		if (gnss->gps == NULL)
+			return 0;
+		gnss->gps->cfg = groupptr;
+		gnss->gps->cfglength = grouplen;
+
+		sat_count = max_sat_count[gps];
+		eph_count = max_eph_count[gps];
+		obs_count = max_obs_count[gps];
+		pony_init_gnss_limits(groupptr, grouplen, &sat_count, &eph_count, &obs_count);
+		if ( !pony_init_gnss_gps(gnss->gps, sat_count, eph_count, obs_count) )
+			return 0;
+	}
+
+	// glonass
+	gnss->glo = NULL;
+	if (pony_locatecfggroup( "glo:", gnss->cfg, gnss->cfglength, &groupptr, &grouplen) )
+	{
+		gnss->glo = (pony_gnss_glo*)calloc( 1, sizeof(pony_gnss_glo) );
+		if (gnss->glo == NULL)
+			return 0;
+		gnss->glo->cfg = groupptr;
+		gnss->glo->cfglength = grouplen;
+
+		sat_count = max_sat_count[glo];
+		eph_count = max_eph_count[glo];
+		obs_count = max_obs_count[glo];
+		pony_init_gnss_limits(groupptr, grouplen, &sat_count, &eph_count, &obs_count);
+		if ( !pony_init_gnss_glo(gnss->glo, sat_count, eph_count, obs_count) )
+			return 0;
+	}
+
+	// galileo
+	gnss->gal = NULL;
+	if ( pony_locatecfggroup("gal:", gnss->cfg, gnss->cfglength, &groupptr, &grouplen) )
+	{
+		gnss->gal = (pony_gnss_gal*)calloc( 1, sizeof(pony_gnss_gal) );
+		if (gnss->gal == NULL)
+			return 0;
+		gnss->gal->cfg = groupptr;
+		gnss->gal->cfglength = grouplen;
+
+		sat_count = max_sat_count[gal];
+		eph_count = max_eph_count[gal];
+		obs_count = max_obs_count[gal];
+		pony_init_gnss_limits(groupptr, grouplen, &sat_count, &eph_count, &obs_count);
+		if ( !pony_init_gnss_gal(gnss->gal, sat_count, eph_count, obs_count) )
+			return 0;
+	}
+
+	// beidou
+	gnss->bds = NULL;
+	if ( pony_locatecfggroup("bds:", gnss->cfg, gnss->cfglength, &groupptr, &grouplen) )
+	{
+		gnss->bds = (pony_gnss_bds*)calloc( 1, sizeof(pony_gnss_bds) );
+		if (gnss->bds == NULL)
+			return 0;
+		gnss->bds->cfg = groupptr;
+		gnss->bds->cfglength = grouplen;
+
+		sat_count = max_sat_count[bds];
+		eph_count = max_eph_count[bds];
+		obs_count = max_obs_count[bds];
+		pony_init_gnss_limits(groupptr, grouplen, &sat_count, &eph_count, &obs_count);
+		if ( !pony_init_gnss_bds(gnss->bds, sat_count, eph_count, obs_count) )
+			return 0;
+	}
+
+	// gnss settings
+	pony_init_gnss_settings(gnss);
+
+	// gnss solution
+	pony_init_solution( &(gnss->sol) );
+
+	// gnss epoch
+	pony_init_epoch( &(gnss->epoch) );
+	pony_init_time( &(gnss->time) );
+
+	gnss->leap_sec = 0;
+	gnss->leap_sec_valid = 0;
+
+	return 1;
+}
+
+	// free gnss memory
+void pony_free_gnss(pony_gnss *gnss)
+{
+	if (gnss == NULL)
+		return;
+
+	pony_free_gnss_gps(gnss->gps);
+	gnss->gps = NULL;
+
+	pony_free_gnss_glo(gnss->glo);
+	gnss->glo = NULL;
+
+	pony_free_gnss_gal(gnss->gal);
+	gnss->gal = NULL;
+
+	pony_free_gnss_bds(gnss->bds);
+	gnss->bds = NULL;
+}
+
+
+
+
+// plugin timing instrumentation
+	// reference clock, s
+double pony_stats_reference(void)
+{
+#ifdef CLOCK_MONOTONIC
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec + ts.tv_nsec*1e-9;
+#else
+	return (double)clock()/CLOCKS_PER_SEC;
+#endif
+}
+
+	// time counter: processor time stamp counter where available, reference clock ticks otherwise
+unsigned long long pony_stats_counter(void)
+{
+#if defined(PONY_RDTSC)
+	return (unsigned long long)__rdtsc();
+#elif defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (unsigned long long)ts.tv_sec*1000000000ULL + (unsigned long long)ts.tv_nsec;
+#else
+	return (unsigned long long)clock();
+#endif
+}
+
+	// duration of a time counter tick, s, the time stamp counter is calibrated against the reference clock
+double pony_stats_calibrate(void)
+{
+#if defined(PONY_RDTSC)
+	const double calibration_time = 0.01;	// s
+
+	double t0, t1;
+	unsigned long long c0, c1;
+
+	t0 = pony_stats_reference();
+	c0 = pony_stats_counter();
+	do
+		t1 = pony_stats_reference();
+	while (t1 - t0 < calibration_time);
+	c1 = pony_stats_counter();
+
+	return (c1 > c0) ? (t1 - t0)/(double)(c1 - c0) : 0;
+#elif defined(CLOCK_MONOTONIC)
+	return 1e-9;
+#else
+	return 1.0/CLOCKS_PER_SEC;
+#endif
+}
+
+	// reset timing statistics
+void pony_stats_reset(pony_plugin_stats *stats)
+{
+	int k;
+
+	stats->count	= 0;
+	stats->last		= 0;
+	stats->min		= 0;
+	stats->max		= 0;
+	stats->mean		= 0;
+	stats->overruns	= 0;
+	for (k = 0; k < pony_stats_bins; k++)
+		stats->hist[k] = 0;
+}
+
+	// account a plugin call in timing statistics, if enabled
+	// input:
+	//		bus			- pointer to bus instance
+	//		id			- plugin index in the execution list
+	//		duration	- call duration, s
+void pony_stats_record(pony_struct *bus, const int id, const double duration)
+{
+	pony_plugin_stats *stats;
+	double bin;
+	int k;
+
+	if (bus->core.stats == NULL || id < 0 || id >= bus->core.plugin_count)
+		return;
+
+	stats = &(bus->core.stats[id]);
+	stats->count++;
+	stats->last = duration;
+	if (stats->count == 1 || duration < stats->min)
+		stats->min = duration;
+	if (stats->count == 1 || duration > stats->max)
+		stats->max = duration;
+	stats->mean += (duration - stats->mean)/stats->count;
+	if (bus->core.stats_overrun > 0 && duration > bus->core.stats_overrun)
+		stats->overruns++;
+	for (k = 0, bin = 1e-6; k < pony_stats_bins-1 && duration >= bin; k++, bin *= 2);
+	stats->hist[k]++;
+}
+
+
+
+
+// worker thread pool for parallel plugin execution
+	// a task is a pair of integers: plugin index in the execution list and gnss instance index (-1 for plugins called once per step)
+	// run a task on the current thread
+	// output:
+	//		task duration, s, if plugin timing is enabled, zero otherwise
+double pony_pool_task(pony_struct *bus, const int *task)
+{
+	unsigned long long start = 0;
+	pony_plugin_stats *stats = bus->core.stats;
+
+	if (stats != NULL)
+		start = pony_stats_counter();
+
+	if (task[1] < 0)
+		bus->core.plugins[task[0]].func();
+	else {
+		pony_gnss_current = &(bus->gnss[task[1]]);
+		bus->core.plugins[task[0]].func();
+		pony_gnss_current = NULL;
+	}
+
+	return (stats != NULL) ? (double)(pony_stats_counter() - start)*bus->core.stats_scale : 0;
+}
+
+#ifdef PONY_THREADS
+typedef struct				// task queue of a thread, taken from the head by the owner and stolen from the tail by others
+{
+	pthread_mutex_t lock;	// queue lock
+	int head;				// first task in the queue
+	int tail;				// next to the last task in the queue
+} pony_pool_queue;
+
+typedef struct				// worker thread pool
+{
+	pony_struct *bus;		// bus instance selected for the worker threads
+	pthread_t *threads;		// worker threads
+	int thread_count;		// number of worker threads, the host thread is not counted
+	pony_pool_queue *queue;	// task queues for each worker thread and the host thread (the last one)
+
+	int *tasks;				// tasks of the current list, two integers each
+
+	pthread_mutex_t lock;	// lock for all the fields below
+	pthread_cond_t start;	// signalled when a new task list is posted or the pool is stopped
+	pthread_cond_t done;	// signalled when the last task of the list is completed
+	int pending;			// number of tasks not completed yet
+	unsigned long list_id;	// task list counter, changed whenever a new list is posted
+	int started;			// number of worker threads started, to assign queues
+	char stop;				// pool termination flag
+} pony_pool;
+
+	// take a task from the own queue, or steal one from another thread when the own queue is empty
+	// output:
+	//		index of the task taken, -1 if all queues are empty
+int pony_pool_take(pony_pool *pool, const int self)
+{
+	int i, q, task = -1;
+
+	for (i = 0, q = self; i <= pool->thread_count && task < 0; i++, q = (q < pool->thread_count) ? q+1 : 0) {
+		pthread_mutex_lock(&(pool->queue[q].lock));
+		if (pool->queue[q].head < pool->queue[q].tail)
+			task = (q == self) ? pool->queue[q].head++ : --(pool->queue[q].tail);
+		pthread_mutex_unlock(&(pool->queue[q].lock));
+	}
+
+	return task;
+}
+
+	// execute tasks until all queues are empty
+void pony_pool_work(pony_pool *pool, const int self)
+{
+	int task;
+
+	double duration;
+
+	while ( (task = pony_pool_take(pool, self)) >= 0 ) {
+		duration = pony_pool_task(pool->bus, pool->tasks + 2*task);
+		pthread_mutex_lock(&pool->lock);
+		pony_stats_record(pool->bus, pool->tasks[2*task], duration);
+		if (--pool->pending == 0)
+			pthread_cond_signal(&pool->done);
+		pthread_mutex_unlock(&pool->lock);
+	}
+}
+
+	// worker thread function
+void *pony_pool_worker(void *arg)
+{
+	pony_pool *pool = (pony_pool *)arg;
+	unsigned long list_id;
+	int self;
+
+	pony_bus_select(pool->bus);
+
+	pthread_mutex_lock(&pool->lock);
+	self = pool->started++;
+	list_id = pool->list_id;
+	while (1) {
+		while (!pool->stop && pool->list_id == list_id)
+			pthread_cond_wait(&pool->start, &pool->lock);
+		if (pool->stop)
+			break;
+		list_id = pool->list_id;
+		pthread_mutex_unlock(&pool->lock);
+		pony_pool_work(pool, self);
+		pthread_mutex_lock(&pool->lock);
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return NULL;
+}
+#endif
+
+	// start worker thread pool
+	// input:
+	//		bus				- bus instance to run plugins for
+	//		thread_count	- number of threads to run plugins on, including the host thread
+	// output:
+	//		pointer to the pool, NULL if not started (single thread requested, no thread support or failed to allocate memory)
+void *pony_pool_start(pony_struct *bus, const int thread_count)
+{
+#ifdef PONY_THREADS
+	pony_pool *pool;
+	int i;
+
+	if (thread_count < 2)
+		return NULL;
+
+	pool = (pony_pool *)calloc( 1, sizeof(pony_pool) );
+	if (pool == NULL)
+		return NULL;
+	pool->threads	= (pthread_t *)		 calloc( thread_count-1,	sizeof(pthread_t) );
+	pool->queue		= (pony_pool_queue *)calloc( thread_count,		sizeof(pony_pool_queue) );
+	if (pool->threads == NULL || pool->queue == NULL) {
+		free(pool->threads);
+		free(pool->queue);
+		free(pool);
+		return NULL;
+	}
+	pool->bus = bus;
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->start, NULL);
+	pthread_cond_init(&pool->done, NULL);
+	for (i = 0; i < thread_count; i++)
+		pthread_mutex_init(&(pool->queue[i].lock), NULL);
+
+	for (pool->thread_count = 0; pool->thread_count < thread_count-1; pool->thread_count++)
+		if (pthread_create( &(pool->threads[pool->thread_count]), NULL, pony_pool_worker, pool ) != 0)
+			break;
+
+	return pool;
+#else
+	(void)bus;
+	(void)thread_count;
+	return NULL;
+#endif
+}
+
+	// execute tasks on the worker thread pool and the host thread, returns when all of them are completed
+	// tasks are split evenly between threads, threads that run out of tasks steal them from others
+	// input:
+	//		pool		- pointer to the pool, tasks are executed on the host thread if NULL
+	//		bus			- bus instance to run plugins for
+	//		tasks		- tasks to execute, independent of each other, two integers each: plugin index and gnss instance index (-1 if none)
+	//		task_count	- number of tasks to execute
+void pony_pool_run(void *pool, pony_struct *bus, int *tasks, const int task_count)
+{
+	int i;
+#ifdef PONY_THREADS
+	pony_pool *p = (pony_pool *)pool;
+	int threads, first;
+
+	if (p != NULL && p->thread_count > 0 && task_count > 1) {
+		threads = p->thread_count + 1;
+		pthread_mutex_lock(&p->lock);
+		p->tasks = tasks;
+		for (i = 0, first = 0; i < threads; i++) {
+			pthread_mutex_lock(&(p->queue[i].lock));
+			p->queue[i].head = first;
+			first += task_count/threads + ( (i < task_count%threads) ? 1 : 0 );
+			p->queue[i].tail = first;
+			pthread_mutex_unlock(&(p->queue[i].lock));
+		}
+		p->pending = task_count;
+		p->list_id++;
+		pthread_cond_broadcast(&p->start);
+		pthread_mutex_unlock(&p->lock);
+
+		pony_pool_work(p, p->thread_count);
+
+		pthread_mutex_lock(&p->lock);
+		while (p->pending > 0)
+			pthread_cond_wait(&p->done, &p->lock);
+		pthread_mutex_unlock(&p->lock);
+		return;
+	}
+#else
+	(void)pool;
+#endif
+	for (i = 0; i < task_count; i++)
+		pony_stats_record(bus, tasks[2*i], pony_pool_task(bus, tasks + 2*i));
+}
+
+	// stop worker threads and free the pool
+void pony_pool_stop(void *pool)
+{
+#ifdef PONY_THREADS
+	pony_pool *p = (pony_pool *)pool;
+	int i;
+
+	if (p == NULL)
+		return;
+
+	pthread_mutex_lock(&p->lock);
+	p->stop = 1;
+	pthread_cond_broadcast(&p->start);
+	pthread_mutex_unlock(&p->lock);
+	for (i = 0; i < p->thread_count; i++)
+		pthread_join(p->threads[i], NULL);
+
+	for (i = 0; i <= p->thread_count; i++)
+		pthread_mutex_destroy(&(p->queue[i].lock));
+	pthread_cond_destroy(&p->done);
+	pthread_cond_destroy(&p->start);
+	pthread_mutex_destroy(&p->lock);
+	free(p->queue);
+	free(p->threads);
+	free(p);
+#else
+	(void)pool;
+#endif
+}
+
+
+
+
+// timing wheel for plugin scheduling
+	// plugins with a positive cycle are kept in the wheel slot of their next due step, lists are ordered as the execution list,
+	// so that a step only visits the plugins actually due; ticks of a plugin are counted from the step it has been (re)scheduled at
+
+	// first step the tick of a plugin is to be counted at: the current one, unless the plugin has been passed in the current step already
+unsigned long pony_wheel_tick(pony_struct *bus, const int id)
+{
+	return (id < bus->core.current_plugin_id) ? bus->core.tick + 1 : bus->core.tick;
+}
+
+	// first step a plugin has not been checked at
+unsigned long pony_wheel_first(pony_struct *bus, const int id)
+{
+	return (id <= bus->core.current_plugin_id) ? bus->core.tick + 1 : bus->core.tick;
+}
+
+	// set the next due step of a plugin, with ticks counted from a given step
+void pony_wheel_phase(pony_struct *bus, const int id, const unsigned long base)
+{
+	pony_plugin *plugin = &(bus->core.plugins[id]);
+	unsigned long first;
+
+	first = pony_wheel_first(bus, id);
+	plugin->due = base + plugin->shift;
+	if (plugin->due < first)
+		plugin->due += abs(plugin->cycle);
+}
+
+	// unlink a plugin from a wheel slot, given its predecessor in the list (-1 if the first one)
+void pony_wheel_unlink(pony_struct *bus, const int slot, const int prev, const int id)
+{
+	int *head = bus->core.wheel, *tail = bus->core.wheel + bus->core.wheel_size;
+
+	if (prev < 0)
+		head[slot] = bus->core.plugins[id].next;
+	else
+		bus->core.plugins[prev].next = bus->core.plugins[id].next;
+	if (tail[slot] == id)
+		tail[slot] = prev;
+	bus->core.plugins[id].next = -1;
+}
+
+	// insert an active plugin into the slot of its due step, keeping the order of the execution list
+void pony_wheel_insert(pony_struct *bus, const int id)
+{
+	int *head, *tail;
+	int slot, prev, node;
+
+	if (bus->core.wheel == NULL || bus->core.plugins[id].cycle <= 0)
+		return;
+
+	head = bus->core.wheel;
+	tail = bus->core.wheel + bus->core.wheel_size;
+	slot = (int)(bus->core.plugins[id].due & (unsigned long)(bus->core.wheel_size - 1));
+
+	if (head[slot] < 0) {					// empty slot
+		head[slot] = tail[slot] = id;
+		bus->core.plugins[id].next = -1;
+	}
+	else if (id > tail[slot]) {				// append, most usual when plugins are passed in order
+		bus->core.plugins[tail[slot]].next = id;
+		tail[slot] = id;
+		bus->core.plugins[id].next = -1;
+	}
+	else {
+		for (prev = -1, node = head[slot]; node < id; prev = node, node = bus->core.plugins[node].next);
+		bus->core.plugins[id].next = node;
+		if (prev < 0)
+			head[slot] = id;
+		else
+			bus->core.plugins[prev].next = id;
+	}
+	bus->core.wheel_version++;
+}
+
+	// remove an active plugin from the wheel
+void pony_wheel_remove(pony_struct *bus, const int id)
+{
+	int slot, prev, node;
+
+	if (bus->core.wheel == NULL || bus->core.plugins[id].cycle <= 0)
+		return;
+
+	slot = (int)(bus->core.plugins[id].due & (unsigned long)(bus->core.wheel_size - 1));
+	for (prev = -1, node = bus->core.wheel[slot]; node >= 0 && node != id; prev = node, node = bus->core.plugins[node].next);
+	if (node == id)
+		pony_wheel_unlink(bus, slot, prev, id);
+	bus->core.wheel_version++;
+}
+
+	// drop the wheel, e.g. when plugins are moved in the execution list, to be rebuilt on the next step
+void pony_wheel_drop(pony_struct *bus)
+{
+	if (bus->core.wheel != NULL)
+		free(bus->core.wheel);
+	bus->core.wheel = NULL;
+	bus->core.wheel_size = 0;
+	bus->core.wheel_version++;
+}
+
+	// (re)build the wheel for the current execution list, with slots enough for the longest cycle, up to a limit
+	// plugins with longer cycles stay in their slots until due
+	//	output: 
+	//		1 - OK
+	//		0 - not OK (failed to allocate memory)
+char pony_wheel_build(pony_struct *bus)
+{
+	const int max_wheel_size = 4096;
+
+	int i, size, max_cycle;
+
+	for (i = 0, max_cycle = 1; i < bus->core.plugin_count; i++)
+		if (bus->core.plugins[i].cycle > max_cycle)
+			max_cycle = bus->core.plugins[i].cycle;
+	for (size = 16; size < max_cycle && size < max_wheel_size; size *= 2);
+
+	pony_wheel_drop(bus);
+	bus->core.wheel = (int *)malloc( 2 * size * sizeof(int) );
+	if (bus->core.wheel == NULL)
+		return 0;
+	bus->core.wheel_size = size;
+	for (i = 0; i < 2*size; i++)
+		bus->core.wheel[i] = -1;
+
+	for (i = 0; i < bus->core.plugin_count; i++)
+		pony_wheel_insert(bus, i);
+
+	return 1;
+}
+
+	// set scheduling parameters of a plugin, ticks to be counted from the current step
+void pony_wheel_schedule(pony_struct *bus, const int id, const int cycle, const int shift)
+{
+	pony_plugin *plugin = &(bus->core.plugins[id]);
+
+	pony_wheel_remove(bus, id);
+	plugin->cycle = cycle;
+	plugin->shift = shift;
+	plugin->since = pony_wheel_tick(bus, id);
+	pony_wheel_phase(bus, id, plugin->since);
+	if (bus->core.wheel != NULL && cycle > bus->core.wheel_size)	// grow the wheel on the next step
+		pony_wheel_drop(bus);
+	pony_wheel_insert(bus, id);
+}
+
+	// suspend a plugin
+void pony_wheel_suspend(pony_struct *bus, const int id)
+{
+	pony_plugin *plugin = &(bus->core.plugins[id]);
+
+	if (plugin->cycle <= 0)
+		return;
+	pony_wheel_remove(bus, id);
+	plugin->cycle = -plugin->cycle;
+	plugin->since = pony_wheel_tick(bus, id);
+}
+
+	// resume a plugin, ticks are counted anew if the plugin has been passed while suspended, otherwise keep going,
+	// with the due step moved past the steps already checked, e.g. for a plugin scheduled suspended and resuming itself at init
+void pony_wheel_resume(pony_struct *bus, const int id)
+{
+	pony_plugin *plugin = &(bus->core.plugins[id]);
+	unsigned long tick, first;
+
+	if (plugin->cycle >= 0)
+		return;
+	plugin->cycle = -plugin->cycle;
+	tick = pony_wheel_tick(bus, id);
+	first = pony_wheel_first(bus, id);
+	if (tick != plugin->since)
+		pony_wheel_phase(bus, id, tick);
+	else if (plugin->due < first)
+		plugin->due += (first - plugin->due + plugin->cycle - 1)/plugin->cycle*plugin->cycle;
+	pony_wheel_insert(bus, id);
+}
+
+	// advance a due plugin to the next step it is due at, given its position in the wheel
+void pony_wheel_advance(pony_struct *bus, const int slot, const int prev, const int id)
+{
+	pony_wheel_unlink(bus, slot, prev, id);
+	bus->core.plugins[id].due += bus->core.plugins[id].cycle;
+	pony_wheel_insert(bus, id);
+}
+
+	// find the next plugin due at the current step after the current plugin
+	//	input: 
+	//		bus - pointer to bus instance
+	//		prev - predecessor of the candidate in the current slot, -1 for the first one
+	//	output: 
+	//		index of the plugin, -1 if none left
+	//		prev - predecessor of the plugin found
+int pony_wheel_next(pony_struct *bus, int *prev)
+{
+	int slot, node;
+
+	slot = (int)(bus->core.tick & (unsigned long)(bus->core.wheel_size - 1));
+	for (node = (*prev < 0) ? bus->core.wheel[slot] : bus->core.plugins[*prev].next; node >= 0; *prev = node, node = bus->core.plugins[node].next)
+		if (bus->core.plugins[node].due == bus->core.tick)
+			return node;
+
+	return -1;
+}
+
+	// find the position in the current slot after the current plugin, when the wheel has been modified by a plugin
+	//	output: 
+	//		predecessor of the next candidate in the current slot, -1 for the first one
+	//		or -2 if failed to rebuild the wheel
+int pony_wheel_seek(pony_struct *bus)
+{
+	int slot, prev, node;
+
+	if (bus->core.wheel == NULL && !pony_wheel_build(bus))
+		return -2;
+
+	slot = (int)(bus->core.tick & (unsigned long)(bus->core.wheel_size - 1));
+	for (prev = -1, node = bus->core.wheel[slot]; node >= 0 && node <= bus->core.current_plugin_id; prev = node, node = bus->core.plugins[node].next);
+
+	return prev;
+}
+
+
+
+
+// general handling routines
+	// free all alocated memory and set pointers and counters to NULL
+void pony_free(pony_struct *bus)
+{
+	int i;
+
+	// core
+	if (bus->core.plugins != NULL)
+		free(bus->core.plugins);
+	bus->core.plugins = NULL;
+	bus->core.plugin_count = 0;
+	pony_pool_stop(bus->core.pool);
+	bus->core.pool = NULL;
+	if (bus->core.batch != NULL)
+		free(bus->core.batch);
+	bus->core.batch = NULL;
+	bus->core.batch_size = 0;
+	bus->core.batch_gnss_count = 0;
+	pony_wheel_drop(bus);
+	bus->core.tick = 0;
+	bus->core.current_plugin_id = -1;
+	if (bus->core.stats != NULL)
+		free(bus->core.stats);
+	bus->core.stats = NULL;
+
+	// configuration string
+	if (bus->cfg != NULL)
+		free(bus->cfg);
+	bus->cfg = NULL;
+	bus->cfglength = 0;
+	pony_cfg_tree_free(&(bus->cfg_tree));
+
+	// imu
+	pony_free_imu(bus);
+
+	// gnss
+	if (bus->gnss != NULL)
+	{
+		for (i = 0; i < bus->gnss_count; i++)
+			pony_free_gnss( &(bus->gnss[i]) );
+		free(bus->gnss);
+		bus->gnss = NULL;
+	}
+	bus->gnss_count = 0;
+
+}
+
+
+
+
+
+
+
+
+
+
+
+///
+///     Core pony functions for host application
+///
+
+
+
+	// basic functions
+
+		// add plugin to the plugin execution list
+		//	input: 
+		//		bus - pointer to bus instance
+		//		newplugin - pointer to plugin function (no arguments, no return value)
+		//	output: 
+		//		1 - OK
+		//		0 - not OK (failed to allocate/realocate memory)
+char pony_bus_add_plugin(pony_struct *bus, void(*newplugin)(void) )
+{
+	pony_plugin *reallocated_pointer;
+	pony_plugin_stats *reallocated_stats;
+
+	reallocated_pointer = (pony_plugin *)realloc( (void *)(bus->core.plugins), (bus->core.plugin_count + 1) * sizeof(pony_plugin) );
+
+	if (reallocated_pointer == NULL)	// failed to allocate/realocate memory
+	{
+		pony_free(bus);
+		return 0;
+	}
+	else
+		bus->core.plugins = reallocated_pointer;
+
+	// timing statistics, if enabled
+	if (bus->core.stats != NULL) {
+		reallocated_stats = (pony_plugin_stats *)realloc( (void *)(bus->core.stats), (bus->core.plugin_count + 1) * sizeof(pony_plugin_stats) );
+		if (reallocated_stats == NULL) {
+			pony_free(bus);
+			return 0;
+		}
+		bus->core.stats = reallocated_stats;
+		pony_stats_reset( &(bus->core.stats[bus->core.plugin_count]) );
+	}
+
+	bus->core.plugins[bus->core.plugin_count].func  = newplugin;
+	bus->core.plugins[bus->core.plugin_count].cycle = 1;
+	bus->core.plugins[bus->core.plugin_count].shift = 0;
+	bus->core.plugins[bus->core.plugin_count].since = pony_wheel_tick(bus, bus->core.plugin_count);
+	bus->core.plugins[bus->core.plugin_count].due   = bus->core.plugins[bus->core.plugin_count].since;
+	bus->core.plugins[bus->core.plugin_count].next  = -1;
+	bus->core.plugins[bus->core.plugin_count].reads  = pony_data_all;
+	bus->core.plugins[bus->core.plugin_count].writes = pony_data_all;
+	bus->core.plugins[bus->core.plugin_count].per_gnss = 0;
+	bus->core.plugin_count++;
+	pony_wheel_insert(bus, bus->core.plugin_count-1);
+
+	return 1;
+}
+
+
+		// add plugin to be called once for each gnss instance to the plugin execution list,
+		// the plugin gets the instance it is called for in pony_gnss_current, calls for different instances may run in parallel when worker threads are available
+		//	input: 
+		//		bus - pointer to bus instance
+		//		newplugin - pointer to plugin function (no arguments, no return value)
+		//	output: 
+		//		1 - OK
+		//		0 - not OK (failed to allocate/realocate memory)
+char pony_bus_add_gnss_plugin( pony_struct *bus, void(*newplugin)(void) )
+{
+	if (!pony_bus_add_plugin(bus, newplugin))
+		return 0;
+	bus->core.plugins[bus->core.plugin_count-1].per_gnss = 1;
+
+	return 1;
+}
+
+
+		// initialize the bus data, except for core, the bus is to be selected for the current thread
+char pony_init_data(pony_struct *bus, char* cfg)
+{
+	const int max_gnss_count = 10;
+	
+	char multi_gnss_token[] = "gnss[0]:";
+	const int multi_gnss_index_position = 5;
+
+	int grouplen;
+	char* groupptr;
+
+	pony_gnss *reallocated_pointer;
+
+	int i;
+
+	// determine configuration string length
+	for (bus->cfglength = 0; cfg[bus->cfglength]; bus->cfglength++);
+
+	// assign configuration string
+	bus->cfg = (char *)malloc( sizeof(char) * (bus->cfglength + 1) );
+	if (bus->cfg == NULL)
+		return 0;
+	for (i = 0; i < bus->cfglength; i++)
+		bus->cfg[i] = cfg[i];
+	bus->cfg[bus->cfglength] = '\0';
+
+	// configuration tree for fast group and token lookup
+	if ( !pony_cfg_tree_build(&(bus->cfg_tree), bus->cfg, bus->cfglength) ) {
+		pony_free(bus);
+		return 0;
+	}
+
+	// fetch a part of configuration that is outside of any group
+	bus->cfg_settings = NULL;
+	bus->settings_length = 0;
+	pony_locatecfggroup("", bus->cfg, bus->cfglength, &bus->cfg_settings, &bus->settings_length);
+
+	// worker threads for parallel plugin execution, if requested
+	groupptr = pony_locate_token("threads", bus->cfg_settings, bus->settings_length, '=');
+	if (groupptr != NULL && bus->core.pool == NULL)
+		bus->core.pool = pony_pool_start(bus, atoi(groupptr));
+	
+	// imu init
+	pony_init_imu_const(bus);
+	bus->imu = NULL;
+	if ( pony_locatecfggroup("imu:", bus->cfg, bus->cfglength, &groupptr, &grouplen) ) // if the group found in configuration
+	{
+		// try to allocate memory
+		bus->imu = (pony_imu*)calloc( 1, sizeof(pony_imu) );
+		if (bus->imu == NULL) {
+			pony_free(bus);
+			return 0;
+		}
+
+		// set configuration pointer
+		bus->imu->cfg = groupptr;
+		bus->imu->cfglength = grouplen;
+
+		// try to init
+		if ( !pony_init_imu(bus->imu, &(bus->imu_const)) ) {
+			pony_free(bus);
+			return 0;
+		}
+	}
+
+	// gnss init
+	pony_init_gnss_const(bus);
+	bus->gnss = NULL;
+	bus->gnss_count = 0;
+		// multiple gnss mode support
+	for (i = 0; i < max_gnss_count; i++)
+	{
+		multi_gnss_token[multi_gnss_index_position] = '0' + (char)i;
+
+		if ( (i == 0 && pony_locatecfggroup("gnss:", bus->cfg, bus->cfglength, &groupptr, &grouplen) ) ||
+			pony_locatecfggroup(multi_gnss_token, bus->cfg, bus->cfglength, &groupptr, &grouplen) ) {
+			if (i >= bus->gnss_count) {
+				// try to allocate/reallocate memory
+				reallocated_pointer = (pony_gnss*)realloc(bus->gnss, sizeof(pony_gnss)*(i+1));
+				if (reallocated_pointer == NULL) {
+					pony_free(bus);
+					return 0;
+				}
+				else
+					bus->gnss = reallocated_pointer;
+				// try to init new instances, except the i-th one
+				for ( ; bus->gnss_count < i; bus->gnss_count++) {
+					bus->gnss[bus->gnss_count].cfg = NULL;
+					bus->gnss[bus->gnss_count].cfglength = 0;
+					pony_init_gnss( &(bus->gnss[bus->gnss_count]) );
+				}
+				bus->gnss_count = i+1;
+			}
+
+			// set configuration pointer
+			bus->gnss[i].cfg = groupptr;
+			bus->gnss[i].cfglength = grouplen;
+
+			// try to init
+			if ( !pony_init_gnss( &(bus->gnss[i]) ) ) {
+				pony_free(bus);
+				return 0;
+			}
+		}
+	}
+
+	// system time, operation mode and solution
+	bus->t = 0;
+	bus->mode = 0;
+	pony_init_solution( &(bus->sol) );
+	
+	return 1;
+}
+
+		// initialize the bus, except for core
+		//	input: 
+		//		bus - pointer to bus instance
+		//		cfg - configuration string (see pony description)
+		//	output: 
+		//		1 - OK
+		//		0 - not OK (memory allocation or partial init failed)
+char pony_bus_init(pony_struct *bus, char* cfg)
+{
+	pony_struct *prev;
+	char res;
+
+	// configuration lookups use the tree of the bus selected for the current thread
+	prev = pony_bus_select(bus);
+	res = pony_init_data(bus, cfg);
+	pony_bus_select(prev);
+
+	return res;
+}
+
+
+
+		// check if two plugins depend on each other, i.e. one of them writes bus data sections accessed by the other one
+char pony_plugins_depend(pony_plugin *a, pony_plugin *b)
+{
+	return ( (a->writes & (b->reads | b->writes)) || (b->writes & a->reads) ) ? 1 : 0;
+}
+
+		// allocate memory for due plugins, their levels and tasks for parallel execution, two integers per plugin and gnss instance
+		//	output: 
+		//		1 - OK
+		//		0 - not OK (failed to allocate memory)
+char pony_step_alloc_batch(pony_struct *bus)
+{
+	int *reallocated_pointer;
+	int gnss_count;
+
+	gnss_count = (bus->gnss_count > 1) ? bus->gnss_count : 1;
+	if (bus->core.batch_size >= bus->core.plugin_count && bus->core.batch_gnss_count >= gnss_count)
+		return 1;
+
+	reallocated_pointer = (int *)realloc( (void *)(bus->core.batch), (2 + 2*gnss_count) * bus->core.plugin_count * sizeof(int) );
+	if (reallocated_pointer == NULL)
+		return 0;
+	bus->core.batch = reallocated_pointer;
+	bus->core.batch_size = bus->core.plugin_count;
+	bus->core.batch_gnss_count = gnss_count;
+
+	return 1;
+}
+
+		// fill tasks for a plugin: a single one, or one per each gnss instance in use for per-gnss plugins
+		//	output: 
+		//		number of tasks
+int pony_step_plugin_tasks(pony_struct *bus, const int plugin_id, int *tasks)
+{
+	int i, count = 0;
+
+	if (!bus->core.plugins[plugin_id].per_gnss) {
+		tasks[0] = plugin_id;
+		tasks[1] = -1;
+		return 1;
+	}
+
+	for (i = 0; i < bus->gnss_count; i++)
+		if (bus->gnss[i].cfg != NULL) {
+			tasks[2*count  ] = plugin_id;
+			tasks[2*count+1] = i;
+			count++;
+		}
+
+	return count;
+}
+
+		// account a call of the current plugin in timing statistics, the plugin might have changed its index by removing preceding ones
+void pony_step_record(pony_struct *bus, const int plugin_id, void(*func)(void), const double duration)
+{
+	int id = bus->core.current_plugin_id;
+
+	if (bus->core.stats != NULL && id >= 0 && id <= plugin_id && id < bus->core.plugin_count && bus->core.plugins[id].func == func)
+		pony_stats_record(bus, id, duration);
+}
+
+		// run a plugin, per-gnss plugins are run for all gnss instances, in parallel when worker threads are available
+void pony_step_run_plugin(pony_struct *bus, const int plugin_id)
+{
+	int i, task[2];
+	void(*func)(void) = bus->core.plugins[plugin_id].func;
+
+	task[0] = plugin_id;
+	task[1] = -1;
+	if (!bus->core.plugins[plugin_id].per_gnss)
+		pony_step_record(bus, plugin_id, func, pony_pool_task(bus, task));
+	else if (bus->core.pool != NULL && pony_step_alloc_batch(bus))
+		pony_pool_run(bus->core.pool, bus, bus->core.batch, pony_step_plugin_tasks(bus, plugin_id, bus->core.batch));
+	else
+		for (i = 0; i < bus->gnss_count; i++)
+			if (bus->gnss[i].cfg != NULL) {
+				task[1] = i;
+				pony_step_record(bus, plugin_id, func, pony_pool_task(bus, task));
+			}
+}
+
+		// check if termination has been initiated by a plugin in a parallel step, same as in the serial loop
+		// plugins up to the last one already run are to be run again on the next step until termination, the rest of the current step proceeds
+void pony_step_check_termination(pony_struct *bus, const int last_id)
+{
+	if ((bus->mode < 0 || bus->core.host_termination == 1) && bus->core.exit_plugin_id == -1) {
+		if (bus->mode > 0)
+			bus->mode = -1;					// set mode to -1 for external termination cases
+		bus->core.exit_plugin_id = last_id;	// set the index to use in the next loop
+	}
+}
+
+		// step through the plugins due in regular operation mode, in the order of the execution list
+		//	input: 
+		//		bus - pointer to bus instance
+		//	output: 
+		//		index of the plugin to continue the step from by passing through the whole execution list,
+		//		plugin count if the step is done, or 0 if failed to build the timing wheel
+int pony_step_wheel(pony_struct *bus)
+{
+	int i, prev;
+	unsigned long version;
+
+	prev = pony_wheel_seek(bus);
+	if (prev < -1)
+		return 0;
+
+	while ((i = pony_wheel_next(bus, &prev)) >= 0) {
+		// move to the next due step before running, so that the plugin is able to reschedule itself
+		pony_wheel_advance(bus, (int)(bus->core.tick & (unsigned long)(bus->core.wheel_size - 1)), prev, i);
+		version = bus->core.wheel_version;
+
+		bus->core.current_plugin_id = i;
+		pony_step_run_plugin(bus, i);
+		pony_step_check_termination(bus, i);
+
+		// the wheel has been modified by the plugin
+		if (bus->core.wheel_version != version) {
+			prev = pony_wheel_seek(bus);
+			if (prev < -1)
+				return bus->core.current_plugin_id+1;
+		}
+	}
+
+	return bus->core.plugin_count;
+}
+
+		// step through the plugins due in regular operation mode, running independent plugins in parallel
+		// due plugins are processed in segments separated by plugins that write core, those are run alone, as in the serial loop;
+		// due plugins of a segment are assigned dependency levels, preserving the list order for dependent ones, and run level by level
+		//	input: 
+		//		bus - pointer to bus instance
+		//	output: 
+		//		index of the plugin to continue the step from by passing through the whole execution list,
+		//		plugin count if the step is done, or 0 if failed to allocate memory
+int pony_step_parallel(pony_struct *bus)
+{
+	int i, k, n, m, count, level, prev, slot, last_id = -1;
+	int *due, *due_level, *tasks;
+	unsigned long version;
+
+	prev = pony_wheel_seek(bus);
+	if (prev < -1)
+		return 0;
+
+	do {
+		// memory for due plugins, their levels and the tasks to run in parallel, the list might have been changed by a plugin that writes core
+		if (!pony_step_alloc_batch(bus)) {
+			if (last_id < 0)
+				return 0;
+			bus->core.exit_plugin_id = last_id;	// terminate in case of memory failure in the middle of a step
+			bus->mode = -1;
+			break;
+		}
+		due			= bus->core.batch;
+		due_level	= due + bus->core.batch_size;
+		tasks		= due_level + bus->core.batch_size;
+
+		// collect due plugins up to the next one that writes core, moving them to their next due steps
+		slot = (int)(bus->core.tick & (unsigned long)(bus->core.wheel_size - 1));
+		for (n = 0; (i = pony_wheel_next(bus, &prev)) >= 0; n++) {
+			pony_wheel_advance(bus, slot, prev, i);
+			if (bus->core.plugins[i].writes & pony_data_core)
+				break;
+			// next to the highest level among preceding due plugins the current one depends on
+			for (k = 0, level = 0; k < n; k++)
+				if (due_level[k] >= level && pony_plugins_depend(&(bus->core.plugins[due[k]]), &(bus->core.plugins[i])))
+					level = due_level[k] + 1;
+			due[n] = i;
+			due_level[n] = level;
+		}
+
+		// run due plugins level by level, k plugins done so far
+		if (n > 0)
+			bus->core.current_plugin_id = due[0];
+		for (level = 0, k = 0; k < n; level++) {
+			for (m = 0, count = 0; m < n; m++)
+				if (due_level[m] == level) {
+					count += pony_step_plugin_tasks(bus, due[m], tasks + 2*count);
+					if (due[m] > last_id)
+						last_id = due[m];
+					k++;
+				}
+			pony_pool_run(bus->core.pool, bus, tasks, count);
+			pony_step_check_termination(bus, last_id);
+		}
+
+		// plugin that writes core, run alone
+		if (i >= 0) {
+			version = bus->core.wheel_version;
+			bus->core.current_plugin_id = i;
+			pony_step_run_plugin(bus, i);
+			last_id = i;
+			pony_step_check_termination(bus, last_id);
+			// the wheel has been modified by the plugin
+			if (bus->core.wheel_version != version) {
+				prev = pony_wheel_seek(bus);
+				if (prev < -1)
+					return bus->core.current_plugin_id+1;
+			}
+		}
+	} while (i >= 0);
+
+	return bus->core.plugin_count;
+}
+
+		// step through the plugin execution list, to be called by host application in a main loop
+		// in regular operation mode, only the plugins due are visited using the timing wheel,
+		// while initialization and termination steps pass through the whole list
+		//	input: 
+		//		bus - pointer to bus instance, selected for the current thread while plugins are running
+		//	output: 
+		//		1 - OK (either staying in regular operation mode, or a termination is properly detected)
+		//		0 - not OK (otherwise)
+char pony_bus_step(pony_struct *bus)
+{
+	int i, start = 0;
+	pony_struct *host_bus;
+
+	// select the bus for plugins running on the current thread
+	host_bus = pony_bus_select(bus);
+
+	// regular operation mode: visit due plugins only, running independent plugins in parallel if worker threads are available
+	if (bus->mode > 0 && bus->core.exit_plugin_id == -1 && !bus->core.host_termination)
+		start = (bus->core.pool != NULL) ? pony_step_parallel(bus) : pony_step_wheel(bus);
+
+	// otherwise, or for the rest of the step, loop through plugin execution list
+	for (bus->core.current_plugin_id = start; bus->core.current_plugin_id < bus->core.plugin_count; bus->core.current_plugin_id++)
+	{
+		i = bus->core.current_plugin_id;
+
+		if (bus->core.plugins[i].cycle > 0 && bus->core.plugins[i].due == bus->core.tick) {	// check if the scheduled tick has come
+			pony_wheel_remove(bus, i);												// move to the next due step
+			bus->core.plugins[i].due += bus->core.plugins[i].cycle;
+			pony_wheel_insert(bus, i);
+			pony_step_run_plugin(bus, i);											// execute the current plugin
+		}
+		else if (bus->mode == 0)													// or init mode
+			pony_step_run_plugin(bus, i);
+
+		if (bus->core.exit_plugin_id == i)	// if termination was initiated by the current plugin on the previous loop
+		{
+			bus->core.exit_plugin_id = -1;		// set to default
+			bus->core.host_termination = 0;		// set to default
+			pony_init_solution(&(bus->sol));	// drop the solution
+			pony_free(bus);						// free memory
+			break;
+		}
+
+		if ((bus->mode < 0 || bus->core.host_termination == 1) && bus->core.exit_plugin_id == -1)	// if termination was initiated by the current plugin on the current loop
+		{
+			if (bus->mode > 0)
+				bus->mode = -1;					// set mode to -1 for external termination cases
+
+			if (bus->mode != 0)
+				bus->core.exit_plugin_id = i;	// set the index to use in the next loop
+
+		}
+	}
+
+	// next step, unless the bus has been freed on termination
+	bus->core.current_plugin_id = -1;
+	if (bus->core.plugins != NULL)
+		bus->core.tick++;
+
+	if (bus->mode == 0)		// if initialization ended
+		bus->mode = 1;		// set operation mode to regular
+
+	// restore the bus previously selected for the current thread
+	pony_bus_select(host_bus);
+
+							// success if either staying in regular operation mode, or a termination is properly detected
+	return (bus->mode >= 0) || (bus->core.exit_plugin_id >= 0);
+}
+
+
+		// terminate operation
+		//	input: 
+		//		bus - pointer to bus instance
+		//	output: 
+		//		1 - OK (termination is due in the next step)
+		//		0 - not OK (had been already terminated by host or by plugin)
+char pony_bus_terminate(pony_struct *bus)
+{
+	if (bus->mode >= 0 && bus->core.host_termination != 1)
+	{
+		bus->core.host_termination = 1;
+
+		return 1; // termination is due in the next step
+	}
+
+	return 0; // had been already terminated by host or by plugin 
+}
+
+
+	// advanced functions
+
+		// remove all instances of a given plugin from the plugin execution list,	
+		//	input: 
+		//		bus - pointer to bus instance
+		//		plugin - pointer to plugin function to remove from execution list
+		//	output: 
+		//		>0 - number of plugin instances found, limited to 255
+		//		 0 - no instances found, or memory reallocation somehow failed
+char pony_bus_remove_plugin(pony_struct *bus, void(*plugin)(void))
+{
+	int i, j;
+	char flag = 0;
+
+	for (i = 0; i < bus->core.plugin_count; i++) { // go through the execution list
+		if (bus->core.plugins[i].func != plugin) // if not the requested plugin, do nothing
+			continue;
+		// otherwise, remove the current plugin from the execution list
+		for (j = i+1; j < bus->core.plugin_count; j++) // move all succeeding plugins one position lower
+			bus->core.plugins[j-1] = bus->core.plugins[j];
+		if (bus->core.stats != NULL) // as well as their timing statistics
+			for (j = i+1; j < bus->core.plugin_count; j++)
+				bus->core.stats[j-1] = bus->core.stats[j];
+		if (i <= bus->core.current_plugin_id) // keep the step going from the plugin next to the current one
+			bus->core.current_plugin_id--;
+		// reset the last one
+		j--;
+		bus->core.plugins[j].func = NULL;
+		bus->core.plugins[j].cycle = 0;
+		bus->core.plugins[j].shift = 0;
+		bus->core.plugins[j].due   = 0;
+		bus->core.plugins[j].since = 0;
+		bus->core.plugins[j].next  = -1;
+		bus->core.plugins[j].reads  = pony_data_all;
+		bus->core.plugins[j].writes = pony_data_all;
+		bus->core.plugins[j].per_gnss = 0;
+		bus->core.plugin_count--;
+		if (flag < 0xff)
+			flag++;
+	}
+
+	// plugins have been moved, the timing wheel is to be rebuilt
+	if (flag)
+		pony_wheel_drop(bus);
+
+	// reallocate memory
+	bus->core.plugins = (pony_plugin *)realloc( (void *)(bus->core.plugins), bus->core.plugin_count*sizeof(pony_plugin) );
+	if (bus->core.plugin_count > 0 &&  bus->core.plugins == NULL) { // memory reallocation somehow failed
+		pony_free(bus);
+		return 0;
+	}
+
+	return flag;
+}
+
+
+		// replace all instances of the given plugin to another one in the plugin execution list,
+		//	input: 
+		//		bus - pointer to bus instance
+		//		oldplugin - pointer to plugin function to be replaced
+		//		newplugin - pointer to plugin function to replace with
+		//	output: 
+		//		number of plugin instances found, limited to 255
+char pony_bus_replace_plugin(pony_struct *bus, void(*oldplugin)(void), void(*newplugin)(void))
+{
+
+	int i;
+	char flag = 0;
+
+	for (i = 0; i < bus->core.plugin_count; i++) {
+		if (bus->core.plugins[i].func != oldplugin)
+			continue;
+		bus->core.plugins[i].func = newplugin;
+		if (flag < 0xff)
+			flag++;
+	}
+
+	return flag;
+}
+
+
+		// add scheduled plugin to the plugin execution list
+		//	input: 
+		//		bus			- pointer to bus instance
+		//		newplugin	- pointer to plugin function
+		//		cycle		- repeating cycle (in ticks of main cycle), 
+		//					  negative for suspended plugin, 
+		//					  zero for the plugin to be turned off (for further rescheduling)
+		//		shift		- shift from the beginning of the cycle, automatically shrunk to [0..cycle-1]
+		//	output: 
+		//		1 - OK
+		//		0 - not OK (failed to allocate/realocate memory)
+char pony_bus_schedule_plugin(pony_struct *bus, void(*newplugin)(void), int cycle, int shift)
+{
+	int abs_cycle;
+
+	// add to the execution list
+	if (!pony_bus_add_plugin(bus, newplugin))
+		return 0;
+	// shrink shift to [0..cycle-1]
+	abs_cycle = abs(cycle);
+	if (abs_cycle) {
+		while (shift >= abs_cycle)
+			shift -= abs_cycle;
+		while (shift < 0)
+			shift += abs_cycle;
+	}
+	else
+		shift = 0;
+	// set scheduling parameters
+	pony_wheel_schedule(bus, bus->core.plugin_count-1, cycle, shift);
+
+	return 1;
+}
+
+
+		// reschedule all instances of the plugin in the plugin execution list
+		//	input: 
+		//		bus		- pointer to bus instance
+		//		plugin	- pointer to plugin function
+		//		cycle	- new repeating cycle (in ticks of main cycle), 
+		//				  negative for suspended plugin, 
+		//				  zero for the plugin to be turned off (for further rescheduling)
+		//		shift	- new shift from the beginning of the cycle, automatically shrunk to [0..cycle-1]
+		//	output: 
+		//		1 - OK
+		//		0 - not OK (plugin not found in the execution list)
+char pony_bus_reschedule_plugin(pony_struct *bus, void(*plugin)(void), int cycle, int shift)
+{
+	int i, abs_cycle;
+	char flag = 0;
+	// shrink shift to [0..cycle-1]
+	abs_cycle = abs(cycle);
+	if (abs_cycle) {
+		while (shift >= abs_cycle)
+			shift -= abs_cycle;
+		while (shift < 0)
+			shift += abs_cycle;
+	}
+	else
+		shift = 0;
+	// go through execution list and set scheduling parameters, if found the plugin
+	for (i = 0; i < bus->core.plugin_count; i++) 
+		if (bus->core.plugins[i].func == plugin) {
+			pony_wheel_schedule(bus, i, cycle, shift);
+			flag = 1;
+		}
+
+	return flag;
+}
+
+
+		// suspend all instances of the plugin in the plugin execution list
+		//	input: 
+		//		bus - pointer to bus instance
+		//		plugin - pointer to plugin function,							
+		//	output: 
+		//		1 - OK
+		//		0 - not OK (plugin not found)
+char pony_bus_suspend_plugin(pony_struct *bus, void(*plugin)(void))
+{
+	int i;
+	char flag = 0;
+	// go through execution list and set cycle to negative, if found the plugin
+	for (i = 0; i < bus->core.plugin_count; i++) 
+		if (bus->core.plugins[i].func == plugin) {
+			pony_wheel_suspend(bus, i);
+			flag = 1;
+		}
+
+	return flag;
+}
+
+
+		// resume all instances of the plugin in the plugin execution list	
+		//	input: 
+		//		bus - pointer to bus instance
+		//		plugin - pointer to plugin function,							
+		//	output: 
+		//		1 - OK
+		//		0 - not OK (plugin not found)
+char pony_bus_resume_plugin(pony_struct *bus, void(*plugin)(void))
+{
+	int i;
+	char flag = 0;
+	// go through execution list and set cycle to positive, if found the plugin
+	for (i = 0; i < bus->core.plugin_count; i++) 
+		if (bus->core.plugins[i].func == plugin) {
+			pony_wheel_resume(bus, i);
+			flag = 1;
+		}
+
+	return flag;
+}
+
+
+		// declare bus data sections accessed by all instances of the plugin in the plugin execution list,
+		// plugins with no data in common are allowed to run in parallel when worker threads are available (threads = ... in configuration),
+		// plugins that write core (i.e. call scheduling functions) always run alone, as well as plugins that have not been declared
+		//	input: 
+		//		bus		- pointer to bus instance
+		//		plugin	- pointer to plugin function
+		//		reads	- bus data sections read by the plugin, a combination of pony_data_... flags
+		//		writes	- bus data sections written by the plugin, a combination of pony_data_... flags
+		//	output: 
+		//		1 - OK
+		//		0 - not OK (plugin not found)
+char pony_bus_declare_plugin(pony_struct *bus, void(*plugin)(void), unsigned long reads, unsigned long writes)
+{
+	int i;
+	char flag = 0;
+
+	for (i = 0; i < bus->core.plugin_count; i++) 
+		if (bus->core.plugins[i].func == plugin) {
+			bus->core.plugins[i].reads  = reads | pony_data_core;
+			bus->core.plugins[i].writes = writes;
+			flag = 1;
+		}
+
+	return flag;
+}
+
+
+		// enable or disable plugin timing statistics: call count, duration and its histogram for each plugin in the execution list
+		// timing adds reading a time counter around each plugin call, nothing is done when disabled
+		//	input: 
+		//		bus		- pointer to bus instance
+		//		enable	- 1 to enable (statistics are reset), 0 to disable (statistics are dropped)
+		//		overrun	- call duration to be counted as an overrun, s, zero if not to be counted
+		//	output: 
+		//		1 - OK
+		//		0 - not OK (failed to allocate memory)
+char pony_bus_enable_stats(pony_struct *bus, char enable, double overrun)
+{
+	int i;
+
+	if (bus->core.stats != NULL)
+		free(bus->core.stats);
+	bus->core.stats = NULL;
+	if (!enable)
+		return 1;
+
+	bus->core.stats = (pony_plugin_stats *)malloc( (bus->core.plugin_count + 1) * sizeof(pony_plugin_stats) );
+	if (bus->core.stats == NULL)
+		return 0;
+	for (i = 0; i < bus->core.plugin_count; i++)
+		pony_stats_reset( &(bus->core.stats[i]) );
+	bus->core.stats_overrun = overrun;
+	if (bus->core.stats_scale <= 0)
+		bus->core.stats_scale = pony_stats_calibrate();
+
+	return 1;
+}
+
+
+		// get timing statistics of a plugin
+		//	input: 
+		//		bus	- pointer to bus instance
+		//		id	- plugin index in the execution list
+		//	output: 
+		//		pointer to the plugin statistics, NULL if disabled or no such plugin
+const pony_plugin_stats *pony_bus_get_stats(pony_struct *bus, int id)
+{
+	if (bus->core.stats == NULL || id < 0 || id >= bus->core.plugin_count)
+		return NULL;
+
+	return &(bus->core.stats[id]);
+}
+
+
+
+
+	// functions operating on the bus instance selected for the current thread, as set in bus function pointers
+char pony_add_plugin		(void(*newplugin)(void)							) {return pony_bus_add_plugin		(pony, newplugin			);}
+char pony_add_gnss_plugin	(void(*newplugin)(void)							) {return pony_bus_add_gnss_plugin	(pony, newplugin			);}
+char pony_init				(char* cfg										) {return pony_bus_init				(pony, cfg					);}
+char pony_step				(void											) {return pony_bus_step				(pony						);}
+char pony_terminate			(void											) {return pony_bus_terminate		(pony						);}
+char pony_remove_plugin		(void(*   plugin)(void)							) {return pony_bus_remove_plugin	(pony, plugin				);}
+char pony_replace_plugin	(void(*oldplugin)(void), void(*newplugin)(void)	) {return pony_bus_replace_plugin	(pony, oldplugin, newplugin	);}
+char pony_schedule_plugin	(void(*newplugin)(void), int cycle, int shift	) {return pony_bus_schedule_plugin	(pony, newplugin, cycle, shift	);}
+char pony_reschedule_plugin	(void(*   plugin)(void), int cycle, int shift	) {return pony_bus_reschedule_plugin(pony, plugin, cycle, shift		);}
+char pony_suspend_plugin	(void(*   plugin)(void)							) {return pony_bus_suspend_plugin	(pony, plugin				);}
+char pony_resume_plugin		(void(*   plugin)(void)							) {return pony_bus_resume_plugin	(pony, plugin				);}
+char pony_declare_plugin	(void(*   plugin)(void), unsigned long reads, unsigned long writes) {return pony_bus_declare_plugin(pony, plugin, reads, writes);}
+	// instrumentation
+char pony_enable_stats		(char enable, double overrun					) {return pony_bus_enable_stats		(pony, enable, overrun			);}
+const pony_plugin_stats *pony_get_stats(int id							) {return pony_bus_get_stats		(pony, id						);}
+
+
+
+
+
+
+
+
+
+
+
+// basic parsing
+	//	locate a token in a configuration string
+	//	skips groups enclosed in braces {...} and strings within quotes ("...")
+	//	the token is matched against whole words, the same as by the configuration tree, e.g. "dt" is not found in "dtx = 1"
+	//	input:
+	//		token - token to be found and located, only non-blank characters
+	//		src - source string to search and locate in
+	//		len - maximum length to search and locate within
+	//		delim - mandatory delimiter to look for after the token found (if any), ignored if zero character
+	//	output:
+	//		NULL - if the token or delimiter (if delim != 0) not found, or token is invalid
+	//		pointer to the next character after the token or delimiter (if delim != 0)
+char * pony_locate_token(const char *token, char *src, const int len, const char delim) {
+
+	const char quote = '"', brace_open = '{', brace_close = '}';
+
+	int i, j, k, n, w, len1;
+	char *res;
+
+	// look up the configuration tree if the string is a group within the bus configuration
+	if (pony_cfg_tree_token(&(pony->cfg_tree), token, src, len, delim, &res))
+		return res;
+
+	for (w = 0; token[w] && pony_cfg_word_char(token[w]); w++); // word part of the token, matched against whole words as in the configuration tree
+	for (n = w; token[n]; n++); // determine token length
+	if (n == 0) // invalid token
+		return NULL; 
+	len1 = len - n;
+
+	// look for the token
+	for (i = 0, j = 0, k = 0; i < len1 && src[i]; i++) // go throughout the string
+		if (src[i] == quote) // skip quoted values
+			for (i++; src[i] && i < len1 && src[i] != quote; i++);
+		else if (src[i] == brace_open) // skip groups
+			for (i++; src[i] && i < len1 && src[i] != brace_close; i++);
+		else if (w == 0 || i == 0 || !pony_cfg_word_char(src[i-1])) { // at the beginning of a word
+			for (j = 0, k = i; j < n && src[k] == token[j]; j++, k++); 
+			if (j == n && w == n && pony_cfg_word_char(src[k])) // only the beginning of a longer word
+				j = 0;
+			if (j == n) // token found
+				break;
+		}
+	if (j < n) // token not found
+		return NULL;
+
+	if (!delim)
+		return (src + k + 1);
+
+	// check for delimiter
+	for (i = k; i < len && src[i] && src[i] <= ' '; i++); // skip all non-printables		
+	if (i >= len || src[i] != delim) // no delimiter found
+		return NULL;
+	else
+		return (src + i + 1);
+}
+
+
+
+
+
+
+
+// imu sample ring routines
+	// push a sample into the ring on the producer thread, without locks or allocation
+	// input:
+	//		ring - imu sample ring
+	//		sample - sample to push
+	// output:
+	//		pushed/dropped as overrun because the ring is full (1/0)
+char pony_imu_ring_push(pony_imu_ring *ring, const pony_imu_sample *sample)
+{
+	unsigned long head = ring->head;
+
+	if (head - ring->tail_cache > ring->mask) {	// full as last seen, refresh consumer position
+		ring->tail_cache = PONY_LOAD_ACQUIRE(&(ring->tail));
+		if (head - ring->tail_cache > ring->mask) {
+			PONY_STORE_RELEASE(&(ring->overruns), ring->overruns + 1);
+			return 0;
+		}
+	}
+	ring->sample[head & ring->mask] = *sample;
+	PONY_STORE_RELEASE(&(ring->head), head + 1);
+	return 1;
+}
+
+	// oldest samples in the ring on the consumer thread, to be processed in place and released with pony_imu_ring_consume
+	// input:
+	//		ring - imu sample ring
+	// output:
+	//		sample - pointer to the oldest sample
+	//		number of samples contiguous from the oldest one, the rest if any following from the ring start
+int pony_imu_ring_peek(pony_imu_ring *ring, pony_imu_sample **sample)
+{
+	unsigned long tail = ring->tail, n, run;
+
+	if (tail == ring->head_cache)	// empty as last seen, refresh producer position
+		ring->head_cache = PONY_LOAD_ACQUIRE(&(ring->head));
+	n = ring->head_cache - tail;
+	run = ring->mask + 1 - (tail & ring->mask);
+	*sample = ring->sample + (tail & ring->mask);
+	return (int)((n < run) ? n : run);
+}
+
+	// release oldest samples on the consumer thread, count not exceeding the number returned by pony_imu_ring_peek
+void pony_imu_ring_consume(pony_imu_ring *ring, const int count)
+{
+	if (count > 0)
+		PONY_STORE_RELEASE(&(ring->tail), ring->tail + (unsigned long)count);
+}
+
+	// copy and release oldest samples on the consumer thread
+	// input:
+	//		ring - imu sample ring
+	//		max_count - maximum number of samples to drain
+	// output:
+	//		sample - samples drained, oldest first
+	//		number of samples drained
+int pony_imu_ring_drain(pony_imu_ring *ring, pony_imu_sample *sample, const int max_count)
+{
+	pony_imu_sample *s;
+	int n = 0, run, i;
+
+	while (n < max_count && (run = pony_imu_ring_peek(ring, &s)) > 0) {
+		if (run > max_count - n)
+			run = max_count - n;
+		for (i = 0; i < run; i++)
+			sample[n + i] = s[i];
+		pony_imu_ring_consume(ring, run);
+		n += run;
+	}
+	return n;
+}
+
+	// drop accumulated increments and the previous sample, keeping the interval
+void pony_imu_preint_reset(pony_imu_preint *pre)
+{
+	int i;
+
+	for (i = 0; i < 3; i++) {
+		pre->dtheta[i] = 0;
+		pre->dv[i] = 0;
+		pre->alpha[i] = 0;
+		pre->beta[i] = 0;
+		pre->v[i] = 0;
+		pre->gamma[i] = 0;
+		pre->dalpha[i] = 0;
+		pre->dvel[i] = 0;
+	}
+	pre->t0 = 0;
+	pre->t = 0;
+	pre->count = 0;
+	pre->valid = 0;
+	pre->start = 0;
+	pre->n = 0;
+	pre->started = 0;
+}
+
+	// integrate an angular rate and specific force sample into coning and sculling compensated increments, using recursive algorithms by P.G. Savage // Journal of Guidance, Control, and Dynamics (1998) 21 (1, 2)
+	// input:
+	//		pre - pre-integration structure
+	//		sample - imu sample: time, angular rate (rad/s) and specific force (m/s^2) in the body frame, skipped if not valid
+	// output:
+	//		pre - increments of the last completed interval, when completed
+	//		interval completed/not (1/0)
+char pony_imu_preint_add(pony_imu_preint *pre, const pony_imu_sample *sample)
+{
+	double dt, da[3], dv[3], a[3], u[3], c[3], r[3];
+	int i;
+
+	if (!sample->w_valid || !sample->f_valid)
+		return 0;
+	if (!pre->started || sample->t <= pre->prev.t) {	// first sample, or time going backwards: start over
+		pony_imu_preint_reset(pre);
+		pre->prev = *sample;
+		pre->start = sample->t;
+		pre->started = 1;
+		return 0;
+	}
+
+	// trapezoidal increments
+	dt = sample->t - pre->prev.t;
+	for (i = 0; i < 3; i++) {
+		da[i] = (sample->w[i] + pre->prev.w[i])*dt/2;
+		dv[i] = (sample->f[i] + pre->prev.f[i])*dt/2;
+	}
+	pre->prev = *sample;
+
+	// coning: beta += (alpha + dalpha_prev/6) x da/2
+	for (i = 0; i < 3; i++) {
+		a[i] = pre->alpha[i] + pre->dalpha[i]/6;
+		u[i] = pre->v[i] + pre->dvel[i]/6;
+	}
+	pony_linal_cross3x1(c, a, da);
+	// sculling: gamma += ((alpha + dalpha_prev/6) x dv + (v + dv_prev/6) x da)/2
+	pony_linal_cross3x1(r, a, dv);
+	for (i = 0; i < 3; i++) {
+		pre->beta[i] += c[i]/2;
+		pre->gamma[i] += r[i]/2;
+	}
+	pony_linal_cross3x1(r, u, da);
+	for (i = 0; i < 3; i++) {
+		pre->gamma[i] += r[i]/2;
+		pre->alpha[i] += da[i];
+		pre->v[i] += dv[i];
+		pre->dalpha[i] = da[i];
+		pre->dvel[i] = dv[i];
+	}
+	pre->n++;
+
+	// interval completed within half a sample step
+	if (sample->t - pre->start < pre->interval - dt/2)
+		return 0;
+	pony_linal_cross3x1(r, pre->alpha, pre->v);	// rotation compensation
+	for (i = 0; i < 3; i++) {
+		pre->dtheta[i] = pre->alpha[i] + pre->beta[i];
+		pre->dv[i] = pre->v[i] + r[i]/2 + pre->gamma[i];
+		pre->alpha[i] = 0;
+		pre->beta[i] = 0;
+		pre->v[i] = 0;
+		pre->gamma[i] = 0;
+	}
+	pre->t0 = pre->start;
+	pre->t = sample->t;
+	pre->count = pre->n;
+	pre->valid = 1;
+	pre->start = sample->t;
+	pre->n = 0;
+	return 1;
+}
+
+	// integrate imu samples from the ring until an interval is completed, leaving the rest for the next call, or the current imu sample if there is no ring
+	// input:
+	//		imu - imu with pre-integration configured
+	// output:
+	//		imu->preint - increments of the last completed interval, when completed
+	//		interval completed/not (1/0)
+char pony_imu_preint_step(pony_imu *imu)
+{
+	pony_imu_sample *sample, current;
+	int n, i;
+
+	if (imu->preint == NULL)
+		return 0;
+	if (imu->ring == NULL) {
+		current.t = imu->t;
+		for (i = 0; i < 3; i++) {
+			current.w[i] = imu->w[i];
+			current.f[i] = imu->f[i];
+		}
+		current.w_valid = imu->w_valid;
+		current.f_valid = imu->f_valid;
+		return pony_imu_preint_add(imu->preint, &current);
+	}
+	while ((n = pony_imu_ring_peek(imu->ring, &sample)) > 0) {
+		for (i = 0; i < n; i++)
+			if (pony_imu_preint_add(imu->preint, sample + i)) {
+				pony_imu_ring_consume(imu->ring, i + 1);
+				return 1;
+			}
+		pony_imu_ring_consume(imu->ring, n);
+	}
+	return 0;
+}
+
+
+
+
+
+
+
+// strapdown inertial navigation
+	// unit quaternion for a rotation vector, by series for angles below 0.03 rad to avoid trigonometric calls
+void pony_imu_strapdown_rotvec2quat(double *q, const double *r)
+{
+	double x = r[0]*r[0] + r[1]*r[1] + r[2]*r[2], n, c, s;
+
+	if (x < 1e-3) {	// truncation error below 1e-19
+		c = 1 - x/8*(1 - x/48*(1 - x/120));
+		s = 0.5 - x/48*(1 - x/80*(1 - x/168));
+	}
+	else {
+		n = sqrt(x);
+		c = cos(n/2);
+		s = sin(n/2)/n;
+	}
+	q[0] = c;
+	q[1] = s*r[0];
+	q[2] = s*r[1];
+	q[3] = s*r[2];
+}
+
+	// sine and cosine of an angle advanced from those of another one by a small difference, by series below 0.01 rad, with first-order renormalization
+void pony_imu_strapdown_advance(double *sin_a, double *cos_a, const double a, const double d)
+{
+	double x = d*d, s, c, k;
+
+	if (x < 1e-4) {
+		c = 1 - x/2*(1 - x/12*(1 - x/30));
+		s = d*(1 - x/6*(1 - x/20*(1 - x/42)));
+		k = *sin_a*c + *cos_a*s;
+		*cos_a = *cos_a*c - *sin_a*s;
+		*sin_a = k;
+		k = 1.5 - (*sin_a**sin_a + *cos_a**cos_a)/2;
+		*sin_a *= k;
+		*cos_a *= k;
+	}
+	else {
+		*sin_a = sin(a);
+		*cos_a = cos(a);
+	}
+}
+
+	// refresh cached position terms when latitude or longitude moved beyond tolerance, or unconditionally when forced: radii of curvature, normal gravity on the ellipsoid and Earth rotation rate
+void pony_imu_strapdown_terms(pony_imu_strapdown *sd, const pony_imu_const *imu_const, const double lat, const double lon, const char force)
+{
+	double s2, w2;
+
+	if (force) {
+		sd->sin_lat = sin(lat);
+		sd->cos_lat = cos(lat);
+		sd->sin_lon = sin(lon);
+		sd->cos_lon = cos(lon);
+	}
+	else if (fabs(lat - sd->lat) > sd->tol || fabs(lon - sd->lon) > sd->tol) {
+		pony_imu_strapdown_advance(&(sd->sin_lat), &(sd->cos_lat), lat, lat - sd->lat);
+		pony_imu_strapdown_advance(&(sd->sin_lon), &(sd->cos_lon), lon, lon - sd->lon);
+	}
+	else
+		return;
+	sd->lat = lat;
+	sd->lon = lon;
+
+	s2 = sd->sin_lat*sd->sin_lat;
+	w2 = 1 - imu_const->e2*s2;
+	sd->Re = imu_const->a/sqrt(w2);
+	sd->Rn = sd->Re*(1 - imu_const->e2)/w2;
+	sd->g0 = imu_const->ge*(1 + imu_const->fg*s2);
+	sd->u[0] = 0;
+	sd->u[1] = imu_const->u*sd->cos_lat;
+	sd->u[2] = imu_const->u*sd->sin_lat;
+	sd->refresh++;
+}
+
+	// start strapdown navigation from imu solution
+	// input:
+	//		imu - imu with time t and solution: position llh, velocity v (east, north, up), attitude q if valid, or rpy otherwise
+	//		imu_const - inertial navigation constants
+	// output:
+	//		sd - strapdown state
+	//		OK/not OK (1/0)
+char pony_imu_strapdown_init(pony_imu_strapdown *sd, pony_imu *imu, const pony_imu_const *imu_const)
+{
+	pony_sol *sol = &(imu->sol);
+	double a[3], q[3][4], t[4];
+	int i;
+
+	sd->valid = 0;
+	if (!sol->llh_valid || !sol->v_valid || (!sol->q_valid && !sol->rpy_valid))
+		return 0;
+
+	if (sol->q_valid) {
+		sd->Q[0] = sol->q[0];
+		for (i = 1; i < 4; i++)
+			sd->Q[i] = -sol->q[i];
+	}
+	else {	// heading about up axis clockwise, pitch about right axis, roll about forward axis
+		a[0] = 0;	a[1] = 0;	a[2] = -sol->rpy[2];
+		pony_imu_strapdown_rotvec2quat(q[0], a);
+		a[0] = sol->rpy[1];	a[2] = 0;
+		pony_imu_strapdown_rotvec2quat(q[1], a);
+		a[0] = 0;	a[1] = sol->rpy[0];
+		pony_imu_strapdown_rotvec2quat(q[2], a);
+		pony_linal_qmul(t, q[0], q[1]);
+		pony_linal_qmul(sd->Q, t, q[2]);
+	}
+
+	sd->t = imu->t;
+	sd->tol = 1e-8;		// about 6 cm
+	sd->refresh = 0;
+	pony_imu_strapdown_terms(sd, imu_const, sol->llh[1], sol->llh[0], 1);
+	sd->valid = 1;
+	return 1;
+}
+
+	// strapdown update by body frame increments: attitude, velocity and position with local-level frame rotation, Coriolis and normal gravity
+	// input:
+	//		sd - strapdown state
+	//		imu - imu with solution to be updated
+	//		imu_const - inertial navigation constants
+	//		dtheta - delta-angle over the update interval, rad, coning compensated if available
+	//		dv - delta-velocity over the update interval in the body frame at its start, m/s, rotation and sculling compensated if available
+	//		dt - update interval, s
+	// output:
+	//		imu->sol - position (llh and x), velocity, attitude (q, L and rpy)
+	//		imu->W - angular velocity of the local-level frame, imu->g - normal gravity vector
+void pony_imu_strapdown_update(pony_imu_strapdown *sd, pony_imu *imu, const pony_imu_const *imu_const, double *dtheta, double *dv, const double dt)
+{
+	pony_sol *sol = &(imu->sol);
+	double Re_h, Rn_h, tan_lat, g, h_a, om[3], w[3], z[3], dvl[3], c[3], v0[3], rl[4], rb[4], t[4], n, d, s, cl;
+	int i;
+
+	Re_h = sd->Re + sol->llh[2];
+	Rn_h = sd->Rn + sol->llh[2];
+	tan_lat = sd->sin_lat/sd->cos_lat;
+
+	// local-level frame rate: Earth rotation and transport rate
+	om[0] = -sol->v[1]/Rn_h;
+	om[1] =  sol->v[0]/Re_h;
+	om[2] =  sol->v[0]*tan_lat/Re_h;
+	for (i = 0; i < 3; i++) {
+		w[i] = sd->u[i] + om[i];
+		z[i] = w[i]*dt;
+		c[i] = 2*sd->u[i] + om[i];
+	}
+
+	// velocity: specific force increment in local-level frame with its rotation over the interval, gravity and Coriolis
+	pony_linal_qrot(dvl, sd->Q, dv);
+	pony_linal_cross3x1(t, z, dvl);
+	h_a = sol->llh[2]/imu_const->a;
+	g = sd->g0*(1 - 2*h_a + 3*h_a*h_a);
+	pony_linal_cross3x1(rl, c, sol->v);
+	for (i = 0; i < 3; i++) {
+		v0[i] = sol->v[i];
+		sol->v[i] += dvl[i] - t[i]/2 - rl[i]*dt;
+	}
+	sol->v[2] -= g*dt;
+
+	// position by mean velocity
+	sol->llh[1] += (v0[1] + sol->v[1])/2*dt/Rn_h;
+	sol->llh[0] += (v0[0] + sol->v[0])/2*dt/(Re_h*sd->cos_lat);
+	sol->llh[2] += (v0[2] + sol->v[2])/2*dt;
+	if (sol->llh[0] > imu_const->pi)
+		sol->llh[0] -= 2*imu_const->pi;
+	else if (sol->llh[0] < -imu_const->pi)
+		sol->llh[0] += 2*imu_const->pi;
+	pony_imu_strapdown_terms(sd, imu_const, sol->llh[1], sol->llh[0], 0);
+
+	// attitude: body rotation, then local-level frame rotation
+	pony_imu_strapdown_rotvec2quat(rb, dtheta);
+	for (i = 0; i < 3; i++)
+		z[i] = -z[i];
+	pony_imu_strapdown_rotvec2quat(rl, z);
+	pony_linal_qmul(t, sd->Q, rb);
+	pony_linal_qmul(sd->Q, rl, t);
+	n = sd->Q[0]*sd->Q[0] + sd->Q[1]*sd->Q[1] + sd->Q[2]*sd->Q[2] + sd->Q[3]*sd->Q[3];
+	n = 1.5 - n/2;	// first-order renormalization
+	for (i = 0; i < 4; i++)
+		sd->Q[i] *= n;
+
+	// solution: attitude quaternion, matrix and angles, cartesian coordinates from cached terms corrected to first order
+	sol->q[0] = sd->Q[0];
+	for (i = 1; i < 4; i++)
+		sol->q[i] = -sd->Q[i];
+	pony_linal_quat2mat(sol->L, sol->q);
+	sol->rpy[0] = atan2(-sol->L[2], sol->L[8]);
+	sol->rpy[1] = asin(sol->L[5]);
+	sol->rpy[2] = atan2(sol->L[3], sol->L[4]);
+	if (sol->rpy[2] < 0)
+		sol->rpy[2] += 2*imu_const->pi;
+	d = sol->llh[1] - sd->lat;
+	s = sd->sin_lat + sd->cos_lat*d;
+	cl = sd->cos_lat - sd->sin_lat*d;
+	d = sol->llh[0] - sd->lon;
+	Re_h = sd->Re + sol->llh[2];
+	sol->x[0] = Re_h*cl*(sd->cos_lon - sd->sin_lon*d);
+	sol->x[1] = Re_h*cl*(sd->sin_lon + sd->cos_lon*d);
+	sol->x[2] = (sd->Re*(1 - imu_const->e2) + sol->llh[2])*s;
+	sol->x_valid = sol->llh_valid = sol->v_valid = sol->q_valid = sol->L_valid = sol->rpy_valid = 1;
+
+	// local-level frame rate and gravity for other plugins
+	for (i = 0; i < 3; i++)
+		imu->W[i] = w[i];
+	imu->W_valid = 1;
+	imu->g[0] = 0;
+	imu->g[1] = 0;
+	imu->g[2] = -g;
+	imu->g_valid = 1;
+}
+
+	// strapdown update by imu measurements since the last update
+	// input:
+	//		sd - strapdown state initialized with pony_imu_strapdown_init
+	//		imu - imu with pre-integrated increments (imu->preint), used when an interval has been completed after the last update, or angular rate and specific force at time t otherwise, held over the time elapsed and rotation compensated
+	//		imu_const - inertial navigation constants
+	// output:
+	//		imu->sol, imu->W, imu->g - see pony_imu_strapdown_update
+	//		updated/not (1/0)
+char pony_imu_strapdown_step(pony_imu_strapdown *sd, pony_imu *imu, const pony_imu_const *imu_const)
+{
+	double dt, dtheta[3], dv[3], r[3];
+	int i;
+
+	if (!sd->valid)
+		return 0;
+	if (imu->preint != NULL) {
+		if (!imu->preint->valid || imu->preint->t <= sd->t)
+			return 0;
+		pony_imu_strapdown_update(sd, imu, imu_const, imu->preint->dtheta, imu->preint->dv, imu->preint->t - imu->preint->t0);
+		sd->t = imu->preint->t;
+		return 1;
+	}
+	dt = imu->t - sd->t;
+	if (dt <= 0 || !imu->w_valid || !imu->f_valid)
+		return 0;
+	for (i = 0; i < 3; i++) {
+		dtheta[i] = imu->w[i]*dt;
+		dv[i] = imu->f[i]*dt;
+	}
+	pony_linal_cross3x1(r, dtheta, dv);	// rotation compensation, as for pre-integrated increments
+	for (i = 0; i < 3; i++)
+		dv[i] += r[i]/2;
+	pony_imu_strapdown_update(sd, imu, imu_const, dtheta, dv, dt);
+	sd->t = imu->t;
+	return 1;
+}
+
+
+
+
+
+
+
+// gnss satellite data routines
+	// copy satellite data from pony_gnss_sat array to its structure-of-arrays view
+	// input:
+	//		sat - array of soa->count satellites
+	// output:
+	//		soa - structure-of-arrays view with coordinates, velocities, elevation, emission time, clock offset and packed validity flags
+void pony_gnss_soa_gather(pony_gnss_sat_soa *soa, pony_gnss_sat *sat)
+{
+	int i, words = (soa->count + 31)/32;
+	unsigned int bit;
+
+	for (i = 0; i < words; i++) {
+		soa->eph_valid[i]	= 0;
+		soa->x_valid[i]		= 0;
+		soa->v_valid[i]		= 0;
+		soa->t_em_valid[i]	= 0;
+		soa->sinEl_valid[i]	= 0;
+	}
+
+	for (i = 0; i < soa->count; i++) {
+		soa->x[i]			= sat[i].x[0];
+		soa->y[i]			= sat[i].x[1];
+		soa->z[i]			= sat[i].x[2];
+		soa->vx[i]			= sat[i].v[0];
+		soa->vy[i]			= sat[i].v[1];
+		soa->vz[i]			= sat[i].v[2];
+		soa->sinEl[i]		= sat[i].sinEl;
+		soa->t_em[i]		= sat[i].t_em;
+		soa->Deltatsv[i]	= sat[i].Deltatsv;
+
+		bit = 1u << (i%32);
+		if (sat[i].eph_valid)	soa->eph_valid[i/32]	|= bit;
+		if (sat[i].x_valid)		soa->x_valid[i/32]		|= bit;
+		if (sat[i].v_valid)		soa->v_valid[i/32]		|= bit;
+		if (sat[i].t_em_valid)	soa->t_em_valid[i/32]	|= bit;
+		if (sat[i].sinEl_valid)	soa->sinEl_valid[i/32]	|= bit;
+	}
+}
+
+	// copy satellite data from structure-of-arrays view back to pony_gnss_sat array, ephemeris and observables are not affected
+	// input:
+	//		soa - structure-of-arrays view
+	// output:
+	//		sat - array of soa->count satellites with coordinates, velocities, elevation, emission time, clock offset and validity flags updated
+void pony_gnss_soa_scatter(pony_gnss_sat *sat, pony_gnss_sat_soa *soa)
+{
+	int i;
+	unsigned int bit;
+
+	for (i = 0; i < soa->count; i++) {
+		sat[i].x[0]			= soa->x[i];
+		sat[i].x[1]			= soa->y[i];
+		sat[i].x[2]			= soa->z[i];
+		sat[i].v[0]			= soa->vx[i];
+		sat[i].v[1]			= soa->vy[i];
+		sat[i].v[2]			= soa->vz[i];
+		sat[i].sinEl		= soa->sinEl[i];
+		sat[i].t_em			= soa->t_em[i];
+		sat[i].Deltatsv		= soa->Deltatsv[i];
+
+		bit = 1u << (i%32);
+		sat[i].eph_valid	= (soa->eph_valid[i/32]		& bit) ? 1 : 0;
+		sat[i].x_valid		= (soa->x_valid[i/32]		& bit) ? 1 : 0;
+		sat[i].v_valid		= (soa->v_valid[i/32]		& bit) ? 1 : 0;
+		sat[i].t_em_valid	= (soa->t_em_valid[i/32]	& bit) ? 1 : 0;
+		sat[i].sinEl_valid	= (soa->sinEl_valid[i/32]	& bit) ? 1 : 0;
+	}
+}
+
+	// sine of elevation angles for all satellites of a structure-of-arrays view, in a single pass to be vectorized
+	// input:
+	//		soa - structure-of-arrays view with satellite coordinates
+	//		r - receiver coordinates, in the same frame as satellite coordinates
+	//		up - unit vector of local vertical at receiver, in the same frame
+	//		sinEl_mask - elevation mask, as a sine of elevation angle
+	// output:
+	//		soa - sines of elevation angles, valid for satellites with valid coordinates
+	//		mask - packed flags of satellites with valid coordinates above elevation mask, (soa->count+31)/32 words, may be NULL
+	//		number of satellites with valid coordinates above elevation mask
+int pony_gnss_soa_elevation(pony_gnss_sat_soa *soa, double *r, double *up, const double sinEl_mask, unsigned int *mask)
+{
+	int i, j, n, words = (soa->count + 31)/32, count = 0;
+	double r0 = r[0], r1 = r[1], r2 = r[2], u0 = up[0], u1 = up[1], u2 = up[2];
+	double *x = soa->x, *y = soa->y, *z = soa->z, *sinEl = soa->sinEl;
+	double dx, dy, dz, d;
+	unsigned int above;
+
+	// all satellites, no branching on validity
+	for (i = 0, n = soa->count; i < n; i++) {
+		dx = x[i] - r0;
+		dy = y[i] - r1;
+		dz = z[i] - r2;
+		d = sqrt(dx*dx + dy*dy + dz*dz);
+		sinEl[i] = (dx*u0 + dy*u1 + dz*u2)/(d + (d == 0));	// zero for satellite at receiver position
+	}
+
+	// validity and mask flags, 32 satellites at a time
+	for (i = 0; i < words; i++) {
+		soa->sinEl_valid[i] = soa->x_valid[i];
+		n = (soa->count - i*32 < 32) ? soa->count - i*32 : 32;
+		for (j = 0, above = 0; j < n; j++)
+			if (soa->sinEl[i*32 + j] >= sinEl_mask)
+				above |= 1u << j;
+		above &= soa->x_valid[i];
+		if (mask != NULL)
+			mask[i] = above;
+		for ( ; above; above &= above-1)
+			count++;
+	}
+
+	return count;
+}
+
+	// seconds of week for a RINEX epoch stored at the beginning of ephemeris array (year, month, day, hour, min, sec), weeks starting on Sunday as in GPS, Galileo and BeiDou time
+double pony_gnss_eph_sow(double *eph)
+{
+	int Y, days;
+
+	Y = (int)eph[0];
+	if (Y < 80)
+		Y += 2000;	// two-digit years in RINEX 2
+	else if (Y < 100)
+		Y += 1900;
+	days = (int)( (pony_time_rata_die(Y, (int)eph[1], (int)eph[2]) - pony_time_gps_rd)%7 );	// from GPS time origin, Sunday
+	if (days < 0)
+		days += 7;
+
+	return days*86400.0 + eph[3]*3600 + eph[4]*60 + eph[5];
+}
+
+	// sines and cosines of n arguments, in separate loops to be vectorized rather than merged into scalar sincos calls
+void pony_gnss_sincos(double *s, double *c, double *arg, const int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		s[i] = sin(arg[i]);
+	for (i = 0; i < n; i++)
+		c[i] = cos(arg[i]);
+}
+
+	// satellite positions and velocities from Keplerian ephemeris for all satellites of a constellation in a single batch
+	// Kepler equation solved with a fixed number of Newton iterations for 32 satellites at a time in branch-free loops over satellites,
+	// ephemeris parameters gathered into local arrays beforehand, loops to be vectorized by compilers providing vector math functions
+	// ephemeris layout as in RINEX navigation files, see pony_gnss_sat.eph
+	// input:
+	//		sat - array of soa->count satellites with ephemeris
+	//		t - time of signal reception, seconds of week in constellation time scale
+	//		pr - array of soa->count pseudoranges to compute time of emission and rotate coordinates for Earth rotation during signal propagation,
+	//			satellites with non-positive pseudoranges skipped, or NULL to compute at time t
+	//		mu, u, F, c - gravity constant, Earth rotation rate, relativistic correction constant and speed of light
+	//		bds - BeiDou constellation flag (0/1), to handle geostationary satellites PRN 1-5 and 59-63
+	// output:
+	//		sat, soa - coordinates, velocities, emission time and clock offset with validity flags
+	//		number of satellites with coordinates computed
+int pony_gnss_kepler(pony_gnss_sat *sat, pony_gnss_sat_soa *soa, const double t, double *pr, const double mu, const double u, const double F, const double c, const char bds)
+{
+	enum {lanes = 32, iterations = 3};	// Newton iterations sufficient for eccentricity up to 0.2
+	const double half_week = 302400, week = 604800;
+	const double sin_tilt = -0.087155742747658174, cos_tilt = 0.99619469809174553;	// BeiDou GEO orbital plane tilt, -5 deg
+
+	// ephemeris parameters
+	double sqrtA[lanes], e[lanes], n[lanes], M[lanes], w[lanes], i0[lanes], idot[lanes], W[lanes], Wdot[lanes], toe[lanes],
+		Cuc[lanes], Cus[lanes], Crc[lanes], Crs[lanes], Cic[lanes], Cis[lanes], af0[lanes], af1[lanes], af2[lanes], toc[lanes], tau[lanes], g[lanes];
+	// intermediate results, angles with their sines and cosines
+	double tk[lanes], tsv[lanes], dts[lanes], Edot[lanes], nudot[lanes], rk[lanes], rdot[lanes], udot[lanes], idk[lanes],
+		E[lanes], sinE[lanes], cosE[lanes], Phi2[lanes], sin2[lanes], cos2[lanes], uk[lanes], sinu[lanes], cosu[lanes],
+		ik[lanes], sini[lanes], cosi[lanes], Wk[lanes], sinW[lanes], cosW[lanes], a[lanes], sina[lanes], cosa[lanes], b[lanes], sinb[lanes], cosb[lanes];
+	double *eph, tc, dtr, ecosE, sq, nu, du, dr, di, Wkdot, xp, yp, xpdot, ypdot, x, y, z, vx, vy, vz, hy, hz, hdy, hdz;
+	int i, j, i1, k, count = 0;
+	unsigned int valid, bit;
+
+	for (i = 0; i < soa->count; i += lanes) {
+		i1 = (soa->count - i < lanes) ? soa->count - i : lanes;
+
+		// gather ephemeris parameters, dummy circular orbit for satellites to be skipped
+		for (j = 0, valid = 0; j < i1; j++) {
+			k = i+j;
+			eph = sat[k].eph;
+			if (sat[k].eph_valid && (pr == NULL || pr[k] > 0)) {
+				valid |= 1u << j;
+				sqrtA[j]	= eph[16];
+				e[j]		= eph[14];
+				n[j]		= sqrt(mu)/(eph[16]*eph[16]*eph[16]) + eph[11];
+				M[j]		= eph[12];
+				w[j]		= eph[23];
+				i0[j]		= eph[21];
+				idot[j]		= eph[25];
+				W[j]		= eph[19];
+				Wdot[j]		= eph[24];
+				toe[j]		= eph[17];
+				Cuc[j]		= eph[13];
+				Cus[j]		= eph[15];
+				Crc[j]		= eph[22];
+				Crs[j]		= eph[10];
+				Cic[j]		= eph[18];
+				Cis[j]		= eph[20];
+				af0[j]		= eph[6];
+				af1[j]		= eph[7];
+				af2[j]		= eph[8];
+				toc[j]		= pony_gnss_eph_sow(eph);
+				tau[j]		= (pr == NULL) ? 0 : pr[k]/c;
+				g[j]		= (bds && (k < 5 || (k >= 58 && k < 63))) ? 1 : 0;
+			}
+			else {
+				sqrtA[j] = 5000;	e[j] = 0;	n[j] = sqrt(mu)/(sqrtA[j]*sqrtA[j]*sqrtA[j]);
+				M[j] = w[j] = i0[j] = idot[j] = W[j] = Wdot[j] = toe[j] = Cuc[j] = Cus[j] = Crc[j] = Crs[j] = Cic[j] = Cis[j] = 0;
+				af0[j] = af1[j] = af2[j] = toc[j] = tau[j] = g[j] = 0;
+			}
+		}
+
+		// the rest in branch-free loops over satellites
+			// satellite time of transmission, clock offset without relativistic correction, mean anomaly
+		for (j = 0; j < i1; j++) {
+			tsv[j] = t - tau[j];
+			tc = tsv[j] - toc[j];
+			tc -= week*floor((tc + half_week)/week);
+			dts[j] = af0[j] + af1[j]*tc + af2[j]*tc*tc;
+			tk[j] = tsv[j] - dts[j] - toe[j];
+			tk[j] -= week*floor((tk[j] + half_week)/week);
+			M[j] += n[j]*tk[j];
+			E[j] = M[j];
+		}
+			// Kepler equation M = E - e*sin(E), Newton iterations starting from E = M + e*sin(M)
+		pony_gnss_sincos(sinE, cosE, E, i1);
+		for (j = 0; j < i1; j++)
+			E[j] += e[j]*sinE[j];
+		for (k = 0; k < iterations; k++) {
+			pony_gnss_sincos(sinE, cosE, E, i1);
+			for (j = 0; j < i1; j++)
+				E[j] -= (E[j] - e[j]*sinE[j] - M[j])/(1 - e[j]*cosE[j]);
+		}
+		pony_gnss_sincos(sinE, cosE, E, i1);
+			// relativistic correction, time of emission with Kepler solution moved back accordingly, argument of latitude
+		for (j = 0; j < i1; j++) {
+			ecosE = 1 - e[j]*cosE[j];
+			dtr = F*e[j]*sqrtA[j]*sinE[j];
+			Edot[j] = n[j]/ecosE;
+			dts[j] += dtr;
+			tsv[j] -= dts[j];
+			tk[j] -= dtr;
+			sinE[j] -= cosE[j]*Edot[j]*dtr;
+			cosE[j] += sinE[j]*Edot[j]*dtr;
+			sq = sqrt(1 - e[j]*e[j]);
+			nu = atan2(sq*sinE[j], cosE[j] - e[j]);
+			nudot[j] = Edot[j]*sq/(1 - e[j]*cosE[j]);
+			Phi2[j] = 2*(nu + w[j]);
+		}
+		pony_gnss_sincos(sin2, cos2, Phi2, i1);
+			// harmonic corrections, radius, inclination and longitude of ascending node (Earth-fixed for all but BeiDou GEO satellites)
+		for (j = 0; j < i1; j++) {
+			du = Cus[j]*sin2[j] + Cuc[j]*cos2[j];
+			dr = Crs[j]*sin2[j] + Crc[j]*cos2[j];
+			di = Cis[j]*sin2[j] + Cic[j]*cos2[j];
+			uk[j] = Phi2[j]/2 + du;
+			rk[j] = sqrtA[j]*sqrtA[j]*(1 - e[j]*cosE[j]) + dr;
+			ik[j] = i0[j] + di + idot[j]*tk[j];
+			udot[j] = nudot[j] + 2*nudot[j]*(Cus[j]*cos2[j] - Cuc[j]*sin2[j]);
+			rdot[j] = sqrtA[j]*sqrtA[j]*e[j]*Edot[j]*sinE[j] + 2*nudot[j]*(Crs[j]*cos2[j] - Crc[j]*sin2[j]);
+			idk[j] = idot[j] + 2*nudot[j]*(Cis[j]*cos2[j] - Cic[j]*sin2[j]);
+			Wk[j] = W[j] + (Wdot[j] - u*(1 - g[j]))*tk[j] - u*toe[j];
+			a[j] = g[j]*u*tk[j];	// BeiDou GEO rotation
+			b[j] = u*tau[j];		// Earth rotation during signal propagation
+		}
+		pony_gnss_sincos(sinu, cosu, uk, i1);
+		pony_gnss_sincos(sini, cosi, ik, i1);
+		pony_gnss_sincos(sinW, cosW, Wk, i1);
+		pony_gnss_sincos(sina, cosa, a, i1);
+		pony_gnss_sincos(sinb, cosb, b, i1);
+			// coordinates and velocities
+		for (j = 0; j < i1; j++) {
+			// in orbital plane
+			xp = rk[j]*cosu[j];
+			yp = rk[j]*sinu[j];
+			xpdot = rdot[j]*cosu[j] - rk[j]*udot[j]*sinu[j];
+			ypdot = rdot[j]*sinu[j] + rk[j]*udot[j]*cosu[j];
+
+			// Earth-fixed, or inertial for BeiDou GEO
+			Wkdot = Wdot[j] - u*(1 - g[j]);
+			x = xp*cosW[j] - yp*cosi[j]*sinW[j];
+			y = xp*sinW[j] + yp*cosi[j]*cosW[j];
+			z = yp*sini[j];
+			vx = xpdot*cosW[j] - ypdot*cosi[j]*sinW[j] + yp*sini[j]*idk[j]*sinW[j] - y*Wkdot;
+			vy = xpdot*sinW[j] + ypdot*cosi[j]*cosW[j] - yp*sini[j]*idk[j]*cosW[j] + x*Wkdot;
+			vz = ypdot*sini[j] + yp*cosi[j]*idk[j];
+
+			// BeiDou GEO: tilt by -5 deg about x axis, then rotation by u*tk about z axis, identity for others
+			hy  = y *(g[j]*cos_tilt + 1 - g[j]) + z *g[j]*sin_tilt;
+			hz  = z *(g[j]*cos_tilt + 1 - g[j]) - y *g[j]*sin_tilt;
+			hdy = vy*(g[j]*cos_tilt + 1 - g[j]) + vz*g[j]*sin_tilt;
+			hdz = vz*(g[j]*cos_tilt + 1 - g[j]) - vy*g[j]*sin_tilt;
+			y  = -sina[j]*x + cosa[j]*hy;
+			x  =  cosa[j]*x + sina[j]*hy;
+			vy = -sina[j]*vx + cosa[j]*hdy - g[j]*u*x;
+			vx =  cosa[j]*vx + sina[j]*hdy + g[j]*u*y;
+
+			// Earth rotation during signal propagation, to the Earth-fixed frame at reception time, stored in place of intermediate results
+			rk[j]	=  cosb[j]*x  + sinb[j]*y;
+			rdot[j]	= -sinb[j]*x  + cosb[j]*y;
+			udot[j]	= hz;
+			idk[j]	=  cosb[j]*vx + sinb[j]*vy;
+			Edot[j]	= -sinb[j]*vx + cosb[j]*vy;
+			nudot[j]= hdz;
+		}
+
+		// results with validity flags
+		for (j = 0; j < i1; j++) {
+			soa->x[i+j]			= rk[j];
+			soa->y[i+j]			= rdot[j];
+			soa->z[i+j]			= udot[j];
+			soa->vx[i+j]		= idk[j];
+			soa->vy[i+j]		= Edot[j];
+			soa->vz[i+j]		= nudot[j];
+			soa->t_em[i+j]		= tsv[j];
+			soa->Deltatsv[i+j]	= dts[j];
+
+			bit = (valid >> j) & 1;
+			sat[i+j].x_valid = sat[i+j].v_valid = sat[i+j].t_em_valid = (char)bit;
+			if (!bit)
+				continue;
+			sat[i+j].x[0]		= soa->x[i+j];
+			sat[i+j].x[1]		= soa->y[i+j];
+			sat[i+j].x[2]		= soa->z[i+j];
+			sat[i+j].v[0]		= soa->vx[i+j];
+			sat[i+j].v[1]		= soa->vy[i+j];
+			sat[i+j].v[2]		= soa->vz[i+j];
+			sat[i+j].t_em		= tsv[j];
+			sat[i+j].Deltatsv	= dts[j];
+			count++;
+		}
+		soa->x_valid[i/lanes]		= valid;
+		soa->v_valid[i/lanes]		= valid;
+		soa->t_em_valid[i/lanes]	= valid;
+	}
+
+	return count;
+}
+
+	// GPS satellite positions and velocities, see pony_gnss_kepler
+int pony_gnss_gps_kepler(pony_gnss_gps *gps, const double t, double *pr)
+{
+	pony_gps_const *gc = &(pony->gnss_const.gps);
+
+	return pony_gnss_kepler(gps->sat, &(gps->soa), t, pr, gc->mu, gc->u, gc->F, pony->gnss_const.c, 0);
+}
+
+	// Galileo satellite positions and velocities, see pony_gnss_kepler
+int pony_gnss_gal_kepler(pony_gnss_gal *gal, const double t, double *pr)
+{
+	pony_gal_const *gc = &(pony->gnss_const.gal);
+
+	return pony_gnss_kepler(gal->sat, &(gal->soa), t, pr, gc->mu, gc->u, gc->F, pony->gnss_const.c, 0);
+}
+
+	// BeiDou satellite positions and velocities, see pony_gnss_kepler, geostationary satellites being PRN 1-5 and 59-63
+int pony_gnss_bds_kepler(pony_gnss_bds *bds, const double t, double *pr)
+{
+	pony_bds_const *gc = &(pony->gnss_const.bds);
+
+	return pony_gnss_kepler(bds->sat, &(bds->soa), t, pr, gc->mu, gc->u, gc->F, pony->gnss_const.c, 1);
+}
+
+	// GLONASS equations of motion in Earth-fixed PZ-90 frame, with lunisolar accelerations constant, for n lanes
+	// state s and derivative d of 6 x lanes: x, y, z, vx, vy, vz, lunisolar accelerations acc of 3 x lanes
+void pony_gnss_glo_motion(double *d, double *s, double *acc, const int n, const int lanes, const double mu, const double J02, const double u, const double a)
+{
+	double x, y, z, r2, r, mr3, j2, z2;
+	int j;
+
+	for (j = 0; j < n; j++) {
+		x = s[j];
+		y = s[lanes + j];
+		z = s[2*lanes + j];
+		r2 = x*x + y*y + z*z;
+		r = sqrt(r2);
+		mr3 = mu/(r2*r);
+		j2 = 1.5*J02*mu*a*a/(r2*r2*r);
+		z2 = 5*z*z/r2;
+		d[j]			= s[3*lanes + j];
+		d[lanes + j]	= s[4*lanes + j];
+		d[2*lanes + j]	= s[5*lanes + j];
+		d[3*lanes + j]	= -mr3*x - j2*x*(1 - z2) + u*u*x + 2*u*s[4*lanes + j] + acc[j];
+		d[4*lanes + j]	= -mr3*y - j2*y*(1 - z2) + u*u*y - 2*u*s[3*lanes + j] + acc[lanes + j];
+		d[5*lanes + j]	= -mr3*z - j2*z*(3 - z2) + acc[2*lanes + j];
+	}
+}
+
+	// GLONASS satellite positions and velocities by numerical integration of equations of motion, as in ICD GLONASS Edition 5.1 2008 Appendix 3.1.2
+	// 4th order Runge-Kutta method for 32 satellites at a time, each state being one lane of branch-free loops over satellites,
+	// with steps of equal length within interval for each satellite, no more than 60 s, and zero length after the satellite is done,
+	// integration starts from the last integrated state cached per satellite, unless ephemeris reference time is closer or ephemeris changed,
+	// cached state dropped for satellites without valid ephemeris
+	// input:
+	//		glo - GLONASS constellation data with ephemeris as in RINEX navigation files, see pony_gnss_sat.eph
+	//		t - time of signal reception, seconds of week in UTC, as ephemeris epochs in RINEX
+	//		pr - array of max_sat_count pseudoranges to compute time of emission and rotate coordinates for Earth rotation during signal propagation,
+	//			satellites with non-positive pseudoranges skipped, or NULL to compute at time t
+	// output:
+	//		glo - satellite coordinates, velocities, emission time and clock offset with validity flags, in both satellite array and its SoA view,
+	//			orbit integration cache
+	//		number of satellites with coordinates computed
+int pony_gnss_glo_orbit(pony_gnss_glo *glo, const double t, double *pr)
+{
+	enum {lanes = 32, state = 6 * lanes};
+	const double step = 60, half_week = 302400, week = 604800, km = 1e3;
+
+	pony_glo_const *gc = &(pony->gnss_const.glo);
+	double s[state], s1[state], k1[state], k2[state], k3[state], k4[state], acc[3*lanes],
+		h[lanes], tem[lanes], dts[lanes], tau[lanes], tb[lanes], x0[lanes], sinb[lanes], cosb[lanes];
+	double *eph, *cache = glo->orbit, dt, dc;
+	int i, j, i1, k, m, steps, count = 0, max_steps;
+	int nsteps[lanes];
+	unsigned int valid, bit;
+
+	for (i = 0; i < glo->max_sat_count; i += lanes) {
+		i1 = (glo->max_sat_count - i < lanes) ? glo->max_sat_count - i : lanes;
+
+		// initial states from ephemeris or cache, step lengths
+		for (j = 0, valid = 0, max_steps = 0; j < i1; j++) {
+			k = i+j;
+			eph = glo->sat[k].eph;
+			h[j] = 0;
+			nsteps[j] = 0;
+			for (m = 0; m < 6; m++)
+				s[m*lanes + j] = 0;
+			s[j] = gc->a;	// dummy state for satellites to be skipped
+			acc[j] = acc[lanes + j] = acc[2*lanes + j] = 0;
+			tau[j] = tem[j] = dts[j] = 0;
+			if (!glo->sat[k].eph_valid)
+				cache[glo->max_sat_count + k] = -1;	// cached state dropped, ephemeris may change before it is valid again
+			if (!glo->sat[k].eph_valid || (pr != NULL && pr[k] <= 0))
+				continue;
+			valid |= 1u << j;
+
+			// time of emission, clock offset
+			tb[j] = pony_gnss_eph_sow(eph);
+			x0[j] = eph[9];
+			tau[j] = (pr == NULL) ? 0 : pr[k]/pony->gnss_const.c;
+			tem[j] = t - tau[j];
+			dt = tem[j] - tb[j];
+			dt -= week*floor((dt + half_week)/week);
+			dts[j] = eph[6] + eph[7]*dt + ((glo->clock_corr_valid) ? glo->clock_corr[0] : 0);
+			tem[j] -= dts[j];
+			dt -= dts[j];
+
+			// cached state if closer in time and ephemeris not changed
+			dc = tem[j] - cache[k];
+			dc -= week*floor((dc + half_week)/week);
+			if (cache[glo->max_sat_count + k] == tb[j] && cache[2*glo->max_sat_count + k] == x0[j] && fabs(dc) < fabs(dt)) {
+				for (m = 0; m < 6; m++)
+					s[m*lanes + j] = cache[(3+m)*glo->max_sat_count + k];
+				dt = dc;
+			}
+			else
+				for (m = 0; m < 3; m++) {
+					s[m*lanes + j] = eph[9 + 4*m]*km;
+					s[(3+m)*lanes + j] = eph[10 + 4*m]*km;
+				}
+			for (m = 0; m < 3; m++)
+				acc[m*lanes + j] = eph[11 + 4*m]*km;
+
+			steps = (int)ceil(fabs(dt)/step);
+			nsteps[j] = steps;
+			h[j] = (steps > 0) ? dt/steps : 0;
+			if (steps > max_steps)
+				max_steps = steps;
+		}
+
+		// Runge-Kutta steps for all lanes, zero step length for lanes done
+		for (steps = 0; steps < max_steps; steps++) {
+			for (j = 0; j < i1; j++)
+				if (steps >= nsteps[j])
+					h[j] = 0;
+			pony_gnss_glo_motion(k1, s, acc, i1, lanes, gc->mu, gc->J02, gc->u, gc->a);
+			for (m = 0; m < 6; m++)
+				for (j = 0; j < i1; j++)
+					s1[m*lanes + j] = s[m*lanes + j] + h[j]/2*k1[m*lanes + j];
+			pony_gnss_glo_motion(k2, s1, acc, i1, lanes, gc->mu, gc->J02, gc->u, gc->a);
+			for (m = 0; m < 6; m++)
+				for (j = 0; j < i1; j++)
+					s1[m*lanes + j] = s[m*lanes + j] + h[j]/2*k2[m*lanes + j];
+			pony_gnss_glo_motion(k3, s1, acc, i1, lanes, gc->mu, gc->J02, gc->u, gc->a);
+			for (m = 0; m < 6; m++)
+				for (j = 0; j < i1; j++)
+					s1[m*lanes + j] = s[m*lanes + j] + h[j]*k3[m*lanes + j];
+			pony_gnss_glo_motion(k4, s1, acc, i1, lanes, gc->mu, gc->J02, gc->u, gc->a);
+			for (m = 0; m < 6; m++)
+				for (j = 0; j < i1; j++)
+					s[m*lanes + j] += h[j]/6*(k1[m*lanes + j] + 2*k2[m*lanes + j] + 2*k3[m*lanes + j] + k4[m*lanes + j]);
+		}
+
+		// Earth rotation during signal propagation, to the Earth-fixed frame at reception time
+		for (j = 0; j < i1; j++)
+			tau[j] *= gc->u;
+		pony_gnss_sincos(sinb, cosb, tau, i1);
+
+		// results with validity flags, cache
+		for (j = 0; j < i1; j++) {
+			k = i+j;
+			bit = (valid >> j) & 1;
+			glo->sat[k].x_valid = glo->sat[k].v_valid = glo->sat[k].t_em_valid = (char)bit;
+			if (!bit)
+				continue;
+			cache[k] = tem[j];
+			cache[glo->max_sat_count + k] = tb[j];
+			cache[2*glo->max_sat_count + k] = x0[j];
+			for (m = 0; m < 6; m++)
+				cache[(3+m)*glo->max_sat_count + k] = s[m*lanes + j];
+
+			glo->soa.x[k]		=  cosb[j]*s[j]				+ sinb[j]*s[lanes + j];
+			glo->soa.y[k]		= -sinb[j]*s[j]				+ cosb[j]*s[lanes + j];
+			glo->soa.z[k]		= s[2*lanes + j];
+			glo->soa.vx[k]		=  cosb[j]*s[3*lanes + j]	+ sinb[j]*s[4*lanes + j];
+			glo->soa.vy[k]		= -sinb[j]*s[3*lanes + j]	+ cosb[j]*s[4*lanes + j];
+			glo->soa.vz[k]		= s[5*lanes + j];
+			glo->soa.t_em[k]	= tem[j];
+			glo->soa.Deltatsv[k]= dts[j];
+
+			glo->sat[k].x[0]		= glo->soa.x[k];
+			glo->sat[k].x[1]		= glo->soa.y[k];
+			glo->sat[k].x[2]		= glo->soa.z[k];
+			glo->sat[k].v[0]		= glo->soa.vx[k];
+			glo->sat[k].v[1]		= glo->soa.vy[k];
+			glo->sat[k].v[2]		= glo->soa.vz[k];
+			glo->sat[k].t_em		= tem[j];
+			glo->sat[k].Deltatsv	= dts[j];
+			count++;
+		}
+		glo->soa.x_valid[i/lanes]		= valid;
+		glo->soa.v_valid[i/lanes]		= valid;
+		glo->soa.t_em_valid[i/lanes]	= valid;
+	}
+
+	return count;
+}
+
+	// fit Chebyshev segments for satellites marked pending over a given interval of satellite time, model being evaluated at pony_gnss_cheb_order nodes
+	// segment state: 0 - not fitted, 1 - fitted, -1 - model failed over the interval, 2 - pending fit
+	// input:
+	//		t0, len - fit interval start (seconds of week) and length, s
+	//		system, model - constellation and function computing satellite positions, velocities and clock offsets, see pony_gnss_cheb_eval
+	// output:
+	//		cheb - pending segments fitted or failed, ephemeris keys updated
+	//		maximum position error at midpoints between nodes, m
+double pony_gnss_cheb_fit(pony_gnss_cheb *cheb, pony_gnss_sat *sat, pony_gnss_sat_soa *soa, const double t0, const double len, void *system, int (*model)(void *system, const double t, double *pr))
+{
+	const double pi = 3.14159265358979323846;
+	const int n = pony_gnss_cheb_order;
+
+	double *seg, *coef, *val[7], x, f, b0, b1, b2, err = 0, d;
+	int i, j, k, m;
+
+	for (m = 0; m < 7; m++)
+		val[m] = (m == 0) ? soa->x : (m == 1) ? soa->y : (m == 2) ? soa->z : (m == 3) ? soa->vx : (m == 4) ? soa->vy : (m == 5) ? soa->vz : soa->Deltatsv;
+
+	// reset segments
+	for (i = 0; i < soa->count; i++) {
+		seg = cheb->seg + i*pony_gnss_cheb_size;
+		if (seg[6] != 2)
+			continue;
+		seg[0] = t0;
+		seg[1] = len;
+		seg[2] = sat[i].eph[2];
+		seg[3] = sat[i].eph[3]*3600 + sat[i].eph[4]*60 + sat[i].eph[5];
+		seg[4] = sat[i].eph[6];
+		seg[5] = sat[i].eph[9];
+		for (j = 0; j < 7*n; j++)
+			seg[7 + j] = 0;
+	}
+
+	// coefficients c_j = 2/n sum_k f(x_k) cos(pi j (k+1/2)/n), at nodes x_k = cos(pi (k+1/2)/n)
+	for (k = 0; k < n; k++) {
+		x = cos(pi*(k + 0.5)/n);
+		model(system, t0 + len/2*(1 + x), NULL);
+		for (i = 0; i < soa->count; i++) {
+			seg = cheb->seg + i*pony_gnss_cheb_size;
+			if (seg[6] != 2)
+				continue;
+			if (!sat[i].x_valid) {
+				seg[6] = -1;
+				continue;
+			}
+			coef = seg + 7;
+			for (m = 0; m < 7; m++)
+				for (j = 0, f = val[m][i]*2/n; j < n; j++)
+					coef[m*n + j] += f*cos(pi*j*(k + 0.5)/n);
+		}
+	}
+	for (i = 0; i < soa->count; i++) {
+		seg = cheb->seg + i*pony_gnss_cheb_size;
+		if (seg[6] != 2)
+			continue;
+		seg[6] = 1;
+		for (m = 0; m < 7; m++)
+			seg[7 + m*n] /= 2;
+	}
+
+	// position error at midpoints between nodes
+	for (k = 1; k < n; k++) {
+		x = cos(pi*k/n);
+		model(system, t0 + len/2*(1 + x), NULL);
+		for (i = 0; i < soa->count; i++) {
+			seg = cheb->seg + i*pony_gnss_cheb_size;
+			if (seg[6] != 1 || seg[0] != t0 || !sat[i].x_valid)
+				continue;
+			for (m = 0, d = 0; m < 3; m++) {
+				coef = seg + 7 + m*n;
+				for (j = n-1, b1 = 0, b2 = 0; j > 0; j--) {
+					b0 = coef[j] + 2*x*b1 - b2;
+					b2 = b1;
+					b1 = b0;
+				}
+				f = coef[0] + x*b1 - b2;
+				d += (f - val[m][i])*(f - val[m][i]);
+			}
+			if (d > err*err)
+				err = sqrt(d);
+		}
+	}
+
+	return err;
+}
+
+	// satellite positions, velocities, emission time and clock offset from Chebyshev orbit cache, with the same meaning as for the model
+	// segments are fitted to the model as functions of satellite time for all satellites out of their segments at once, on a common grid with a margin for different signal travel times,
+	// and refitted automatically when ephemeris changes or is invalidated, segment length is halved when accuracy bound is not met and doubled when it is met by far
+	// input:
+	//		sat, soa - constellation satellites with ephemeris and their structure-of-arrays view
+	//		cheb - Chebyshev orbit cache
+	//		t - time of signal reception, seconds of week
+	//		pr - array of soa->count pseudoranges, satellites with non-positive pseudoranges skipped, or NULL to compute at time t
+	//		c, u - speed of light and Earth rotation rate
+	//		system, model - constellation and function computing its satellite positions, velocities and clock offsets, e.g. pony_gnss_gps_kepler,
+	//			called with NULL pseudoranges to fill satellite array and its SoA view
+	// output:
+	//		sat, soa - coordinates, velocities, emission time and clock offset with validity flags
+	//		cheb - segments refitted if needed
+	//		number of satellites with coordinates computed
+int pony_gnss_cheb_eval(pony_gnss_sat *sat, pony_gnss_sat_soa *soa, pony_gnss_cheb *cheb, const double t, double *pr, const double c, const double u, void *system, int (*model)(void *system, const double t, double *pr))
+{
+	const double margin = 1, span_min = 10, span_max = 3600, half_week = 302400, week = 604800;
+	const int n = pony_gnss_cheb_order;
+
+	char need;
+	double *seg, *coef, tsv, dt, x, f[7], b0, b1, b2, t0, err, a, sina, cosa;
+	int i, j, m, count = 0;
+
+	if (cheb->seg == NULL)
+		return 0;
+
+	// satellites out of their segments or with ephemeris changed marked pending and fitted on a common grid by the first one
+	for (;;) {
+		for (i = 0, need = 0, t0 = 0; i < soa->count; i++) {
+			seg = cheb->seg + i*pony_gnss_cheb_size;
+			if (!sat[i].eph_valid)
+				seg[6] = 0;	// segment dropped, ephemeris may change before it is valid again
+			if (!sat[i].eph_valid || (pr != NULL && pr[i] <= 0))
+				continue;
+			tsv = (pr == NULL) ? t : t - pr[i]/c;
+			dt = tsv - seg[0];
+			dt -= week*floor((dt + half_week)/week);
+			if (seg[6] != 0 && dt >= 0 && dt <= seg[1] && seg[2] == sat[i].eph[2] && seg[3] == sat[i].eph[3]*3600 + sat[i].eph[4]*60 + sat[i].eph[5]
+				&& seg[4] == sat[i].eph[6] && seg[5] == sat[i].eph[9])
+				continue;
+			if (!need)
+				t0 = floor(tsv/cheb->span)*cheb->span - margin;
+			dt = tsv - t0;
+			dt -= week*floor((dt + half_week)/week);
+			if (dt < 0 || dt > cheb->span + 2*margin)
+				continue;
+			seg[6] = 2;
+			need = 1;
+		}
+		if (!need)
+			break;
+
+		// segment length halved and fitted again if accuracy bound is not met, doubled next time if met by far
+		err = pony_gnss_cheb_fit(cheb, sat, soa, t0, cheb->span + 2*margin, system, model);
+		if (err > cheb->tol && cheb->span > span_min) {
+			cheb->span /= 2;
+			for (i = 0; i < soa->count; i++)
+				if (cheb->seg[i*pony_gnss_cheb_size + 6] == 1 && cheb->seg[i*pony_gnss_cheb_size] == t0)
+					cheb->seg[i*pony_gnss_cheb_size + 6] = 0;
+		}
+		else if (err < cheb->tol/64 && cheb->span*2 <= span_max)
+			cheb->span *= 2;
+	}
+
+	// Clenshaw evaluation
+	for (i = 0; i < soa->count; i++) {
+		seg = cheb->seg + i*pony_gnss_cheb_size;
+		if (!sat[i].eph_valid || (pr != NULL && pr[i] <= 0) || seg[6] != 1) {
+			sat[i].x_valid = sat[i].v_valid = sat[i].t_em_valid = 0;
+			soa->x_valid[i/32] &= ~(1u << (i%32));
+			continue;
+		}
+		tsv = (pr == NULL) ? t : t - pr[i]/c;
+		dt = tsv - seg[0];
+		dt -= week*floor((dt + half_week)/week);
+		x = 2*dt/seg[1] - 1;
+		for (m = 0; m < 7; m++) {
+			coef = seg + 7 + m*n;
+			for (j = n-1, b1 = 0, b2 = 0; j > 0; j--) {
+				b0 = coef[j] + 2*x*b1 - b2;
+				b2 = b1;
+				b1 = b0;
+			}
+			f[m] = coef[0] + x*b1 - b2;
+		}
+
+		// Earth rotation during signal propagation, to the Earth-fixed frame at reception time
+		a = (pr == NULL) ? 0 : u*pr[i]/c;
+		sina = sin(a);
+		cosa = cos(a);
+		soa->x[i]			=  cosa*f[0] + sina*f[1];
+		soa->y[i]			= -sina*f[0] + cosa*f[1];
+		soa->z[i]			= f[2];
+		soa->vx[i]			=  cosa*f[3] + sina*f[4];
+		soa->vy[i]			= -sina*f[3] + cosa*f[4];
+		soa->vz[i]			= f[5];
+		soa->Deltatsv[i]	= f[6];
+		soa->t_em[i]		= tsv - f[6];
+
+		sat[i].x[0]			= soa->x[i];
+		sat[i].x[1]			= soa->y[i];
+		sat[i].x[2]			= soa->z[i];
+		sat[i].v[0]			= soa->vx[i];
+		sat[i].v[1]			= soa->vy[i];
+		sat[i].v[2]			= soa->vz[i];
+		sat[i].t_em			= soa->t_em[i];
+		sat[i].Deltatsv		= soa->Deltatsv[i];
+		sat[i].x_valid = sat[i].v_valid = sat[i].t_em_valid = 1;
+		soa->x_valid[i/32] |= 1u << (i%32);
+		count++;
+	}
+	for (i = 0; i < (soa->count + 31)/32; i++)
+		soa->v_valid[i] = soa->t_em_valid[i] = soa->x_valid[i];
+
+	return count;
+}
+
+	// orbit models for Chebyshev orbit cache
+int pony_gnss_cheb_model_gps(void *system, const double t, double *pr) { return pony_gnss_gps_kepler((pony_gnss_gps *)system, t, pr); }
+int pony_gnss_cheb_model_glo(void *system, const double t, double *pr) { return pony_gnss_glo_orbit ((pony_gnss_glo *)system, t, pr); }
+int pony_gnss_cheb_model_gal(void *system, const double t, double *pr) { return pony_gnss_gal_kepler((pony_gnss_gal *)system, t, pr); }
+int pony_gnss_cheb_model_bds(void *system, const double t, double *pr) { return pony_gnss_bds_kepler((pony_gnss_bds *)system, t, pr); }
+
+	// GPS satellites from Chebyshev orbit cache, see pony_gnss_cheb_eval and pony_gnss_gps_kepler
+int pony_gnss_gps_cheb(pony_gnss_gps *gps, const double t, double *pr)
+{
+	return pony_gnss_cheb_eval(gps->sat, &(gps->soa), &(gps->cheb), t, pr, pony->gnss_const.c, pony->gnss_const.gps.u, gps, pony_gnss_cheb_model_gps);
+}
+
+	// GLONASS satellites from Chebyshev orbit cache, see pony_gnss_cheb_eval and pony_gnss_glo_orbit
+int pony_gnss_glo_cheb(pony_gnss_glo *glo, const double t, double *pr)
+{
+	return pony_gnss_cheb_eval(glo->sat, &(glo->soa), &(glo->cheb), t, pr, pony->gnss_const.c, pony->gnss_const.glo.u, glo, pony_gnss_cheb_model_glo);
+}
+
+	// Galileo satellites from Chebyshev orbit cache, see pony_gnss_cheb_eval and pony_gnss_gal_kepler
+int pony_gnss_gal_cheb(pony_gnss_gal *gal, const double t, double *pr)
+{
+	return pony_gnss_cheb_eval(gal->sat, &(gal->soa), &(gal->cheb), t, pr, pony->gnss_const.c, pony->gnss_const.gal.u, gal, pony_gnss_cheb_model_gal);
+}
+
+	// BeiDou satellites from Chebyshev orbit cache, see pony_gnss_cheb_eval and pony_gnss_bds_kepler
+int pony_gnss_bds_cheb(pony_gnss_bds *bds, const double t, double *pr)
+{
+	return pony_gnss_cheb_eval(bds->sat, &(bds->soa), &(bds->cheb), t, pr, pony->gnss_const.c, pony->gnss_const.bds.u, bds, pony_gnss_cheb_model_bds);
+}
+
+	// constellation satellites and observation types by index: GPS, GLONASS, Galileo, BeiDou
+	// output:
+	//		sat, max_sat_count, max_eph_count, max_obs_count - satellites, their maximum number, number of ephemeris values and of observables reserved at init
+	//		obs_types, obs_count - pointers to constellation observation types and their number
+	//		1 if constellation is configured, 0 otherwise
+char pony_gnss_constellation(pony_gnss *gnss, const int s, pony_gnss_sat **sat, int *max_sat_count, int *max_eph_count, int *max_obs_count, char ****obs_types, int **obs_count)
+{
+	switch (s) {
+		case 0:
+			if (gnss->gps == NULL || gnss->gps->sat == NULL)
+				return 0;
+			*sat = gnss->gps->sat; *max_sat_count = gnss->gps->max_sat_count; *max_eph_count = gnss->gps->max_eph_count; *max_obs_count = gnss->gps->max_obs_count; *obs_types = &(gnss->gps->obs_types); *obs_count = &(gnss->gps->obs_count);
+			return 1;
+		case 1:
+			if (gnss->glo == NULL || gnss->glo->sat == NULL)
+				return 0;
+			*sat = gnss->glo->sat; *max_sat_count = gnss->glo->max_sat_count; *max_eph_count = gnss->glo->max_eph_count; *max_obs_count = gnss->glo->max_obs_count; *obs_types = &(gnss->glo->obs_types); *obs_count = &(gnss->glo->obs_count);
+			return 1;
+		case 2:
+			if (gnss->gal == NULL || gnss->gal->sat == NULL)
+				return 0;
+			*sat = gnss->gal->sat; *max_sat_count = gnss->gal->max_sat_count; *max_eph_count = gnss->gal->max_eph_count; *max_obs_count = gnss->gal->max_obs_count; *obs_types = &(gnss->gal->obs_types); *obs_count = &(gnss->gal->obs_count);
+			return 1;
+		case 3:
+			if (gnss->bds == NULL || gnss->bds->sat == NULL)
+				return 0;
+			*sat = gnss->bds->sat; *max_sat_count = gnss->bds->max_sat_count; *max_eph_count = gnss->bds->max_eph_count; *max_obs_count = gnss->bds->max_obs_count; *obs_types = &(gnss->bds->obs_types); *obs_count = &(gnss->bds->obs_count);
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+	// constellation ionospheric model and clock correction parameters by index: GPS, GLONASS, Galileo, BeiDou
+	// output:
+	//		iono_a, iono_b, iono_valid - ionospheric model parameters (4 + 4, or 3 for Galileo with iono_b NULL) and validity flag, all NULL for GLONASS
+	//		clock_corr, clock_corr_to, clock_corr_valid - clock correction parameters, target time system and validity flag
+	//		1 if constellation is configured, 0 otherwise
+char pony_gnss_constellation_params(pony_gnss *gnss, const int s, double **iono_a, double **iono_b, char **iono_valid, double **clock_corr, char **clock_corr_to, char **clock_corr_valid)
+{
+	*iono_a = *iono_b = NULL;
+	*iono_valid = NULL;
+	switch (s) {
+		case 0:
+			if (gnss->gps == NULL)
+				return 0;
+			*iono_a = gnss->gps->iono_a; *iono_b = gnss->gps->iono_b; *iono_valid = &(gnss->gps->iono_valid);
+			*clock_corr = gnss->gps->clock_corr; *clock_corr_to = gnss->gps->clock_corr_to; *clock_corr_valid = &(gnss->gps->clock_corr_valid);
+			return 1;
+		case 1:
+			if (gnss->glo == NULL)
+				return 0;
+			*clock_corr = gnss->glo->clock_corr; *clock_corr_to = gnss->glo->clock_corr_to; *clock_corr_valid = &(gnss->glo->clock_corr_valid);
+			return 1;
+		case 2:
+			if (gnss->gal == NULL)
+				return 0;
+			*iono_a = gnss->gal->iono; *iono_valid = &(gnss->gal->iono_valid);
+			*clock_corr = gnss->gal->clock_corr; *clock_corr_to = gnss->gal->clock_corr_to; *clock_corr_valid = &(gnss->gal->clock_corr_valid);
+			return 1;
+		case 3:
+			if (gnss->bds == NULL)
+				return 0;
+			*iono_a = gnss->bds->iono_a; *iono_b = gnss->bds->iono_b; *iono_valid = &(gnss->bds->iono_valid);
+			*clock_corr = gnss->bds->clock_corr; *clock_corr_to = gnss->bds->clock_corr_to; *clock_corr_valid = &(gnss->bds->clock_corr_valid);
+			return 1;
+		default:
+			return 0;
+	}
+}
+
+
+
+
+
+
+
+// RINEX input routines
+	// number in a fixed-width field of a line, in the form of [sign]digits[.digits][exponent], e.g. F14.3 observable or D19.12 ephemeris with Fortran-style D exponent
+	// computed as a single multiplication or division by an exact power of ten where this is correctly rounded, by strtod otherwise
+	// input:
+	//		line, len - line and its length without end-of-line characters
+	//		col, width - field start column (zero-based) and width
+	// output:
+	//		val - number parsed, unchanged if the field is blank or outside the line
+	//		1 if a number has been parsed, 0 otherwise
+char pony_rinex_field(const char *line, const int len, const int col, const int width, double *val)
+{
+	const double pow10[] = {1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+	const int max_pow10 = 22;
+
+	const char *p, *start, *end;
+	char buf[64];
+	double m;
+	int frac, ex, i, sig;
+	char neg, digits, eneg;
+
+	if (col >= len)
+		return 0;
+	p = line + col;
+	end = line + ((col + width < len) ? col + width : len);
+	for (; p < end && *p == ' '; p++);
+	if (p == end)
+		return 0;
+	start = p;
+	neg = (*p == '-');
+	if (*p == '-' || *p == '+')
+		p++;
+	for (m = 0, digits = 0, sig = 0; p < end && *p >= '0' && *p <= '9'; p++, digits = 1, sig += (m > 0))
+		m = m*10 + (*p - '0');
+	frac = 0;
+	if (p < end && *p == '.')
+		for (p++; p < end && *p >= '0' && *p <= '9'; p++, frac++, digits = 1, sig += (m > 0))
+			m = m*10 + (*p - '0');
+	if (!digits)
+		return 0;
+	ex = 0;
+	if (p < end && (*p == 'D' || *p == 'd' || *p == 'E' || *p == 'e')) {
+		p++;
+		eneg = (p < end && *p == '-');
+		if (p < end && (*p == '-' || *p == '+'))
+			p++;
+		for (; p < end && *p >= '0' && *p <= '9'; p++)
+			ex = ex*10 + (*p - '0');
+		if (eneg)
+			ex = -ex;
+	}
+	ex -= frac;
+	if (sig <= 15 && ex >= -max_pow10 && ex <= max_pow10)
+		m = (ex >= 0) ? m*pow10[ex] : m/pow10[-ex];
+	else {
+		for (i = 0; start + i < p && i < (int)sizeof(buf) - 1; i++)
+			buf[i] = (start[i] == 'D' || start[i] == 'd') ? 'E' : start[i];
+		buf[i] = '\0';
+		m = fabs(strtod(buf, NULL));
+	}
+	*val = neg ? -m : m;
+	return 1;
+}
+
+	// integer in a fixed-width field of a line, zero if blank
+int pony_rinex_int(const char *line, const int len, const int col, const int width)
+{
+	double val = 0;
+
+	pony_rinex_field(line, len, col, width, &val);
+	return (int)val;
+}
+
+	// next line of file contents
+	// input:
+	//		data, size - file contents
+	//		pos - current position
+	// output:
+	//		line, len - line start and length without end-of-line characters
+	//		pos - advanced to the next line
+	//		1 if a line is available, 0 at the end of file
+char pony_rinex_line(char *data, const unsigned long size, unsigned long *pos, char **line, int *len)
+{
+	unsigned long i;
+
+	if (*pos >= size)
+		return 0;
+	*line = data + *pos;
+	for (i = *pos; i < size && data[i] != '\n'; i++);
+	*len = (int)(i - *pos);
+	if (*len > 0 && (*line)[*len - 1] == '\r')
+		(*len)--;
+	*pos = (i < size) ? i + 1 : i;
+	return 1;
+}
+
+	// check header line label, given from column 61 on
+char pony_rinex_label(const char *label, const int len, const char *name)
+{
+	int i;
+
+	for (i = 0; name[i] && i < len && label[i] == name[i]; i++);
+	return (name[i] == '\0');
+}
+
+	// constellation index (GPS, GLONASS, Galileo, BeiDou) for a RINEX satellite system identifier, -1 if not supported
+int pony_rinex_system(const char sys)
+{
+	switch (sys) {
+		case ' ':
+		case 'G': return 0;
+		case 'R': return 1;
+		case 'E': return 2;
+		case 'C': return 3;
+		default : return -1;
+	}
+}
+
+	// RINEX 2 observation type in RINEX 3 notation, tracking mode assumed: P-code as W for GPS and P for GLONASS, C/A on band 1, L2C as X, X on other bands
+void pony_rinex_type2to3(char *t3, const char *t2, const int s)
+{
+	const int glo = 1;
+
+	t3[0] = (t2[0] == 'P') ? 'C' : t2[0];
+	t3[1] = t2[1];
+	if (t2[0] == 'P')
+		t3[2] = (s == glo) ? 'P' : 'W';
+	else if (t2[1] == '1')
+		t3[2] = 'C';
+	else if (t2[1] == '2')
+		t3[2] = (t2[0] == 'C') ? ((s == glo) ? 'C' : 'X') : ((s == glo) ? 'P' : 'W');
+	else
+		t3[2] = 'X';
+	t3[3] = '\0';
+}
+
+	// read file contents: memory-mapped if possible, read into allocated buffer otherwise
+	// output:
+	//		data, size - file contents and size
+	//		mapped - memory-mapped (1) or allocated (0)
+	//		OK/not OK (1/0)
+char pony_file_load(const char *file_name, char **data, unsigned long *size, char *mapped)
+{
+	const unsigned long chunk = 1 << 20;
+
+	FILE *fp;
+	char *buf, *tmp;
+	unsigned long cap, n;
+#ifdef PONY_MMAP
+	struct stat st;
+	int fd;
+
+	fd = open(file_name, O_RDONLY);
+	if (fd >= 0) {
+		if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+			buf = (char *)mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (buf != (char *)MAP_FAILED) {
+				posix_madvise(buf, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+				close(fd);
+				*data = buf;
+				*size = (unsigned long)st.st_size;
+				*mapped = 1;
+				return 1;
+			}
+		}
+		close(fd);
+	}
+#endif
+
+	fp = fopen(file_name, "rb");
+	if (fp == NULL)
+		return 0;
+	for (buf = NULL, cap = 0, n = 0; ; n += (unsigned long)fread(buf + n, 1, cap - n, fp)) {
+		if (n < cap)
+			break;
+		cap = (cap == 0) ? chunk : 2*cap;
+		tmp = (char *)realloc(buf, cap);
+		if (tmp == NULL) {
+			free(buf);
+			fclose(fp);
+			return 0;
+		}
+		buf = tmp;
+	}
+	fclose(fp);
+	*data = buf;
+	*size = n;
+	*mapped = 0;
+	return 1;
+}
+
+	// release file contents read by pony_file_load
+void pony_file_unload(char *data, const unsigned long size, const char mapped)
+{
+	if (data == NULL)
+		return;
+#ifdef PONY_MMAP
+	if (mapped) {
+		munmap(data, (size_t)size);
+		return;
+	}
+#else
+	(void)size;
+	(void)mapped;
+#endif
+	free(data);
+}
+
+	// open RINEX 2/3 observation file and parse its header
+	// constellations with observation types set before get file observation types mapped to them by name,
+	// others adopt file observation types, up to the number of observables reserved at init if configured,
+	// satellite observables and validity flags are allocated by the reader if neither reserved at init nor allocated elsewhere
+	// input:
+	//		gnss - GNSS data with constellations initialized
+	//		file_name - RINEX observation file name, e.g. given by obs_in key in constellation configuration
+	// output:
+	//		rnx - reader positioned at the first epoch
+	//		gnss - constellation observation types and observables set up, epoch time scale in gnss->time.scale
+	//		OK/not OK (1/0)
+char pony_rinex_obs_open(pony_rinex_obs *rnx, pony_gnss *gnss, const char *file_name)
+{
+	const int label_col = 60;
+
+	pony_gnss_sat *sat;
+	char *line, *label, ***obs_types, t2[2];
+	int len, s, i, j, k, n, max_sat_count, max_eph_count, max_obs_count, *obs_count, count2 = 0;
+	char sys = ' ', header = 0, time_sys = ' ';
+
+	rnx->data = NULL;
+	rnx->size = 0;
+	rnx->pos = 0;
+	rnx->mapped = 0;
+	rnx->version = 0;
+	rnx->sys = 'G';
+	rnx->gnss = gnss;
+	for (s = 0; s < 4; s++) {
+		rnx->sat[s] = NULL;
+		rnx->sat_count[s] = 0;
+		rnx->obs_count[s] = 0;
+		rnx->type_count[s] = 0;
+		rnx->adopted[s] = 0;
+		rnx->obs_block[s] = NULL;
+	}
+	if (gnss == NULL || !pony_file_load(file_name, &(rnx->data), &(rnx->size), &(rnx->mapped)))
+		return 0;
+
+	// header
+	while (pony_rinex_line(rnx->data, rnx->size, &(rnx->pos), &line, &len)) {
+		if (len <= label_col)
+			continue;
+		label = line + label_col;
+		if (pony_rinex_label(label, len - label_col, "RINEX VERSION / TYPE")) {
+			pony_rinex_field(line, len, 0, 9, &(rnx->version));
+			if (len > 40 && line[40] != ' ')
+				rnx->sys = line[40];
+		}
+		else if (pony_rinex_label(label, len - label_col, "# / TYPES OF OBSERV")) {	// RINEX 2, common to all systems
+			n = pony_rinex_int(line, len, 0, 6);
+			if (n > 0)
+				count2 = n;
+			for (j = 10; j + 2 <= label_col && rnx->type_count[0] < count2 && rnx->type_count[0] < pony_rinex_max_obs_types; j += 6) {
+				t2[0] = line[j];
+				t2[1] = line[j + 1];
+				for (s = 0; s < 4; s++)
+					pony_rinex_type2to3(rnx->types[s][rnx->type_count[0]], t2, s);
+				for (s = 0, n = rnx->type_count[0] + 1; s < 4; s++)
+					rnx->type_count[s] = n;
+			}
+		}
+		else if (pony_rinex_label(label, len - label_col, "SYS / # / OBS TYPES")) {	// RINEX 3, by system
+			if (line[0] != ' ') {
+				sys = line[0];
+				count2 = pony_rinex_int(line, len, 3, 3);
+			}
+			s = pony_rinex_system(sys);
+			if (s < 0 || sys == ' ')
+				continue;
+			for (j = 7; j + 3 <= label_col && rnx->type_count[s] < count2 && rnx->type_count[s] < pony_rinex_max_obs_types; j += 4) {
+				for (k = 0; k < 3; k++)
+					rnx->types[s][rnx->type_count[s]][k] = line[j + k];
+				rnx->types[s][rnx->type_count[s]][3] = '\0';
+				rnx->type_count[s]++;
+			}
+		}
+		else if (pony_rinex_label(label, len - label_col, "TIME OF FIRST OBS")) {	// time system: GPS, GLO, GAL, BDT
+			if (len > 50)
+				time_sys = (line[48] == 'G' && line[49] == 'L') ? 'R' : (line[48] == 'G' && line[49] == 'A') ? 'E' : (line[48] == 'B') ? 'C' : (line[48] == 'G') ? 'G' : ' ';
+		}
+		else if (pony_rinex_label(label, len - label_col, "END OF HEADER")) {
+			header = 1;
+			break;
+		}
+	}
+	if (!header || rnx->version < 1 || rnx->version >= 5) {
+		pony_rinex_obs_close(rnx);
+		return 0;
+	}
+
+	// epoch time scale: as given, or of the file system
+	if (time_sys == ' ')
+		time_sys = rnx->sys;
+	gnss->time.scale = (time_sys == 'R') ? pony_time_glo : (time_sys == 'E') ? pony_time_gal : (time_sys == 'C') ? pony_time_bds : pony_time_gps;
+	gnss->time.valid = 0;
+
+	// observables set up for each constellation
+	for (s = 0; s < 4; s++) {
+		if (!pony_gnss_constellation(gnss, s, &sat, &max_sat_count, &max_eph_count, &max_obs_count, &obs_types, &obs_count))
+			continue;
+		rnx->sat[s] = sat;
+		rnx->sat_count[s] = max_sat_count;
+		for (k = 0; k < rnx->type_count[s]; k++)
+			rnx->type_index[s][k] = -1;
+		if (*obs_types != NULL && *obs_count > 0) {	// types set before
+			n = *obs_count;
+			if (max_obs_count > 0 && n > max_obs_count)
+				n = max_obs_count;
+			for (k = 0; k < rnx->type_count[s]; k++)
+				for (i = 0; i < n; i++)
+					if ((*obs_types)[i][0] == rnx->types[s][k][0] && (*obs_types)[i][1] == rnx->types[s][k][1] && (*obs_types)[i][2] == rnx->types[s][k][2]) {
+						rnx->type_index[s][k] = i;
+						break;
+					}
+		}
+		else {										// file types adopted
+			n = rnx->type_count[s];
+			if (max_obs_count > 0 && n > max_obs_count)
+				n = max_obs_count;
+			for (k = 0; k < n; k++) {
+				rnx->type_ptr[s][k] = rnx->types[s][k];
+				rnx->type_index[s][k] = k;
+			}
+			*obs_types = (n > 0) ? rnx->type_ptr[s] : NULL;
+			*obs_count = n;
+			rnx->adopted[s] = 1;
+		}
+		rnx->obs_count[s] = n;
+		if (max_obs_count == 0 && n > 0 && sat[0].obs == NULL) {
+			rnx->obs_block[s] = calloc((size_t)max_sat_count*n, sizeof(double) + sizeof(char));
+			if (rnx->obs_block[s] == NULL) {
+				pony_rinex_obs_close(rnx);
+				return 0;
+			}
+			for (i = 0; i < max_sat_count; i++) {
+				sat[i].obs = (double *)rnx->obs_block[s] + i*n;
+				sat[i].obs_valid = (char *)((double *)rnx->obs_block[s] + max_sat_count*n) + i*n;
+			}
+		}
+	}
+
+	return 1;
+}
+
+	// parse the next observation epoch: epoch time into gnss->epoch, observables of satellites listed into their obs/obs_valid,
+	// observables of all other satellites invalidated, event and cycle slip records skipped
+	// input:
+	//		rnx - reader opened with pony_rinex_obs_open
+	// output:
+	//		rnx - positioned at the next epoch
+	//		gnss - epoch and observables
+	//		epoch read/end of file or error (1/0)
+char pony_rinex_obs_read(pony_rinex_obs *rnx)
+{
+	const int max_epoch_sat = 999, obs_width = 16, obs_per_line2 = 5, sat_per_line2 = 12;
+
+	char *line, *eline, *id[999], v3;
+	int len, elen, flag, count, s, i, j, k, prn, lines2, col;
+	double sec;
+	pony_gnss_sat *sat;
+
+	if (rnx->data == NULL)
+		return 0;
+	v3 = (rnx->version >= 3);
+	lines2 = (rnx->type_count[0] + obs_per_line2 - 1)/obs_per_line2;
+
+	for (;;) {
+		// epoch record
+		do
+			if (!pony_rinex_line(rnx->data, rnx->size, &(rnx->pos), &line, &len))
+				return 0;
+		while (len == 0 || (v3 && line[0] != '>'));
+		eline = line;
+		elen = len;
+		if (v3) {
+			flag  = pony_rinex_int(line, len, 31, 1);
+			count = pony_rinex_int(line, len, 32, 3);
+		}
+		else {
+			flag  = pony_rinex_int(line, len, 28, 1);
+			count = pony_rinex_int(line, len, 29, 3);
+		}
+		if (count > max_epoch_sat)
+			return 0;
+
+		// event records: special lines follow
+		if (flag >= 2 && flag <= 5) {
+			for (i = 0; i < count; i++)
+				if (!pony_rinex_line(rnx->data, rnx->size, &(rnx->pos), &line, &len))
+					return 0;
+			continue;
+		}
+
+		// satellite list for RINEX 2, on the epoch line and continuation lines
+		if (!v3)
+			for (i = 0; i < count; i++) {
+				if (i > 0 && i%sat_per_line2 == 0 && !pony_rinex_line(rnx->data, rnx->size, &(rnx->pos), &line, &len))
+					return 0;
+				col = 32 + 3*(i%sat_per_line2);
+				id[i] = (col + 3 <= len) ? line + col : NULL;
+			}
+
+		// cycle slip records
+		if (flag == 6) {
+			for (i = 0, k = v3 ? count : count*lines2; i < k; i++)
+				if (!pony_rinex_line(rnx->data, rnx->size, &(rnx->pos), &line, &len))
+					return 0;
+			continue;
+		}
+		break;
+	}
+
+	// epoch time
+	if (v3) {
+		rnx->gnss->epoch.Y = pony_rinex_int(line, len, 2, 4);
+		rnx->gnss->epoch.M = pony_rinex_int(line, len, 7, 2);
+		rnx->gnss->epoch.D = pony_rinex_int(line, len, 10, 2);
+		rnx->gnss->epoch.h = pony_rinex_int(line, len, 13, 2);
+		rnx->gnss->epoch.m = pony_rinex_int(line, len, 16, 2);
+		sec = 0;
+		pony_rinex_field(line, len, 18, 11, &sec);
+	}
+	else {
+		line = eline;
+		len = elen;
+		rnx->gnss->epoch.Y = pony_rinex_int(line, len, 0, 3);
+		rnx->gnss->epoch.Y += (rnx->gnss->epoch.Y < 80) ? 2000 : 1900;
+		rnx->gnss->epoch.M = pony_rinex_int(line, len, 3, 3);
+		rnx->gnss->epoch.D = pony_rinex_int(line, len, 6, 3);
+		rnx->gnss->epoch.h = pony_rinex_int(line, len, 9, 3);
+		rnx->gnss->epoch.m = pony_rinex_int(line, len, 12, 3);
+		sec = 0;
+		pony_rinex_field(line, len, 15, 11, &sec);
+	}
+	rnx->gnss->epoch.s = sec;
+
+	// observables invalidated for all satellites
+	for (s = 0; s < 4; s++)
+		for (i = 0, sat = rnx->sat[s]; sat != NULL && rnx->obs_count[s] > 0 && i < rnx->sat_count[s]; i++)
+			for (j = 0; j < rnx->obs_count[s]; j++)
+				sat[i].obs_valid[j] = 0;
+
+	// satellite records
+	for (i = 0; i < count; i++) {
+		if (!pony_rinex_line(rnx->data, rnx->size, &(rnx->pos), &line, &len))
+			return 0;
+		if (v3) {
+			if (len < 3)
+				continue;
+			s = pony_rinex_system(line[0]);
+			prn = pony_rinex_int(line, len, 1, 2);
+		}
+		else {
+			if (id[i] == NULL)
+				s = -1, prn = 0;
+			else {
+				s = pony_rinex_system((id[i][0] == ' ') ? rnx->sys : id[i][0]);
+				prn = pony_rinex_int(id[i], 3, 1, 2);
+			}
+		}
+		sat = (s < 0) ? NULL : rnx->sat[s];
+		if (sat == NULL || prn < 1 || prn > rnx->sat_count[s] || rnx->obs_count[s] == 0) {
+			for (j = 1; !v3 && j < lines2; j++)
+				if (!pony_rinex_line(rnx->data, rnx->size, &(rnx->pos), &line, &len))
+					return 0;
+			continue;
+		}
+		sat += prn - 1;
+		for (k = 0; k < rnx->type_count[s]; k++) {
+			if (!v3 && k > 0 && k%obs_per_line2 == 0 && !pony_rinex_line(rnx->data, rnx->size, &(rnx->pos), &line, &len))
+				return 0;
+			j = rnx->type_index[s][k];
+			col = v3 ? 3 + k*obs_width : (k%obs_per_line2)*obs_width;
+			if (j >= 0)
+				sat->obs_valid[j] = pony_rinex_field(line, len, col, obs_width - 2, &(sat->obs[j]));
+		}
+		for (k = (rnx->type_count[s] + obs_per_line2 - 1)/obs_per_line2; !v3 && k < lines2; k++)	// no types for this system
+			if (!pony_rinex_line(rnx->data, rnx->size, &(rnx->pos), &line, &len))
+				return 0;
+	}
+
+	return 1;
+}
+
+	// release file and memory allocated by the reader, detach observation types and observables it has set
+void pony_rinex_obs_close(pony_rinex_obs *rnx)
+{
+	pony_gnss_sat *sat;
+	char ***obs_types;
+	int s, i, max_sat_count, max_eph_count, max_obs_count, *obs_count;
+
+	for (s = 0; s < 4; s++) {
+		if (rnx->gnss != NULL && pony_gnss_constellation(rnx->gnss, s, &sat, &max_sat_count, &max_eph_count, &max_obs_count, &obs_types, &obs_count)) {
+			if (rnx->obs_block[s] != NULL)
+				for (i = 0; i < max_sat_count; i++) {
+					sat[i].obs = NULL;
+					sat[i].obs_valid = NULL;
+				}
+			if (rnx->adopted[s]) {
+				*obs_types = NULL;
+				*obs_count = 0;
+			}
+		}
+		free(rnx->obs_block[s]);
+		rnx->obs_block[s] = NULL;
+		rnx->adopted[s] = 0;
+		rnx->sat[s] = NULL;
+		rnx->obs_count[s] = 0;
+	}
+
+	pony_file_unload(rnx->data, rnx->size, rnx->mapped);
+	rnx->data = NULL;
+	rnx->size = 0;
+	rnx->pos = 0;
+}
+
+	// file size and modification time to validate binary caches against, zero modification time if not available
+char pony_file_stamp(const char *file_name, double *size, double *mtime)
+{
+#ifdef PONY_MMAP
+	struct stat st;
+
+	if (stat(file_name, &st) != 0)
+		return 0;
+	*size = (double)st.st_size;
+	*mtime = (double)st.st_mtime;
+	return 1;
+#else
+	FILE *fp;
+
+	fp = fopen(file_name, "rb");
+	if (fp == NULL || fseek(fp, 0, SEEK_END) != 0) {
+		if (fp != NULL)
+			fclose(fp);
+		return 0;
+	}
+	*size = (double)ftell(fp);
+	*mtime = 0;
+	fclose(fp);
+	return 1;
+#endif
+}
+
+	// compare ephemeris records by constellation, satellite and epoch, for qsort
+int pony_rinex_nav_compare(const void *a, const void *b)
+{
+	const double *ra = (const double *)a, *rb = (const double *)b;
+	int i;
+
+	for (i = 0; i < 3 + 6; i++)	// constellation, satellite, skipping number of values, epoch
+		if (i != 2 && ra[i] != rb[i])
+			return (ra[i] < rb[i]) ? -1 : 1;
+	return 0;
+}
+
+	// parse RINEX 2/3 navigation file text into binary cache image
+	// input:
+	//		text, size - navigation file contents
+	// output:
+	//		nav - image allocated and filled, records sorted
+	//		OK/not OK (1/0)
+char pony_rinex_nav_parse(pony_rinex_nav *nav, char *text, const unsigned long size)
+{
+	const int head = pony_rinex_nav_head, rec_size = 3 + pony_rinex_nav_width, param_count = 16, label_col = 60, value_width = 19;
+
+	double version = 0, *rec, *param;
+	char *line, *label, *image, *tmp, sys = 'G', v3;
+	int len, s, i, j, k, n, cap, count;
+	unsigned long pos = 0;
+
+	// header
+	image = (char *)calloc((size_t)head, sizeof(double));
+	if (image == NULL)
+		return 0;
+	param = (double *)image + pony_rinex_nav_head - pony_rinex_nav_params;
+	for (;;) {
+		if (!pony_rinex_line(text, size, &pos, &line, &len)) {
+			free(image);
+			return 0;
+		}
+		if (len <= label_col)
+			continue;
+		label = line + label_col;
+		if (pony_rinex_label(label, len - label_col, "RINEX VERSION / TYPE")) {
+			pony_rinex_field(line, len, 0, 9, &version);
+			sys = (line[20] == 'N') ? 'G' : (line[20] == 'G') ? 'R' : line[20];	// RINEX 2 file type, RINEX 3 records give their systems
+		}
+		else if (pony_rinex_label(label, len - label_col, "IONOSPHERIC CORR")) {		// RINEX 3: GPSA, GPSB, GAL, BDSA, BDSB
+			s = (line[0] == 'G' && line[1] == 'P') ? 0 : (line[0] == 'G' && line[1] == 'A') ? 2 : (line[0] == 'B' && line[1] == 'D') ? 3 : -1;
+			if (s < 0)
+				continue;
+			j = (line[3] == 'B') ? 4 : 0;
+			for (k = 0; k < 4; k++)
+				pony_rinex_field(line, len, 5 + 12*k, 12, param + s*param_count + j + k);
+			param[s*param_count + 8] += 1;
+		}
+		else if (pony_rinex_label(label, len - label_col, "ION ALPHA") || pony_rinex_label(label, len - label_col, "ION BETA")) {	// RINEX 2 GPS
+			j = (label[4] == 'B') ? 4 : 0;
+			for (k = 0; k < 4; k++)
+				pony_rinex_field(line, len, 2 + 12*k, 12, param + j + k);
+			param[8] += 1;
+		}
+		else if (pony_rinex_label(label, len - label_col, "TIME SYSTEM CORR")) {		// RINEX 3: GPUT, GLUT, GAUT, BDUT, GAGP, etc., corrections to UTC preferred
+			s = (line[0] == 'G' && line[1] == 'P') ? 0 : (line[0] == 'G' && line[1] == 'L') ? 1 : (line[0] == 'G' && line[1] == 'A') ? 2 : (line[0] == 'B' && line[1] == 'D') ? 3 : -1;
+			if (s < 0 || (param[s*param_count + 15] && !(line[2] == 'U' && line[3] == 'T')))
+				continue;
+			pony_rinex_field(line, len,  5, 17, param + s*param_count +  9);
+			pony_rinex_field(line, len, 22, 16, param + s*param_count + 10);
+			pony_rinex_field(line, len, 38,  7, param + s*param_count + 11);
+			pony_rinex_field(line, len, 45,  5, param + s*param_count + 12);
+			param[s*param_count + 13] = line[2];
+			param[s*param_count + 14] = line[3];
+			param[s*param_count + 15] = 1;
+		}
+		else if (pony_rinex_label(label, len - label_col, "DELTA-UTC: A0,A1,T,W")) {	// RINEX 2 GPS
+			pony_rinex_field(line, len,  3, 19, param +  9);
+			pony_rinex_field(line, len, 22, 19, param + 10);
+			pony_rinex_field(line, len, 41,  9, param + 11);
+			pony_rinex_field(line, len, 50,  9, param + 12);
+			param[13] = 'U';
+			param[14] = 'T';
+			param[15] = 1;
+		}
+		else if (pony_rinex_label(label, len - label_col, "CORR TO SYSTEM TIME")) {	// RINEX 2 GLONASS: -tauC
+			pony_rinex_field(line, len, 21, 19, param + param_count + 9);
+			param[param_count + 13] = 'U';
+			param[param_count + 14] = 'T';
+			param[param_count + 15] = 1;
+		}
+		else if (pony_rinex_label(label, len - label_col, "LEAP SECONDS")) {
+			pony_rinex_field(line, len, 0, 6, param + 4*param_count);
+			param[4*param_count + 1] = 1;
+		}
+		else if (pony_rinex_label(label, len - label_col, "END OF HEADER"))
+			break;
+	}
+	if (version < 1 || version >= 5) {
+		free(image);
+		return 0;
+	}
+	v3 = (version >= 3);
+
+	// ephemeris records: first line with satellite, epoch and clock, continuation lines starting with blanks
+	for (count = 0, cap = 0, rec = NULL, n = 0; pony_rinex_line(text, size, &pos, &line, &len); ) {
+		if (len == 0)
+			continue;
+		if (line[0] != ' ' || (!v3 && line[1] != ' ')) {	// new record
+			s = pony_rinex_system(v3 ? line[0] : sys);
+			if (s < 0) {
+				n = -1;
+				continue;
+			}
+			if (count == cap) {
+				cap = (cap == 0) ? 1024 : 2*cap;
+				tmp = (char *)realloc(image, ((size_t)head + (size_t)cap*rec_size)*sizeof(double));
+				if (tmp == NULL) {
+					free(image);
+					return 0;
+				}
+				image = tmp;
+			}
+			rec = (double *)image + head + (size_t)count*rec_size;
+			count++;
+			for (i = 0; i < rec_size; i++)
+				rec[i] = 0;
+			rec[0] = s;
+			if (v3) {
+				rec[1] = pony_rinex_int(line, len, 1, 2);
+				rec[3] = pony_rinex_int(line, len, 4, 4);
+				for (k = 0; k < 5; k++)
+					rec[4 + k] = pony_rinex_int(line, len, 9 + 3*k, 2);
+				j = 23;
+			}
+			else {
+				rec[1] = pony_rinex_int(line, len, 0, 2);
+				rec[3] = pony_rinex_int(line, len, 3, 2);
+				rec[3] += (rec[3] < 80) ? 2000 : 1900;
+				for (k = 0; k < 4; k++)
+					rec[4 + k] = pony_rinex_int(line, len, 6 + 3*k, 2);
+				pony_rinex_field(line, len, 17, 5, rec + 8);
+				j = 22;
+			}
+			for (k = 0, n = 6; k < 3; k++, n++)
+				pony_rinex_field(line, len, j + value_width*k, value_width, rec + 3 + n);
+		}
+		else if (n >= 0 && rec != NULL) {					// broadcast orbit line
+			j = v3 ? 4 : 3;
+			for (k = 0; k < 4 && n < pony_rinex_nav_width; k++, n++)
+				pony_rinex_field(line, len, j + value_width*k, value_width, rec + 3 + n);
+		}
+		if (rec != NULL && n >= 0)
+			rec[2] = n;
+	}
+
+	// image header
+	rec = (double *)image;
+	for (i = 0; i < 8; i++)
+		image[i] = "PONYNAV"[i];
+	rec[1] = pony_rinex_nav_version;
+	rec[2] = 1.0/3;		// floating-point format check
+	rec[3] = pony_rinex_nav_width;
+	rec[4] = count;
+	qsort(rec + head, (size_t)count, rec_size*sizeof(double), pony_rinex_nav_compare);
+
+	nav->data = image;
+	nav->size = ((unsigned long)head + (unsigned long)count*rec_size)*sizeof(double);
+	nav->mapped = 0;
+	return 1;
+}
+
+	// set up navigation data pointers to binary cache image, checking its format
+char pony_rinex_nav_image(pony_rinex_nav *nav, const double src_size, const double src_mtime)
+{
+	const int head = pony_rinex_nav_head, rec_size = 3 + pony_rinex_nav_width;
+
+	double *hdr = (double *)nav->data;
+	int i;
+
+	if (nav->data == NULL || nav->size < head*sizeof(double))
+		return 0;
+	for (i = 0; i < 8; i++)
+		if (nav->data[i] != "PONYNAV"[i])
+			return 0;
+	if (hdr[1] != pony_rinex_nav_version || hdr[2] != 1.0/3 || hdr[3] != pony_rinex_nav_width || hdr[4] < 0
+		|| nav->size != ((unsigned long)head + (unsigned long)hdr[4]*rec_size)*sizeof(double))
+		return 0;
+	if (src_size >= 0 && (hdr[5] != src_size || hdr[6] != src_mtime))
+		return 0;
+	nav->param = hdr + pony_rinex_nav_head - pony_rinex_nav_params;
+	nav->count = (int)hdr[4];
+	nav->rec = hdr + head;
+	return 1;
+}
+
+	// load RINEX 2/3 navigation data: from binary cache if it is valid for the navigation file, parsed from text otherwise,
+	// then saved to binary cache to be memory-mapped on the next start
+	// input:
+	//		file_name - RINEX navigation file name, e.g. given by eph_in key in constellation configuration
+	//		cache_name - binary cache file name, e.g. file_name with an extension added, NULL if not used
+	// output:
+	//		nav - navigation data with all ephemeris records and header parameters
+	//		OK/not OK (1/0)
+char pony_rinex_nav_open(pony_rinex_nav *nav, const char *file_name, const char *cache_name)
+{
+	double src_size, src_mtime;
+	char *text, mapped, written;
+	unsigned long size;
+	FILE *fp;
+
+	nav->data = NULL;
+	nav->size = 0;
+	nav->mapped = 0;
+	nav->cached = 0;
+	nav->param = NULL;
+	nav->count = 0;
+	nav->rec = NULL;
+	if (!pony_file_stamp(file_name, &src_size, &src_mtime))
+		return 0;
+
+	// binary cache
+	if (cache_name != NULL && pony_file_load(cache_name, &(nav->data), &(nav->size), &(nav->mapped))) {
+		if (pony_rinex_nav_image(nav, src_size, src_mtime)) {
+			nav->cached = 1;
+			return 1;
+		}
+		pony_file_unload(nav->data, nav->size, nav->mapped);
+		nav->data = NULL;
+	}
+
+	// text
+	if (!pony_file_load(file_name, &text, &size, &mapped))
+		return 0;
+	if (!pony_rinex_nav_parse(nav, text, size)) {
+		pony_file_unload(text, size, mapped);
+		return 0;
+	}
+	pony_file_unload(text, size, mapped);
+	((double *)nav->data)[5] = src_size;
+	((double *)nav->data)[6] = src_mtime;
+	pony_rinex_nav_image(nav, -1, 0);
+
+	// binary cache saved, removed if incomplete
+	if (cache_name != NULL && (fp = fopen(cache_name, "wb")) != NULL) {
+		written = (fwrite(nav->data, 1, nav->size, fp) == nav->size);
+		if (fclose(fp) != 0 || !written)
+			remove(cache_name);
+	}
+
+	return 1;
+}
+
+	// select ephemeris with epoch (toc) nearest to a given epoch for each satellite and set header parameters
+	// input:
+	//		nav - navigation data opened with pony_rinex_nav_open
+	//		epoch - time epoch to select ephemeris for, e.g. gnss->epoch
+	// output:
+	//		gnss - satellite ephemeris with validity flags, ionospheric model parameters, clock corrections and leap seconds, when given in navigation data
+	//		number of satellites with ephemeris set
+int pony_rinex_nav_select(pony_rinex_nav *nav, pony_gnss *gnss, pony_time_epoch epoch)
+{
+	const int rec_size = 3 + pony_rinex_nav_width, param_count = 16;
+
+	pony_gnss_sat *sat;
+	long epoch_rd = pony_time_rata_die(epoch.Y, epoch.M, epoch.D);
+	double *rec, *best, *param, dt, best_dt;
+	double *iono_a, *iono_b, *clock_corr;
+	char *iono_valid, *clock_corr_to, *clock_corr_valid, ***obs_types;
+	int s, i, j, k, m, n, max_sat_count, max_eph_count, max_obs_count, *obs_count, count = 0, iono_lines;
+
+	if (nav->rec == NULL || gnss == NULL)
+		return 0;
+
+	// satellites without ephemeris invalidated
+	for (s = 0; s < 4; s++)
+		if (pony_gnss_constellation(gnss, s, &sat, &max_sat_count, &max_eph_count, &max_obs_count, &obs_types, &obs_count))
+			for (i = 0; i < max_sat_count; i++)
+				sat[i].eph_valid = 0;
+
+	// records of each satellite go together
+	for (i = 0; i < nav->count; i = j) {
+		rec = nav->rec + (size_t)i*rec_size;
+		for (j = i, best = NULL, best_dt = 0; j < nav->count && nav->rec[(size_t)j*rec_size] == rec[0] && nav->rec[(size_t)j*rec_size + 1] == rec[1]; j++) {
+			rec = nav->rec + (size_t)j*rec_size;
+			dt = fabs((epoch_rd - pony_time_rata_die((int)rec[3], (int)rec[4], (int)rec[5]))*86400.0 + (epoch.h - rec[6])*3600 + (epoch.m - rec[7])*60 + (epoch.s - rec[8]));
+			if (best == NULL || dt < best_dt) {
+				best = rec;
+				best_dt = dt;
+			}
+		}
+		s = (int)best[0];
+		k = (int)best[1] - 1;
+		if (!pony_gnss_constellation(gnss, s, &sat, &max_sat_count, &max_eph_count, &max_obs_count, &obs_types, &obs_count) || k < 0 || k >= max_sat_count || sat[k].eph == NULL)
+			continue;
+		n = ((int)best[2] < max_eph_count) ? (int)best[2] : max_eph_count;
+		for (m = 0; m < n; m++)
+			sat[k].eph[m] = best[3 + m];
+		sat[k].eph_valid = 1;
+		count++;
+	}
+
+	// header parameters
+	for (s = 0; s < 4; s++) {
+		param = nav->param + s*param_count;
+		if (!pony_gnss_constellation_params(gnss, s, &iono_a, &iono_b, &iono_valid, &clock_corr, &clock_corr_to, &clock_corr_valid))
+			continue;
+		iono_lines = (iono_b == NULL) ? 1 : 2;
+		if (iono_a != NULL && param[8] >= iono_lines) {
+			for (k = 0; k < ((iono_b == NULL) ? 3 : 4); k++)
+				iono_a[k] = param[k];
+			for (k = 0; iono_b != NULL && k < 4; k++)
+				iono_b[k] = param[4 + k];
+			*iono_valid = 1;
+		}
+		if (param[15]) {
+			for (k = 0; k < 4; k++)
+				clock_corr[k] = param[9 + k];
+			clock_corr_to[0] = (char)param[13];
+			clock_corr_to[1] = (char)param[14];
+			*clock_corr_valid = 1;
+		}
+	}
+	param = nav->param + 4*param_count;
+	if (param[1]) {
+		gnss->leap_sec = (int)param[0];
+		gnss->leap_sec_valid = 1;
+	}
+	gnss->time.valid = 0;	// clock corrections may have changed
+
+	return count;
+}
+
+	// release navigation data
+void pony_rinex_nav_close(pony_rinex_nav *nav)
+{
+	pony_file_unload(nav->data, nav->size, nav->mapped);
+	nav->data = NULL;
+	nav->size = 0;
+	nav->param = NULL;
+	nav->rec = NULL;
+	nav->count = 0;
+}
+
+
+
+
+
+
+
+// bus input journal
+	// unsigned integer in LEB128 encoding
+unsigned char *pony_journal_put(unsigned char *p, unsigned long v)
+{
+	for (; v >= 0x80; v >>= 7)
+		*p++ = (unsigned char)(v | 0x80);
+	*p++ = (unsigned char)v;
+	return p;
+}
+
+	// unsigned integer in LEB128 encoding, checked against the end of data
+	// output:
+	//		v - integer decoded
+	//		1 if decoded, 0 if data is truncated
+char pony_journal_get(unsigned char **p, const unsigned char *end, unsigned long *v)
+{
+	int shift;
+
+	for (*v = 0, shift = 0; *p < end && shift < 64; shift += 7) {
+		*v |= (unsigned long)(**p & 0x7f) << shift;
+		if (!(*(*p)++ & 0x80))
+			return 1;
+	}
+	return 0;
+}
+
+	// copy bus input values to or from a journal frame
+void pony_journal_doubles(double *frame, int *k, double *a, const int n, const char restore)
+{
+	int i;
+
+	if (frame != NULL) {
+		if (restore)
+			for (i = 0; i < n; i++)
+				a[i] = frame[*k + i];
+		else
+			for (i = 0; i < n; i++)
+				frame[*k + i] = a[i];
+	}
+	*k += n;
+}
+
+void pony_journal_chars(double *frame, int *k, char *a, const int n, const char restore)
+{
+	int i;
+
+	if (frame != NULL) {
+		if (restore)
+			for (i = 0; i < n; i++)
+				a[i] = (char)frame[*k + i];
+		else
+			for (i = 0; i < n; i++)
+				frame[*k + i] = a[i];
+	}
+	*k += n;
+}
+
+void pony_journal_ints(double *frame, int *k, int *a, const int n, const char restore)
+{
+	int i;
+
+	if (frame != NULL) {
+		if (restore)
+			for (i = 0; i < n; i++)
+				a[i] = (int)frame[*k + i];
+		else
+			for (i = 0; i < n; i++)
+				frame[*k + i] = a[i];
+	}
+	*k += n;
+}
+
+	// bus input layout: imu presence, number of gnss instances, for each gnss instance and constellation: presence, satellites, ephemeris values and observables per satellite
+	// output:
+	//		layout - layout entries, 2 + 16*gnss_count
+	//		types - observation types, 4 characters each, NULL if not needed
+	//		number of layout entries, number of observation types in type_count
+int pony_journal_layout(int *layout, char *types, int *type_count)
+{
+	pony_gnss_sat *sat;
+	char ***obs_types;
+	int g, s, i, n = 0, max_sat_count, max_eph_count, max_obs_count, *obs_count;
+
+	*type_count = 0;
+	layout[n++] = (pony->imu != NULL);
+	layout[n++] = pony->gnss_count;
+	for (g = 0; g < pony->gnss_count; g++)
+		for (s = 0; s < 4; s++) {
+			if (!pony_gnss_constellation(&(pony->gnss[g]), s, &sat, &max_sat_count, &max_eph_count, &max_obs_count, &obs_types, &obs_count)) {
+				for (i = 0; i < 4; i++)
+					layout[n++] = 0;
+				continue;
+			}
+			layout[n++] = 1;
+			layout[n++] = max_sat_count;
+			layout[n++] = (sat[0].eph == NULL) ? 0 : max_eph_count;
+			layout[n++] = (sat[0].obs == NULL || *obs_types == NULL) ? 0 : *obs_count;
+			for (i = 0; i < layout[n-1]; i++, (*type_count)++)
+				if (types != NULL) {
+					types[4*(*type_count)    ] = (*obs_types)[i][0];
+					types[4*(*type_count) + 1] = (*obs_types)[i][1];
+					types[4*(*type_count) + 2] = (*obs_types)[i][2];
+					types[4*(*type_count) + 3] = '\0';
+				}
+		}
+	return n;
+}
+
+	// constellation ionospheric model and clock correction parameters to or from 16 frame values: ionospheric model (8), validity, clock correction (4), target time system (2), validity; continuous time invalidated when restored clock corrections change
+void pony_journal_params(pony_gnss *gnss, const int s, double *p, const char restore)
+{
+	double *iono_a, *iono_b, *clock_corr;
+	char *iono_valid, *clock_corr_to, *clock_corr_valid, changed;
+	int i, n;
+
+	pony_gnss_constellation_params(gnss, s, &iono_a, &iono_b, &iono_valid, &clock_corr, &clock_corr_to, &clock_corr_valid);
+	n = (iono_a == NULL) ? 0 : (iono_b == NULL) ? 3 : 4;
+	if (restore) {
+		for (i = 0; i < n; i++)
+			iono_a[i] = p[i];
+		for (i = 0; iono_b != NULL && i < 4; i++)
+			iono_b[i] = p[4 + i];
+		if (iono_valid != NULL)
+			*iono_valid = (char)p[8];
+		changed = (clock_corr_to[0] != (char)p[13] || clock_corr_to[1] != (char)p[14] || *clock_corr_valid != (char)p[15]);
+		for (i = 0; i < 4; i++) {
+			changed = changed || clock_corr[i] != p[9 + i];
+			clock_corr[i] = p[9 + i];
+		}
+		clock_corr_to[0] = (char)p[13];
+		clock_corr_to[1] = (char)p[14];
+		*clock_corr_valid = (char)p[15];
+		if (changed)
+			gnss->time.valid = 0;	// clock corrections are not part of the continuous time refresh check
+	}
+	else {
+		for (i = 0; i < 9; i++)
+			p[i] = 0;
+		for (i = 0; i < n; i++)
+			p[i] = iono_a[i];
+		for (i = 0; iono_b != NULL && i < 4; i++)
+			p[4 + i] = iono_b[i];
+		if (iono_valid != NULL)
+			p[8] = *iono_valid;
+		for (i = 0; i < 4; i++)
+			p[9 + i] = clock_corr[i];
+		p[13] = clock_corr_to[0];
+		p[14] = clock_corr_to[1];
+		p[15] = *clock_corr_valid;
+	}
+}
+
+	// check constellation observation types against those of the journal layout
+int pony_journal_types_match(pony_journal *jrn)
+{
+	pony_gnss_sat *sat;
+	char ***obs_types;
+	int g, s, i, t, max_sat_count, max_eph_count, max_obs_count, *obs_count;
+
+	for (g = 0, t = 0; g < jrn->layout[1]; g++)
+		for (s = 0; s < 4; s++) {
+			if (!jrn->layout[2 + 16*g + 4*s + 3])
+				continue;
+			pony_gnss_constellation(&(pony->gnss[g]), s, &sat, &max_sat_count, &max_eph_count, &max_obs_count, &obs_types, &obs_count);
+			for (i = 0; i < *obs_count; i++, t++)
+				if ((*obs_types)[i][0] != jrn->types[4*t] || (*obs_types)[i][1] != jrn->types[4*t + 1] || (*obs_types)[i][2] != jrn->types[4*t + 2])
+					return 0;
+		}
+	return 1;
+}
+
+	// gather bus input values into a journal frame, or restore them from it
+	// input:
+	//		layout - bus input layout, see pony_journal_layout
+	//		frame - frame to gather into or restore from, NULL to count values only
+	//		restore - restore (1) or gather (0)
+	// output:
+	//		number of values in a frame
+int pony_journal_frame(const int *layout, double *frame, const char restore)
+{
+	const int param_count = 16;
+
+	pony_gnss *gnss;
+	pony_gnss_sat *sat;
+	char ***obs_types;
+	int g, s, i, k = 0, max_sat_count, max_eph_count, max_obs_count, *obs_count;
+	const int *entry;
+
+	if (frame == NULL) {	// count from layout only, the bus is not accessed
+		k = 1 + (layout[0] ? 9 : 0) + 8*layout[1];
+		for (g = 0; g < layout[1]; g++)
+			for (s = 0; s < 4; s++) {
+				entry = layout + 2 + 16*g + 4*s;
+				if (entry[0])
+					k += param_count + entry[1]*(1 + entry[2] + 2*entry[3]);
+			}
+		return k;
+	}
+
+	pony_journal_doubles(frame, &k, &(pony->t), 1, restore);
+	if (layout[0]) {
+		pony_journal_doubles(frame, &k, &(pony->imu->t), 1, restore);
+		pony_journal_doubles(frame, &k,   pony->imu->w , 3, restore);
+		pony_journal_chars  (frame, &k, &(pony->imu->w_valid), 1, restore);
+		pony_journal_doubles(frame, &k,   pony->imu->f , 3, restore);
+		pony_journal_chars  (frame, &k, &(pony->imu->f_valid), 1, restore);
+	}
+	for (g = 0; g < layout[1]; g++) {
+		gnss = &(pony->gnss[g]);
+		pony_journal_ints   (frame, &k, &(gnss->epoch.Y), 1, restore);
+		pony_journal_ints   (frame, &k, &(gnss->epoch.M), 1, restore);
+		pony_journal_ints   (frame, &k, &(gnss->epoch.D), 1, restore);
+		pony_journal_ints   (frame, &k, &(gnss->epoch.h), 1, restore);
+		pony_journal_ints   (frame, &k, &(gnss->epoch.m), 1, restore);
+		pony_journal_doubles(frame, &k, &(gnss->epoch.s), 1, restore);
+		pony_journal_ints   (frame, &k, &(gnss->leap_sec), 1, restore);
+		pony_journal_chars  (frame, &k, &(gnss->leap_sec_valid), 1, restore);
+		for (s = 0; s < 4; s++) {
+			entry = layout + 2 + 16*g + 4*s;
+			if (!entry[0])
+				continue;
+			pony_journal_params(gnss, s, frame + k, restore);
+			k += param_count;
+			pony_gnss_constellation(gnss, s, &sat, &max_sat_count, &max_eph_count, &max_obs_count, &obs_types, &obs_count);
+			for (i = 0; i < entry[1]; i++) {
+				pony_journal_chars  (frame, &k, &(sat[i].eph_valid), 1, restore);
+				pony_journal_doubles(frame, &k, sat[i].eph, entry[2], restore);
+				pony_journal_chars  (frame, &k, sat[i].obs_valid, entry[3], restore);
+				pony_journal_doubles(frame, &k, sat[i].obs, entry[3], restore);
+			}
+		}
+	}
+	return k;
+}
+
+#ifdef PONY_THREADS
+typedef struct				// journal writer thread, writing blocks filled by host in rotation
+{
+	pony_journal *jrn;		// journal
+	pthread_t thread;		// writer thread
+	pthread_mutex_t lock;	// lock for all the fields below
+	pthread_cond_t cond;	// signalled when a block is queued, written, or the writer is stopped
+	int head;				// next block to be written
+	int queued;				// number of blocks queued for writing
+	char stop;				// writer termination flag
+} pony_journal_writer;
+
+	// write queued blocks until stopped
+void *pony_journal_writer_thread(void *arg)
+{
+	pony_journal_writer *w = (pony_journal_writer *)arg;
+	int b;
+
+	pthread_mutex_lock(&(w->lock));
+	for (;;) {
+		while (w->queued == 0 && !w->stop)
+			pthread_cond_wait(&(w->cond), &(w->lock));
+		if (w->queued == 0)
+			break;
+		b = w->head;
+		pthread_mutex_unlock(&(w->lock));
+		fwrite(w->jrn->block[b], 1, w->jrn->used[b], (FILE *)w->jrn->fp);
+		pthread_mutex_lock(&(w->lock));
+		w->head = (w->head + 1)%pony_journal_blocks;
+		w->queued--;
+		pthread_cond_broadcast(&(w->cond));
+	}
+	pthread_mutex_unlock(&(w->lock));
+	return NULL;
+}
+#endif
+
+	// pass the current block to the writer thread and take the next one, waiting while all others are queued, or write it on host thread
+	// input:
+	//		drain - wait until all blocks are written (1) or not (0)
+void pony_journal_submit(pony_journal *jrn, const char drain)
+{
+#ifdef PONY_THREADS
+	pony_journal_writer *w = (pony_journal_writer *)jrn->writer;
+
+	if (w != NULL) {
+		pthread_mutex_lock(&(w->lock));
+		if (jrn->used[jrn->current] > 0) {
+			while (w->queued == pony_journal_blocks - 1)
+				pthread_cond_wait(&(w->cond), &(w->lock));
+			w->queued++;
+			jrn->current = (jrn->current + 1)%pony_journal_blocks;
+			jrn->used[jrn->current] = 0;
+			pthread_cond_broadcast(&(w->cond));
+		}
+		while (drain && w->queued > 0)
+			pthread_cond_wait(&(w->cond), &(w->lock));
+		pthread_mutex_unlock(&(w->lock));
+		return;
+	}
+#else
+	(void)drain;
+#endif
+	fwrite(jrn->block[jrn->current], 1, jrn->used[jrn->current], (FILE *)jrn->fp);
+	jrn->used[jrn->current] = 0;
+}
+
+	// initialize journal structure
+void pony_journal_reset(pony_journal *jrn)
+{
+	int i;
+
+	jrn->fp = NULL;
+	jrn->data = NULL;
+	jrn->size = 0;
+	jrn->pos = 0;
+	jrn->mapped = 0;
+	jrn->layout = NULL;
+	jrn->layout_size = 0;
+	jrn->types = NULL;
+	jrn->type_count = 0;
+	jrn->obs_types = NULL;
+	jrn->obs_block = NULL;
+	jrn->frame = NULL;
+	jrn->prev = NULL;
+	jrn->frame_size = 0;
+	for (i = 0; i < pony_journal_blocks; i++) {
+		jrn->block[i] = NULL;
+		jrn->used[i] = 0;
+	}
+	jrn->block_size = 0;
+	jrn->current = 0;
+	jrn->writer = NULL;
+	jrn->steps = 0;
+}
+
+	// start recording bus inputs to a journal file
+	// input:
+	//		file_name - journal file name
+	// output:
+	//		jrn - journal ready for pony_journal_record, with writer thread started if built with PONY_THREADS
+	//		OK/not OK (1/0)
+char pony_journal_open(pony_journal *jrn, const char *file_name)
+{
+	const char signature[] = "PONYJRN";
+
+	unsigned char head[16], *p;
+	int i;
+
+	pony_journal_reset(jrn);
+	jrn->layout = (int *)calloc(2 + 16*(size_t)pony->gnss_count, sizeof(int));
+	if (jrn->layout == NULL)
+		return 0;
+	jrn->fp = fopen(file_name, "wb");
+	if (jrn->fp == NULL) {
+		pony_journal_close(jrn);
+		return 0;
+	}
+
+	// signature, format and bus versions
+	for (i = 0; i < 8; i++)
+		head[i] = (unsigned char)signature[i];
+	p = pony_journal_put(head + 8, pony_journal_version);
+	p = pony_journal_put(p, pony_bus_version);
+	if (fwrite(head, 1, (size_t)(p - head), (FILE *)jrn->fp) != (size_t)(p - head)) {
+		pony_journal_close(jrn);
+		return 0;
+	}
+
+#ifdef PONY_THREADS
+	{
+		pony_journal_writer *w = (pony_journal_writer *)calloc(1, sizeof(pony_journal_writer));
+
+		if (w != NULL) {
+			w->jrn = jrn;
+			pthread_mutex_init(&(w->lock), NULL);
+			pthread_cond_init(&(w->cond), NULL);
+			if (pthread_create(&(w->thread), NULL, pony_journal_writer_thread, w) == 0)
+				jrn->writer = w;
+			else {
+				pthread_mutex_destroy(&(w->lock));
+				pthread_cond_destroy(&(w->cond));
+				free(w);
+			}
+		}
+	}
+#endif
+
+	return 1;
+}
+
+	// record bus inputs written by host, to be called before each pony_step
+	// a layout record is written first and whenever the layout or observation types change, followed by values differing from the previous step:
+	// runs of changed values each given by the number of unchanged values skipped and the run length, values XOR-ed with the previous ones with leading and trailing zero bytes dropped
+	// input:
+	//		jrn - journal opened with pony_journal_open
+	// output:
+	//		jrn - step encoded, blocks passed to writer when full
+	//		OK/not OK (1/0)
+char pony_journal_record(pony_journal *jrn)
+{
+	const unsigned long min_block_size = 1 << 20;
+
+	int layout[2 + 16*10], layout_size, type_count, i, j, e, m, n, lz, tz;
+	char *types, changed;
+	unsigned char *p, *start;
+	unsigned long bound, last;
+	double *tmp;
+	union {double d; unsigned long long u;} a, b;
+
+	if (jrn->fp == NULL || pony->gnss_count > 10)
+		return 0;
+
+	// layout and observation types
+	layout_size = pony_journal_layout(layout, NULL, &type_count);
+	changed = (layout_size != jrn->layout_size || type_count != jrn->type_count || jrn->frame == NULL);
+	for (i = 0; i < layout_size && !changed; i++)
+		changed = (layout[i] != jrn->layout[i]);
+	if (!changed)
+		changed = !pony_journal_types_match(jrn);
+	if (changed) {
+		types = (char *)malloc(4*(size_t)type_count + 1);
+		if (types == NULL)
+			return 0;
+		pony_journal_layout(layout, types, &type_count);
+		free(jrn->types);
+		jrn->types = types;
+		jrn->type_count = type_count;
+		jrn->layout_size = layout_size;
+		for (i = 0; i < layout_size; i++)
+			jrn->layout[i] = layout[i];
+		n = pony_journal_frame(layout, NULL, 0);
+		free(jrn->frame);
+		free(jrn->prev);
+		jrn->frame = (double *)malloc((size_t)n*sizeof(double));
+		jrn->prev  = (double *)calloc((size_t)n, sizeof(double));
+		jrn->frame_size = n;
+		if (jrn->frame == NULL || jrn->prev == NULL)
+			return 0;
+
+		// blocks large enough for a layout record and a step with all values changed
+		bound = 1 + 5*(2 + (unsigned long)layout_size) + 3*(unsigned long)type_count + 1 + 19*(unsigned long)n + 10;
+		if (bound*2 > jrn->block_size) {
+			if (jrn->block[jrn->current] != NULL)
+				pony_journal_submit(jrn, 1);
+			jrn->block_size = (bound*2 > min_block_size) ? bound*2 : min_block_size;
+			for (i = 0; i < pony_journal_blocks; i++) {
+				free(jrn->block[i]);
+				jrn->block[i] = (char *)malloc(jrn->block_size);
+				if (jrn->block[i] == NULL)
+					return 0;
+			}
+		}
+		if (jrn->used[jrn->current] + bound > jrn->block_size)
+			pony_journal_submit(jrn, 0);
+		p = (unsigned char *)jrn->block[jrn->current] + jrn->used[jrn->current];
+		*p++ = 'L';
+		p = pony_journal_put(p, (unsigned long)layout_size);
+		for (i = 0; i < layout_size; i++)
+			p = pony_journal_put(p, (unsigned long)layout[i]);
+		for (i = 0; i < type_count; i++)
+			for (j = 0; j < 3; j++)
+				*p++ = (unsigned char)types[4*i + j];
+		jrn->used[jrn->current] = (unsigned long)(p - (unsigned char *)jrn->block[jrn->current]);
+	}
+
+	// step values
+	n = jrn->frame_size;
+	pony_journal_frame(jrn->layout, jrn->frame, 0);
+	bound = 1 + 19*(unsigned long)n + 10;
+	if (jrn->used[jrn->current] + bound > jrn->block_size)
+		pony_journal_submit(jrn, 0);
+	p = start = (unsigned char *)jrn->block[jrn->current] + jrn->used[jrn->current];
+	*p++ = 'F';
+	for (i = 0, last = 0; i < n; ) {
+		for (; i < n; i++) {
+			a.d = jrn->frame[i];
+			b.d = jrn->prev[i];
+			if (a.u != b.u)
+				break;
+		}
+		if (i == n)
+			break;
+		for (e = i + 1; e < n; e++) {
+			a.d = jrn->frame[e];
+			b.d = jrn->prev[e];
+			if (a.u == b.u)
+				break;
+		}
+		p = pony_journal_put(p, (unsigned long)i - last);
+		p = pony_journal_put(p, (unsigned long)(e - i));
+		for (; i < e; i++) {
+			a.d = jrn->frame[i];
+			b.d = jrn->prev[i];
+			a.u ^= b.u;
+			for (lz = 0; lz < 7 && !(a.u >> (56 - 8*lz) & 0xff); lz++);
+			for (tz = 0; tz < 7 - lz && !(a.u >> (8*tz) & 0xff); tz++);
+			*p++ = (unsigned char)(lz << 4 | tz);
+			for (m = 7 - lz; m >= tz; m--)
+				*p++ = (unsigned char)(a.u >> (8*m));
+		}
+		last = (unsigned long)i;
+	}
+	p = pony_journal_put(p, 0);
+	p = pony_journal_put(p, 0);
+	jrn->used[jrn->current] += (unsigned long)(p - start);
+
+	tmp = jrn->prev;
+	jrn->prev = jrn->frame;
+	jrn->frame = tmp;
+	jrn->steps++;
+	return 1;
+}
+
+	// allocate layout and per-constellation replay arrays for the bus
+char pony_journal_replay_alloc(pony_journal *jrn)
+{
+	jrn->obs_types = (char ***)calloc(4*(size_t)pony->gnss_count + 1, sizeof(char **));
+	jrn->obs_block = (void **)calloc(4*(size_t)pony->gnss_count + 1, sizeof(void *));
+	jrn->layout = (int *)calloc(2 + 16*(size_t)pony->gnss_count, sizeof(int));
+	return (jrn->obs_types != NULL && jrn->obs_block != NULL && jrn->layout != NULL);
+}
+
+	// open a journal file for replay
+	// input:
+	//		file_name - journal file name
+	// output:
+	//		jrn - journal ready for pony_journal_read, file memory-mapped if possible
+	//		OK/not OK (1/0)
+char pony_journal_replay_open(pony_journal *jrn, const char *file_name)
+{
+	const char signature[] = "PONYJRN";
+
+	unsigned char *p;
+	unsigned long version;
+	int i;
+
+	pony_journal_reset(jrn);
+	if (!pony_file_load(file_name, &(jrn->data), &(jrn->size), &(jrn->mapped)))
+		return 0;
+	if (!pony_journal_replay_alloc(jrn) || jrn->size < 8) {
+		pony_journal_close(jrn);
+		return 0;
+	}
+	for (i = 0; i < 8; i++)
+		if (jrn->data[i] != signature[i]) {
+			pony_journal_close(jrn);
+			return 0;
+		}
+	p = (unsigned char *)jrn->data + 8;
+	if (!pony_journal_get(&p, (unsigned char *)jrn->data + jrn->size, &version) || version != pony_journal_version
+		|| !pony_journal_get(&p, (unsigned char *)jrn->data + jrn->size, &version)) {	// bus version, informative
+		pony_journal_close(jrn);
+		return 0;
+	}
+	jrn->pos = (unsigned long)(p - (unsigned char *)jrn->data);
+	return 1;
+}
+
+	// apply a journal layout to the bus: check it fits, set observation types and allocate observables not reserved at init
+	// output:
+	//		OK/not OK (1/0)
+char pony_journal_apply(pony_journal *jrn)
+{
+	pony_gnss_sat *sat;
+	char ***obs_types;
+	int g, s, i, c, t, n, max_sat_count, max_eph_count, max_obs_count, *obs_count, *entry;
+
+	if (jrn->layout_size != 2 + 16*jrn->layout[1] || (jrn->layout[0] && pony->imu == NULL) || jrn->layout[1] > pony->gnss_count)
+		return 0;
+	for (g = 0, t = 0; g < jrn->layout[1]; g++)
+		for (s = 0; s < 4; s++) {
+			entry = jrn->layout + 2 + 16*g + 4*s;
+			c = 4*g + s;
+			if (!entry[0])
+				continue;
+			if (!pony_gnss_constellation(&(pony->gnss[g]), s, &sat, &max_sat_count, &max_eph_count, &max_obs_count, &obs_types, &obs_count)
+				|| entry[1] > max_sat_count || entry[2] > max_eph_count || (entry[2] > 0 && sat[0].eph == NULL) || (max_obs_count > 0 && entry[3] > max_obs_count))
+				return 0;
+			n = entry[3];
+			if (jrn->obs_block[c] != NULL) {	// observables allocated for a previous layout
+				for (i = 0; i < max_sat_count; i++)
+					sat[i].obs = NULL, sat[i].obs_valid = NULL;
+				free(jrn->obs_block[c]);
+				jrn->obs_block[c] = NULL;
+			}
+			if (n > 0 && max_obs_count == 0 && sat[0].obs == NULL) {
+				jrn->obs_block[c] = calloc((size_t)max_sat_count*n, sizeof(double) + sizeof(char));
+				if (jrn->obs_block[c] == NULL)
+					return 0;
+				for (i = 0; i < max_sat_count; i++) {
+					sat[i].obs = (double *)jrn->obs_block[c] + i*n;
+					sat[i].obs_valid = (char *)((double *)jrn->obs_block[c] + max_sat_count*n) + i*n;
+				}
+			}
+			if (jrn->obs_types[c] != NULL) {	// observation types set for a previous layout
+				free(jrn->obs_types[c]);
+				jrn->obs_types[c] = NULL;
+				*obs_types = NULL;
+				*obs_count = 0;
+			}
+			if (n > 0) {
+				jrn->obs_types[c] = (char **)calloc((size_t)n, sizeof(char *));
+				if (jrn->obs_types[c] == NULL)
+					return 0;
+				for (i = 0; i < n; i++, t++)
+					jrn->obs_types[c][i] = jrn->types + 4*t;
+				*obs_types = jrn->obs_types[c];
+				*obs_count = n;
+			}
+		}
+	return 1;
+}
+
+	// decode the next journal record without touching the bus
+	// input:
+	//		jrn - journal opened with pony_journal_replay_open
+	//		changed - array of frame_size indices for values changed by a step record, may be NULL
+	// output:
+	//		jrn - layout and observation types for a layout record, with values of the previous step zeroed, or values of the next step in prev
+	//		changed, change_count - indices of values changed by a step record and their number, if requested
+	//		record type: 2 - layout, 1 - step, 0 - end of journal, -1 - error
+int pony_journal_decode(pony_journal *jrn, int *changed, int *change_count)
+{
+	unsigned char *p, *end;
+	unsigned long v, skip, run, i, k;
+	int lz, tz, m, t;
+	union {double d; unsigned long long u;} a, b;
+
+	if (jrn->data == NULL)
+		return -1;
+	p = (unsigned char *)jrn->data + jrn->pos;
+	end = (unsigned char *)jrn->data + jrn->size;
+	if (p >= end)
+		return 0;
+
+	if (*p == 'L') {			// layout
+		p++;
+		if (!pony_journal_get(&p, end, &v) || v > 2 + 16*(unsigned long)pony->gnss_count)
+			return -1;
+		jrn->layout_size = (int)v;
+		for (i = 0, t = 0; i < v; i++) {
+			if (!pony_journal_get(&p, end, &k))
+				return -1;
+			jrn->layout[i] = (int)k;
+			if (i >= 2 && (i - 2)%4 == 3)
+				t += (int)k;
+		}
+		if (jrn->layout_size != 2 + 16*jrn->layout[1] || (unsigned long)(end - p) < 3*(unsigned long)t)
+			return -1;
+		free(jrn->types);
+		jrn->types = (char *)malloc(4*(size_t)t + 1);
+		if (jrn->types == NULL)
+			return -1;
+		for (i = 0; i < (unsigned long)t; i++, p += 3) {
+			jrn->types[4*i    ] = (char)p[0];
+			jrn->types[4*i + 1] = (char)p[1];
+			jrn->types[4*i + 2] = (char)p[2];
+			jrn->types[4*i + 3] = '\0';
+		}
+		jrn->type_count = t;
+		free(jrn->prev);
+		jrn->frame_size = pony_journal_frame(jrn->layout, NULL, 1);
+		jrn->prev = (double *)calloc((size_t)jrn->frame_size + 1, sizeof(double));
+		if (jrn->prev == NULL)
+			return -1;
+		jrn->pos = (unsigned long)(p - (unsigned char *)jrn->data);
+		return 2;
+	}
+	if (*p != 'F' || jrn->prev == NULL)
+		return -1;
+
+	// step
+	p++;
+	if (changed != NULL)
+		*change_count = 0;
+	for (k = 0; ; k += run) {
+		if (!pony_journal_get(&p, end, &skip) || !pony_journal_get(&p, end, &run))
+			return -1;
+		if (run == 0)
+			break;
+		k += skip;
+		if (k + run > (unsigned long)jrn->frame_size)
+			return -1;
+		for (i = k; i < k + run; i++) {
+			if (p >= end)
+				return -1;
+			lz = *p >> 4;
+			tz = *p++ & 0x0f;
+			if (lz + tz > 7 || end - p < 8 - lz - tz)
+				return -1;
+			for (a.u = 0, m = 7 - lz; m >= tz; m--)
+				a.u |= (unsigned long long)(*p++) << (8*m);
+			b.d = jrn->prev[i];
+			a.u ^= b.u;
+			jrn->prev[i] = a.d;
+			if (changed != NULL)
+				changed[(*change_count)++] = (int)i;
+		}
+	}
+	jrn->pos = (unsigned long)(p - (unsigned char *)jrn->data);
+	return 1;
+}
+
+	// restore bus inputs of the next recorded step, to be followed by pony_step
+	// input:
+	//		jrn - journal opened with pony_journal_replay_open
+	// output:
+	//		bus inputs: time, imu measurements, gnss epochs, ephemeris, observables and their validity flags
+	//		step restored/end of journal or error (1/0)
+char pony_journal_read(pony_journal *jrn)
+{
+	int r;
+
+	while ((r = pony_journal_decode(jrn, NULL, NULL)) == 2)
+		if (!pony_journal_apply(jrn))
+			return 0;
+	if (r != 1)
+		return 0;
+	pony_journal_frame(jrn->layout, jrn->prev, 1);
+	jrn->steps++;
+	return 1;
+}
+
+	// close journal: write remaining data and stop writer thread when recording, release file and memory allocated for replay
+void pony_journal_close(pony_journal *jrn)
+{
+	pony_gnss_sat *sat;
+	char ***obs_types;
+	int g, s, i, max_sat_count, max_eph_count, max_obs_count, *obs_count;
+
+	// recording
+	if (jrn->fp != NULL) {
+		if (jrn->block[jrn->current] != NULL)
+			pony_journal_submit(jrn, 1);
+#ifdef PONY_THREADS
+		if (jrn->writer != NULL) {
+			pony_journal_writer *w = (pony_journal_writer *)jrn->writer;
+
+			pthread_mutex_lock(&(w->lock));
+			w->stop = 1;
+			pthread_cond_broadcast(&(w->cond));
+			pthread_mutex_unlock(&(w->lock));
+			pthread_join(w->thread, NULL);
+			pthread_mutex_destroy(&(w->lock));
+			pthread_cond_destroy(&(w->cond));
+			free(w);
+		}
+#endif
+		fclose((FILE *)jrn->fp);
+	}
+
+	// replay: observation types and observables detached
+	for (g = 0; g < pony->gnss_count && (jrn->obs_types != NULL || jrn->obs_block != NULL); g++)
+		for (s = 0; s < 4; s++) {
+			if (!pony_gnss_constellation(&(pony->gnss[g]), s, &sat, &max_sat_count, &max_eph_count, &max_obs_count, &obs_types, &obs_count))
+				continue;
+			if (jrn->obs_types != NULL && jrn->obs_types[4*g + s] != NULL) {
+				free(jrn->obs_types[4*g + s]);
+				*obs_types = NULL;
+				*obs_count = 0;
+			}
+			if (jrn->obs_block != NULL && jrn->obs_block[4*g + s] != NULL) {
+				for (i = 0; i < max_sat_count; i++)
+					sat[i].obs = NULL, sat[i].obs_valid = NULL;
+				free(jrn->obs_block[4*g + s]);
+			}
+		}
+	pony_file_unload(jrn->data, jrn->size, jrn->mapped);
+
+	for (i = 0; i < pony_journal_blocks; i++)
+		free(jrn->block[i]);
+	free(jrn->obs_types);
+	free(jrn->obs_block);
+	free(jrn->layout);
+	free(jrn->types);
+	free(jrn->frame);
+	free(jrn->prev);
+	pony_journal_reset(jrn);
+}
+
+	// replay a journal through pony_step at full speed, on a bus initialized with the same configuration and plugins as recorded
+	// input:
+	//		file_name - journal file name
+	// output:
+	//		number of steps replayed, -1 if the journal could not be opened
+long pony_journal_replay(const char *file_name)
+{
+	pony_journal jrn;
+	long steps;
+
+	if (!pony_journal_replay_open(&jrn, file_name))
+		return -1;
+	while (pony_journal_read(&jrn))
+		if (!pony->step())
+			break;
+	steps = (long)jrn.steps;
+	pony_journal_close(&jrn);
+
+	return steps;
+}
+
+
+
+
+
+
+
+
+// batch post-processing driver
+typedef struct				// step inputs decoded ahead of pony_step
+{
+	char kind;				// 1 - step, 0 - end of a journal file, -1 - journal error
+	int *index;				// frame indices of bus input values changed since the previous step
+	double *value;			// changed values
+	int count;				// number of changed values
+	int capacity;			// number of changed values the arrays are allocated for
+	char layout_changed;	// new layout to be applied before the step (1) or the previous one kept (0)
+	int *layout;			// new bus input layout, see pony_journal
+	int layout_size;		// number of layout entries
+	char *types;			// observation types of the new layout, passed on to the bus side with it
+	int type_count;			// number of observation types
+} pony_batch_slot;
+
+typedef struct				// journal reader decoding files first, first + stride, ... into a ring of slots
+{
+	pony_struct *bus;		// bus instance the journals are decoded for
+	pony_journal jrn;		// journal being decoded
+	char open;				// journal open for decoding
+	int *changed;			// indices of values changed by the last step decoded
+	int changed_size;		// number of indices the array is allocated for
+	const char **file_names;	// journal file names
+	int file_count;			// number of journal files
+	int file;				// journal file being decoded or to be decoded next
+	int stride;				// number of readers
+	pony_batch_slot *slot;	// ring of slots
+	int ahead;				// number of slots
+	unsigned long head;		// slots filled
+	unsigned long tail;		// slots consumed
+#ifdef PONY_THREADS
+	char started;			// reader thread started
+	pthread_t thread;		// reader thread
+	pthread_mutex_t lock;	// lock for head, tail and stop
+	pthread_cond_t cond;	// signalled to a waiting side when half of the ring is filled or consumed, or the reader is stopped or done
+	char host_waiting;		// host waiting for slots
+	char thread_waiting;	// reader waiting for free slots
+	char stop;				// reader termination flag
+	char done;				// all reader files decoded
+#endif
+} pony_batch_reader;
+
+typedef struct				// solution writer passing queued solutions to the output function in order
+{
+	void (*output)(const pony_batch_sol *sol, void *arg);	// output function
+	void *arg;				// output function argument
+	pony_batch_sol *sol;	// ring of solutions
+	int ahead;				// number of solutions in the ring
+	unsigned long head;		// solutions queued
+	unsigned long tail;		// solutions passed to output
+#ifdef PONY_THREADS
+	char started;			// writer thread started
+	pthread_t thread;		// writer thread
+	pthread_mutex_t lock;	// lock for head, tail and stop
+	pthread_cond_t cond;	// signalled to a waiting side when half of the ring is queued or written, or the writer is stopped
+	char host_waiting;		// host waiting for free solutions
+	char thread_waiting;	// writer waiting for solutions
+	char stop;				// writer termination flag
+#endif
+} pony_batch_writer;
+
+	// decode inputs of the next step from reader journal files into a slot, opening and closing files in turn
+	// output:
+	//		slot - bus input values changed by the step, with a new layout if any
+	//		slot kind: 1 - step, 0 - end of a journal file, -1 - journal error
+char pony_batch_decode(pony_batch_reader *rd, pony_batch_slot *slot)
+{
+	int *index;
+	double *value;
+	int r, i, n;
+
+	if (!rd->open) {
+		if (!pony_journal_replay_open(&(rd->jrn), rd->file_names[rd->file])) {
+			rd->file = rd->file_count;
+			return (slot->kind = -1);
+		}
+		rd->open = 1;
+	}
+
+	slot->layout_changed = 0;
+	for (;;) {
+		if (rd->jrn.frame_size > rd->changed_size) {
+			free(rd->changed);
+			rd->changed_size = 0;
+			if ((rd->changed = (int *)malloc((size_t)rd->jrn.frame_size*sizeof(int))) == NULL) {
+				r = -1;
+				break;
+			}
+			rd->changed_size = rd->jrn.frame_size;
+		}
+		r = pony_journal_decode(&(rd->jrn), (rd->jrn.prev == NULL) ? NULL : rd->changed, &n);
+		if (r != 2)
+			break;
+		for (i = 0; i < rd->jrn.layout_size; i++)
+			slot->layout[i] = rd->jrn.layout[i];
+		slot->layout_size = rd->jrn.layout_size;
+		free(slot->types);
+		slot->types = rd->jrn.types;		// passed on with the slot
+		slot->type_count = rd->jrn.type_count;
+		rd->jrn.types = NULL;
+		slot->layout_changed = 1;
+	}
+	if (r == 1 && n > slot->capacity) {
+		index = (int *)realloc(slot->index, (size_t)n*sizeof(int));
+		if (index != NULL)
+			slot->index = index;
+		value = (double *)realloc(slot->value, (size_t)n*sizeof(double));
+		if (value != NULL)
+			slot->value = value;
+		if (index == NULL || value == NULL)
+			r = -1;
+		else
+			slot->capacity = n;
+	}
+	if (r == 1) {
+		for (i = 0; i < n; i++) {
+			slot->index[i] = rd->changed[i];
+			slot->value[i] = rd->jrn.prev[rd->changed[i]];
+		}
+		slot->count = n;
+		return (slot->kind = 1);
+	}
+
+	pony_journal_close(&(rd->jrn));
+	rd->open = 0;
+	rd->file = (r == 0) ? rd->file + rd->stride : rd->file_count;
+	return (slot->kind = (r == 0) ? 0 : -1);
+}
+
+#ifdef PONY_THREADS
+	// decode reader journal files into the ring until done or stopped
+void *pony_batch_reader_thread(void *arg)
+{
+	pony_batch_reader *rd = (pony_batch_reader *)arg;
+	char stop = 0;
+
+	pony_bus_select(rd->bus);
+	while (rd->file < rd->file_count && !stop) {
+		pthread_mutex_lock(&(rd->lock));
+		if (rd->head - rd->tail == (unsigned long)rd->ahead) {	// ring full: wait until half of it is consumed
+			rd->thread_waiting = 1;
+			while (rd->head - rd->tail > (unsigned long)rd->ahead/2 && !rd->stop)
+				pthread_cond_wait(&(rd->cond), &(rd->lock));
+			rd->thread_waiting = 0;
+		}
+		stop = rd->stop;
+		pthread_mutex_unlock(&(rd->lock));
+		if (stop)
+			break;
+		pony_batch_decode(rd, rd->slot + rd->head%rd->ahead);
+		pthread_mutex_lock(&(rd->lock));
+		rd->head++;
+		if (rd->host_waiting && (rd->head - rd->tail >= (unsigned long)(rd->ahead + 1)/2 || rd->file >= rd->file_count))
+			pthread_cond_broadcast(&(rd->cond));
+		pthread_mutex_unlock(&(rd->lock));
+	}
+	pthread_mutex_lock(&(rd->lock));
+	rd->done = 1;
+	pthread_cond_broadcast(&(rd->cond));
+	pthread_mutex_unlock(&(rd->lock));
+	return NULL;
+}
+
+	// pass queued solutions to the output function until stopped and drained
+void *pony_batch_writer_thread(void *arg)
+{
+	pony_batch_writer *w = (pony_batch_writer *)arg;
+
+	pthread_mutex_lock(&(w->lock));
+	for (;;) {
+		if (w->head == w->tail && !w->stop) {	// ring empty: wait until half of it is queued
+			w->thread_waiting = 1;
+			while (w->head - w->tail < (unsigned long)(w->ahead + 1)/2 && !w->stop)
+				pthread_cond_wait(&(w->cond), &(w->lock));
+			w->thread_waiting = 0;
+		}
+		if (w->head == w->tail)
+			break;
+		pthread_mutex_unlock(&(w->lock));
+		w->output(w->sol + w->tail%w->ahead, w->arg);
+		pthread_mutex_lock(&(w->lock));
+		w->tail++;
+		if (w->host_waiting && w->head - w->tail <= (unsigned long)w->ahead/2)
+			pthread_cond_broadcast(&(w->cond));
+	}
+	pthread_mutex_unlock(&(w->lock));
+	return NULL;
+}
+#endif
+
+	// take the next decoded slot from a reader, waiting for its thread to refill half of the ring when empty, or decoding on host thread
+pony_batch_slot *pony_batch_take(pony_batch_reader *rd, unsigned long *waits)
+{
+#ifdef PONY_THREADS
+	if (rd->started) {
+		pthread_mutex_lock(&(rd->lock));
+		if (rd->head == rd->tail) {
+			(*waits)++;
+			rd->host_waiting = 1;
+			while (rd->head - rd->tail < (unsigned long)(rd->ahead + 1)/2 && !rd->done)
+				pthread_cond_wait(&(rd->cond), &(rd->lock));
+			rd->host_waiting = 0;
+		}
+		pthread_mutex_unlock(&(rd->lock));
+		return rd->slot + rd->tail%rd->ahead;
+	}
+#else
+	(void)waits;
+#endif
+	pony_batch_decode(rd, rd->slot + rd->tail%rd->ahead);
+	return rd->slot + rd->tail%rd->ahead;
+}
+
+	// return a consumed slot to its reader
+void pony_batch_release(pony_batch_reader *rd)
+{
+#ifdef PONY_THREADS
+	if (rd->started) {
+		pthread_mutex_lock(&(rd->lock));
+		rd->tail++;
+		if (rd->thread_waiting && rd->head - rd->tail <= (unsigned long)rd->ahead/2)
+			pthread_cond_broadcast(&(rd->cond));
+		pthread_mutex_unlock(&(rd->lock));
+		return;
+	}
+#endif
+	rd->tail++;
+}
+
+	// queue the bus solution for the writer thread, waiting for it to drain half of the ring when full, or pass it to the output function on host thread
+void pony_batch_put(pony_batch_writer *w, const unsigned long step, const int file, unsigned long *waits)
+{
+	pony_batch_sol *sol;
+
+	if (w->output == NULL)
+		return;
+#ifdef PONY_THREADS
+	if (w->started) {
+		pthread_mutex_lock(&(w->lock));
+		if (w->head - w->tail == (unsigned long)w->ahead) {
+			(*waits)++;
+			w->host_waiting = 1;
+			while (w->head - w->tail > (unsigned long)w->ahead/2)
+				pthread_cond_wait(&(w->cond), &(w->lock));
+			w->host_waiting = 0;
+		}
+		pthread_mutex_unlock(&(w->lock));
+	}
+#else
+	(void)waits;
+#endif
+	sol = w->sol + w->head%w->ahead;
+	sol->step = step;
+	sol->file = file;
+	sol->t    = pony->t;
+	sol->sol  = pony->sol;
+#ifdef PONY_THREADS
+	if (w->started) {
+		pthread_mutex_lock(&(w->lock));
+		w->head++;
+		if (w->thread_waiting && w->head - w->tail >= (unsigned long)(w->ahead + 1)/2)
+			pthread_cond_broadcast(&(w->cond));
+		pthread_mutex_unlock(&(w->lock));
+		return;
+	}
+#endif
+	w->output(sol, w->arg);
+	w->head++;
+	w->tail++;
+}
+
+	// run journal files in sequence through pony_step at full speed, on a bus initialized with the same configuration and plugins as recorded
+	// input:
+	//		file_names - journal file names, in processing order
+	//		file_count - number of journal files
+	//		readers - number of reader threads decoding files in turn, used when built with PONY_THREADS
+	//		ahead - number of steps decoded ahead by each reader and solutions queued for the writer, pony_batch_ahead if not positive
+	//		output - function called for the solution after each step in order, on the writer thread when built with PONY_THREADS, may be NULL
+	//		arg - output function argument
+	// output:
+	//		stats - steps run, files completed, processing time and sustained rate, waits for readers and writer, may be NULL
+	//		number of steps run, -1 if a journal could not be opened, was corrupted, or does not fit the bus
+long pony_batch_run(const char **file_names, const int file_count, const int readers, const int ahead, void (*output)(const pony_batch_sol *sol, void *arg), void *arg, pony_batch_stats *stats)
+{
+	pony_batch_reader *rd;
+	pony_batch_writer w;
+	pony_batch_slot *slot;
+	pony_batch_stats st;
+	pony_journal jrn;		// bus side: layout applied, observation types and observables set
+	double t0;
+	int reader_count, slot_count, f, i, k;
+	char ok, running;
+
+	st.steps = 0;
+	st.files = 0;
+	st.seconds = 0;
+	st.rate = 0;
+	st.input_waits = 0;
+	st.output_waits = 0;
+	if (stats != NULL)
+		*stats = st;
+	if (file_count <= 0)
+		return 0;
+
+	reader_count = (readers < 1) ? 1 : (readers > file_count) ? file_count : readers;
+	slot_count = (ahead > 0) ? ahead : pony_batch_ahead;
+#ifndef PONY_THREADS
+	reader_count = 1;
+	slot_count = 1;
+#endif
+
+	// readers, writer and bus side journal
+	pony_journal_reset(&jrn);
+	ok = pony_journal_replay_alloc(&jrn);
+	rd = (pony_batch_reader *)calloc((size_t)reader_count, sizeof(pony_batch_reader));
+	w.output = output;
+	w.arg = arg;
+	w.sol = (pony_batch_sol *)calloc((size_t)slot_count, sizeof(pony_batch_sol));
+	w.ahead = slot_count;
+	w.head = 0;
+	w.tail = 0;
+	if (rd == NULL || w.sol == NULL)
+		ok = 0;
+	for (i = 0; ok && i < reader_count; i++) {
+		rd[i].bus = pony;
+		pony_journal_reset(&(rd[i].jrn));
+		rd[i].file_names = file_names;
+		rd[i].file_count = file_count;
+		rd[i].file = i;
+		rd[i].stride = reader_count;
+		rd[i].ahead = slot_count;
+		rd[i].slot = (pony_batch_slot *)calloc((size_t)slot_count, sizeof(pony_batch_slot));
+		if (rd[i].slot == NULL)
+			ok = 0;
+		for (k = 0; ok && k < slot_count; k++)
+			if ((rd[i].slot[k].layout = (int *)calloc(2 + 16*(size_t)pony->gnss_count, sizeof(int))) == NULL)
+				ok = 0;
+	}
+#ifdef PONY_THREADS
+	// threads, falling back to host thread for any that fail to start
+	for (i = 0; ok && i < reader_count; i++) {
+		pthread_mutex_init(&(rd[i].lock), NULL);
+		pthread_cond_init(&(rd[i].cond), NULL);
+		rd[i].started = (pthread_create(&(rd[i].thread), NULL, pony_batch_reader_thread, rd + i) == 0);
+	}
+	w.host_waiting = 0;
+	w.thread_waiting = 0;
+	w.stop = 0;
+	w.started = 0;
+	if (ok && output != NULL) {
+		pthread_mutex_init(&(w.lock), NULL);
+		pthread_cond_init(&(w.cond), NULL);
+		w.started = (pthread_create(&(w.thread), NULL, pony_batch_writer_thread, &w) == 0);
+	}
+#endif
+
+	// steps
+	t0 = pony_stats_reference();
+	for (f = 0, running = ok; running && f < file_count; f++)
+		for (;;) {
+			slot = pony_batch_take(rd + f%reader_count, &(st.input_waits));
+			if (slot->kind < 0) {
+				ok = running = 0;
+				break;
+			}
+			if (slot->kind == 0) {
+				pony_batch_release(rd + f%reader_count);
+				st.files++;
+				break;
+			}
+			if (slot->layout_changed) {
+				for (i = 0; i < slot->layout_size; i++)
+					jrn.layout[i] = slot->layout[i];
+				jrn.layout_size = slot->layout_size;
+				free(jrn.types);
+				jrn.types = slot->types;
+				jrn.type_count = slot->type_count;
+				slot->types = NULL;
+				free(jrn.prev);
+				jrn.frame_size = pony_journal_frame(jrn.layout, NULL, 1);
+				jrn.prev = (double *)calloc((size_t)jrn.frame_size + 1, sizeof(double));
+				if (jrn.prev == NULL || !pony_journal_apply(&jrn)) {
+					ok = running = 0;
+					break;
+				}
+			}
+			for (i = 0; i < slot->count; i++)
+				jrn.prev[slot->index[i]] = slot->value[i];
+			pony_batch_release(rd + f%reader_count);
+			pony_journal_frame(jrn.layout, jrn.prev, 1);
+			if (!pony->step()) {
+				running = 0;
+				break;
+			}
+			pony_batch_put(&w, st.steps, f, &(st.output_waits));
+			st.steps++;
+		}
+
+	// stop readers, drain writer and release everything
+#ifdef PONY_THREADS
+	for (i = 0; rd != NULL && i < reader_count; i++)
+		if (rd[i].started) {
+			pthread_mutex_lock(&(rd[i].lock));
+			rd[i].stop = 1;
+			pthread_cond_broadcast(&(rd[i].cond));
+			pthread_mutex_unlock(&(rd[i].lock));
+			pthread_join(rd[i].thread, NULL);
+			pthread_mutex_destroy(&(rd[i].lock));
+			pthread_cond_destroy(&(rd[i].cond));
+		}
+	if (w.started) {
+		pthread_mutex_lock(&(w.lock));
+		w.stop = 1;
+		pthread_cond_broadcast(&(w.cond));
+		pthread_mutex_unlock(&(w.lock));
+		pthread_join(w.thread, NULL);
+		pthread_mutex_destroy(&(w.lock));
+		pthread_cond_destroy(&(w.cond));
+	}
+#endif
+	st.seconds = pony_stats_reference() - t0;
+	st.rate = (st.seconds > 0) ? st.steps/st.seconds : 0;
+	for (i = 0; rd != NULL && i < reader_count; i++) {
+		if (rd[i].open)
+			pony_journal_close(&(rd[i].jrn));
+		free(rd[i].changed);
+		for (k = 0; rd[i].slot != NULL && k < slot_count; k++) {
+			free(rd[i].slot[k].index);
+			free(rd[i].slot[k].value);
+			free(rd[i].slot[k].layout);
+			free(rd[i].slot[k].types);
+		}
+		free(rd[i].slot);
+	}
+	free(rd);
+	free(w.sol);
+	pony_journal_close(&jrn);
+
+	if (stats != NULL)
+		*stats = st;
+	return ok ? (long)st.steps : -1;
+}
+
+
+
+
+
+
+
+// time routines
+	// days elapsed from one date to another, based on Rata Die serial date from day one on 0001/01/01
+	// input:
+	//		epoch_from	- starting epoch, only Y, M and D are used
+	//		epoch_to	- ending epoch, only Y, M and D are used
+	// output:
+	//		number of days elapsed from starting epoch to the ending one 
+int pony_time_days_between_dates(pony_time_epoch epoch_from, pony_time_epoch epoch_to) {
+
+	return (int)( pony_time_rata_die(epoch_to.Y, epoch_to.M, epoch_to.D) - pony_time_rata_die(epoch_from.Y, epoch_from.M, epoch_from.D) );
+
+}
+
+	// Rata Die serial date, day one on 0001/01/01
+long pony_time_rata_die(const int Y, const int M, const int D) {
+	long y = Y, m = M;
+
+	if (m < 3) 
+		y--, m += 12;
+	return 365*y + y/4 - y/100 + y/400 + (153*m - 457)/5 + D - 306;
+}
+
+	// clock correction a0 + a1*(t - t_ref) from almanac parameters
+	//		clock_corr - a0, a1, reference seconds of week, reference week
+	//		t - time since the origin of week numbering, seconds
+double pony_time_clock_corr(double *clock_corr, const double t)
+{
+	const double week = 604800, rollover = 1024*week;
+	double dt;
+
+	if (clock_corr[1] == 0)
+		return clock_corr[0];
+	dt = t - (clock_corr[3]*week + clock_corr[2]);
+	dt -= rollover*floor(dt/rollover + 0.5);	// reference week number given modulo 1024
+	return clock_corr[0] + clock_corr[1]*dt;
+}
+
+	// offsets of time scales from GPS time, with leap seconds and clock corrections to UTC or GPS time as in RINEX 3 (e.g. GAUT = GAL - UTC, GAGP = GAL - GPS)
+	//		t - GPS time since its origin, seconds, for the clock correction drift terms
+void pony_time_offsets(pony_time *time, pony_gnss *gnss, const double t)
+{
+	const double bds_week0 = 1356*604800.0;	// BeiDou time origin 2006/01/01 in GPS weeks
+
+	double *iono_a, *iono_b, *clock_corr;
+	char *iono_valid, *clock_corr_to, *clock_corr_valid, to_utc, to_gps;
+	int s;
+
+	// nominal offsets, UTC from leap seconds if known
+	for (s = 0; s < pony_time_scales; s++) {
+		time->offset[s] = 0;
+		time->offset_valid[s] = 1;
+	}
+	time->offset[pony_time_bds] = -pony->gnss_const.bds.leap_sec;
+	if (gnss->leap_sec_valid)
+		time->leap_sec = gnss->leap_sec;
+	else if (gnss->settings.leap_sec_def > 0)
+		time->leap_sec = (int)gnss->settings.leap_sec_def;
+	else
+		time->leap_sec = -1;
+	time->offset_valid[pony_time_utc] = time->offset_valid[pony_time_glo] = (time->leap_sec >= 0);
+	if (time->leap_sec < 0)
+		return;
+	time->offset[pony_time_utc] = -time->leap_sec;
+	if (pony_gnss_constellation_params(gnss, pony_time_gps, &iono_a, &iono_b, &iono_valid, &clock_corr, &clock_corr_to, &clock_corr_valid)
+		&& *clock_corr_valid && clock_corr_to[0] == 'U' && clock_corr_to[1] == 'T')
+		time->offset[pony_time_utc] -= pony_time_clock_corr(clock_corr, t);
+	time->offset[pony_time_glo] = time->offset[pony_time_utc];
+
+	// corrections of other constellations
+	for (s = pony_time_glo; s <= pony_time_bds; s++) {
+		if (!pony_gnss_constellation_params(gnss, s, &iono_a, &iono_b, &iono_valid, &clock_corr, &clock_corr_to, &clock_corr_valid) || !*clock_corr_valid)
+			continue;
+		to_utc = (clock_corr_to[0] == 'U' && clock_corr_to[1] == 'T');
+		to_gps = (clock_corr_to[0] == 'G' && clock_corr_to[1] == 'P');
+		switch (s) {
+			case pony_time_glo:		// GLONASS system time in RINEX is UTC(SU) plus -tauC
+				if (to_utc)
+					time->offset[s] = time->offset[pony_time_utc] + clock_corr[0];
+				break;
+			case pony_time_gal:
+				if (to_gps)
+					time->offset[s] = pony_time_clock_corr(clock_corr, t);
+				else if (to_utc)
+					time->offset[s] = time->offset[pony_time_utc] + time->leap_sec + pony_time_clock_corr(clock_corr, t);
+				break;
+			case pony_time_bds:
+				if (to_utc)
+					time->offset[s] = time->offset[pony_time_utc] + time->leap_sec - pony->gnss_const.bds.leap_sec + pony_time_clock_corr(clock_corr, t - bds_week0);
+				break;
+		}
+	}
+}
+
+	// refresh continuous time of the current gnss epoch when the epoch, its time scale or leap seconds change since the last refresh
+	// clock corrections are not compared, gnss->time.valid is to be cleared when they are set, as by pony_rinex_nav_select and journal replay
+	// input:
+	//		gnss - epoch in time scale gnss->time.scale, leap seconds, clock corrections of constellations
+	// output:
+	//		gnss->time - days and seconds of the day in GPS time, time scale offsets
+	//		valid/not (1/0), not valid for zero epoch or unknown offset of the epoch time scale
+char pony_time_update(pony_gnss *gnss)
+{
+	pony_time *time = &(gnss->time);
+	pony_time_epoch *epoch = &(gnss->epoch);
+	int leap_sec = (gnss->leap_sec_valid) ? gnss->leap_sec : (gnss->settings.leap_sec_def > 0) ? (int)gnss->settings.leap_sec_def : -1;
+	double sec, k;
+
+	if (time->valid && epoch->s == time->epoch.s && epoch->m == time->epoch.m && epoch->h == time->epoch.h
+		&& epoch->D == time->epoch.D && epoch->M == time->epoch.M && epoch->Y == time->epoch.Y && leap_sec == time->leap_sec && time->scale == time->epoch_scale)
+		return 1;
+
+	time->epoch = *epoch;
+	time->epoch_scale = time->scale;
+	time->valid = 0;
+	if (epoch->Y <= 0 || epoch->M <= 0 || epoch->D <= 0 || time->scale < 0 || time->scale >= pony_time_scales)
+		return 0;
+	time->day = pony_time_rata_die(epoch->Y, epoch->M, epoch->D) - pony_time_gps_rd;
+	sec = epoch->h*3600.0 + epoch->m*60.0 + epoch->s;
+	pony_time_offsets(time, gnss, time->day*86400.0 + sec);
+	if (!time->offset_valid[time->scale])
+		return 0;
+	sec -= time->offset[time->scale];
+	k = floor(sec/86400);
+	time->day += (long)k;
+	time->sec = sec - k*86400;
+	time->valid = 1;
+
+	return 1;
+}
+
+	// days since GPS time origin and seconds of the day in a time scale
+	// input:
+	//		gnss - current epoch, see pony_time_update
+	//		scale - time scale: pony_time_gps, pony_time_glo, pony_time_gal, pony_time_bds or pony_time_utc
+	// output:
+	//		day, sec - days since 1980/01/06 and seconds of the day, [0, 86400), in the time scale
+	//		OK/not OK (1/0)
+char pony_time_day(pony_gnss *gnss, const int scale, long *day, double *sec)
+{
+	pony_time *time = &(gnss->time);
+	double k;
+
+	if (scale < 0 || scale >= pony_time_scales || !pony_time_update(gnss) || !time->offset_valid[scale])
+		return 0;
+	*sec = time->sec + time->offset[scale];
+	k = floor(*sec/86400);
+	*day = time->day + (long)k;
+	*sec -= k*86400;
+
+	return 1;
+}
+
+	// seconds of week and week number in a time scale
+	// input:
+	//		gnss - current epoch, see pony_time_update
+	//		scale - time scale: pony_time_gps, pony_time_glo, pony_time_gal, pony_time_bds or pony_time_utc
+	// output:
+	//		sow - seconds of week, weeks starting on Sunday in all time scales
+	//		week - week number since 1980/01/06 for GPS, GLONASS and UTC, since 1999/08/22 for Galileo, since 2006/01/01 for BeiDou, may be NULL
+	//		OK/not OK (1/0)
+char pony_time_sow(pony_gnss *gnss, const int scale, double *sow, int *week)
+{
+	long day, w;
+	double sec;
+
+	if (!pony_time_day(gnss, scale, &day, &sec))
+		return 0;
+	w = (day >= 0) ? day/7 : -((6 - day)/7);
+	*sow = (day - 7*w)*86400.0 + sec;
+	if (week != NULL)
+		*week = (int)w - ((scale == pony_time_gal) ? 1024 : (scale == pony_time_bds) ? 1356 : 0);
+
+	return 1;
+}
+
+	// GLONASS day numbers as in ICD GLONASS Edition 5.1 2008
+	// input:
+	//		gnss - current epoch, see pony_time_update
+	// output:
+	//		N4 - four-year interval number starting from 1996
+	//		NT - day number within the four-year interval, starting from 1
+	//		tod - time of day in Moscow time, i.e. GLONASS time, seconds
+	//		OK/not OK (1/0)
+char pony_time_glo_day(pony_gnss *gnss, int *N4, int *NT, double *tod)
+{
+	long day;
+	double sec, k;
+
+	if (!pony_time_day(gnss, pony_time_glo, &day, &sec))
+		return 0;
+	sec += 3*3600;
+	k = floor(sec/86400);
+	day += (long)k - (pony_time_rata_die(1996, 1, 1) - pony_time_gps_rd);
+	*tod = sec - k*86400;
+	*N4 = (int)(day/1461) + 1;
+	*NT = (int)(day%1461) + 1;
+
+	return 1;
+}
+
+	// calendar epoch in a time scale
+	// input:
+	//		gnss - current epoch, see pony_time_update
+	//		scale - time scale: pony_time_gps, pony_time_glo, pony_time_gal, pony_time_bds or pony_time_utc
+	// output:
+	//		epoch - calendar date and time in the time scale
+	//		OK/not OK (1/0)
+char pony_time_calendar(pony_time_epoch *epoch, pony_gnss *gnss, const int scale)
+{
+	long day, z, era, doe, yoe, doy, mp;
+	double sec;
+
+	if (!pony_time_day(gnss, scale, &day, &sec))
+		return 0;
+
+	// civil date from serial day, March-based years of 400-year eras
+	z = day + pony_time_gps_rd + 305;
+	era = (z >= 0 ? z : z - 146096)/146097;
+	doe = z - era*146097;
+	yoe = (doe - doe/1460 + doe/36524 - doe/146096)/365;
+	doy = doe - (365*yoe + yoe/4 - yoe/100);
+	mp = (5*doy + 2)/153;
+	epoch->D = (int)(doy - (153*mp + 2)/5 + 1);
+	epoch->M = (int)((mp < 10) ? mp + 3 : mp - 9);
+	epoch->Y = (int)(yoe + era*400 + (epoch->M <= 2));
+	epoch->h = (int)(sec/3600);
+	epoch->m = (int)((sec - epoch->h*3600.0)/60);
+	epoch->s = sec - epoch->h*3600.0 - epoch->m*60.0;
+
+	return 1;
+}
+
+	// time near the current epoch from one time scale to another
+	// input:
+	//		gnss - current epoch, see pony_time_update
+	//		t - time in scale from, seconds, e.g. seconds of week or of the day
+	//		from, to - time scales: pony_time_gps, pony_time_glo, pony_time_gal, pony_time_bds or pony_time_utc
+	// output:
+	//		t - time in scale to, with offsets of the current epoch
+	//		OK/not OK (1/0)
+char pony_time_convert(pony_gnss *gnss, double *t, const int from, const int to)
+{
+	pony_time *time = &(gnss->time);
+
+	if (from < 0 || from >= pony_time_scales || to < 0 || to >= pony_time_scales || !pony_time_update(gnss) || !time->offset_valid[from] || !time->offset_valid[to])
+		return 0;
+	*t += time->offset[to] - time->offset[from];
+
+	return 1;
+}
+
+
+
+
+
+
+
+
+
+
+
+// linear algebra functions
+	// conventional operations
+		// dot product
+double pony_linal_dot(double *u, double *v, const int m) {
+	double res;
+	int i;
+
+	for (i = 1, res = u[0]*v[0]; i < m; i++)
+		res += u[i]*v[i];
+
+	return res;
+}
+
+		// l2 vector norm, i.e. sqrt(u^T*u)
+double pony_linal_vnorm(double *u, const int m) {
+	return sqrt(pony_linal_dot(u, u, m));
+}
+
+		// cross product for 3x1 vectors
+void pony_linal_cross3x1(double *res, double *u, double *v) {
+	res[0] = u[1]*v[2] - u[2]*v[1];
+	res[1] = u[2]*v[0] - u[0]*v[2];
+	res[2] = u[0]*v[1] - u[1]*v[0];
+}
+
+		// matrix multiplication res = a*b, a is n x n1, b is n1 x m, res is n x m
+void pony_linal_mmul(double *res,  double *a, double *b, const int n, const int n1, const int m) {
+	int i, j, k, k0, ka, kb, p;
+
+	for (i = 0, k = 0, k0 = 0; i < n; i++, k0 += n1)
+		for (j = 0; j < m; j++, k++) {
+			ka = k0;
+			kb = j;
+			res[k] = a[ka]*b[kb];
+			for (ka++, kb += m, p = 1; p < n1; ka++, kb += m, p++)
+				res[k] += a[ka]*b[kb];
+		}
+}
+
+		// matrix multiplication with the second argument transposed res = a*b^T, a is n x m, b is n1 x m, res is n x n1
+void pony_linal_mmul2T(double *res,  double *a, double *b, const int n, const int m, const int n1) {
+	int i, j, k, k0, ka, kb, p;
+
+	for (i = 0, k = 0, k0 = 0; i < n; i++, k0 += m)
+		for (j = 0; j < n1; j++, k++) {
+			ka = k0;
+			kb = j*m;
+			res[k] = a[ka]*b[kb];
+			for (ka++, kb++, p = 1; p < m; ka++, kb++, p++)
+				res[k] += a[ka]*b[kb];
+		}
+}
+
+		// quaternion multiplication for 4x1 quaternions res = q x r, with res0, q0, r0 being scalar parts
+void pony_linal_qmul(double *res, double *q, double *r) {
+	res[0] = q[0]*r[0] - q[1]*r[1] - q[2]*r[2] - q[3]*r[3];
+	res[1] = q[0]*r[1] + q[1]*r[0] + q[2]*r[3] - q[3]*r[2];
+	res[2] = q[0]*r[2] + q[2]*r[0] + q[3]*r[1] - q[1]*r[3];
+	res[3] = q[0]*r[3] + q[3]*r[0] + q[1]*r[2] - q[2]*r[1];
+}
+
+	// fixed-size operations, unrolled
+		// 3x3 matrix multiplication res = a*b
+			// overwriting input (double *res = double *a or double *b) allowed
+void pony_linal_m3mul(double *res, double *a, double *b) {
+	double t[9];
+	int i;
+
+	t[0] = a[0]*b[0] + a[1]*b[3] + a[2]*b[6];
+	t[1] = a[0]*b[1] + a[1]*b[4] + a[2]*b[7];
+	t[2] = a[0]*b[2] + a[1]*b[5] + a[2]*b[8];
+	t[3] = a[3]*b[0] + a[4]*b[3] + a[5]*b[6];
+	t[4] = a[3]*b[1] + a[4]*b[4] + a[5]*b[7];
+	t[5] = a[3]*b[2] + a[4]*b[5] + a[5]*b[8];
+	t[6] = a[6]*b[0] + a[7]*b[3] + a[8]*b[6];
+	t[7] = a[6]*b[1] + a[7]*b[4] + a[8]*b[7];
+	t[8] = a[6]*b[2] + a[7]*b[5] + a[8]*b[8];
+	for (i = 0; i < 9; i++)
+		res[i] = t[i];
+}
+
+		// 3x3 matrix multiplication with the first argument transposed res = a^T*b
+			// overwriting input (double *res = double *a or double *b) allowed
+void pony_linal_m3mul1T(double *res, double *a, double *b) {
+	double t[9];
+	int i;
+
+	t[0] = a[0]*b[0] + a[3]*b[3] + a[6]*b[6];
+	t[1] = a[0]*b[1] + a[3]*b[4] + a[6]*b[7];
+	t[2] = a[0]*b[2] + a[3]*b[5] + a[6]*b[8];
+	t[3] = a[1]*b[0] + a[4]*b[3] + a[7]*b[6];
+	t[4] = a[1]*b[1] + a[4]*b[4] + a[7]*b[7];
+	t[5] = a[1]*b[2] + a[4]*b[5] + a[7]*b[8];
+	t[6] = a[2]*b[0] + a[5]*b[3] + a[8]*b[6];
+	t[7] = a[2]*b[1] + a[5]*b[4] + a[8]*b[7];
+	t[8] = a[2]*b[2] + a[5]*b[5] + a[8]*b[8];
+	for (i = 0; i < 9; i++)
+		res[i] = t[i];
+}
+
+		// 3x3 matrix multiplication with the second argument transposed res = a*b^T
+			// overwriting input (double *res = double *a or double *b) allowed
+void pony_linal_m3mul2T(double *res, double *a, double *b) {
+	double t[9];
+	int i;
+
+	t[0] = a[0]*b[0] + a[1]*b[1] + a[2]*b[2];
+	t[1] = a[0]*b[3] + a[1]*b[4] + a[2]*b[5];
+	t[2] = a[0]*b[6] + a[1]*b[7] + a[2]*b[8];
+	t[3] = a[3]*b[0] + a[4]*b[1] + a[5]*b[2];
+	t[4] = a[3]*b[3] + a[4]*b[4] + a[5]*b[5];
+	t[5] = a[3]*b[6] + a[4]*b[7] + a[5]*b[8];
+	t[6] = a[6]*b[0] + a[7]*b[1] + a[8]*b[2];
+	t[7] = a[6]*b[3] + a[7]*b[4] + a[8]*b[5];
+	t[8] = a[6]*b[6] + a[7]*b[7] + a[8]*b[8];
+	for (i = 0; i < 9; i++)
+		res[i] = t[i];
+}
+
+		// 3x3 matrix by 3x1 vector multiplication res = a*v
+			// overwriting input (double *res = double *v) allowed
+void pony_linal_m3mul_v(double *res, double *a, double *v) {
+	double v0 = v[0], v1 = v[1], v2 = v[2];
+
+	res[0] = a[0]*v0 + a[1]*v1 + a[2]*v2;
+	res[1] = a[3]*v0 + a[4]*v1 + a[5]*v2;
+	res[2] = a[6]*v0 + a[7]*v1 + a[8]*v2;
+}
+
+		// transposed 3x3 matrix by 3x1 vector multiplication res = a^T*v
+			// overwriting input (double *res = double *v) allowed
+void pony_linal_m3Tmul_v(double *res, double *a, double *v) {
+	double v0 = v[0], v1 = v[1], v2 = v[2];
+
+	res[0] = a[0]*v0 + a[3]*v1 + a[6]*v2;
+	res[1] = a[1]*v0 + a[4]*v1 + a[7]*v2;
+	res[2] = a[2]*v0 + a[5]*v1 + a[8]*v2;
+}
+
+		// quaternion sandwich product for 4x1 quaternions res = q x r x q^-1, with res0, q0, r0 being scalar parts, q being unit quaternion
+			// overwriting input (double *res = double *r) allowed
+void pony_linal_qsandwich(double *res, double *q, double *r) {
+	double t[4];
+
+	// t = q x r
+	t[0] = q[0]*r[0] - q[1]*r[1] - q[2]*r[2] - q[3]*r[3];
+	t[1] = q[0]*r[1] + q[1]*r[0] + q[2]*r[3] - q[3]*r[2];
+	t[2] = q[0]*r[2] + q[2]*r[0] + q[3]*r[1] - q[1]*r[3];
+	t[3] = q[0]*r[3] + q[3]*r[0] + q[1]*r[2] - q[2]*r[1];
+	// res = t x q^-1, with q^-1 = (q0, -q1, -q2, -q3)
+	res[0] =  t[0]*q[0] + t[1]*q[1] + t[2]*q[2] + t[3]*q[3];
+	res[1] = -t[0]*q[1] + t[1]*q[0] - t[2]*q[3] + t[3]*q[2];
+	res[2] = -t[0]*q[2] + t[2]*q[0] - t[3]*q[1] + t[1]*q[3];
+	res[3] = -t[0]*q[3] + t[3]*q[0] - t[1]*q[2] + t[2]*q[1];
+}
+
+		// 3x1 vector rotation by unit quaternion res = q x (0,v) x q^-1, with q0 being scalar part
+			// overwriting input (double *res = double *v) allowed
+void pony_linal_qrot(double *res, double *q, double *v) {
+	double t0, t1, t2;
+
+	// t = 2*(q_v x v)
+	t0 = 2*(q[2]*v[2] - q[3]*v[1]);
+	t1 = 2*(q[3]*v[0] - q[1]*v[2]);
+	t2 = 2*(q[1]*v[1] - q[2]*v[0]);
+	// res = v + q0*t + q_v x t
+	res[0] = v[0] + q[0]*t0 + q[2]*t2 - q[3]*t1;
+	res[1] = v[1] + q[0]*t1 + q[3]*t0 - q[1]*t2;
+	res[2] = v[2] + q[0]*t2 + q[1]*t1 - q[2]*t0;
+}
+
+		// unit quaternion to 3x3 rotation matrix, so that a*v = q x (0,v) x q^-1, with q0 being scalar part
+void pony_linal_quat2mat(double *a, double *q) {
+	double q00 = q[0]*q[0], q11 = q[1]*q[1], q22 = q[2]*q[2], q33 = q[3]*q[3],
+		q01 = q[0]*q[1], q02 = q[0]*q[2], q03 = q[0]*q[3], q12 = q[1]*q[2], q13 = q[1]*q[3], q23 = q[2]*q[3];
+
+	a[0] = q00 + q11 - q22 - q33;	a[1] = 2*(q12 - q03);			a[2] = 2*(q13 + q02);
+	a[3] = 2*(q12 + q03);			a[4] = q00 - q11 + q22 - q33;	a[5] = 2*(q23 - q01);
+	a[6] = 2*(q13 - q02);			a[7] = 2*(q23 + q01);			a[8] = q00 - q11 - q22 + q33;
+}
+
+	// batched operations on n 3x1 vectors stored as structure of arrays, i.e. 3 x n matrix: x[0..n-1], y[0..n-1], z[0..n-1]
+		// rotation by 3x3 matrix res = a*v
+			// overwriting input (double *res = double *v) allowed
+void pony_linal_m3mul_v_soa(double *res, double *a, double *v, const int n) {
+	double *x = v, *y = v+n, *z = v+2*n, *rx = res, *ry = res+n, *rz = res+2*n;
+	double a0 = a[0], a1 = a[1], a2 = a[2], a3 = a[3], a4 = a[4], a5 = a[5], a6 = a[6], a7 = a[7], a8 = a[8];
+	double x0, y0, z0;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		x0 = x[i];
+		y0 = y[i];
+		z0 = z[i];
+		rx[i] = a0*x0 + a1*y0 + a2*z0;
+		ry[i] = a3*x0 + a4*y0 + a5*z0;
+		rz[i] = a6*x0 + a7*y0 + a8*z0;
+	}
+}
+
+		// rotation by transposed 3x3 matrix res = a^T*v
+			// overwriting input (double *res = double *v) allowed
+void pony_linal_m3Tmul_v_soa(double *res, double *a, double *v, const int n) {
+	double aT[9];
+
+	aT[0] = a[0];	aT[1] = a[3];	aT[2] = a[6];
+	aT[3] = a[1];	aT[4] = a[4];	aT[5] = a[7];
+	aT[6] = a[2];	aT[7] = a[5];	aT[8] = a[8];
+	pony_linal_m3mul_v_soa(res, aT, v, n);
+}
+
+		// rotation by unit quaternion res = q x (0,v) x q^-1, with q0 being scalar part
+			// overwriting input (double *res = double *v) allowed
+void pony_linal_qrot_soa(double *res, double *q, double *v, const int n) {
+	double a[9];
+
+	pony_linal_quat2mat(a, q);
+	pony_linal_m3mul_v_soa(res, a, v, n);
+}
+
+
+
+
+/*	// space rotation representation
+		// 3x3 attitude matrix R to quaternion q with q0 being scalar part
+void pony_linal_mat2quat(double *q, double *R) {
+
+	int i, i1, i3;
+
+	q[0] = 1 + R[0] + R[4] + R[8];
+	q[1] = 1 + R[0] - R[4] - R[8];
+	q[2] = 1 - R[0] + R[4] - R[8];
+	q[3] = 1 - R[0] - R[4] + R[8];
+
+	for (i = 0; i < 4; i++)
+		if (q[i] > 0)
+			q[i] = sqrt(q[i])/2;
+		else
+			q[i] = 0;
+	
+
+	// this part does not always work !! -- revise
+
+	for (i = 1; i < 4; i++) {
+		// copysign function implemented for q[i], R[x]-R[y] arguments 
+		i1 = (i+1)%3;
+		i3 = (i+3)%3;
+		if ( (q[i]>0) == (R[i1*3+i3] < R[i3*3+i1]) ) // R[7]vs.R[5] for i=1, R[2]vs.R[6] for i=2, R[3]vs.R[1] for i=3.
+			q[i] = -q[i];
+	}
+	//q[1] = _copysign(q[1], R[7] - R[5]);
+	//q[2] = _copysign(q[2], R[2] - R[6]);
+	//q[3] = _copysign(q[3], R[3] - R[1]);
+}*/
+
+
+
+
+	// vector kernels for linear algebra routines
+		// instruction sets are detected at runtime, the kernels are compiled for them regardless of compiler options (see PONY_SIMD)
+typedef struct					// vector kernels
+{
+	int level;					// instruction set level: 0 - scalar, 1 - SSE2, 2 - AVX2 with FMA, 3 - AVX-512
+	double (*dot)(const double *u, const double *v, const int n);			// dot product u^T*v
+	void (*axpy)(double *y, const double a, const double *x, const int n);	// y += a*x
+} pony_linal_kernel_set;
+
+#ifdef PONY_SIMD
+		// scalar loops for vectors too short to gain from vector instructions (see pony_linal_simd_min)
+double pony_linal_dot_short(const double *u, const double *v, const int n) {
+	double s = 0;
+	int i;
+
+	for (i = 0; i < n; i++)
+		s += u[i]*v[i];
+
+	return s;
+}
+
+void pony_linal_axpy_short(double *y, const double a, const double *x, const int n) {
+	int i;
+
+	for (i = 0; i < n; i++)
+		y[i] += a*x[i];
+}
+
+		// SSE2
+double pony_linal_dot_sse2(const double *u, const double *v, const int n) {
+	__m128d s0 = _mm_setzero_pd(), s1 = _mm_setzero_pd();
+	double s[2];
+	int i;
+
+	if (n < pony_linal_simd_min)
+		return pony_linal_dot_short(u, v, n);
+	for (i = 0; i+4 <= n; i += 4) {
+		s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(u+i  ), _mm_loadu_pd(v+i  )));
+		s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(u+i+2), _mm_loadu_pd(v+i+2)));
+	}
+	_mm_storeu_pd(s, _mm_add_pd(s0, s1));
+	for (s[0] += s[1]; i < n; i++)
+		s[0] += u[i]*v[i];
+
+	return s[0];
+}
+
+void pony_linal_axpy_sse2(double *y, const double a, const double *x, const int n) {
+	__m128d va = _mm_set1_pd(a);
+	int i;
+
+	if (n < pony_linal_simd_min) {
+		pony_linal_axpy_short(y, a, x, n);
+		return;
+	}
+	for (i = 0; i+2 <= n; i += 2)
+		_mm_storeu_pd(y+i, _mm_add_pd(_mm_loadu_pd(y+i), _mm_mul_pd(va, _mm_loadu_pd(x+i))));
+	for (; i < n; i++)
+		y[i] += a*x[i];
+}
+
+		// AVX2 with FMA
+PONY_SIMD_TARGET("avx2,fma")
+double pony_linal_dot_avx2(const double *u, const double *v, const int n) {
+	__m256d s0 = _mm256_setzero_pd(), s1 = _mm256_setzero_pd();
+	__m128d s2;
+	double s;
+	int i;
+
+	if (n < pony_linal_simd_min)
+		return pony_linal_dot_short(u, v, n);
+	for (i = 0; i+8 <= n; i += 8) {
+		s0 = _mm256_fmadd_pd(_mm256_loadu_pd(u+i  ), _mm256_loadu_pd(v+i  ), s0);
+		s1 = _mm256_fmadd_pd(_mm256_loadu_pd(u+i+4), _mm256_loadu_pd(v+i+4), s1);
+	}
+	if (i+4 <= n) {
+		s0 = _mm256_fmadd_pd(_mm256_loadu_pd(u+i), _mm256_loadu_pd(v+i), s0);
+		i += 4;
+	}
+	s0 = _mm256_add_pd(s0, s1);
+	s2 = _mm_add_pd(_mm256_castpd256_pd128(s0), _mm256_extractf128_pd(s0, 1));
+	s = _mm_cvtsd_f64(_mm_add_sd(s2, _mm_unpackhi_pd(s2, s2)));
+	for (; i < n; i++)
+		s += u[i]*v[i];
+
+	return s;
+}
+
+PONY_SIMD_TARGET("avx2,fma")
+void pony_linal_axpy_avx2(double *y, const double a, const double *x, const int n) {
+	__m256d va = _mm256_set1_pd(a);
+	int i;
+
+	if (n < pony_linal_simd_min) {
+		pony_linal_axpy_short(y, a, x, n);
+		return;
+	}
+	for (i = 0; i+4 <= n; i += 4)
+		_mm256_storeu_pd(y+i, _mm256_fmadd_pd(va, _mm256_loadu_pd(x+i), _mm256_loadu_pd(y+i)));
+	for (; i < n; i++)
+		y[i] += a*x[i];
+}
+
+		// AVX-512, dot product tail handled by scalar code, axpy tail with masks
+PONY_SIMD_TARGET("avx512f")
+double pony_linal_dot_avx512(const double *u, const double *v, const int n) {
+	__m512d s0 = _mm512_setzero_pd(), s1 = _mm512_setzero_pd();
+	double s;
+	int i;
+
+	if (n < pony_linal_simd_min)
+		return pony_linal_dot_short(u, v, n);
+	for (i = 0; i+16 <= n; i += 16) {
+		s0 = _mm512_fmadd_pd(_mm512_loadu_pd(u+i  ), _mm512_loadu_pd(v+i  ), s0);
+		s1 = _mm512_fmadd_pd(_mm512_loadu_pd(u+i+8), _mm512_loadu_pd(v+i+8), s1);
+	}
+	if (i+8 <= n) {
+		s0 = _mm512_fmadd_pd(_mm512_loadu_pd(u+i), _mm512_loadu_pd(v+i), s0);
+		i += 8;
+	}
+	s = _mm512_reduce_add_pd(_mm512_add_pd(s0, s1));
+	for (; i < n; i++)
+		s += u[i]*v[i];
+
+	return s;
+}
+
+PONY_SIMD_TARGET("avx512f")
+void pony_linal_axpy_avx512(double *y, const double a, const double *x, const int n) {
+	__m512d va = _mm512_set1_pd(a);
+	__mmask8 mask;
+	int i;
+
+	if (n < pony_linal_simd_min) {
+		pony_linal_axpy_short(y, a, x, n);
+		return;
+	}
+	for (i = 0; i+8 <= n; i += 8)
+		_mm512_storeu_pd(y+i, _mm512_fmadd_pd(va, _mm512_loadu_pd(x+i), _mm512_loadu_pd(y+i)));
+	if (i < n) {
+		mask = (__mmask8)((1u << (n-i)) - 1);
+		_mm512_mask_storeu_pd(y+i, mask, _mm512_fmadd_pd(va, _mm512_maskz_loadu_pd(mask, x+i), _mm512_maskz_loadu_pd(mask, y+i)));
+	}
+}
+
+		// instruction set level supported by the processor and operating system
+int pony_linal_cpu_level(void) {
+#if defined(_MSC_VER)
+	int r[4];
+	unsigned long long xcr0;
+
+	__cpuid(r, 0);
+	if (r[0] < 7)
+		return 1;
+	__cpuid(r, 1);
+	if ( !(r[2] & (1 << 27)) || !(r[2] & (1 << 12)) || !(r[2] & (1 << 28)) )	// OSXSAVE, FMA, AVX
+		return 1;
+	xcr0 = _xgetbv(0);
+	if ((xcr0 & 0x06) != 0x06)	// XMM and YMM state enabled by the operating system
+		return 1;
+	__cpuidex(r, 7, 0);
+	if ( !(r[1] & (1 << 5)) )	// AVX2
+		return 1;
+	if ( (r[1] & (1 << 16)) && (xcr0 & 0xe6) == 0xe6 )	// AVX-512F, opmask and ZMM state enabled
+		return 3;
+	return 2;
+#else
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f"))
+		return 3;
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+		return 2;
+	return __builtin_cpu_supports("sse2") ? 1 : 0;
+#endif
+}
+#endif
+
+		// instruction set level detected once for all vector kernels
+			// any thread detecting it first stores the same value, so concurrent first calls from several buses or pool threads are harmless
+unsigned long pony_simd_cpu = 0;	// instruction set level plus one, 0 if not detected yet
+
+int pony_simd_cpu_level(void) {
+	unsigned long level = PONY_LOAD_ACQUIRE(&pony_simd_cpu);
+
+	if (level == 0) {
+#ifdef PONY_SIMD
+		level = pony_linal_cpu_level() + 1;
+#else
+		level = 1;
+#endif
+		PONY_STORE_RELEASE(&pony_simd_cpu, level);
+	}
+
+	return (int)level - 1;
+}
+
+		// select instruction set level for a set of vector kernels, stored as the level plus one with 0 for not selected yet
+			// AVX-512 only when asked for explicitly, as it is slower than AVX2 for the matrix sizes measured
+int pony_simd_select(unsigned long *selected, const int max_level) {
+	int level = pony_simd_cpu_level();
+
+	if (max_level < 0 && level > 2)
+		level = 2;
+	if (max_level >= 0 && level > max_level)
+		level = max_level;
+	PONY_STORE_RELEASE(selected, (unsigned long)level + 1);
+
+	return level;
+}
+
+		// instruction set level selected for a set of vector kernels, the best available unless selected before
+int pony_simd_selected(unsigned long *selected) {
+	unsigned long level = PONY_LOAD_ACQUIRE(selected);
+
+	return (level == 0) ? pony_simd_select(selected, -1) : (int)level - 1;
+}
+
+pony_linal_kernel_set pony_linal_kernel_sets[4] = {	// by instruction set level
+	{0, NULL, NULL}
+#ifdef PONY_SIMD
+	, {1, pony_linal_dot_sse2,   pony_linal_axpy_sse2  }
+	, {2, pony_linal_dot_avx2,   pony_linal_axpy_avx2  }
+	, {3, pony_linal_dot_avx512, pony_linal_axpy_avx512}
+#endif
+};
+unsigned long pony_linal_level = 1;	// instruction set level selected plus one, scalar routines unless selected by pony_linal_simd
+
+	// select vector kernels for packed upper-triangular routines, scalar ones being used until selected
+	// vector kernels change the order of additions and use FMA, so results differ from the scalar ones in rounding, and between processors,
+	// e.g. a journal replayed with vector kernels selected does not reproduce solutions bit-exactly on other machines
+	//	input: 
+	//		max_level - maximum instruction set level to use: 0 - scalar (results are the same on all platforms), 1 - SSE2, 2 - AVX2 with FMA, 3 - AVX-512,
+	//					or negative for the best one available up to AVX2
+	//	output: 
+	//		instruction set level selected
+int pony_linal_simd(const int max_level) {
+	return pony_simd_select(&pony_linal_level, max_level);
+}
+
+		// vector kernels selected, NULL for scalar routines, also for m x m matrices smaller than pony_linal_simd_min
+pony_linal_kernel_set *pony_linal_vector(const int m) {
+	int level = pony_simd_selected(&pony_linal_level);
+
+	return (level > 0 && m >= pony_linal_simd_min) ? &pony_linal_kernel_sets[level] : NULL;
+}
+
+
+	// routines for m x m upper-triangular matrices lined up in a single-dimension array
+		// index conversion for upper-triangular matrix lined up in a single-dimension array: (i,j) -> k
+void pony_linal_u_ij2k(int *k, const int i, const int j, const int m) {
+	*k = ( i*(2*m - 1 - i) )/2 + j;
+}
+
+		// index conversion for upper-triangular matrix lined up in a single-dimension array: k -> (i,j)
+void pony_linal_u_k2ij(int *i, int *j, const int k, const int m) {
+	double onehalf_plus_m = 0.5+m;
+	*i = (int)(floor( onehalf_plus_m - sqrt(onehalf_plus_m*onehalf_plus_m - 2.0*k) ) + 0.5);
+	*j = k - ( ( 2*m - 1 - (*i) )*(*i) )/2;
+}
+
+		// upper-triangular matrix lined up in a single-dimension array multiplication: res = U*v
+			// overwriting input (double *res = double *v) allowed
+void pony_linal_u_mul(double *res, double *u, double *v, const int n, const int m) {
+	int i, j, k, p, p0, mn;
+	pony_linal_kernel_set *vec = pony_linal_vector(n);
+
+	// vector kernels: dot products of rows for a vector, otherwise rows of res as linear combinations of rows of v, unless too short
+	if (vec != NULL && m == 1) {
+		for (i = 0, k = 0; i < n; k += n-i, i++)
+			res[i] = vec->dot(u+k, v+i, n-i);
+		return;
+	}
+	if (vec != NULL && m >= 8) {
+		for (i = 0, k = 0, p0 = 0; i < n; i++, p0 += m) {
+			for (j = 0; j < m; j++)
+				res[p0+j] = u[k]*v[p0+j];
+			for (p = p0+m, k++; p < m*n; p += m, k++)
+				vec->axpy(res+p0, u[k], v+p, m);
+		}
+		return;
+	}
+
+	mn = m*n;
+	for (j = 0; j < m; j++)
+		for (i = 0, k = 0, p0 = j; i < n; i++, p0 += m) {
+			res[p0] = u[k]*v[p0];
+			for (p = p0+m, k++; p < mn; p += m, k++)
+				res[p0] += u[k]*v[p];
+		}
+}
+
+		// upper-triangular matrix lined up in a single-dimension array of m(m+1)/2 x 1, transposed, multiplication by vector: res = U^T*v
+void pony_linal_uT_mul_v(double *res, double *u, double *v, const int m) {
+	int i, j, k;
+	pony_linal_kernel_set *vec = pony_linal_vector(m);
+
+	for (i = 0; i < m; i++)
+		res[i] = u[i]*v[0];
+	if (vec != NULL)
+		for (j = 1, k = m; j < m; k += m-j, j++)
+			vec->axpy(res+j, v[j], u+k, m-j);
+	else
+		for (j = 1, k = m; j < m; j++)
+			for (i = j; i < m; i++, k++)
+				res[i] += u[k]*v[j];
+}
+
+		// inversion of upper-triangular matrix lined up in a single-dimension array of m(m+1)/2 x 1: res = U^-1
+			// overwriting input (double *res = double *u) allowed
+void pony_linal_u_inv(double *res, double *u, const int m) {
+
+	int i, j, k, k0, p, q, p0, r;
+	double s, *t;
+	pony_linal_kernel_set *vec = pony_linal_vector(m);
+
+	// vector kernels: rows of the inverse from the last one up, each row as a linear combination of the succeeding ones
+	if (vec != NULL) {
+		for (i = m-1, k0 = (m+2)*(m-1)/2; i >= 0; i--, k0 -= m-i) {
+			t = res + k0;
+			if (res != u)
+				for (j = 0; j < m-i; j++)
+					t[j] = u[k0+j];
+			// t[r-i] holds U(i,r) until the r-th row is accounted, in the reverse order
+			for (r = m-1, k = (m+2)*(m-1)/2; r > i; r--, k -= m-r) {
+				s = t[r-i];
+				t[r-i] = s*res[k];
+				vec->axpy(t+r-i+1, s, res+k+1, m-1-r);
+			}
+			s = t[0];
+			t[0] = 1/s; // division by zero if matrix is not invertible
+			for (j = 1; j < m-i; j++)
+				t[j] = -t[j]/s;
+		}
+		return;
+	}
+
+	for (j = 0, k0 = (m+2)*(m-1)/2; j < m; k0 -= j+2, j++) {
+		res[k0] = 1/u[k0]; // division by zero if matrix is not invertible
+		for (i = j+1, k = k0-j-1; i < m; k -= i+1, i++) {
+			p0 = k-(i-j);
+			for (p = k, q = k0, r = 0, s = 0; q > k; p--, q -= j+r+1, r++)
+				s += u[p]*res[q];
+			res[k] = -s/u[p0]; // division by zero if matrix is not invertible
+		}
+	}
+
+}
+
+		// square (with transposition) of upper-triangular matrix lined up in a single-dimension array of m(m+1)/2 x 1: res = U U^T
+			// overwriting input (double *res = double *u) allowed
+void pony_linal_uuT(double *res, double *u, const int m) {
+
+	int i, j, k, p, q, r;
+	pony_linal_kernel_set *vec = pony_linal_vector(m);
+
+	// vector kernels: dot products of contiguous row parts
+	if (vec != NULL) {
+		for (i = 0, k = 0; i < m; i++)
+			for (j = i, p = k; j < m; p += m-j, j++, k++)
+				res[k] = vec->dot(u+k, u+p, m-j);
+		return;
+	}
+
+	for (i = 0, k = 0; i < m; i++)
+		for (j = i; j < m; j++, k++) {
+			pony_linal_u_ij2k(&p, j,j, m);
+			res[k] = u[k]*u[p];
+			for (q = k+1, p++, r = j+1; r < m; q++, p++, r++)
+				res[k] += u[q]*u[p];
+		}
+
+}
+
+	// Cholesky upper-triangular factorization P = S*S^T, where P is symmetric positive-definite matrix
+		// input:	P - upper-triangular part of symmetric m-by-m positive-definite R lined in a single-dimension array m(m+1)/2 x 1
+		// output:	S - upper-triangular part of a Cholesky factor S lined in a single-dimension array m(m+1)/2 x 1
+		// overwriting input (double *P == double *S) allowed
+void pony_linal_chol(double *S, double *P, const int m) {
+
+	int i, j, k, k0, p, q, p0;
+	double s;
+	pony_linal_kernel_set *vec = pony_linal_vector(m);
+
+	for (j = 0, k0 = (m+2)*(m-1)/2; j < m; k0 -= j+2, j++) {
+		p0 = k0+j;
+		if (vec != NULL)
+			s = (j > 0) ? vec->dot(S+k0+1, S+k0+1, j) : 0;
+		else
+			for (p = k0+1, s = 0; p <= p0; p++)
+				s += S[p]*S[p];
+		S[k0] = sqrt(P[k0] - s);
+		for (i = j+1, k = k0-j-1; i < m; k -= i+1, i++) {
+			if (vec != NULL)
+				s = (j > 0) ? vec->dot(S+k0+1, S+k+1, j) : 0;
+			else
+				for (p = k0+1, q = k+1, s = 0; p <= p0; p++, q++)
+					s += S[p]*S[q];
+			S[k] = (S[k0] == 0)? 0 : (P[k] - s)/S[k0];
+		}
+	}
+
+}
+
+	// square root Kalman filtering
+	//	input: 
+	//		x - current estimate of m x 1 state vector
+	//		S - upper-truangular part of a Cholesky factor of current covariance matrix, lined in a single-dimension array m(m+1)/2 x 1
+	//		z - scalar measurement value
+	//		h - linear measurement model matrix, so that z = h*x + r
+	//		sigma - measurement error a priori standard deviation, so that sigma = sqrt(E[r^2])
+	//	output:
+	//		x - updated estimate of state vector
+	//		S - upper-truangular part of a Cholesky factor of updated covariance matrix, lined in a single-dimension array m(m+1)/2 x 1
+	//		K - Kalman gain
+double pony_linal_kalman_update(double *x, double *S, double *K, double z, double *h, double sigma, const int m) {
+
+	double d, d1, sdd1, f, e;
+	int i, j, k;
+
+	// e0 stored in K
+	for (i = 0; i < m; i++)
+		K[i] = 0;
+
+	// d0
+	d = sigma*sigma;
+
+	// S
+	for (i = 0; i < m; i++) {
+		// f = S^T*h
+		f = S[i]*h[0];
+		for (j = 1, k = i+m-1; j <= i; j++, k += m-j)
+			f += S[k]*h[j];
+		// d
+		d1 = d + f*f;
+		sdd1 = sqrt(d*d1);
+		// S^+, e
+		for (j = 0, k = i; j <= i; j++, k += m-j) {
+			e = K[j];
+			K[j] += S[k]*f;
+			S[k] = (S[k]*d - e*f)/sdd1; // sigma = 0 not allowed
+		}
+		d = d1;
+	}
+
+	// dz
+	for (i = 0; i < m; i++)
+		z -= h[i]*x[i];
+
+	// K, x
+	for (i = 0; i < m; i++) {
+		K[i] /= d; // sigma = 0 not allowed
+		x[i] += K[i]*z;
+	}
+
+	return z;
+}
+
+	// square root Kalman filtering, batch of measurements with uncorrelated errors
+	// equivalent to sequential scalar updates in the order of measurements, but passes through S once per block of measurements,
+	// column by column for all measurements of the block, with columns of S lined up contiguously in a work array,
+	// done by sequential scalar updates unless S is large enough for the passes to pay off, or with no work array
+	//	input: 
+	//		x - current estimate of m x 1 state vector
+	//		S - upper-truangular part of a Cholesky factor of current covariance matrix, lined in a single-dimension array m(m+1)/2 x 1
+	//		z - n x 1 measurement vector
+	//		H - n x m linear measurement model matrix, so that z = H*x + r
+	//		sigma - n x 1 vector of measurement error a priori standard deviations, so that sigma[i] = sqrt(E[r[i]^2])
+	//		work - m(m+1)/2 x 1 work array, or NULL for sequential scalar updates
+	//		n - number of measurements
+	//		m - state vector size
+	//	output:
+	//		x - updated estimate of state vector
+	//		S - upper-truangular part of a Cholesky factor of updated covariance matrix, lined in a single-dimension array m(m+1)/2 x 1
+	//		K - n x m matrix of Kalman gains, i-th row for i-th measurement
+	//		res - n x 1 vector of residuals, i-th one being z[i] - H[i]*x before i-th measurement is taken into account
+void pony_linal_kalman_update_batch(double *x, double *S, double *K, double *res, double *z, double *H, double *sigma, double *work, const int n, const int m) {
+
+	const int block = 16; // measurements per pass through S, keeping their gains in cache
+	const int min_size = 128; // smallest state vector size for the passes to be faster than sequential updates, with S out of the first level cache
+
+	double d, d1, sdd1, f, e, *h, *Kl, *c;
+	int i, j, k, l, l0, l1;
+
+	if (work == NULL || m < min_size) {
+		for (l = 0, h = H, Kl = K; l < n; l++, h += m, Kl += m)
+			res[l] = pony_linal_kalman_update(x, S, Kl, z[l], h, sigma[l], m);
+		return;
+	}
+
+	// columns of S lined up one after another: S(0,i), ..., S(i,i) starting from i(i+1)/2
+	for (i = 0, c = work; i < m; c += ++i)
+		for (j = 0, k = i; j <= i; j++, k += m-j)
+			c[j] = S[k];
+
+	for (l0 = 0; l0 < n; l0 = l1) {
+		l1 = (l0 + block < n) ? l0 + block : n;
+
+		// e0 stored in K, d0 stored in res
+		for (l = l0, Kl = K + l0*m; l < l1; l++, Kl += m) {
+			for (i = 0; i < m; i++)
+				Kl[i] = 0;
+			res[l] = sigma[l]*sigma[l];
+		}
+
+		// S, each column updated for all measurements of the block in turn
+		for (i = 0, c = work; i < m; c += ++i)
+			for (l = l0, h = H + l0*m, Kl = K + l0*m; l < l1; l++, h += m, Kl += m) {
+				// f = S^T*h
+				for (j = 0, f = 0; j <= i; j++)
+					f += c[j]*h[j];
+				// d
+				d = res[l];
+				d1 = d + f*f;
+				sdd1 = sqrt(d*d1);
+				// S^+, e
+				for (j = 0; j <= i; j++) {
+					e = Kl[j];
+					Kl[j] += c[j]*f;
+					c[j] = (c[j]*d - e*f)/sdd1; // sigma = 0 not allowed
+				}
+				res[l] = d1;
+			}
+
+		// dz, K, x, for each measurement of the block in turn
+		for (l = l0, h = H + l0*m, Kl = K + l0*m; l < l1; l++, h += m, Kl += m) {
+			d = res[l];
+			res[l] = z[l];
+			for (i = 0; i < m; i++)
+				res[l] -= h[i]*x[i];
+			for (i = 0; i < m; i++) {
+				Kl[i] /= d; // sigma = 0 not allowed
+				x[i] += Kl[i]*res[l];
+			}
+		}
+	}
+
+	// updated S back from columns
+	for (i = 0, c = work; i < m; c += ++i)
+		for (j = 0, k = i; j <= i; j++, k += m-j)
+			S[k] = c[j];
+}
+
+	// square root Kalman filtering, time update (prediction) with process noise uncorrelated between states
+	// Householder triangularization of [diag(q) | F*S] from the right, so that S^+ S^+^T = F S S^T F^T + diag(q)^2,
+	// zero entries of F and q are skipped, rows already in triangular form are not reflected
+	//	input: 
+	//		x - current estimate of m x 1 state vector, or NULL if propagated by the caller
+	//		S - upper-truangular part of a Cholesky factor of current covariance matrix, lined in a single-dimension array m(m+1)/2 x 1
+	//		F - m x m state transition matrix, so that x^+ = F*x + w
+	//		q - m x 1 vector of process noise standard deviations, so that q[i] = sqrt(E[w[i]^2])
+	//		work - 2m^2 x 1 work array
+	//		m - state vector size
+	//	output:
+	//		x - predicted estimate of state vector
+	//		S - upper-truangular part of a Cholesky factor of predicted covariance matrix, lined in a single-dimension array m(m+1)/2 x 1, with non-negative diagonal
+void pony_linal_kalman_predict(double *x, double *S, double *F, double *q, double *work, const int m) {
+
+	double *A, *a, *v, *f, s, t, nv, beta;
+	int i, j, k, l, r, n, nq, len;
+	pony_linal_kernel_set *vec = pony_linal_vector(m);
+
+	// x = F*x, stored in work first
+	if (x != NULL) {
+		for (i = 0, f = F; i < m; i++, f += m)
+			for (j = 0, work[i] = 0; j < m; j++)
+				if (f[j] != 0)
+					work[i] += f[j]*x[j];
+		for (i = 0; i < m; i++)
+			x[i] = work[i];
+	}
+
+	// A = [diag(q) | F*S], m x n, n = nq + m, with zero columns of diag(q) dropped
+	for (i = 0, nq = 0; i < m; i++)
+		if (q[i] != 0)
+			nq++;
+	n = nq + m;
+	A = work;
+	for (i = 0, l = 0, f = F, a = A; i < m; i++, f += m, a += n) {
+		for (j = 0; j < n; j++)
+			a[j] = 0;
+		if (q[i] != 0)
+			a[l++] = q[i];
+		// i-th row of F*S as a combination of rows of S, k-th row of S being contiguous S(k,k), ..., S(k,m-1)
+		for (k = 0, r = 0; k < m; r += m-k, k++)
+			if (f[k] != 0) {
+				if (vec != NULL)
+					vec->axpy(a+nq+k, f[k], S+r, m-k);
+				else
+					for (j = k; j < m; j++)
+						a[nq+j] += f[k]*S[r+j-k];
+			}
+	}
+
+	// rows from the last one, i-th row reflected to its element at column nq+i, not affecting the rows below
+	for (i = m-1; i >= 0; i--) {
+		v = A + i*n;
+		len = nq+i+1;
+		// squared norm of the part to be eliminated
+		if (vec != NULL)
+			s = vec->dot(v, v, len-1);
+		else
+			for (j = 0, s = 0; j < len-1; j++)
+				s += v[j]*v[j];
+		if (s == 0)
+			continue;
+		// Householder vector v = a - alpha*e, alpha = -sign(a_last)*|a|, stored in place of i-th row
+		t = v[len-1];
+		nv = sqrt(s + t*t);
+		beta = 1/(nv*(nv + fabs(t)));	// 2/(v^T v)
+		v[len-1] = (t >= 0) ? t + nv : t - nv;
+		// rows above: a -= beta*(a^T v)*v
+		for (r = 0, a = A; r < i; r++, a += n) {
+			if (vec != NULL)
+				s = vec->dot(a, v, len);
+			else
+				for (j = 0, s = 0; j < len; j++)
+					s += a[j]*v[j];
+			if (s == 0)
+				continue;
+			if (vec != NULL)
+				vec->axpy(a, -beta*s, v, len);
+			else
+				for (j = 0; j < len; j++)
+					a[j] -= beta*s*v[j];
+		}
+		// i-th row itself becomes alpha*e
+		for (j = 0; j < len-1; j++)
+			v[j] = 0;
+		v[len-1] = (t >= 0) ? -nv : nv;
+	}
+
+	// S^+ from the last m columns, columns with negative diagonal sign-flipped
+	for (i = 0, k = 0, a = A+nq; i < m; i++, a += n)
+		for (j = i; j < m; j++, k++)
+			S[k] = a[j];
+	for (j = 0; j < m; j++) {
+		pony_linal_u_ij2k(&k, j,j, m);
+		if (S[k] < 0)
+			for (i = 0; i <= j; i++) {
+				pony_linal_u_ij2k(&k, i,j, m);
+				S[k] = -S[k];
+			}
+	}
+
+}
+
+
+
+
+// geodetic routines
+	// vector kernels for batched conversions and gravity, each processing a multiple of the vector width and returning the number of points processed, the rest left to scalar loops
+typedef struct					// vector kernels
+{
+	int level;					// instruction set level: 0 - scalar, 2 - AVX2 with FMA
+	int (*llh2xyz)(double *x,   double *llh, const pony_imu_const *imu_const, const int n);
+	int (*xyz2llh)(double *llh, double *x,   const pony_imu_const *imu_const, const int n);
+	int (*gravity)(double *g,   double *llh, const pony_imu_const *imu_const, const int n);
+} pony_geo_kernel_set;
+
+	// scalar loops over points i0..n-1
+void pony_geo_llh2xyz_scalar(double *x, double *llh, const pony_imu_const *imu_const, const int n, const int i0)
+{
+	double sin_lat, cos_lat, Re, h;
+	int i;
+
+	for (i = i0; i < n; i++) {
+		sin_lat = sin(llh[n+i]);
+		cos_lat = cos(llh[n+i]);
+		h = llh[2*n+i];
+		Re = imu_const->a/sqrt(1 - imu_const->e2*sin_lat*sin_lat);
+		x[2*n+i] = (Re*(1 - imu_const->e2) + h)*sin_lat;
+		Re = (Re + h)*cos_lat;
+		x[n+i] = Re*sin(llh[i]);
+		x[i]   = Re*cos(llh[i]);
+	}
+}
+
+		// two Bowring steps from the reduced latitude of the point, with no data-dependent iterations: error below 1e-9 m from the Earth surface up to the orbits of navigation satellites
+void pony_geo_xyz2llh_scalar(double *llh, double *x, const pony_imu_const *imu_const, const int n, const int i0)
+{
+	double
+		k = sqrt(1 - imu_const->e2),	// semi-minor to semi-major axis ratio
+		ea = imu_const->e2*imu_const->a,
+		eb = ea/k;
+	double p, z, su, cu, N, D, r;
+	int i;
+
+	for (i = i0; i < n; i++) {
+		p = sqrt(x[i]*x[i] + x[n+i]*x[n+i]);
+		z = x[2*n+i];
+		su = z;
+		cu = p*k;
+		r = 1/sqrt(su*su + cu*cu);
+		su *= r;
+		cu *= r;
+		N = z + eb*su*su*su;
+		D = p - ea*cu*cu*cu;
+		su = N*k;
+		cu = D;
+		r = 1/sqrt(su*su + cu*cu);
+		su *= r;
+		cu *= r;
+		N = z + eb*su*su*su;
+		D = p - ea*cu*cu*cu;
+		r = 1/sqrt(N*N + D*D);
+		llh[i] = atan2(x[n+i], x[i]);
+		llh[2*n+i] = p*D*r + z*N*r - imu_const->a*sqrt(1 - imu_const->e2*N*N*r*r);
+		llh[n+i] = atan2(N, D);
+	}
+}
+
+		// normal gravity on the ellipsoid with second-order height correction
+void pony_geo_gravity_scalar(double *g, double *llh, const pony_imu_const *imu_const, const int n, const int i0)
+{
+	double s, h_a;
+	int i;
+
+	for (i = i0; i < n; i++) {
+		s = sin(llh[n+i]);
+		h_a = llh[2*n+i]/imu_const->a;
+		g[i] = imu_const->ge*(1 + imu_const->fg*s*s)*(1 - 2*h_a + 3*h_a*h_a);
+	}
+}
+
+#ifdef PONY_SIMD
+		// AVX2 with FMA: sine and cosine for |a| up to a few pi, quadrant reduction and fdlibm kernel polynomials, within 1-2 ulp of libm
+PONY_SIMD_TARGET("avx2,fma")
+void pony_geo_sincos_avx2(__m256d *s, __m256d *c, const __m256d a)
+{
+	__m256d k, r, z, ps, pc, swap;
+	__m256i q;
+
+	k = _mm256_round_pd(_mm256_mul_pd(a, _mm256_set1_pd(6.36619772367581382433e-01)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);	// 2/pi
+	r = _mm256_fnmadd_pd(k, _mm256_set1_pd(1.57079632673412561417e+00), a);	// pi/2 in two parts
+	r = _mm256_fnmadd_pd(k, _mm256_set1_pd(6.07710050650619224932e-11), r);
+	z = _mm256_mul_pd(r, r);
+
+	ps = _mm256_fmadd_pd(z, _mm256_set1_pd( 1.58969099521155010221e-10), _mm256_set1_pd(-2.50507602534068634195e-08));
+	ps = _mm256_fmadd_pd(z, ps, _mm256_set1_pd( 2.75573137070700676789e-06));
+	ps = _mm256_fmadd_pd(z, ps, _mm256_set1_pd(-1.98412698298579493134e-04));
+	ps = _mm256_fmadd_pd(z, ps, _mm256_set1_pd( 8.33333333332248946124e-03));
+	ps = _mm256_fmadd_pd(z, ps, _mm256_set1_pd(-1.66666666666666324348e-01));
+	ps = _mm256_fmadd_pd(_mm256_mul_pd(z, r), ps, r);
+
+	pc = _mm256_fmadd_pd(z, _mm256_set1_pd(-1.13596475577881948265e-11), _mm256_set1_pd( 2.08757232129817482790e-09));
+	pc = _mm256_fmadd_pd(z, pc, _mm256_set1_pd(-2.75573143513906633035e-07));
+	pc = _mm256_fmadd_pd(z, pc, _mm256_set1_pd( 2.48015872894767294178e-05));
+	pc = _mm256_fmadd_pd(z, pc, _mm256_set1_pd(-1.38888888888741095749e-03));
+	pc = _mm256_fmadd_pd(z, pc, _mm256_set1_pd( 4.16666666666666019037e-02));
+	pc = _mm256_fmadd_pd(_mm256_mul_pd(z, z), pc, _mm256_fnmadd_pd(z, _mm256_set1_pd(0.5), _mm256_set1_pd(1)));
+
+	// quadrant: swap sine and cosine on odd ones, sine negated in 2 and 3, cosine in 1 and 2
+	q = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(k));
+	swap = _mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(q, _mm256_set1_epi64x(1)), _mm256_set1_epi64x(1)));
+	*s = _mm256_blendv_pd(ps, pc, swap);
+	*c = _mm256_blendv_pd(pc, ps, swap);
+	*s = _mm256_xor_pd(*s, _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(q, _mm256_set1_epi64x(2)), 62)));
+	*c = _mm256_xor_pd(*c, _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_and_si256(_mm256_add_epi64(q, _mm256_set1_epi64x(1)), _mm256_set1_epi64x(2)), 62)));
+}
+
+		// four-quadrant arctangent: reduction to [0, tan(pi/8)] and fdlibm kernel polynomial, within 1-2 ulp of libm, zero for y = x = 0
+PONY_SIMD_TARGET("avx2,fma")
+__m256d pony_geo_atan2_avx2(const __m256d y, const __m256d x)
+{
+	__m256d sign = _mm256_set1_pd(-0.0), ax, ay, num, den, t, z, p, a, big, swap, zero = _mm256_setzero_pd();
+
+	ax = _mm256_andnot_pd(sign, x);
+	ay = _mm256_andnot_pd(sign, y);
+	num = _mm256_min_pd(ax, ay);
+	den = _mm256_max_pd(ax, ay);
+	t = _mm256_div_pd(num, _mm256_blendv_pd(den, _mm256_set1_pd(1), _mm256_cmp_pd(den, zero, _CMP_EQ_OQ)));
+
+	// above tan(pi/8): atan(t) = pi/4 + atan((t-1)/(t+1))
+	big = _mm256_cmp_pd(t, _mm256_set1_pd(4.14213562373095034e-01), _CMP_GT_OQ);
+	t = _mm256_blendv_pd(t, _mm256_div_pd(_mm256_sub_pd(t, _mm256_set1_pd(1)), _mm256_add_pd(t, _mm256_set1_pd(1))), big);
+	z = _mm256_mul_pd(t, t);
+	p = _mm256_fmadd_pd(z, _mm256_set1_pd( 1.62858201153657823623e-02), _mm256_set1_pd(-3.65315727442169155270e-02));
+	p = _mm256_fmadd_pd(z, p, _mm256_set1_pd( 4.97687799461593236017e-02));
+	p = _mm256_fmadd_pd(z, p, _mm256_set1_pd(-5.83357013379057348645e-02));
+	p = _mm256_fmadd_pd(z, p, _mm256_set1_pd( 6.66107313738753120669e-02));
+	p = _mm256_fmadd_pd(z, p, _mm256_set1_pd(-7.69187620504482999495e-02));
+	p = _mm256_fmadd_pd(z, p, _mm256_set1_pd( 9.09088713343650656196e-02));
+	p = _mm256_fmadd_pd(z, p, _mm256_set1_pd(-1.11111104054623557880e-01));
+	p = _mm256_fmadd_pd(z, p, _mm256_set1_pd( 1.42857142725034663711e-01));
+	p = _mm256_fmadd_pd(z, p, _mm256_set1_pd(-1.99999999998764832476e-01));
+	p = _mm256_fmadd_pd(z, p, _mm256_set1_pd( 3.33333333333329318027e-01));
+	p = _mm256_mul_pd(_mm256_mul_pd(z, t), p);
+	a = _mm256_sub_pd(t, p);
+	a = _mm256_blendv_pd(a, _mm256_add_pd(_mm256_set1_pd(7.85398163397448278999e-01), _mm256_add_pd(_mm256_set1_pd(3.06161699786838301793e-17), a)), big);	// pi/4 in two parts
+
+	// octants: pi/2 - a when |y| > |x|, pi - a when x < 0, sign of y
+	swap = _mm256_cmp_pd(ay, ax, _CMP_GT_OQ);
+	a = _mm256_blendv_pd(a, _mm256_add_pd(_mm256_sub_pd(_mm256_set1_pd(1.57079632679489655800e+00), a), _mm256_set1_pd(6.12323399573676603587e-17)), swap);
+	a = _mm256_blendv_pd(a, _mm256_add_pd(_mm256_sub_pd(_mm256_set1_pd(3.14159265358979311600e+00), a), _mm256_set1_pd(1.22464679914735317723e-16)), x);
+	return _mm256_or_pd(a, _mm256_and_pd(sign, y));
+}
+
+PONY_SIMD_TARGET("avx2,fma")
+int pony_geo_llh2xyz_avx2(double *x, double *llh, const pony_imu_const *imu_const, const int n)
+{
+	__m256d sin_lat, cos_lat, sin_lon, cos_lon, h, Re,
+		one = _mm256_set1_pd(1), a = _mm256_set1_pd(imu_const->a), e2 = _mm256_set1_pd(imu_const->e2);
+	int i;
+
+	for (i = 0; i+4 <= n; i += 4) {
+		pony_geo_sincos_avx2(&sin_lat, &cos_lat, _mm256_loadu_pd(llh+n+i));
+		pony_geo_sincos_avx2(&sin_lon, &cos_lon, _mm256_loadu_pd(llh+i));
+		h = _mm256_loadu_pd(llh+2*n+i);
+		Re = _mm256_div_pd(a, _mm256_sqrt_pd(_mm256_fnmadd_pd(_mm256_mul_pd(e2, sin_lat), sin_lat, one)));
+		_mm256_storeu_pd(x+2*n+i, _mm256_mul_pd(_mm256_fmadd_pd(Re, _mm256_sub_pd(one, e2), h), sin_lat));
+		Re = _mm256_mul_pd(_mm256_add_pd(Re, h), cos_lat);
+		_mm256_storeu_pd(x+n+i, _mm256_mul_pd(Re, sin_lon));
+		_mm256_storeu_pd(x+i,   _mm256_mul_pd(Re, cos_lon));
+	}
+
+	return i;
+}
+
+PONY_SIMD_TARGET("avx2,fma")
+int pony_geo_xyz2llh_avx2(double *llh, double *x, const pony_imu_const *imu_const, const int n)
+{
+	__m256d px, py, p, z, su, cu, N, D, r,
+		one = _mm256_set1_pd(1), a = _mm256_set1_pd(imu_const->a), e2 = _mm256_set1_pd(imu_const->e2),
+		k  = _mm256_set1_pd(sqrt(1 - imu_const->e2)),
+		ea = _mm256_set1_pd(imu_const->e2*imu_const->a),
+		eb = _mm256_set1_pd(imu_const->e2*imu_const->a/sqrt(1 - imu_const->e2));
+	int i, j;
+
+	for (i = 0; i+4 <= n; i += 4) {
+		px = _mm256_loadu_pd(x+i);
+		py = _mm256_loadu_pd(x+n+i);
+		z  = _mm256_loadu_pd(x+2*n+i);
+		p = _mm256_sqrt_pd(_mm256_fmadd_pd(px, px, _mm256_mul_pd(py, py)));
+		su = z;
+		cu = _mm256_mul_pd(p, k);
+		for (j = 0; j < 2; j++) {	// Bowring steps
+			r = _mm256_div_pd(one, _mm256_sqrt_pd(_mm256_fmadd_pd(su, su, _mm256_mul_pd(cu, cu))));
+			su = _mm256_mul_pd(su, r);
+			cu = _mm256_mul_pd(cu, r);
+			N = _mm256_fmadd_pd(_mm256_mul_pd(eb, su), _mm256_mul_pd(su, su), z);
+			D = _mm256_fnmadd_pd(_mm256_mul_pd(ea, cu), _mm256_mul_pd(cu, cu), p);
+			su = _mm256_mul_pd(N, k);
+			cu = D;
+		}
+		r = _mm256_div_pd(one, _mm256_sqrt_pd(_mm256_fmadd_pd(N, N, _mm256_mul_pd(D, D))));
+		su = _mm256_mul_pd(N, r);
+		cu = _mm256_mul_pd(D, r);
+		_mm256_storeu_pd(llh+2*n+i, _mm256_fnmadd_pd(a, _mm256_sqrt_pd(_mm256_fnmadd_pd(_mm256_mul_pd(e2, su), su, one)), _mm256_fmadd_pd(p, cu, _mm256_mul_pd(z, su))));
+		_mm256_storeu_pd(llh+n+i, pony_geo_atan2_avx2(N, D));
+		_mm256_storeu_pd(llh+i,   pony_geo_atan2_avx2(py, px));
+	}
+
+	return i;
+}
+
+PONY_SIMD_TARGET("avx2,fma")
+int pony_geo_gravity_avx2(double *g, double *llh, const pony_imu_const *imu_const, const int n)
+{
+	__m256d s, c, h_a,
+		one = _mm256_set1_pd(1), a_inv = _mm256_set1_pd(1/imu_const->a), ge = _mm256_set1_pd(imu_const->ge), fg = _mm256_set1_pd(imu_const->fg);
+	int i;
+
+	for (i = 0; i+4 <= n; i += 4) {
+		pony_geo_sincos_avx2(&s, &c, _mm256_loadu_pd(llh+n+i));
+		h_a = _mm256_mul_pd(_mm256_loadu_pd(llh+2*n+i), a_inv);
+		_mm256_storeu_pd(g+i, _mm256_mul_pd(
+			_mm256_mul_pd(ge, _mm256_fmadd_pd(_mm256_mul_pd(fg, s), s, one)),
+			_mm256_fmadd_pd(_mm256_fmadd_pd(_mm256_set1_pd(3), h_a, _mm256_set1_pd(-2)), h_a, one) ));
+	}
+
+	return i;
+}
+#endif
+
+pony_geo_kernel_set pony_geo_kernel_sets[4] = {	// by instruction set level, SSE2 and AVX-512 falling back to scalar and AVX2
+	{0, NULL, NULL, NULL}
+	, {0, NULL, NULL, NULL}
+#ifdef PONY_SIMD
+	, {2, pony_geo_llh2xyz_avx2, pony_geo_xyz2llh_avx2, pony_geo_gravity_avx2}
+	, {2, pony_geo_llh2xyz_avx2, pony_geo_xyz2llh_avx2, pony_geo_gravity_avx2}
+#endif
+};
+unsigned long pony_geo_level = 0;	// instruction set level selected plus one, 0 if not selected yet
+
+	// select vector kernels for batched conversions and gravity
+	//	input: 
+	//		max_level - maximum instruction set level to use: 0 - scalar, 2 - AVX2 with FMA, 1 and 3 as 0 and 2 respectively (no SSE2 or AVX-512 variants),
+	//					or negative for the best one available
+	//	output: 
+	//		instruction set level selected
+int pony_geo_simd(const int max_level)
+{
+	return pony_geo_kernel_sets[pony_simd_select(&pony_geo_level, max_level)].level;
+}
+
+		// vector kernels selected, the best available unless selected before, NULL for scalar loops
+pony_geo_kernel_set *pony_geo_vector(void)
+{
+	pony_geo_kernel_set *vec = &pony_geo_kernel_sets[pony_simd_selected(&pony_geo_level)];
+
+	return (vec->level > 0) ? vec : NULL;
+}
+
+	// geodetic to cartesian coordinates
+	// input:
+	//		llh - geodetic coordinates of n points: longitudes llh[0..n-1], latitudes llh[n..2n-1], heights llh[2n..3n-1], rad and meters
+	//		imu_const - inertial navigation constants for the ellipsoid
+	//		n - number of points
+	// output:
+	//		x - cartesian coordinates of n points: x[0..n-1], y[n..2n-1], z[2n..3n-1], meters, may be the same as llh
+void pony_geo_llh2xyz_soa(double *x, double *llh, const pony_imu_const *imu_const, const int n)
+{
+	pony_geo_kernel_set *vec = pony_geo_vector();
+
+	pony_geo_llh2xyz_scalar(x, llh, imu_const, n, (vec != NULL) ? vec->llh2xyz(x, llh, imu_const, n) : 0);
+}
+
+	// cartesian to geodetic coordinates, non-iterative
+	// input:
+	//		x - cartesian coordinates of n points: x[0..n-1], y[n..2n-1], z[2n..3n-1], meters, away from the Earth center
+	//		imu_const - inertial navigation constants for the ellipsoid
+	//		n - number of points
+	// output:
+	//		llh - geodetic coordinates of n points: longitudes llh[0..n-1] in [-pi, pi], latitudes llh[n..2n-1], heights llh[2n..3n-1], rad and meters, may be the same as x
+void pony_geo_xyz2llh_soa(double *llh, double *x, const pony_imu_const *imu_const, const int n)
+{
+	pony_geo_kernel_set *vec = pony_geo_vector();
+
+	pony_geo_xyz2llh_scalar(llh, x, imu_const, n, (vec != NULL) ? vec->xyz2llh(llh, x, imu_const, n) : 0);
+}
+
+	// normal gravity magnitude, the same as used by strapdown navigation
+	// input:
+	//		llh - geodetic coordinates of n points: longitudes llh[0..n-1], latitudes llh[n..2n-1], heights llh[2n..3n-1], rad and meters
+	//		imu_const - inertial navigation constants for the ellipsoid and normal gravity
+	//		n - number of points
+	// output:
+	//		g - normal gravity g[0..n-1], m/s^2
+void pony_geo_gravity_soa(double *g, double *llh, const pony_imu_const *imu_const, const int n)
+{
+	pony_geo_kernel_set *vec = pony_geo_vector();
+
+	pony_geo_gravity_scalar(g, llh, imu_const, n, (vec != NULL) ? vec->gravity(g, llh, imu_const, n) : 0);
+}
+
+	// move local-level frame origin
+	// input:
+	//		fr - frame, zeroed or with valid = 0 before the first call, tol may be set beforehand to reuse trigonometric terms and rotation matrix while the origin moves less
+	//		imu_const - inertial navigation constants for the ellipsoid and normal gravity
+	//		llh - new origin geodetic coordinates: longitude (rad), latitude (rad), height (meters)
+	// output:
+	//		fr - frame with origin cartesian coordinates and gravity exact to first order in the change since the last refresh, with terms refreshed incrementally when moved beyond tol
+	//		refreshed/not (1/0)
+char pony_geo_frame_set(pony_geo_frame *fr, const pony_imu_const *imu_const, double *llh)
+{
+	double lat = llh[1], lon = llh[0], d, s, c, w2, Re, h_a;
+	char refresh;
+
+	refresh = !fr->valid || fabs(lat - fr->lat) > fr->tol || fabs(lon - fr->lon) > fr->tol;
+	if (!fr->valid || (refresh && fr->refresh % pony_geo_frame_exact == 0)) {	// exact on a periodic refresh, bounding rounding drift of incremental updates
+		fr->sin_lat = sin(lat);
+		fr->cos_lat = cos(lat);
+		fr->sin_lon = sin(lon);
+		fr->cos_lon = cos(lon);
+	}
+	else if (refresh) {
+		pony_imu_strapdown_advance(&(fr->sin_lat), &(fr->cos_lat), lat, lat - fr->lat);
+		pony_imu_strapdown_advance(&(fr->sin_lon), &(fr->cos_lon), lon, lon - fr->lon);
+	}
+
+	if (refresh) {
+		fr->lat = lat;
+		fr->lon = lon;
+		w2 = 1 - imu_const->e2*fr->sin_lat*fr->sin_lat;
+		fr->Re = imu_const->a/sqrt(w2);
+		fr->Rn = fr->Re*(1 - imu_const->e2)/w2;
+		fr->C[0] = -fr->sin_lon;				fr->C[1] = fr->cos_lon;					fr->C[2] = 0;
+		fr->C[3] = -fr->sin_lat*fr->cos_lon;	fr->C[4] = -fr->sin_lat*fr->sin_lon;	fr->C[5] = fr->cos_lat;
+		fr->C[6] = fr->cos_lat*fr->cos_lon;		fr->C[7] = fr->cos_lat*fr->sin_lon;		fr->C[8] = fr->sin_lat;
+		fr->refresh++;
+	}
+
+	// origin from cached terms corrected to first order
+	d = lat - fr->lat;
+	s = fr->sin_lat + fr->cos_lat*d;
+	c = fr->cos_lat - fr->sin_lat*d;
+	Re = fr->Re*(1 + imu_const->e2*fr->sin_lat*fr->cos_lat*d*fr->Re*fr->Re/(imu_const->a*imu_const->a));
+	d = lon - fr->lon;
+	fr->x[0] = (Re + llh[2])*c*(fr->cos_lon - fr->sin_lon*d);
+	fr->x[1] = (Re + llh[2])*c*(fr->sin_lon + fr->cos_lon*d);
+	fr->x[2] = (Re*(1 - imu_const->e2) + llh[2])*s;
+	h_a = llh[2]/imu_const->a;
+	fr->g = imu_const->ge*(1 + imu_const->fg*s*s)*(1 - 2*h_a + 3*h_a*h_a);
+	fr->llh[0] = lon;
+	fr->llh[1] = lat;
+	fr->llh[2] = llh[2];
+	fr->valid = 1;
+
+	return refresh;
+}
+
+	// cartesian coordinates to local-level frame coordinates relative to the origin
+	// input:
+	//		x - cartesian coordinates of n points: x[0..n-1], y[n..2n-1], z[2n..3n-1], meters
+	//		fr - frame set with pony_geo_frame_set
+	//		n - number of points
+	// output:
+	//		enu - east, north and up coordinates of n points: e[0..n-1], n[n..2n-1], u[2n..3n-1], meters, may be the same as x
+void pony_geo_xyz2enu_soa(double *enu, double *x, pony_geo_frame *fr, const int n)
+{
+	int i, j;
+
+	for (j = 0; j < 3; j++)
+		for (i = 0; i < n; i++)
+			enu[j*n+i] = x[j*n+i] - fr->x[j];
+	pony_linal_m3mul_v_soa(enu, fr->C, enu, n);
+}
+
+	// local-level frame coordinates relative to the origin to cartesian coordinates
+	// input:
+	//		enu - east, north and up coordinates of n points: e[0..n-1], n[n..2n-1], u[2n..3n-1], meters
+	//		fr - frame set with pony_geo_frame_set
+	//		n - number of points
+	// output:
+	//		x - cartesian coordinates of n points: x[0..n-1], y[n..2n-1], z[2n..3n-1], meters, may be the same as enu
+void pony_geo_enu2xyz_soa(double *x, double *enu, pony_geo_frame *fr, const int n)
+{
+	int i, j;
+
+	pony_linal_m3Tmul_v_soa(x, fr->C, enu, n);
+	for (j = 0; j < 3; j++)
+		for (i = 0; i < n; i++)
+			x[j*n+i] += fr->x[j];
+}
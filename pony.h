@@ -1,417 +1,910 @@
-// Feb-2020
-//
-// PONY core declarations
-#define pony_bus_version 4		// current bus version
-
-// TIME EPOCH
-typedef struct 		// Julian-type time epoch
-{
-	int Y;			// Year
-	int M;			// Month
-	int D;			// Day
-	int h;			// hour
-	int m;			// minute
-	double s;		// seconds
-} pony_time_epoch;
-
-// SOL
-typedef struct			// navigation solution structure
-{
-	double x[3];		// cartesian coordinates, meters
-	char x_valid;		// validity flag (0/1)
-	double x_cov;		// coordinate RMS deviation estimate, meters
-	
-	double llh[3];		// geodetic coordinates: longitude (rad), latitude (rad), height (meters)
-	char llh_valid;		// validity flag (0/1)
-
-	double v[3];		// relative-to-Earth velocity vector coordinates in local-level geodetic or cartesian frame, meters per second
-	char v_valid;		// validity flag (0/1)
-	double v_cov;		// velocity RMS deviation estimate, meters per second
-
-	double q[4];		// attitude quaternion, relative to local-level or cartesian frame
-	char q_valid;		// validity flag (0/1)
-
-	double L[9];		// attitude matrix for the transition from local-level or cartesian frame, row-wise: L[0] = L_11, L[1] = L_12, ..., L[8] = L[33]
-	char L_valid;		// validity flag (0/1)
-
-	double rpy[3];		// attitude angles relative to local-level frame: roll (rad), pitch (rad), yaw = true heading (rad)
-	char rpy_valid;		// validity flag (0/1)
-
-	double dt;			// clock bias
-	char dt_valid;		// validity flag (0/1)
-} pony_sol;
-
-
-
-
-// IMU
-	// IMU const
-typedef struct		// inertial navigation constants
-{
-	double 
-		pi,			// pi
-		rad2deg,	// 180/pi
-		// Earth parameters as in GRS-80 by H. Moritz // Journal of Geodesy (2000) 74 (1): pp. 128162
-		u,			// Earth rotation rate, rad/s
-		a,			// Earth ellipsoid semi-major axis, m
-		e2,			// Earth ellipsoid first eccentricity squared
-		ge,			// Earth normal gravity at the equator, m/s^2
-		fg;			// Earth normal gravity flattening
-} pony_imu_const;
-
-	// IMU
-typedef struct		// inertial measurement unit
-{
-	char* cfg;		// pointer to IMU configuration string
-	int cfglength;	// IMU configuration string length
-
-	double t;		// time of measurement update
-
-	double w[3];	// up to 3 gyroscope measurements
-	char w_valid;	// validity flag (0/1)
-
-	double f[3];	// up to 3 accelerometer measurements
-	char f_valid;	// validity flag (0/1)
-
-	double W[3];	// angular velocity of the local level reference frame
-	char W_valid;	// validity flag (0/1)
-
-	double g[3];	// current gravity acceleration vector
-	char g_valid;	// validity flag (0/1)
-
-	pony_sol sol;	// inertial solution
-} pony_imu;
-
-
-
-
-// GNSS
-	// SAT
-typedef struct 				// GNSS satellite data
-{
-	double *eph;			// array of satellite ephemeris as defined by RINEX format (starting with toc: year, month, day, hour, min, sec, clock bias, etc., system-dependent)
-	char eph_valid;			// validity flag (0/1)
-
-	double Deltatsv;		// SV PRN code phase time offset (seconds), SV slock correction term to be subtracted: 
-								// GPS as in Section 20.3.3.3.3.1 of IS-GPS-200J (22 May 2018) p. 96
-								// GLONASS as in Section 3.3.3 of ICD GLONASS Edition 5.1 2008, minus sign, tau_c if present in pony_gnss_glo.clock_corr[0]
-
-	double t_em;			// time of signal emission
-	char t_em_valid;		// validity flag (0/1)
-	double x[3];			// satellite coordinates
-	char x_valid;			// validity flag (0/1)
-	double v[3];			// satellite velocity vector
-	char v_valid;			// validity flag (0/1)
-	
-	double sinEl;			// sine of satellite elevation angle
-	char sinEl_valid;		// validity flag (0/1)
-
-	double *obs;			// satellite observables array, defined at runtime
-	char *obs_valid;		// satellite observables validity flag array (0/1)
-} pony_gnss_sat;
-
-	// GPS const
-typedef struct		// GPS system constants
-{
-	double 
-		mu,			// Earth grav constant as in GPS interface specs, m^3/s^2
-		u,			// Earth rotation rate as in GPS interface specs, rad/s
-		a,			// Earth ellipsoid semi-major axis, m
-		e2,			// Earth ellipsoid first eccentricity squared
-		F,			// relativistic correction constant as in GPS interface specs, sec/sqrt(m)
-		F1, L1,		// nominal frequency and wavelength for L1 signal as in GPS interface specs, Hz and m
-		F2, L2;		// nominal frequency and wavelength for L2 signal as in GPS interface specs, Hz and m
-} pony_gps_const;
-
-	// GLONASS const
-typedef struct		// GLONASS system constants
-{
-	double 
-		mu,			// Earth grav constant as in GLONASS ICD, m^3/s^2
-		J02,		// second zonal harmonic of geopotential
-		u,			// Earth rotation rate as in GLONASS ICD, rad/s
-		a,			// Earth ellipsoid semi-major axis, m
-		e2,			// Earth ellipsoid first eccentricity squared as in GLONASS ICD
-		F01, dF1,	// nominal centre frequency and channel separation for L1 signal as in GLONASS ICD, Hz
-		F02, dF2;	// nominal centre frequency and channel wavelength for L2 signal as in GLONASS ICD, Hz
-} pony_glo_const;
-
-	// GALILEO const
-typedef struct		// Galileo system constants
-{
-	double 
-		mu,			// Earth grav constant as in Galileo interface specs, m^3/s^2
-		u,			// Earth rotation rate as in Galileo interface specs, rad/s
-		a,			// Earth ellipsoid semi-major axis, m
-		e2,			// Earth ellipsoid first eccentricity squared
-		F,			// relativistic correction constant as in Galileo interface specs, sec/sqrt(m)
-		F1, L1,		// nominal frequency and wavelength for E1 signal as in Galileo interface specs, Hz and m
-		F5a, L5a,	// nominal frequency and wavelength for E5a signal as in Galileo interface specs, Hz and m
-		F5b, L5b,	// nominal frequency and wavelength for E5b signal as in Galileo interface specs, Hz and m
-		F6, L6;		// nominal frequency and wavelength for E6 signal as in Galileo interface specs, Hz and m
-} pony_gal_const;
-
-	// BEIDOU const
-typedef struct		// BeiDou system constants
-{
-	double 
-		mu,			// Earth grav constant as in BeiDou interface specs, m^3/s^2
-		u,			// Earth rotation rate as in BeiDou interface specs, rad/s
-		a,			// Earth ellipsoid semi-major axis as in CGCS2000, m
-		e2,			// Earth ellipsoid first eccentricity squared, as in CGCS2000
-		F,			// relativistic correction constant as in BeiDou interface specs, sec/sqrt(m)
-		leap_sec,	// leap seconds between BeiDou time and GPS time as of 01-Jan-2006
-		B1, L1,		// nominal frequency and wavelength for B1 signal as in BeiDou interface specs, Hz and m
-		B2, L2;		// nominal frequency and wavelength for B2 signal as in BeiDou interface specs, Hz and m
-} pony_bds_const;
-
-typedef struct		// GNSS constants
-{
-	double 
-		pi,			// circumference-to-diameter ratio
-		c,			// speed of light, m/s
-		sec_in_w,	// seconds in a week
-		sec_in_d;	// seconds in a day
-	// constellation-specific constants
-	pony_gps_const gps;		// GPS constants
-	pony_glo_const glo;		// GLONASS constants
-	pony_gal_const gal;		// Galileo constants
-	pony_bds_const bds;		// BeiDou constants
-} pony_gnss_const;
-
-	// GPS
-typedef struct				// GPS constellation data
-{
-	char* cfg;				// GPS configuration string
-	int cfglength;			// configuration string length
-
-	int max_sat_count;		// maximum supported number of satellites
-	int max_eph_count;		// maximum supported number of ephemeris
-
-	pony_gnss_sat *sat;		// GPS satellites
-	char **obs_types;		// observation types according to RINEX: C1C, etc.; an array of 3-character null-terminated strings in the same order as in satellites
-	int obs_count;			// number of observation types
-
-	double iono_a[4];		// ionospheric model parameters from GPS almanac
-	double iono_b[4];		
-	char iono_valid;		// validity flag (0/1)
-
-	double clock_corr[4];	// clock correction parameters from GPS almanac: e.g. a0, a1, gps_second, gps_week for GPS to UTC, optional
-	char clock_corr_to[2];	// time system, which the correction results into: GP - GPS, UT - UTC, GA - Galileo, etc.
-	char clock_corr_valid;	// validity flag (0/1)
-} pony_gnss_gps;
-
-	// GLONASS
-typedef struct				// GLONASS constellation data
-{
-	char* cfg;				// GLONASS configuration string
-	int cfglength;			// configuration string length
-
-	int max_sat_count;		// maximum supported number of satellites
-	int max_eph_count;		// maximum supported number of ephemeris
-
-	pony_gnss_sat *sat;		// GLONASS satellites
-	int *freq_slot;			// frequency numbers
-	char **obs_types;		// observation types according to RINEX: C1C, etc.; an array of 3-character null-terminated strings in the same order as in satellites
-	int obs_count;			// number of observation types
-
-	double clock_corr[4];	// clock correction parameters from GLONASS almanac: e.g. -tauC, zero, Na_day_number, N4_four_year_interval for GLONASS to UTC, optional
-	char clock_corr_to[2];	// time system, which the correction results into: GP - GPS, UT - UTC, GA - Galileo, etc.
-	char clock_corr_valid;	// validity flag (0/1)
-} pony_gnss_glo;
-
-	// GALILEO
-typedef struct				// Galileo constellation data
-{
-	char* cfg;				// Galileo configuration string
-	int cfglength;			// configuration string length
-
-	int max_sat_count;		// maximum supported number of satellites
-	int max_eph_count;		// maximum supported number of ephemeris
-
-	pony_gnss_sat *sat;		// Galileo satellites
-	char **obs_types;		// observation types according to RINEX: C1C, etc.; an array of 3-character null-terminated strings in the same order as in satellites
-	int obs_count;			// number of observation types
-
-	double iono[3];			// ionospheric model parameters from Galileo almanac
-	char iono_valid;		// validity flag (0/1)
-
-	double clock_corr[4];	// clock correction parameters from Galileo almanac: e.g. a0, a1, gal_second, gal_week for GAL to UTC, optional
-	char clock_corr_to[2];	// time system, which the correction results into: GP - GPS, UT - UTC, GA - Galileo, etc.
-	char clock_corr_valid;	// validity flag (0/1)
-} pony_gnss_gal;
-
-		// BEIDOU
-typedef struct				// BeiDou constellation data
-{
-	char* cfg;				// BeiDou configuration string
-	int cfglength;			// configuration string length
-
-	int max_sat_count;		// maximum supported number of satellites
-	int max_eph_count;		// maximum supported number of ephemeris
-
-	pony_gnss_sat *sat;		// BeiDou satellites
-	char **obs_types;		// observation types according to RINEX: C1C, etc.; an array of 3-character null-terminated strings in the same order as in satellites
-	int obs_count;			// number of observation types
-
-	double iono_a[4];		// ionospheric model parameters from BeiDou almanac
-	double iono_b[4];		
-	char iono_valid;		// validity flag (0/1)
-
-	double clock_corr[4];	// clock correction parameters from BeiDou almanac: e.g. a0, a1, bds_second, bds_week for BDS to UTC, optional
-	char clock_corr_to[2];	// time system, which the correction results into: GP - GPS, UT - UTC, GA - Galileo, etc.
-	char clock_corr_valid;	// validity flag (0/1)
-} pony_gnss_bds;
-
-	// SETTINGS
-typedef struct // GNSS operation settings
-{
-	double sinEl_mask;			// elevation angle mask, sine of
-
-	double code_sigma;			// pseudorange measurement rmsdev (sigma), meters
-	double phase_sigma;			// carrier phase measurement rmsdev (sigma), cycles
-
-	double ant_pos[3];				// antenna coordinates in the instrumental frame
-	double ant_pos_tol;			// antenna position tolerance (-1 if undefined)
-
-	double leap_sec_def;		// default value of leap seconds ( <= 0 if undefined)
-} pony_gnss_settings;
-
-	// GNSS
-typedef struct						// global navigation satellite systems data
-{
-	char* cfg;						// full GNSS configuration string pointer, NULL if gnss is not used
-	int cfglength;					// full GNSS configuration string length
-
-	char* cfg_settings;				// pointer to a part of GNSS configuration string common to all systems
-	int settings_length;			// length of the part of GNSS configuration string common to all systems
-
-	pony_gnss_settings settings;	// GNSS operation settings
-
-	pony_gnss_gps* gps;				// GPS constellation data pointer
-	pony_gnss_glo* glo;				// GLONASS constellation data pointer
-	pony_gnss_gal* gal;				// Galileo constellation data pointer
-	pony_gnss_bds* bds;				// BeiDou constellation data pointer
-
-	pony_time_epoch epoch;			// current GNSS time epoch
-	int leap_sec;					// current number of leap seconds (for UTC by default, but may also be used for BDS leap second for BDS-only processing)
-	char leap_sec_valid;			// validity flag (0/1)
-
-	pony_sol sol;					// current GNSS solution
-	int obs_count;					// total observations used in solution
-} pony_gnss;
-
-
-
-
-
-// BUS
-	// PLUGIN
-typedef struct	// scheduled plugin structure
-{
-	void(*func)(void);	// pointer to plugin function to execute
-	int cycle;			// tick cycle (period) to execute
-	int shift;			// tick within a cycle to execute at (shift)
-	int tick;			// current tick
-} pony_plugin;
-	// CORE
-typedef struct	// core structure
-{
-	pony_plugin *plugins;	// plugin array pointer
-	int plugin_count;		// number of plugins
-	int current_plugin_id;	// current plugin in plugin execution list
-	int exit_plugin_id;		// index of a plugin that initiated termination
-	char host_termination;	// identifier of termination being called by host
-} pony_core;
-
-typedef struct					// bus data to be used in host application
-{
-	int ver;								// bus version to be used at runtime	
-
-	// main functions to be used in host app
-		// basic
-	char(*add_plugin)	(void(*func)(void)	);	// add plugin to the plugin execution list,	input: pointer to plugin function,				output: OK/not OK (1/0)
-	char(*init)			(char *cfg			);	// initialize the bus, except for core,		input: configuration string (see description),	output: OK/not OK (1/0)
-	char(*step)			(void				);	// step through the plugin execution list,													output: OK/not OK (1/0)
-	char(*terminate)	(void				);	// terminate operation,																		output: OK/not OK (1/0)
-		// advanced scheduling
-	char(*remove_plugin)		(void(*func)(void)							);	// remove all instances of a plugin from the plugin execution list,		input: pointer to plugin function to be removed,			output: OK/not OK (1/0)
-	char(*replace_plugin)		(void(*oldfunc)(void), void(*newfunc)(void)	);	// replace all instances of the plugin by another one,					input: pointers to old and new plugin functions,			output: OK/not OK (1/0)
-	char(*schedule_plugin)		(void(*func)(void), int cycle, int shift	);	// add scheduled plugin to the plugin execution list,					input: pointer to plugin function, cycle, shift,			output: OK/not OK (1/0)
-	char(*reschedule_plugin)	(void(*func)(void), int cycle, int shift	);	// reschedule all instances of the plugin in the plugin execution list,	input: pointer to plugin function, new cycle, new shift,	output: OK/not OK (1/0)
-	char(*suspend_plugin)		(void(*func)(void)							);	// suspend all instances of the plugin in the plugin execution list,	input: pointer to plugin function,							output: OK/not OK (1/0)
-	char(*resume_plugin)		(void(*func)(void)							);	// resume all instances of the plugin in the plugin execution list,		input: pointer to plugin function,							output: OK/not OK (1/0)
-	pony_core core;								// core instances
-
-	char* cfg;									// full configuration string
-	int cfglength;								// full configuration string length
-
-	char* cfg_settings;							// pointer to a part of the configuration string common to all subsystems
-	int settings_length;						// length of the part of the configuration string common to all subsystems
-
-	pony_imu_const imu_const;					// inertial navigation constants, initialized independent of imu structure
-	pony_imu* imu;								// inertial measurement unit data pointer
-
-	pony_gnss_const gnss_const;					// global navigation satellite system constants, initialized independent of gnss structure
-	pony_gnss* gnss;							// global navigation satellite system data pointer
-	int gnss_count;								// number of gnss instances
-
-	double t;									// system time
-	int mode;									// operation mode: 0 - init, <0 termination, >0 normal operation
-	pony_sol sol;								// navigation solution
-} pony_struct;
-
-extern pony_struct *pony;
-
-
-
-
-
-
-
-// basic parsing
-char * pony_locate_token(const char *token, char *src, const int len, const char delim); // locate a token (and delimiter, when given) within a configuration string
-
-
-
-
-
-
-
-// time routines
-int pony_time_days_between_dates(pony_time_epoch epoch_from, pony_time_epoch epoch_to);	// days elapsed from one date to another, based on Rata Die serial date from day one on 0001/01/01 
-
-
-
-
-
-
-
-// linear algebra functions
-	// conventional operations
-double pony_linal_dot(double *u, double *v, const int m); // dot product
-double pony_linal_vnorm(double *u, const int m); // l2 vector norm, i.e. sqrt(u^T*u)
-void pony_linal_cross3x1(double *res, double *u, double *v); // cross product for 3x1 vectors res = u x v
-void pony_linal_mmul  (double *res,  double *a, double *b, const int n, const int n1, const int m); // matrix multiplication res = a*b, a is n x n1, b is n1 x m, res is n x m
-void pony_linal_mmul2T(double *res,  double *a, double *b, const int n, const int m, const int n1); // matrix multiplication with the second argument transposed res = a*b^T, a is n x m, b is n1 x m, res is n x n1
-void pony_linal_qmul(double *res, double *q, double *r); // quaternion multiplication for 4x1 quaternions res = q x r, with res0, q0, r0 being scalar parts
-
-	// space rotation representation
-/*void pony_linal_mat2quat(double *q, double *R); // 3x3 attitude matrix R to quaternion q with q0 being scalar part*/
-
-	// routines for m x m upper-triangular matrices U lined up in a single-dimension array u
-		// index conversion
-void pony_linal_u_ij2k(int *k,  const int i, const int j, const int m);	// upper-triangular matrix lined up in a single-dimension array index conversion: (i,j) -> k
-void pony_linal_u_k2ij(int *i,  int *j, const int k, const int m);		// upper-triangular matrix lined up in a single-dimension array index conversion: k -> (i,j)
-		// conventional matrix operations
-void pony_linal_u_mul(double *res,  double *u, double *v, const int n, const int m);	// upper-triangular matrix lined up in a single-dimension array multiplication: res = U*v
-void pony_linal_uT_mul_v(double *res,  double *u, double *v, const int m);	// upper-triangular matrix lined up in a single-dimension array transposed multiplication by vector: res = U^T*v
-void pony_linal_u_inv(double *res,  double *u, const int m); // inversion of upper-triangular matrix lined up in a single-dimension array: res = U^-1
-void pony_linal_uuT(double *res,  double *u, const int m); // square (with transposition) of upper-triangular matrix lined up in a single-dimension array: res = U U^T
-	
-	// matrix factorizations
-void pony_linal_chol(double *S,  double *P, const int m); // Cholesky upper-triangular factorization P = S*S^T, where P is symmetric positive-definite matrix
-
-	// square root Kalman filtering
-double pony_linal_kalman_update(double *x, double *S, double *K,  double z, double *h, double sigma, const int m);
-
+// Feb-2020
+//
+// PONY core declarations
+#define pony_bus_version 17		// current bus version
+
+// TIME EPOCH
+typedef struct 		// Julian-type time epoch
+{
+	int Y;			// Year
+	int M;			// Month
+	int D;			// Day
+	int h;			// hour
+	int m;			// minute
+	double s;		// seconds
+} pony_time_epoch;
+
+// CONTINUOUS TIME
+#define pony_time_gps 0			// time scales: GPS time
+#define pony_time_glo 1			// GLONASS time less 3 hours, as epochs in RINEX
+#define pony_time_gal 2			// Galileo system time
+#define pony_time_bds 3			// BeiDou time
+#define pony_time_utc 4			// coordinated universal time
+#define pony_time_scales 5		// number of time scales, the first four numbered as constellations in pony_gnss_constellation
+#define pony_time_gps_rd 722820	// Rata Die serial date of GPS time origin 1980/01/06
+
+typedef struct		// current epoch as continuous GPS time, with offsets of other time scales, refreshed once per epoch
+{
+	int scale;				// time scale of gnss epoch, pony_time_gps by default
+	pony_time_epoch epoch;	// epoch the time is refreshed for
+	int epoch_scale;		// time scale the time is refreshed for
+	long day;				// days since GPS time origin in GPS time
+	double sec;				// seconds of the day in GPS time, [0, 86400)
+	double offset[pony_time_scales];		// time of each scale minus GPS time, seconds
+	char offset_valid[pony_time_scales];	// validity flags (0/1)
+	int leap_sec;			// leap seconds the offsets are refreshed with, -1 if unknown
+	char valid;				// validity flag (0/1)
+} pony_time;
+
+// SOL
+typedef struct			// navigation solution structure
+{
+	double x[3];		// cartesian coordinates, meters
+	char x_valid;		// validity flag (0/1)
+	double x_cov;		// coordinate RMS deviation estimate, meters
+	
+	double llh[3];		// geodetic coordinates: longitude (rad), latitude (rad), height (meters)
+	char llh_valid;		// validity flag (0/1)
+
+	double v[3];		// relative-to-Earth velocity vector coordinates in local-level geodetic or cartesian frame, meters per second
+	char v_valid;		// validity flag (0/1)
+	double v_cov;		// velocity RMS deviation estimate, meters per second
+
+	double q[4];		// attitude quaternion, relative to local-level or cartesian frame
+	char q_valid;		// validity flag (0/1)
+
+	double L[9];		// attitude matrix for the transition from local-level or cartesian frame, row-wise: L[0] = L_11, L[1] = L_12, ..., L[8] = L[33]
+	char L_valid;		// validity flag (0/1)
+
+	double rpy[3];		// attitude angles relative to local-level frame: roll (rad), pitch (rad), yaw = true heading (rad)
+	char rpy_valid;		// validity flag (0/1)
+
+	double dt;			// clock bias
+	char dt_valid;		// validity flag (0/1)
+} pony_sol;
+
+
+
+
+// IMU
+	// IMU const
+typedef struct		// inertial navigation constants
+{
+	double 
+		pi,			// pi
+		rad2deg,	// 180/pi
+		// Earth parameters as in GRS-80 by H. Moritz // Journal of Geodesy (2000) 74 (1): pp. 128–162
+		u,			// Earth rotation rate, rad/s
+		a,			// Earth ellipsoid semi-major axis, m
+		e2,			// Earth ellipsoid first eccentricity squared
+		ge,			// Earth normal gravity at the equator, m/s^2
+		fg;			// Earth normal gravity flattening
+} pony_imu_const;
+
+	// IMU SAMPLE RING
+#define pony_imu_ring_pad 64	// padding between producer and consumer fields of the ring, bytes, at least a cache line
+
+typedef struct		// imu sample pushed by a driver thread
+{
+	double t;		// time of measurement
+	double w[3];	// gyroscope measurements
+	double f[3];	// accelerometer measurements
+	char w_valid;	// validity flag (0/1)
+	char f_valid;	// validity flag (0/1)
+} pony_imu_sample;
+
+typedef struct		// lock-free single-producer/single-consumer ring of imu samples, producer and consumer fields on separate cache lines
+{
+	pony_imu_sample *sample;	// sample slots
+	unsigned long mask;			// number of slots minus one, the number of slots being a power of two
+	char pad0[pony_imu_ring_pad];
+
+	unsigned long head;			// samples pushed, written by producer only
+	unsigned long tail_cache;	// samples drained as last seen by producer
+	unsigned long overruns;		// samples dropped because the ring was full, written by producer only
+	char pad1[pony_imu_ring_pad];
+
+	unsigned long tail;			// samples drained, written by consumer only
+	unsigned long head_cache;	// samples pushed as last seen by consumer
+	char pad2[pony_imu_ring_pad];
+} pony_imu_ring;
+
+	// IMU PRE-INTEGRATION
+typedef struct		// coning and sculling compensated increments accumulated from high-rate imu samples over a fixed interval
+{
+	double interval;	// accumulation interval, s
+
+		// last completed interval
+	double t0;			// interval start time
+	double t;			// interval end time
+	double dtheta[3];	// delta-angle, i.e. rotation vector of the body frame at interval end relative to that at interval start, coning compensated, rad
+	double dv[3];		// delta-velocity in the body frame at interval start, rotation and sculling compensated, m/s
+	int count;			// number of samples integrated
+	char valid;			// validity flag (0/1)
+
+		// interval being accumulated
+	double start;		// interval start time
+	double alpha[3];	// sum of angle increments
+	double beta[3];		// coning term
+	double v[3];		// sum of velocity increments
+	double gamma[3];	// sculling term
+	double dalpha[3];	// previous angle increment, carried across intervals
+	double dvel[3];		// previous velocity increment, carried across intervals
+	int n;				// number of samples integrated
+
+		// previous sample, for trapezoidal increments from rate measurements
+	pony_imu_sample prev;
+	char started;		// previous sample present (1) or not (0)
+} pony_imu_preint;
+
+	// STRAPDOWN
+typedef struct		// strapdown inertial navigation in local-level east-north-up frame, body frame axes: right, forward, up
+{
+	double t;			// time of the last update
+	double Q[4];		// body to local-level frame attitude quaternion, i.e. conjugate of pony_sol.q
+
+		// terms cached for the latitude and longitude of the last refresh, updated incrementally as position changes
+	double lat;			// latitude the terms are computed for, rad
+	double lon;			// longitude the terms are computed for, rad
+	double sin_lat, cos_lat, sin_lon, cos_lon;
+	double Re;			// prime vertical radius of curvature, m
+	double Rn;			// meridian radius of curvature, m
+	double g0;			// normal gravity on the ellipsoid, m/s^2
+	double u[3];		// Earth rotation rate in local-level frame, rad/s
+	double tol;			// latitude and longitude change to refresh the terms at, rad
+	unsigned long refresh;	// number of refreshes
+
+	char valid;			// initialized (1) or not (0)
+} pony_imu_strapdown;
+
+	// LOCAL-LEVEL FRAME
+#define pony_geo_frame_exact 4096	// refreshes per exact, not incremental, one of the trigonometric terms
+typedef struct		// east-north-up frame at a point, with terms cached for the point and updated incrementally as it moves
+{
+	double llh[3];		// origin geodetic coordinates: longitude (rad), latitude (rad), height (meters)
+	double x[3];		// origin cartesian coordinates, meters
+	double sin_lat, cos_lat, sin_lon, cos_lon;	// for the latitude and longitude of the last refresh
+	double lat, lon;	// latitude and longitude of the last refresh, rad
+	double C[9];		// cartesian to local-level frame rotation matrix, rows: east, north, up
+	double Re;			// prime vertical radius of curvature, m
+	double Rn;			// meridian radius of curvature, m
+	double g;			// normal gravity at the origin, m/s^2
+	double tol;			// latitude and longitude change to refresh the terms at, rad, 0 to refresh on any change
+	unsigned long refresh;	// number of refreshes
+
+	char valid;			// initialized (1) or not (0)
+} pony_geo_frame;
+
+	// IMU
+typedef struct		// inertial measurement unit
+{
+	char* cfg;		// pointer to IMU configuration string
+	int cfglength;	// IMU configuration string length
+
+	double t;		// time of measurement update
+
+	double w[3];	// up to 3 gyroscope measurements
+	char w_valid;	// validity flag (0/1)
+
+	double f[3];	// up to 3 accelerometer measurements
+	char f_valid;	// validity flag (0/1)
+
+	double W[3];	// angular velocity of the local level reference frame
+	char W_valid;	// validity flag (0/1)
+
+	double g[3];	// current gravity acceleration vector
+	char g_valid;	// validity flag (0/1)
+
+	pony_sol sol;	// inertial solution
+
+	pony_imu_ring *ring;	// samples pushed by a driver thread ahead of the bus, NULL if not configured (ring_size in imu configuration)
+	pony_imu_preint *preint;	// increments pre-integrated from samples, NULL if not configured (preint_interval in imu configuration, s)
+} pony_imu;
+
+
+
+
+// GNSS
+	// SAT
+typedef struct 				// GNSS satellite data
+{
+	double *eph;			// array of satellite ephemeris as defined by RINEX format (starting with toc: year, month, day, hour, min, sec, clock bias, etc., system-dependent)
+	char eph_valid;			// validity flag (0/1)
+
+	double Deltatsv;		// SV PRN code phase time offset (seconds), SV slock correction term to be subtracted: 
+								// GPS as in Section 20.3.3.3.3.1 of IS-GPS-200J (22 May 2018) p. 96
+								// GLONASS as in Section 3.3.3 of ICD GLONASS Edition 5.1 2008, minus sign, tau_c if present in pony_gnss_glo.clock_corr[0]
+
+	double t_em;			// time of signal emission
+	char t_em_valid;		// validity flag (0/1)
+	double x[3];			// satellite coordinates
+	char x_valid;			// validity flag (0/1)
+	double v[3];			// satellite velocity vector
+	char v_valid;			// validity flag (0/1)
+	
+	double sinEl;			// sine of satellite elevation angle
+	char sinEl_valid;		// validity flag (0/1)
+
+	double *obs;			// satellite observables array, defined at runtime, or reserved at init if max_obs_count is configured
+	char *obs_valid;		// satellite observables validity flag array (0/1), defined along with observables
+} pony_gnss_sat;
+
+	// SAT SoA
+typedef struct				// structure-of-arrays view of constellation satellites, i-th element for i-th satellite, synchronized with pony_gnss_sat array on request
+{
+	int count;				// number of satellites, equal to max_sat_count
+
+	double *x, *y, *z;		// satellite coordinates
+	double *vx, *vy, *vz;	// satellite velocity vector
+	double *sinEl;			// sine of satellite elevation angle
+	double *t_em;			// time of signal emission
+	double *Deltatsv;		// SV PRN code phase time offset (seconds)
+
+	unsigned int *eph_valid;	// packed validity flags, bit i%32 of word i/32 for i-th satellite
+	unsigned int *x_valid;
+	unsigned int *v_valid;
+	unsigned int *t_em_valid;
+	unsigned int *sinEl_valid;
+} pony_gnss_sat_soa;
+
+	// GPS const
+typedef struct		// GPS system constants
+{
+	double 
+		mu,			// Earth grav constant as in GPS interface specs, m^3/s^2
+		u,			// Earth rotation rate as in GPS interface specs, rad/s
+		a,			// Earth ellipsoid semi-major axis, m
+		e2,			// Earth ellipsoid first eccentricity squared
+		F,			// relativistic correction constant as in GPS interface specs, sec/sqrt(m)
+		F1, L1,		// nominal frequency and wavelength for L1 signal as in GPS interface specs, Hz and m
+		F2, L2;		// nominal frequency and wavelength for L2 signal as in GPS interface specs, Hz and m
+} pony_gps_const;
+
+	// GLONASS const
+typedef struct		// GLONASS system constants
+{
+	double 
+		mu,			// Earth grav constant as in GLONASS ICD, m^3/s^2
+		J02,		// second zonal harmonic of geopotential
+		u,			// Earth rotation rate as in GLONASS ICD, rad/s
+		a,			// Earth ellipsoid semi-major axis, m
+		e2,			// Earth ellipsoid first eccentricity squared as in GLONASS ICD
+		F01, dF1,	// nominal centre frequency and channel separation for L1 signal as in GLONASS ICD, Hz
+		F02, dF2;	// nominal centre frequency and channel wavelength for L2 signal as in GLONASS ICD, Hz
+} pony_glo_const;
+
+	// GALILEO const
+typedef struct		// Galileo system constants
+{
+	double 
+		mu,			// Earth grav constant as in Galileo interface specs, m^3/s^2
+		u,			// Earth rotation rate as in Galileo interface specs, rad/s
+		a,			// Earth ellipsoid semi-major axis, m
+		e2,			// Earth ellipsoid first eccentricity squared
+		F,			// relativistic correction constant as in Galileo interface specs, sec/sqrt(m)
+		F1, L1,		// nominal frequency and wavelength for E1 signal as in Galileo interface specs, Hz and m
+		F5a, L5a,	// nominal frequency and wavelength for E5a signal as in Galileo interface specs, Hz and m
+		F5b, L5b,	// nominal frequency and wavelength for E5b signal as in Galileo interface specs, Hz and m
+		F6, L6;		// nominal frequency and wavelength for E6 signal as in Galileo interface specs, Hz and m
+} pony_gal_const;
+
+	// BEIDOU const
+typedef struct		// BeiDou system constants
+{
+	double 
+		mu,			// Earth grav constant as in BeiDou interface specs, m^3/s^2
+		u,			// Earth rotation rate as in BeiDou interface specs, rad/s
+		a,			// Earth ellipsoid semi-major axis as in CGCS2000, m
+		e2,			// Earth ellipsoid first eccentricity squared, as in CGCS2000
+		F,			// relativistic correction constant as in BeiDou interface specs, sec/sqrt(m)
+		leap_sec,	// leap seconds between BeiDou time and GPS time as of 01-Jan-2006
+		B1, L1,		// nominal frequency and wavelength for B1 signal as in BeiDou interface specs, Hz and m
+		B2, L2;		// nominal frequency and wavelength for B2 signal as in BeiDou interface specs, Hz and m
+} pony_bds_const;
+
+typedef struct		// GNSS constants
+{
+	double 
+		pi,			// circumference-to-diameter ratio
+		c,			// speed of light, m/s
+		sec_in_w,	// seconds in a week
+		sec_in_d;	// seconds in a day
+	// constellation-specific constants
+	pony_gps_const gps;		// GPS constants
+	pony_glo_const glo;		// GLONASS constants
+	pony_gal_const gal;		// Galileo constants
+	pony_bds_const bds;		// BeiDou constants
+} pony_gnss_const;
+
+	// ORBIT CACHE
+#define pony_gnss_cheb_order 13		// Chebyshev polynomial coefficients per segment for each fitted value
+#define pony_gnss_cheb_size (7 + 7*pony_gnss_cheb_order)	// cache entries per satellite: fit interval start and length, ephemeris key (4), fitted flag, coefficients for x, y, z, vx, vy, vz, Deltatsv
+
+typedef struct				// Chebyshev orbit cache of a constellation: polynomial segments fitted to satellite positions, velocities and clock offsets
+{
+	double tol;				// position accuracy bound, m
+	double span;			// segment length, s, adapted to the accuracy bound
+	double *seg;			// segments, pony_gnss_cheb_size x max_sat_count, for each satellite contiguously
+} pony_gnss_cheb;
+
+	// GPS
+typedef struct				// GPS constellation data
+{
+	char* cfg;				// GPS configuration string
+	int cfglength;			// configuration string length
+
+	int max_sat_count;		// maximum supported number of satellites
+	int max_eph_count;		// maximum supported number of ephemeris
+	int max_obs_count;		// number of observables reserved per satellite at init, zero if allocated at runtime
+	void *arena;			// single aligned memory block for satellites, ephemeris, observables and their validity flags, satellite SoA view, orbit caches
+
+	pony_gnss_sat *sat;		// GPS satellites
+	pony_gnss_sat_soa soa;	// structure-of-arrays view of satellites, see pony_gnss_soa_gather/scatter
+	pony_gnss_cheb cheb;	// Chebyshev orbit cache, see pony_gnss_cheb_eval
+	char **obs_types;		// observation types according to RINEX: C1C, etc.; an array of 3-character null-terminated strings in the same order as in satellites
+	int obs_count;			// number of observation types
+
+	double iono_a[4];		// ionospheric model parameters from GPS almanac
+	double iono_b[4];		
+	char iono_valid;		// validity flag (0/1)
+
+	double clock_corr[4];	// clock correction parameters from GPS almanac: e.g. a0, a1, gps_second, gps_week for GPS to UTC, optional
+	char clock_corr_to[2];	// time system, which the correction results into: GP - GPS, UT - UTC, GA - Galileo, etc.
+	char clock_corr_valid;	// validity flag (0/1)
+} pony_gnss_gps;
+
+	// GLONASS
+#define pony_gnss_orbit_cache_size 9	// orbit integration cache entries per satellite: time, ephemeris reference time, ephemeris x coordinate, x, y, z, vx, vy, vz
+
+typedef struct				// GLONASS constellation data
+{
+	char* cfg;				// GLONASS configuration string
+	int cfglength;			// configuration string length
+
+	int max_sat_count;		// maximum supported number of satellites
+	int max_eph_count;		// maximum supported number of ephemeris
+	int max_obs_count;		// number of observables reserved per satellite at init, zero if allocated at runtime
+	void *arena;			// single aligned memory block for satellites, ephemeris, observables and their validity flags, satellite SoA view, orbit caches
+
+	pony_gnss_sat *sat;		// GLONASS satellites
+	pony_gnss_sat_soa soa;	// structure-of-arrays view of satellites, see pony_gnss_soa_gather/scatter
+	pony_gnss_cheb cheb;	// Chebyshev orbit cache, see pony_gnss_cheb_eval
+	int *freq_slot;			// frequency numbers
+	double *orbit;			// orbit integration cache, pony_gnss_orbit_cache_size x max_sat_count, i-th entry of all satellites stored contiguously
+	char **obs_types;		// observation types according to RINEX: C1C, etc.; an array of 3-character null-terminated strings in the same order as in satellites
+	int obs_count;			// number of observation types
+
+	double clock_corr[4];	// clock correction parameters from GLONASS almanac: e.g. -tauC, zero, Na_day_number, N4_four_year_interval for GLONASS to UTC, optional
+	char clock_corr_to[2];	// time system, which the correction results into: GP - GPS, UT - UTC, GA - Galileo, etc.
+	char clock_corr_valid;	// validity flag (0/1)
+} pony_gnss_glo;
+
+	// GALILEO
+typedef struct				// Galileo constellation data
+{
+	char* cfg;				// Galileo configuration string
+	int cfglength;			// configuration string length
+
+	int max_sat_count;		// maximum supported number of satellites
+	int max_eph_count;		// maximum supported number of ephemeris
+	int max_obs_count;		// number of observables reserved per satellite at init, zero if allocated at runtime
+	void *arena;			// single aligned memory block for satellites, ephemeris, observables and their validity flags, satellite SoA view, orbit caches
+
+	pony_gnss_sat *sat;		// Galileo satellites
+	pony_gnss_sat_soa soa;	// structure-of-arrays view of satellites, see pony_gnss_soa_gather/scatter
+	pony_gnss_cheb cheb;	// Chebyshev orbit cache, see pony_gnss_cheb_eval
+	char **obs_types;		// observation types according to RINEX: C1C, etc.; an array of 3-character null-terminated strings in the same order as in satellites
+	int obs_count;			// number of observation types
+
+	double iono[3];			// ionospheric model parameters from Galileo almanac
+	char iono_valid;		// validity flag (0/1)
+
+	double clock_corr[4];	// clock correction parameters from Galileo almanac: e.g. a0, a1, gal_second, gal_week for GAL to UTC, optional
+	char clock_corr_to[2];	// time system, which the correction results into: GP - GPS, UT - UTC, GA - Galileo, etc.
+	char clock_corr_valid;	// validity flag (0/1)
+} pony_gnss_gal;
+
+		// BEIDOU
+typedef struct				// BeiDou constellation data
+{
+	char* cfg;				// BeiDou configuration string
+	int cfglength;			// configuration string length
+
+	int max_sat_count;		// maximum supported number of satellites
+	int max_eph_count;		// maximum supported number of ephemeris
+	int max_obs_count;		// number of observables reserved per satellite at init, zero if allocated at runtime
+	void *arena;			// single aligned memory block for satellites, ephemeris, observables and their validity flags, satellite SoA view, orbit caches
+
+	pony_gnss_sat *sat;		// BeiDou satellites
+	pony_gnss_sat_soa soa;	// structure-of-arrays view of satellites, see pony_gnss_soa_gather/scatter
+	pony_gnss_cheb cheb;	// Chebyshev orbit cache, see pony_gnss_cheb_eval
+	char **obs_types;		// observation types according to RINEX: C1C, etc.; an array of 3-character null-terminated strings in the same order as in satellites
+	int obs_count;			// number of observation types
+
+	double iono_a[4];		// ionospheric model parameters from BeiDou almanac
+	double iono_b[4];		
+	char iono_valid;		// validity flag (0/1)
+
+	double clock_corr[4];	// clock correction parameters from BeiDou almanac: e.g. a0, a1, bds_second, bds_week for BDS to UTC, optional
+	char clock_corr_to[2];	// time system, which the correction results into: GP - GPS, UT - UTC, GA - Galileo, etc.
+	char clock_corr_valid;	// validity flag (0/1)
+} pony_gnss_bds;
+
+	// SETTINGS
+typedef struct // GNSS operation settings
+{
+	double sinEl_mask;			// elevation angle mask, sine of
+
+	double code_sigma;			// pseudorange measurement rmsdev (sigma), meters
+	double phase_sigma;			// carrier phase measurement rmsdev (sigma), cycles
+
+	double ant_pos[3];				// antenna coordinates in the instrumental frame
+	double ant_pos_tol;			// antenna position tolerance (-1 if undefined)
+
+	double leap_sec_def;		// default value of leap seconds ( <= 0 if undefined)
+} pony_gnss_settings;
+
+	// GNSS
+typedef struct						// global navigation satellite systems data
+{
+	char* cfg;						// full GNSS configuration string pointer, NULL if gnss is not used
+	int cfglength;					// full GNSS configuration string length
+
+	char* cfg_settings;				// pointer to a part of GNSS configuration string common to all systems
+	int settings_length;			// length of the part of GNSS configuration string common to all systems
+
+	pony_gnss_settings settings;	// GNSS operation settings
+
+	pony_gnss_gps* gps;				// GPS constellation data pointer
+	pony_gnss_glo* glo;				// GLONASS constellation data pointer
+	pony_gnss_gal* gal;				// Galileo constellation data pointer
+	pony_gnss_bds* bds;				// BeiDou constellation data pointer
+
+	pony_time_epoch epoch;			// current GNSS time epoch
+	pony_time time;					// current GNSS time epoch as continuous time, see pony_time_update, time.valid to be cleared when setting clock corrections
+	int leap_sec;					// current number of leap seconds (for UTC by default, but may also be used for BDS leap second for BDS-only processing)
+	char leap_sec_valid;			// validity flag (0/1)
+
+	pony_sol sol;					// current GNSS solution
+	int obs_count;					// total observations used in solution
+} pony_gnss;
+
+	// RINEX
+#define pony_rinex_max_obs_types 64	// maximum number of observation types per constellation in a RINEX observation file
+
+typedef struct				// streaming RINEX 2/3 observation file reader, parses one epoch per call straight from file contents into constellation observables
+{
+	char *data;				// file contents, memory-mapped or read into memory
+	unsigned long size;		// file size, bytes
+	unsigned long pos;		// position of the next epoch record
+	char mapped;			// memory-mapped (1) or read into allocated buffer (0)
+
+	double version;			// RINEX version
+	char sys;				// satellite system of the file: G, R, E, C, M for mixed
+	pony_gnss *gnss;		// GNSS data to be filled
+
+	pony_gnss_sat *sat[4];	// satellites of GPS, GLONASS, Galileo, BeiDou, NULL if constellation not configured
+	int sat_count[4];		// maximum number of satellites
+	int obs_count[4];		// number of observables per satellite filled
+	int type_count[4];		// number of observation types in file
+	int type_index[4][pony_rinex_max_obs_types];	// index of each file observation type in satellite observables, -1 if not used
+	char types[4][pony_rinex_max_obs_types][4];		// file observation types, RINEX 2 types converted to RINEX 3 notation
+	char *type_ptr[4][pony_rinex_max_obs_types];	// observation types array for constellations with no types set before
+	char adopted[4];		// constellation observation types set by the reader (0/1)
+	void *obs_block[4];		// observables and validity flags allocated by the reader, NULL if reserved at init or allocated elsewhere
+} pony_rinex_obs;
+
+#define pony_rinex_nav_width 41		// ephemeris values per record: epoch (6), clock (3), up to 8 broadcast orbit lines of 4
+#define pony_rinex_nav_version 1	// binary ephemeris cache format version
+#define pony_rinex_nav_params 72	// header parameters in binary cache: 16 for each constellation, leap seconds and validity, padding
+#define pony_rinex_nav_head (8 + pony_rinex_nav_params)	// binary cache header in doubles: signature, format version, format check, record width, record count, navigation file size and time, reserved, header parameters
+
+typedef struct				// RINEX 2/3 navigation data: all ephemeris records and header parameters, in the binary cache layout either memory-mapped from cache or parsed from text
+{
+	char *data;				// binary cache image
+	unsigned long size;		// image size, bytes
+	char mapped;			// memory-mapped (1) or allocated (0)
+	char cached;			// loaded from binary cache (1) or parsed from text (0)
+
+	double *param;			// header parameters, 16 for each of GPS, GLONASS, Galileo, BeiDou: ionospheric model (8), number of ionospheric model lines, clock correction (4), its target time system (2), validity; then leap seconds and validity
+	int count;				// number of ephemeris records
+	double *rec;			// ephemeris records sorted by constellation, satellite and epoch: constellation index, satellite number, number of values, pony_rinex_nav_width values as in pony_gnss_sat.eph
+} pony_rinex_nav;
+
+	// JOURNAL
+#define pony_journal_version 1	// journal file format version
+#define pony_journal_blocks 4	// encoded data blocks in rotation between host and writer thread
+
+typedef struct				// journal of bus inputs written by host before each step: time, imu measurements, gnss epochs, ionospheric and clock corrections, ephemeris and observables, delta-encoded step to step
+{
+	void *fp;				// journal file being recorded (FILE *), NULL if replaying
+	char *data;				// journal file contents being replayed, memory-mapped or read into memory
+	unsigned long size;		// journal file size, bytes
+	unsigned long pos;		// replay position
+	char mapped;			// replayed file memory-mapped (1) or read into memory (0)
+
+	int *layout;			// bus input layout: imu presence, number of gnss instances, for each gnss instance and constellation: presence, satellites, ephemeris values and observables per satellite
+	int layout_size;		// number of layout entries
+	char *types;			// observation types of all constellations in layout order, 4 characters each including null
+	int type_count;			// number of observation types
+	char ***obs_types;		// observation type arrays set by replay for each gnss instance and constellation, NULL if not set
+	void **obs_block;		// observables and validity flags allocated by replay for each gnss instance and constellation, NULL if reserved at init or allocated elsewhere
+
+	double *frame;			// bus input values of the current step
+	double *prev;			// bus input values of the previous step
+	int frame_size;			// number of values per step
+
+	char *block[pony_journal_blocks];			// encoded data blocks
+	unsigned long used[pony_journal_blocks];	// bytes used in each block
+	unsigned long block_size;	// block capacity, bytes
+	int current;			// block being filled by host
+	void *writer;			// writer thread, NULL if blocks are written on host thread
+	unsigned long steps;	// steps recorded or replayed
+} pony_journal;
+
+	// BATCH
+#define pony_batch_ahead 16		// default number of steps decoded ahead by each reader thread, and solutions queued for the writer thread
+
+typedef struct				// solution passed to the batch output function
+{
+	unsigned long step;		// step number within the batch, starting from zero
+	int file;				// index of the journal file the step inputs came from
+	double t;				// system time
+	pony_sol sol;			// navigation solution after the step
+} pony_batch_sol;
+
+typedef struct				// batch post-processing statistics
+{
+	unsigned long steps;	// steps run
+	int files;				// journal files completed
+	double seconds;			// wall-clock processing time, s
+	double rate;			// sustained rate, steps (epochs) per second
+	unsigned long input_waits;	// steps that waited for a reader to decode inputs
+	unsigned long output_waits;	// steps that waited for the writer to drain solutions
+} pony_batch_stats;
+
+
+
+
+
+// CONFIGURATION
+	// NODE
+typedef struct			// configuration tree node: group, word (key or value) outside quotes, or settings part of a group
+{
+	char type;			// node type: 'g' - group (including the root one), 'w' - word, 's' - settings part of a group, i.e. outside of its subgroups
+	char *name;			// name within configuration string: group identifier with a colon (e.g. "gps:"), or word characters
+	int namelength;		// name length
+	int scope;			// enclosing group node index, -1 for the root group
+	char *ptr;			// groups and settings: starting character of contents, words: next character after the word
+	int length;			// groups and settings: number of characters in contents, words: 0
+	int settings;		// groups: index of the settings node, or the group itself if its settings start from the beginning of contents
+	int next;			// next node with the same name within the same scope, -1 if none
+} pony_cfg_node;
+	// TREE
+typedef struct			// configuration tree, parsed once at init for hashed group and token lookup
+{
+	char *cfg;			// configuration string the tree is built for
+	int cfglength;		// configuration string length
+	pony_cfg_node *node;	// nodes, the root group first
+	int node_count;		// number of nodes
+	int *name_table;	// hash table of group and word nodes by scope and name, -1 for empty entries
+	int *ptr_table;		// hash table of group and settings nodes by contents starting character, -1 for empty entries
+	int table_size;		// hash table size, a power of two
+} pony_cfg_tree;
+
+
+
+
+// BUS
+	// DATA SECTIONS
+		// bus data sections for plugins to declare what they read and write, so that independent plugins may run in parallel
+#define pony_data_core		0x00000001UL					// core: plugin execution list and scheduling, implicitly read by all plugins
+#define pony_data_t			0x00000002UL					// system time
+#define pony_data_sol		0x00000004UL					// navigation solution
+#define pony_data_cfg		0x00000008UL					// configuration strings
+#define pony_data_imu		0x00000010UL					// imu data
+#define pony_data_gnss(i)	(0x00000100UL << (i))			// i-th gnss instance data, i = 0..9
+#define pony_data_gnss_all	(0x000003ffUL << 8)				// all gnss instances data
+#define pony_data_all		0xffffffffUL					// all bus data, default for plugins with no declaration
+	// PLUGIN
+typedef struct	// scheduled plugin structure
+{
+	void(*func)(void);		// pointer to plugin function to execute
+	int cycle;				// tick cycle (period) to execute
+	int shift;				// tick within a cycle to execute at (shift)
+	unsigned long due;		// step to execute at next, if cycle > 0
+	unsigned long since;	// first step the plugin has been suspended or rescheduled for
+	int next;				// next plugin due in the same timing wheel slot, in the order of the execution list
+	unsigned long reads;	// bus data sections read by the plugin
+	unsigned long writes;	// bus data sections written by the plugin
+	char per_gnss;			// plugin is called once for each gnss instance (1), or once per step (0)
+} pony_plugin;
+
+#define pony_stats_bins 16	// number of plugin call duration histogram bins
+
+typedef struct	// plugin timing statistics
+{
+	unsigned long count;	// number of calls, counted for each gnss instance for plugins called once per instance
+	double last;			// last call duration, s
+	double min;				// minimum call duration, s
+	double max;				// maximum call duration, s
+	double mean;			// mean call duration, s
+	unsigned long overruns;	// number of calls longer than the overrun threshold
+	unsigned long hist[pony_stats_bins];	// call duration histogram: bin 0 for durations below 1 microsecond, bin k for [2^(k-1), 2^k) microseconds, the last bin for all the longer ones
+} pony_plugin_stats;
+	// CORE
+typedef struct	// core structure
+{
+	pony_plugin *plugins;	// plugin array pointer
+	int plugin_count;		// number of plugins
+	int current_plugin_id;	// current plugin in plugin execution list, -1 outside of a step
+	int exit_plugin_id;		// index of a plugin that initiated termination
+	char host_termination;	// identifier of termination being called by host
+
+	void *pool;				// worker thread pool for parallel plugin execution, NULL if all plugins run on the host thread
+	int *batch;				// plugins due within the current step, with their dependency levels, and tasks for parallel execution
+	int batch_size;			// number of plugins the batch array is allocated for
+	int batch_gnss_count;	// number of gnss instances the batch array is allocated for
+
+	unsigned long tick;		// current step (main cycle tick) number, the next one outside of a step
+	int *wheel;				// timing wheel: heads of the lists of plugins due in each slot, followed by tails, slot = due step modulo wheel_size
+	int wheel_size;			// number of timing wheel slots, a power of two
+	unsigned long wheel_version;	// counter of timing wheel modifications other than by the step loop itself
+
+	pony_plugin_stats *stats;	// timing statistics for each plugin in the execution list, NULL if instrumentation disabled
+	double stats_overrun;	// call duration to be counted as an overrun, s, zero if not counted
+	double stats_scale;		// duration of a time counter tick, s
+} pony_core;
+
+typedef struct					// bus data to be used in host application
+{
+	int ver;								// bus version to be used at runtime	
+
+	// main functions to be used in host app, operating on the bus instance selected for the current thread (see pony_bus_select)
+		// basic
+	char(*add_plugin)	(void(*func)(void)	);	// add plugin to the plugin execution list,	input: pointer to plugin function,				output: OK/not OK (1/0)
+	char(*add_gnss_plugin)(void(*func)(void)	);	// add plugin to be called for each gnss instance (see pony_gnss_current),	input: pointer to plugin function,	output: OK/not OK (1/0)
+	char(*init)			(char *cfg			);	// initialize the bus, except for core,		input: configuration string (see description),	output: OK/not OK (1/0)
+	char(*step)			(void				);	// step through the plugin execution list,													output: OK/not OK (1/0)
+	char(*terminate)	(void				);	// terminate operation,																		output: OK/not OK (1/0)
+		// advanced scheduling
+	char(*remove_plugin)		(void(*func)(void)							);	// remove all instances of a plugin from the plugin execution list,		input: pointer to plugin function to be removed,			output: OK/not OK (1/0)
+	char(*replace_plugin)		(void(*oldfunc)(void), void(*newfunc)(void)	);	// replace all instances of the plugin by another one,					input: pointers to old and new plugin functions,			output: OK/not OK (1/0)
+	char(*schedule_plugin)		(void(*func)(void), int cycle, int shift	);	// add scheduled plugin to the plugin execution list,					input: pointer to plugin function, cycle, shift,			output: OK/not OK (1/0)
+	char(*reschedule_plugin)	(void(*func)(void), int cycle, int shift	);	// reschedule all instances of the plugin in the plugin execution list,	input: pointer to plugin function, new cycle, new shift,	output: OK/not OK (1/0)
+	char(*suspend_plugin)		(void(*func)(void)							);	// suspend all instances of the plugin in the plugin execution list,	input: pointer to plugin function,							output: OK/not OK (1/0)
+	char(*resume_plugin)		(void(*func)(void)							);	// resume all instances of the plugin in the plugin execution list,		input: pointer to plugin function,							output: OK/not OK (1/0)
+	char(*declare_plugin)		(void(*func)(void), unsigned long reads, unsigned long writes);	// declare bus data sections accessed by all instances of the plugin,	input: pointer to plugin function, sections read and written (pony_data_...),	output: OK/not OK (1/0)
+		// instrumentation
+	char(*enable_stats)			(char enable, double overrun				);	// enable (resetting) or disable plugin timing statistics,				input: 1/0, call duration to count as overrun (s, 0 if none),	output: OK/not OK (1/0)
+	const pony_plugin_stats*(*get_stats)(int id							);	// get timing statistics of a plugin,									input: plugin index in the execution list,					output: pointer to statistics, NULL if disabled or no such plugin
+	pony_core core;								// core instances
+
+	char* cfg;									// full configuration string
+	int cfglength;								// full configuration string length
+
+	char* cfg_settings;							// pointer to a part of the configuration string common to all subsystems
+	int settings_length;						// length of the part of the configuration string common to all subsystems
+	pony_cfg_tree cfg_tree;						// configuration tree for group and token lookup without rescanning the string
+
+	pony_imu_const imu_const;					// inertial navigation constants, initialized independent of imu structure
+	pony_imu* imu;								// inertial measurement unit data pointer
+
+	pony_gnss_const gnss_const;					// global navigation satellite system constants, initialized independent of gnss structure
+	pony_gnss* gnss;							// global navigation satellite system data pointer
+	int gnss_count;								// number of gnss instances
+
+	double t;									// system time
+	int mode;									// operation mode: 0 - init, <0 termination, >0 normal operation
+	pony_sol sol;								// navigation solution
+} pony_struct;
+
+	// thread-local storage class for the current bus pointer, so that plugins running on different threads may refer to different bus instances
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+	#define PONY_THREAD_LOCAL _Thread_local
+#elif defined(_MSC_VER)
+	#define PONY_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+	#define PONY_THREAD_LOCAL __thread
+#else
+	#define PONY_THREAD_LOCAL
+#endif
+
+extern PONY_THREAD_LOCAL pony_struct *pony;	// bus instance selected for the current thread, points to the default bus instance unless selected otherwise
+extern PONY_THREAD_LOCAL pony_gnss *pony_gnss_current;	// gnss instance a per-gnss plugin is called for on the current thread, NULL for other plugins
+
+
+
+
+// re-entrant bus instances: caller-owned bus structures with functions taking the bus explicitly, to run several independent pipelines in a single process
+char pony_bus_setup(pony_struct *bus);			// set up a caller-owned bus instance before init (version, functions, core),	input: pointer to bus structure,	output: OK/not OK (1/0)
+pony_struct *pony_bus_select(pony_struct *bus);	// select a bus instance for the current thread (NULL for the default one),		input: pointer to bus structure,	output: pointer to previously selected bus
+	// basic
+char pony_bus_add_plugin	(pony_struct *bus, void(*func)(void)	);	// add plugin to the plugin execution list of a given bus
+char pony_bus_add_gnss_plugin(pony_struct *bus, void(*func)(void)	);	// add plugin to be called for each gnss instance to the plugin execution list of a given bus
+char pony_bus_init			(pony_struct *bus, char *cfg			);	// initialize a given bus, except for core
+char pony_bus_step			(pony_struct *bus						);	// step through the plugin execution list of a given bus, the bus is selected for the current thread while plugins are running
+char pony_bus_terminate		(pony_struct *bus						);	// terminate operation of a given bus
+	// advanced scheduling
+char pony_bus_remove_plugin		(pony_struct *bus, void(*func)(void)							);	// remove all instances of a plugin from the plugin execution list of a given bus
+char pony_bus_replace_plugin	(pony_struct *bus, void(*oldfunc)(void), void(*newfunc)(void)	);	// replace all instances of the plugin by another one for a given bus
+char pony_bus_schedule_plugin	(pony_struct *bus, void(*func)(void), int cycle, int shift		);	// add scheduled plugin to the plugin execution list of a given bus
+char pony_bus_reschedule_plugin	(pony_struct *bus, void(*func)(void), int cycle, int shift		);	// reschedule all instances of the plugin in the plugin execution list of a given bus
+char pony_bus_suspend_plugin	(pony_struct *bus, void(*func)(void)							);	// suspend all instances of the plugin in the plugin execution list of a given bus
+char pony_bus_resume_plugin		(pony_struct *bus, void(*func)(void)							);	// resume all instances of the plugin in the plugin execution list of a given bus
+char pony_bus_declare_plugin	(pony_struct *bus, void(*func)(void), unsigned long reads, unsigned long writes);	// declare bus data sections accessed by all instances of the plugin of a given bus
+	// instrumentation
+char pony_bus_enable_stats		(pony_struct *bus, char enable, double overrun					);	// enable or disable plugin timing statistics for a given bus
+const pony_plugin_stats *pony_bus_get_stats(pony_struct *bus, int id						);	// get timing statistics of a plugin of a given bus
+
+
+
+
+
+
+
+// basic parsing
+char * pony_locate_token(const char *token, char *src, const int len, const char delim); // locate a token (and delimiter, when given) within a configuration string
+
+
+
+
+
+
+
+// imu sample ring and pre-integration routines
+char pony_imu_ring_push   (pony_imu_ring *ring, const pony_imu_sample *sample);	// push a sample on the producer thread without locks or allocation, output: pushed/dropped as overrun (1/0)
+int  pony_imu_ring_peek   (pony_imu_ring *ring, pony_imu_sample **sample);		// oldest samples on the consumer thread, in place, output: number of samples contiguous from *sample
+void pony_imu_ring_consume(pony_imu_ring *ring, const int count);				// release count oldest samples on the consumer thread after peek
+int  pony_imu_ring_drain  (pony_imu_ring *ring, pony_imu_sample *sample, const int max_count);	// copy and release up to max_count oldest samples on the consumer thread, output: number of samples drained
+void pony_imu_preint_reset(pony_imu_preint *pre);	// drop accumulated increments and the previous sample
+char pony_imu_preint_add  (pony_imu_preint *pre, const pony_imu_sample *sample);	// integrate an angular rate and specific force sample, output: interval completed with increments set/not (1/0)
+char pony_imu_preint_step (pony_imu *imu);	// integrate samples from the imu ring up to the end of an interval, or the current imu sample if no ring, output: interval completed/not (1/0)
+
+
+
+
+
+
+
+// strapdown inertial navigation
+char pony_imu_strapdown_init  (pony_imu_strapdown *sd, pony_imu *imu, const pony_imu_const *imu_const);	// start from imu->sol position (llh), velocity (v) and attitude (q or rpy) at time imu->t, output: OK/not OK (1/0)
+void pony_imu_strapdown_update(pony_imu_strapdown *sd, pony_imu *imu, const pony_imu_const *imu_const, double *dtheta, double *dv, const double dt);	// update imu->sol, imu->W and imu->g by body frame delta-angle and delta-velocity over dt
+char pony_imu_strapdown_step  (pony_imu_strapdown *sd, pony_imu *imu, const pony_imu_const *imu_const);	// update by pre-integrated increments completed since the last update, or by imu rates over the time elapsed, output: updated/not (1/0)
+
+// geodetic routines
+	// batched over n points stored as structure of arrays: cartesian x[0..n-1], y[0..n-1], z[0..n-1], geodetic lon[0..n-1], lat[0..n-1], h[0..n-1], overwriting input allowed
+void pony_geo_llh2xyz_soa(double *x,   double *llh, const pony_imu_const *imu_const, const int n);	// geodetic to cartesian coordinates
+void pony_geo_xyz2llh_soa(double *llh, double *x,   const pony_imu_const *imu_const, const int n);	// cartesian to geodetic coordinates, non-iterative
+void pony_geo_gravity_soa(double *g,   double *llh, const pony_imu_const *imu_const, const int n);	// normal gravity magnitude g[0..n-1] at geodetic coordinates, m/s^2
+	// local-level frame
+char pony_geo_frame_set(pony_geo_frame *fr, const pony_imu_const *imu_const, double *llh);	// move frame origin to llh, refreshing cached terms beyond fr->tol, output: refreshed/not (1/0)
+void pony_geo_xyz2enu_soa(double *enu, double *x,   pony_geo_frame *fr, const int n);	// cartesian coordinates to local-level frame coordinates relative to the origin
+void pony_geo_enu2xyz_soa(double *x,   double *enu, pony_geo_frame *fr, const int n);	// local-level frame coordinates relative to the origin to cartesian coordinates
+	// vector kernels
+int pony_geo_simd(const int max_level);	// select vector kernels for batched conversions and gravity: 0 - scalar, 2 - AVX2, 1 and 3 fall back to 0 and 2, -1 - the best available, output: level selected
+
+
+
+
+
+
+
+// gnss satellite data routines
+void pony_gnss_soa_gather (pony_gnss_sat_soa *soa, pony_gnss_sat *sat);	// copy satellite data from pony_gnss_sat array to its structure-of-arrays view
+void pony_gnss_soa_scatter(pony_gnss_sat *sat, pony_gnss_sat_soa *soa);	// copy satellite data from structure-of-arrays view back to pony_gnss_sat array
+int  pony_gnss_soa_elevation(pony_gnss_sat_soa *soa, double *r, double *up, const double sinEl_mask, unsigned int *mask);	// sine of elevation angles for satellites with valid coordinates as seen from r with local vertical up, mask of those above sinEl_mask (may be NULL), output: number of satellites above mask
+double pony_gnss_eph_sow(double *eph);	// seconds of week for a RINEX epoch stored at the beginning of ephemeris array
+int  pony_gnss_kepler(pony_gnss_sat *sat, pony_gnss_sat_soa *soa, const double t, double *pr, const double mu, const double u, const double F, const double c, const char bds);	// satellite positions, velocities, emission time and clock offset from Keplerian ephemeris at reception time t (seconds of week) for pseudoranges pr (may be NULL), output: number of satellites computed
+int  pony_gnss_gps_kepler(pony_gnss_gps *gps, const double t, double *pr);	// GPS satellites, see pony_gnss_kepler
+int  pony_gnss_gal_kepler(pony_gnss_gal *gal, const double t, double *pr);	// Galileo satellites, see pony_gnss_kepler
+int  pony_gnss_bds_kepler(pony_gnss_bds *bds, const double t, double *pr);	// BeiDou satellites, see pony_gnss_kepler
+int  pony_gnss_glo_orbit(pony_gnss_glo *glo, const double t, double *pr);	// GLONASS satellite positions, velocities, emission time and clock offset by numerical integration from ephemeris or cached state at reception time t (seconds of week, UTC) for pseudoranges pr (may be NULL), output: number of satellites computed
+int  pony_gnss_cheb_eval(pony_gnss_sat *sat, pony_gnss_sat_soa *soa, pony_gnss_cheb *cheb, const double t, double *pr, const double c, const double u, void *system, int (*model)(void *system, const double t, double *pr));	// satellite positions, velocities, emission time and clock offset from Chebyshev orbit cache, refitted to model when needed, output: number of satellites computed
+int  pony_gnss_gps_cheb(pony_gnss_gps *gps, const double t, double *pr);	// GPS satellites from orbit cache, see pony_gnss_gps_kepler
+int  pony_gnss_glo_cheb(pony_gnss_glo *glo, const double t, double *pr);	// GLONASS satellites from orbit cache, see pony_gnss_glo_orbit
+int  pony_gnss_gal_cheb(pony_gnss_gal *gal, const double t, double *pr);	// Galileo satellites from orbit cache, see pony_gnss_gal_kepler
+int  pony_gnss_bds_cheb(pony_gnss_bds *bds, const double t, double *pr);	// BeiDou satellites from orbit cache, see pony_gnss_bds_kepler
+
+
+
+
+
+
+
+// RINEX input routines
+char pony_rinex_obs_open (pony_rinex_obs *rnx, pony_gnss *gnss, const char *file_name);	// open RINEX 2/3 observation file and parse its header, setting up constellation observation types and observables, output: OK/not OK (1/0)
+char pony_rinex_obs_read (pony_rinex_obs *rnx);	// parse the next observation epoch into gnss epoch and satellite observables with validity flags, output: epoch read/end of file or error (1/0)
+void pony_rinex_obs_close(pony_rinex_obs *rnx);	// release file and memory allocated by the reader, detach observation types it has set
+char pony_rinex_nav_open (pony_rinex_nav *nav, const char *file_name, const char *cache_name);	// load RINEX 2/3 navigation file from binary cache if valid, parse it and save the cache otherwise, cache_name may be NULL, output: OK/not OK (1/0)
+int  pony_rinex_nav_select(pony_rinex_nav *nav, pony_gnss *gnss, pony_time_epoch epoch);	// set ephemeris nearest to epoch for each satellite, ionospheric model, clock corrections and leap seconds, output: number of satellites with ephemeris set
+void pony_rinex_nav_close (pony_rinex_nav *nav);	// release navigation data
+
+
+
+
+
+
+
+// bus input journal
+char pony_journal_open		 (pony_journal *jrn, const char *file_name);	// start recording bus inputs to a journal file, with writer thread if built with PONY_THREADS, output: OK/not OK (1/0)
+char pony_journal_record	 (pony_journal *jrn);	// record bus inputs written by host, to be called before each pony_step, output: OK/not OK (1/0)
+char pony_journal_replay_open(pony_journal *jrn, const char *file_name);	// open a journal file for replay, output: OK/not OK (1/0)
+char pony_journal_read		 (pony_journal *jrn);	// restore bus inputs of the next recorded step, to be followed by pony_step, output: step restored/end of journal or error (1/0)
+void pony_journal_close		 (pony_journal *jrn);	// finish recording or replay, release journal resources
+long pony_journal_replay	 (const char *file_name);	// replay a journal through pony_step at full speed on a bus initialized as recorded, output: number of steps replayed, -1 if not opened
+
+// batch post-processing driver
+long pony_batch_run(const char **file_names, const int file_count, const int readers, const int ahead, void (*output)(const pony_batch_sol *sol, void *arg), void *arg, pony_batch_stats *stats);	// run journals in sequence through pony_step, decoded ahead by reader threads and solutions drained by a writer thread if built with PONY_THREADS, output: number of steps run, -1 on a journal error
+
+
+
+
+
+
+// time routines
+int pony_time_days_between_dates(pony_time_epoch epoch_from, pony_time_epoch epoch_to);	// days elapsed from one date to another, based on Rata Die serial date from day one on 0001/01/01 
+long pony_time_rata_die(const int Y, const int M, const int D);	// Rata Die serial date, day one on 0001/01/01
+	// continuous time of gnss->epoch, refreshed by each of the routines below when the epoch or leap seconds change
+char pony_time_update (pony_gnss *gnss);	// refresh gnss->time from gnss->epoch in gnss->time.scale, leap seconds and clock corrections, output: valid/not (1/0)
+char pony_time_sow    (pony_gnss *gnss, const int scale, double *sow, int *week);	// seconds of week and week number: GPS for GPS, GLONASS and UTC, Galileo for Galileo, BeiDou for BeiDou time, output: OK/not OK (1/0)
+char pony_time_day    (pony_gnss *gnss, const int scale, long *day, double *sec);	// days since GPS time origin and seconds of the day in a time scale, output: OK/not OK (1/0)
+char pony_time_glo_day(pony_gnss *gnss, int *N4, int *NT, double *tod);	// GLONASS four-year interval number from 1996, day number in it and Moscow time of day, output: OK/not OK (1/0)
+char pony_time_calendar(pony_time_epoch *epoch, pony_gnss *gnss, const int scale);	// calendar epoch in a time scale, output: OK/not OK (1/0)
+char pony_time_convert(pony_gnss *gnss, double *t, const int from, const int to);	// time in seconds near the current epoch from one scale to another, output: OK/not OK (1/0)
+
+
+
+
+
+
+
+// linear algebra functions
+	// conventional operations
+double pony_linal_dot(double *u, double *v, const int m); // dot product
+double pony_linal_vnorm(double *u, const int m); // l2 vector norm, i.e. sqrt(u^T*u)
+void pony_linal_cross3x1(double *res, double *u, double *v); // cross product for 3x1 vectors res = u x v
+void pony_linal_mmul  (double *res,  double *a, double *b, const int n, const int n1, const int m); // matrix multiplication res = a*b, a is n x n1, b is n1 x m, res is n x m
+void pony_linal_mmul2T(double *res,  double *a, double *b, const int n, const int m, const int n1); // matrix multiplication with the second argument transposed res = a*b^T, a is n x m, b is n1 x m, res is n x n1
+void pony_linal_qmul(double *res, double *q, double *r); // quaternion multiplication for 4x1 quaternions res = q x r, with res0, q0, r0 being scalar parts
+
+	// fixed-size operations, unrolled, overwriting input allowed
+void pony_linal_m3mul   (double *res, double *a, double *b); // 3x3 matrix multiplication res = a*b
+void pony_linal_m3mul1T (double *res, double *a, double *b); // 3x3 matrix multiplication with the first argument transposed res = a^T*b
+void pony_linal_m3mul2T (double *res, double *a, double *b); // 3x3 matrix multiplication with the second argument transposed res = a*b^T
+void pony_linal_m3mul_v (double *res, double *a, double *v); // 3x3 matrix by 3x1 vector multiplication res = a*v
+void pony_linal_m3Tmul_v(double *res, double *a, double *v); // transposed 3x3 matrix by 3x1 vector multiplication res = a^T*v
+void pony_linal_qsandwich(double *res, double *q, double *r); // quaternion sandwich product for 4x1 quaternions res = q x r x q^-1, q being unit quaternion
+void pony_linal_qrot    (double *res, double *q, double *v); // 3x1 vector rotation by unit quaternion res = q x (0,v) x q^-1
+void pony_linal_quat2mat(double *a, double *q); // unit quaternion to 3x3 rotation matrix, so that a*v = q x (0,v) x q^-1
+
+	// batched operations on n 3x1 vectors stored as structure of arrays, i.e. 3 x n matrix: x[0..n-1], y[0..n-1], z[0..n-1], overwriting input allowed
+void pony_linal_m3mul_v_soa (double *res, double *a, double *v, const int n); // rotation by 3x3 matrix res = a*v
+void pony_linal_m3Tmul_v_soa(double *res, double *a, double *v, const int n); // rotation by transposed 3x3 matrix res = a^T*v
+void pony_linal_qrot_soa    (double *res, double *q, double *v, const int n); // rotation by unit quaternion res = q x (0,v) x q^-1
+
+	// space rotation representation
+/*void pony_linal_mat2quat(double *q, double *R); // 3x3 attitude matrix R to quaternion q with q0 being scalar part*/
+
+	// routines for m x m upper-triangular matrices U lined up in a single-dimension array u
+		// index conversion
+void pony_linal_u_ij2k(int *k,  const int i, const int j, const int m);	// upper-triangular matrix lined up in a single-dimension array index conversion: (i,j) -> k
+void pony_linal_u_k2ij(int *i,  int *j, const int k, const int m);		// upper-triangular matrix lined up in a single-dimension array index conversion: k -> (i,j)
+		// conventional matrix operations
+void pony_linal_u_mul(double *res,  double *u, double *v, const int n, const int m);	// upper-triangular matrix lined up in a single-dimension array multiplication: res = U*v
+void pony_linal_uT_mul_v(double *res,  double *u, double *v, const int m);	// upper-triangular matrix lined up in a single-dimension array transposed multiplication by vector: res = U^T*v
+void pony_linal_u_inv(double *res,  double *u, const int m); // inversion of upper-triangular matrix lined up in a single-dimension array: res = U^-1
+void pony_linal_uuT(double *res,  double *u, const int m); // square (with transposition) of upper-triangular matrix lined up in a single-dimension array: res = U U^T
+	
+		// vector kernels, not used unless selected, results differing from the scalar routines in rounding and between processors
+#define pony_linal_simd_min 32	// shortest vectors and smallest matrices to use vector kernels for, scalar loops being faster below
+int pony_linal_simd(const int max_level); // select vector kernels for the routines above, Cholesky factorization and Kalman prediction: 0 - scalar (default), 1 - SSE2, 2 - AVX2, 3 - AVX-512, -1 - the best available up to AVX2, output: level selected
+	
+	// matrix factorizations
+void pony_linal_chol(double *S,  double *P, const int m); // Cholesky upper-triangular factorization P = S*S^T, where P is symmetric positive-definite matrix
+
+	// square root Kalman filtering
+double pony_linal_kalman_update(double *x, double *S, double *K,  double z, double *h, double sigma, const int m);
+void pony_linal_kalman_update_batch(double *x, double *S, double *K, double *res,  double *z, double *H, double *sigma, double *work, const int n, const int m);	// batch of n measurements with uncorrelated errors, K is n x m, work is m(m+1)/2 x 1, or NULL for sequential updates
+void pony_linal_kalman_predict(double *x, double *S,  double *F, double *q, double *work, const int m);	// time update with process noise standard deviations q, x may be NULL, work is 2m^2 x 1
+
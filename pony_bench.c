@@ -0,0 +1,738 @@
+// PONY microbenchmarks for linear algebra routines, plugin dispatch, Keplerian orbits and strapdown navigation
+//
+// build together with the core, e.g.:
+//		cc -O2 -std=c99 pony_bench.c pony.c -lm -o pony_bench
+//		(add -DPONY_THREADS -lpthread to run the core with its worker thread pool)
+// usage:
+//		pony_bench [-q] [-s max_simd_level] [-b baseline.tsv] [-t tolerance] > results.tsv
+//			-q - quick run: shorter timing, state sizes up to 50
+//			-s - maximum vector kernel level for linear algebra (see pony_linal_simd), the best available up to AVX2 by default, 3 for AVX-512
+//			-b - baseline results of a previous run to compare against, exit code 1 if any benchmark is slower by more than tolerance
+//			-t - relative tolerance for baseline comparison, 0.1 by default
+// output, tab-separated, lines starting with # being comments:
+//		name		- benchmark: routine/vector kernel level, step/schedule pattern, kepler/scalar loop or batch, or strapdown/rates or preint updates
+//		size		- state vector size m, number of plugins, number of satellites, or imu sample rate, Hz
+//		ns_op		- nanoseconds per operation: routine call, plugin dispatch, satellite, or imu sample
+//		gflops		- nominal floating point operations per second, 10^9, zero for dispatch, orbits and strapdown
+//		cycles_op	- time stamp counter cycles per operation, -1 if not available
+//		base_ns, ratio - baseline nanoseconds per operation and current-to-baseline ratio, if baseline given
+
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+#define _POSIX_C_SOURCE 200112L	// monotonic clock
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))	// time stamp counter, as in the core
+#define PONY_RDTSC
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define PONY_RDTSC
+#endif
+
+#include "pony.h"
+
+	// core plugin timing instrumentation, not in the public header
+double pony_stats_reference(void);				// reference clock, s
+unsigned long long pony_stats_counter(void);	// time stamp counter where available, reference clock ticks otherwise
+
+#define pony_bench_max_results 512		// results per run
+#define pony_bench_name_length 32		// benchmark name length, including terminating null
+
+typedef struct			// benchmark result
+{
+	char name[pony_bench_name_length];	// routine/level, or step/pattern
+	int size;			// state vector size, or number of plugins
+	double ns;			// nanoseconds per operation
+	double gflops;		// nominal 10^9 floating point operations per second
+	double cycles;		// time stamp counter cycles per operation, -1 if not available
+} pony_bench_result;
+
+typedef struct			// benchmark run
+{
+	double min_time;	// time to spend on each benchmark, s
+	int max_size;		// maximum state vector size
+	pony_bench_result res[pony_bench_max_results];
+	int count;			// number of results
+	double checksum;	// sum of outputs, printed to keep them computed
+} pony_bench_run;
+
+typedef struct			// linear algebra operands
+{
+	int m;				// state vector size
+	int n;				// number of measurements for batch update
+	double *P, *S, *S0, *U, *x, *K, *h, *H, *z, *sigma, *res, *work;
+} pony_bench_linal;
+
+unsigned long pony_bench_calls = 0;	// plugin calls
+
+	// copy string into fixed-size name
+void pony_bench_name(char *name, const char *a, const char *b)
+{
+	int i = 0, j;
+
+	for (j = 0; a[j] && i < pony_bench_name_length-1; j++)
+		name[i++] = a[j];
+	for (j = 0; b != NULL && b[j] && i < pony_bench_name_length-1; j++)
+		name[i++] = b[j];
+	name[i] = '\0';
+}
+
+	// compare names
+char pony_bench_same(const char *a, const char *b)
+{
+	int i;
+
+	for (i = 0; a[i] && a[i] == b[i]; i++);
+	return a[i] == b[i];
+}
+
+	// store a result
+void pony_bench_store(pony_bench_run *run, const char *name, const char *variant, const int size, const double seconds, const double counts, const double ops, const double flops)
+{
+	pony_bench_result *r;
+
+	if (run->count >= pony_bench_max_results || ops <= 0)
+		return;
+	r = run->res + run->count++;
+	pony_bench_name(r->name, name, variant);
+	r->size = size;
+	r->ns = seconds/ops*1e9;
+	r->gflops = (seconds > 0) ? flops*ops/seconds*1e-9 : 0;
+#ifdef PONY_RDTSC
+	r->cycles = counts/ops;
+#else
+	(void)counts;
+	r->cycles = -1;
+#endif
+}
+
+
+
+// linear algebra routines
+	// allocate operands for state vector size m and n measurements, with covariance matrix well-conditioned
+char pony_bench_linal_alloc(pony_bench_linal *a, const int m, const int n)
+{
+	int i, j, k, l, mm = m*(m+1)/2;
+	double s;
+
+	a->m = m;
+	a->n = n;
+	a->P		= (double *)calloc(mm, sizeof(double));
+	a->S		= (double *)calloc(mm, sizeof(double));
+	a->S0		= (double *)calloc(mm, sizeof(double));
+	a->U		= (double *)calloc(mm, sizeof(double));
+	a->work		= (double *)calloc(mm, sizeof(double));
+	a->x		= (double *)calloc(m, sizeof(double));
+	a->K		= (double *)calloc((size_t)n*m, sizeof(double));
+	a->h		= (double *)calloc(m, sizeof(double));
+	a->H		= (double *)calloc((size_t)n*m, sizeof(double));
+	a->z		= (double *)calloc(n, sizeof(double));
+	a->sigma	= (double *)calloc(n, sizeof(double));
+	a->res		= (double *)calloc(n, sizeof(double));
+	if (a->P == NULL || a->S == NULL || a->S0 == NULL || a->U == NULL || a->work == NULL || a->x == NULL || a->K == NULL
+		|| a->h == NULL || a->H == NULL || a->z == NULL || a->sigma == NULL || a->res == NULL)
+		return 0;
+
+	// P = A*A^T + m*I with A(i,j) = cos(i + 2j), upper-triangular part
+	for (i = 0, k = 0; i < m; i++)
+		for (j = i; j < m; j++, k++) {
+			for (l = 0, s = 0; l < m; l++)
+				s += cos(i + 2.0*l)*cos(j + 2.0*l);
+			a->P[k] = s + ((i == j) ? m : 0);
+		}
+	pony_linal_chol(a->S0, a->P, m);
+	for (k = 0; k < mm; k++)
+		a->S[k] = a->S0[k];
+	for (i = 0; i < m; i++) {
+		a->x[i] = sin(i + 1.0);
+		a->h[i] = cos(3.0*i);
+	}
+	for (i = 0; i < n*m; i++)
+		a->H[i] = cos(0.7*i);
+	for (i = 0; i < n; i++) {
+		a->z[i] = sin(0.3*i);
+		a->sigma[i] = 1 + 0.1*i;
+	}
+	return 1;
+}
+
+void pony_bench_linal_free(pony_bench_linal *a)
+{
+	free(a->P);		free(a->S);	free(a->S0);	free(a->U);		free(a->work);	free(a->x);
+	free(a->K);		free(a->h);	free(a->H);		free(a->z);		free(a->sigma);	free(a->res);
+}
+
+	// run a routine reps times
+	//		op - 0: Cholesky factorization, 1: upper-triangular inversion, 2: scalar Kalman update, 3: batch Kalman update
+double pony_bench_linal_op(pony_bench_linal *a, const int op, const long reps)
+{
+	double s = 0;
+	long r;
+
+	switch (op) {
+		case 0:
+			for (r = 0; r < reps; r++) {
+				pony_linal_chol(a->U, a->P, a->m);
+				s += a->U[0];
+			}
+			break;
+		case 1:
+			for (r = 0; r < reps; r++) {
+				pony_linal_u_inv(a->U, a->S0, a->m);
+				s += a->U[0];
+			}
+			break;
+		case 2:	// covariance shrinks slowly under repeated updates, no need to restore it
+			for (r = 0; r < reps; r++)
+				s += pony_linal_kalman_update(a->x, a->S, a->K, a->z[0], a->h, a->sigma[0], a->m);
+			break;
+		case 3:
+			for (r = 0; r < reps; r++) {
+				pony_linal_kalman_update_batch(a->x, a->S, a->K, a->res, a->z, a->H, a->sigma, a->work, a->n, a->m);
+				s += a->res[0];
+			}
+			break;
+	}
+	return s;
+}
+
+	// nominal floating point operations of a routine
+double pony_bench_linal_flops(const int op, const int m, const int n)
+{
+	double dm = m;
+
+	switch (op) {
+		case 0:		return dm*dm*dm/3;		// Cholesky factorization
+		case 1:		return dm*dm*dm/3;		// triangular inversion
+		case 2:		return 4*dm*dm + 6*dm;	// scalar update: S^T*h, S and gain
+		default:	return n*(4*dm*dm + 6*dm);
+	}
+}
+
+	// time a routine: repetitions doubled until a tenth of the time is spent, then the best of three trials
+void pony_bench_linal_time(pony_bench_run *run, pony_bench_linal *a, const int op, const char *name, const char *variant)
+{
+	double t0, t, best_t = -1, best_c = 0;
+	unsigned long long c0, c;
+	long reps;
+	int trial;
+
+	for (reps = 1; ; reps *= 2) {
+		t0 = pony_stats_reference();
+		run->checksum += pony_bench_linal_op(a, op, reps);
+		if (pony_stats_reference() - t0 >= run->min_time/10 || reps > (1L << 30))
+			break;
+	}
+	reps = (reps*10)/3 + 1;
+	for (trial = 0; trial < 3; trial++) {
+		t0 = pony_stats_reference();
+		c0 = pony_stats_counter();
+		run->checksum += pony_bench_linal_op(a, op, reps);
+		c = pony_stats_counter() - c0;
+		t = pony_stats_reference() - t0;
+		if (best_t < 0 || t < best_t) {
+			best_t = t;
+			best_c = (double)c;
+		}
+	}
+	pony_bench_store(run, name, variant, a->m, best_t, best_c, (double)reps, pony_bench_linal_flops(op, a->m, a->n));
+}
+
+	// sweep state vector sizes for each routine at scalar and the best vector kernel level
+void pony_bench_linal_sweep(pony_bench_run *run, const int max_level)
+{
+	const int sizes[] = {3, 4, 6, 8, 10, 15, 20, 30, 50, 75, 100, 150, 200}, size_count = sizeof(sizes)/sizeof(sizes[0]), batch = 8;
+	const char *names[] = {"chol", "u_inv", "kalman_update", "kalman_update_batch8"};
+
+	pony_bench_linal a;
+	char variant[4];
+	int i, op, level, best, levels[2], level_count;
+
+	best = pony_linal_simd(max_level);
+	levels[0] = 0;
+	levels[1] = best;
+	level_count = (best > 0) ? 2 : 1;
+	for (i = 0; i < size_count && sizes[i] <= run->max_size; i++) {
+		if (!pony_bench_linal_alloc(&a, sizes[i], batch)) {
+			pony_bench_linal_free(&a);
+			fprintf(stderr, "# out of memory at m = %d\n", sizes[i]);
+			return;
+		}
+		for (level = 0; level < level_count; level++) {
+			pony_linal_simd(levels[level]);
+			variant[0] = '/';
+			variant[1] = (char)('0' + levels[level]);
+			variant[2] = '\0';
+			for (op = 0; op < 4; op++)
+				pony_bench_linal_time(run, &a, op, names[op], variant);
+		}
+		pony_bench_linal_free(&a);
+	}
+	pony_linal_simd(max_level);
+}
+
+
+
+// plugin dispatch
+	// trivial plugin
+void pony_bench_plugin(void)
+{
+	pony_bench_calls++;
+}
+
+	// time pony_bus_step with plugin_count instances of a trivial plugin
+	//		pattern - 0: every step, 1: staggered over 10 steps (cycle 10, shifts 0..9), 2: half every step, half once in 100 steps
+void pony_bench_step_time(pony_bench_run *run, const int plugin_count, const int pattern, const char *name)
+{
+	pony_struct bus;
+	double t0, t;
+	unsigned long long c0, c;
+	unsigned long calls;
+	long steps, s;
+	int i;
+	char ok = 1;
+
+	pony_bus_setup(&bus);
+	for (i = 0; i < plugin_count && ok; i++)
+		switch (pattern) {
+			case 0:		ok = pony_bus_add_plugin(&bus, pony_bench_plugin);						break;
+			case 1:		ok = pony_bus_schedule_plugin(&bus, pony_bench_plugin, 10, i%10);		break;
+			default:	ok = (i%2 == 0) ? pony_bus_add_plugin(&bus, pony_bench_plugin) : pony_bus_schedule_plugin(&bus, pony_bench_plugin, 100, i%100);
+		}
+	if (!ok || !pony_bus_init(&bus, "")) {
+		fprintf(stderr, "# bus setup failed for %s with %d plugins\n", name, plugin_count);
+		pony_bus_terminate(&bus);
+		return;
+	}
+
+	// warm-up, then steps to last about the time given
+	for (steps = 100; ; steps *= 2) {
+		t0 = pony_stats_reference();
+		for (s = 0; s < steps; s++)
+			pony_bus_step(&bus);
+		if (pony_stats_reference() - t0 >= run->min_time/10 || steps > (1L << 30))
+			break;
+	}
+	steps = (steps*10)/3 + 1;
+	calls = pony_bench_calls;
+	t0 = pony_stats_reference();
+	c0 = pony_stats_counter();
+	for (s = 0; s < steps; s++)
+		pony_bus_step(&bus);
+	c = pony_stats_counter() - c0;
+	t = pony_stats_reference() - t0;
+	calls = pony_bench_calls - calls;
+	pony_bus_terminate(&bus);
+
+	// per dispatch, or per step without plugins
+	pony_bench_store(run, name, NULL, plugin_count, t, (double)c, (double)((plugin_count > 0) ? calls : (unsigned long)steps), 0);
+}
+
+	// sweep plugin counts for each schedule pattern
+void pony_bench_step_sweep(pony_bench_run *run)
+{
+	const int counts[] = {1, 4, 16, 64, 256}, count_count = sizeof(counts)/sizeof(counts[0]);
+	const char *names[] = {"step/every", "step/staggered10", "step/mixed100"};
+
+	int i, pattern;
+
+	pony_bench_step_time(run, 0, 0, "step/empty");
+	for (pattern = 0; pattern < 3; pattern++)
+		for (i = 0; i < count_count; i++)
+			pony_bench_step_time(run, counts[i], pattern, names[pattern]);
+}
+
+
+
+// Keplerian orbits
+	// satellite position, velocity, emission time and clock offset for a single satellite, textbook scalar algorithm as in GPS interface specs,
+	// Kepler equation iterated to convergence, for comparison with batched pony_gnss_kepler
+	// input:
+	//		eph - ephemeris as in RINEX navigation files, see pony_gnss_sat.eph
+	//		t - time of signal reception, seconds of week
+	//		pr - pseudorange, m
+	//		gc - GPS constants, c - speed of light
+	// output:
+	//		sat - coordinates, velocity, emission time and clock offset
+void pony_bench_kepler_sat(pony_gnss_sat *sat, double *eph, const double t, const double pr, const pony_gps_const *gc, const double c)
+{
+	const double half_week = 302400, week = 604800;
+
+	double A, n, tau, tsv, tc, dts, tk, M, E, E0, sinE, cosE, Edot, dtr, sq, nu, nudot, Phi, sin2, cos2,
+		uk, rk, ik, Wk, udot, rdot, idk, Wkdot, xp, yp, xpdot, ypdot, x, y, z, vx, vy, vz, b;
+	int k;
+
+	A = eph[16]*eph[16];
+	n = sqrt(gc->mu/(A*A*A)) + eph[11];
+	tau = pr/c;
+	tsv = t - tau;
+	tc = tsv - pony_gnss_eph_sow(eph);
+	if (tc > half_week)
+		tc -= week;
+	else if (tc < -half_week)
+		tc += week;
+	dts = eph[6] + eph[7]*tc + eph[8]*tc*tc;
+	tk = tsv - dts - eph[17];
+	if (tk > half_week)
+		tk -= week;
+	else if (tk < -half_week)
+		tk += week;
+
+	// Kepler equation
+	M = eph[12] + n*tk;
+	E = M;
+	for (k = 0; k < 20; k++) {
+		E0 = E;
+		E = M + eph[14]*sin(E0);
+		if (fabs(E - E0) < 1e-13)
+			break;
+	}
+	sinE = sin(E);
+	cosE = cos(E);
+
+	// relativistic correction and emission time
+	dtr = gc->F*eph[14]*eph[16]*sinE;
+	dts += dtr;
+	tsv -= dts;
+
+	// argument of latitude, radius, inclination with harmonic corrections
+	Edot = n/(1 - eph[14]*cosE);
+	sq = sqrt(1 - eph[14]*eph[14]);
+	nu = atan2(sq*sinE, cosE - eph[14]);
+	nudot = Edot*sq/(1 - eph[14]*cosE);
+	Phi = nu + eph[23];
+	sin2 = sin(2*Phi);
+	cos2 = cos(2*Phi);
+	uk = Phi + eph[15]*sin2 + eph[13]*cos2;
+	rk = A*(1 - eph[14]*cosE) + eph[10]*sin2 + eph[22]*cos2;
+	ik = eph[21] + eph[20]*sin2 + eph[18]*cos2 + eph[25]*tk;
+	udot = nudot*(1 + 2*(eph[15]*cos2 - eph[13]*sin2));
+	rdot = A*eph[14]*Edot*sinE + 2*nudot*(eph[10]*cos2 - eph[22]*sin2);
+	idk = eph[25] + 2*nudot*(eph[20]*cos2 - eph[18]*sin2);
+	Wkdot = eph[24] - gc->u;
+	Wk = eph[19] + Wkdot*tk - gc->u*eph[17];
+
+	// coordinates and velocity, Earth-fixed at emission time
+	xp = rk*cos(uk);
+	yp = rk*sin(uk);
+	xpdot = rdot*cos(uk) - yp*udot;
+	ypdot = rdot*sin(uk) + xp*udot;
+	x = xp*cos(Wk) - yp*cos(ik)*sin(Wk);
+	y = xp*sin(Wk) + yp*cos(ik)*cos(Wk);
+	z = yp*sin(ik);
+	vx = xpdot*cos(Wk) - ypdot*cos(ik)*sin(Wk) + yp*sin(ik)*idk*sin(Wk) - y*Wkdot;
+	vy = xpdot*sin(Wk) + ypdot*cos(ik)*cos(Wk) - yp*sin(ik)*idk*cos(Wk) + x*Wkdot;
+	vz = ypdot*sin(ik) + yp*cos(ik)*idk;
+
+	// Earth rotation during signal propagation
+	b = gc->u*tau;
+	sat->x[0] =  cos(b)*x  + sin(b)*y;
+	sat->x[1] = -sin(b)*x  + cos(b)*y;
+	sat->x[2] = z;
+	sat->v[0] =  cos(b)*vx + sin(b)*vy;
+	sat->v[1] = -sin(b)*vx + cos(b)*vy;
+	sat->v[2] = vz;
+	sat->t_em = tsv;
+	sat->Deltatsv = dts;
+	sat->x_valid = sat->v_valid = sat->t_em_valid = 1;
+}
+
+	// run the scalar loop over satellites (batch = 0) or the batched routine (batch = 1) reps times
+double pony_bench_kepler_op(pony_gnss_sat *sat, pony_gnss_sat_soa *soa, double *pr, const pony_gnss_const *gnss_const, const int batch, const long reps)
+{
+	const double t = 181800;
+
+	double s = 0;
+	long r;
+	int i;
+
+	for (r = 0; r < reps; r++) {
+		if (batch)
+			pony_gnss_kepler(sat, soa, t, pr, gnss_const->gps.mu, gnss_const->gps.u, gnss_const->gps.F, gnss_const->c, 0);
+		else
+			for (i = 0; i < soa->count; i++)
+				pony_bench_kepler_sat(sat + i, sat[i].eph, t, pr[i], &(gnss_const->gps), gnss_const->c);
+		s += sat[0].x[0];
+	}
+	return s;
+}
+
+	// time the scalar loop or the batched routine for sat_count satellites of a synthetic GPS-like constellation, per satellite
+void pony_bench_kepler_time(pony_bench_run *run, const pony_gnss_const *gnss_const, const int sat_count, const int batch)
+{
+	pony_gnss_sat *sat;
+	pony_gnss_sat_soa soa;
+	double *eph, *x, *pr, t0, t, best_t = -1, best_c = 0;
+	unsigned long long c0, c;
+	unsigned int *flags;
+	long reps;
+	int i, j, words = (sat_count + 31)/32, trial;
+
+	sat		= (pony_gnss_sat *)calloc(sat_count, sizeof(pony_gnss_sat));
+	eph		= (double *)calloc((size_t)26*sat_count, sizeof(double));
+	x		= (double *)calloc((size_t)9*sat_count, sizeof(double));
+	pr		= (double *)calloc(sat_count, sizeof(double));
+	flags	= (unsigned int *)calloc((size_t)5*words, sizeof(unsigned int));
+	if (sat == NULL || eph == NULL || x == NULL || pr == NULL || flags == NULL) {
+		fprintf(stderr, "# out of memory for %d satellites\n", sat_count);
+		free(sat); free(eph); free(x); free(pr); free(flags);
+		return;
+	}
+
+	// six orbital planes, satellites spread along each, toc 2020/06/09 02:00:00
+	for (i = 0; i < sat_count; i++) {
+		sat[i].eph = eph + 26*i;
+		sat[i].eph_valid = 1;
+		sat[i].eph[0] = 2020; sat[i].eph[1] = 6; sat[i].eph[2] = 9; sat[i].eph[3] = 2;
+		sat[i].eph[6] = -1.5e-4 + 1e-5*i;	sat[i].eph[7] = -6e-12;
+		sat[i].eph[10] = 50;		sat[i].eph[11] = 4.6e-9;	sat[i].eph[12] = -3 + 0.37*i;
+		sat[i].eph[13] = -2.1e-6;	sat[i].eph[14] = 0.001 + 0.0005*(i%20);	sat[i].eph[15] = 7.8e-6;	sat[i].eph[16] = 5153.65;
+		sat[i].eph[17] = 180000;	sat[i].eph[18] = 1.1e-7;	sat[i].eph[19] = -3 + (i%6);	sat[i].eph[20] = -9.3e-8;
+		sat[i].eph[21] = 0.96;		sat[i].eph[22] = 240.3;		sat[i].eph[23] = 0.7 - 0.1*(i%7);	sat[i].eph[24] = -8.1e-9;
+		sat[i].eph[25] = 3.2e-10;
+		pr[i] = 2.0e7 + 1e5*i;
+	}
+	soa.count = sat_count;
+	soa.x = x; soa.y = x+sat_count; soa.z = x+2*sat_count;
+	soa.vx = x+3*sat_count; soa.vy = x+4*sat_count; soa.vz = x+5*sat_count;
+	soa.sinEl = x+6*sat_count; soa.t_em = x+7*sat_count; soa.Deltatsv = x+8*sat_count;
+	soa.eph_valid = flags; soa.x_valid = flags+words; soa.v_valid = flags+2*words; soa.t_em_valid = flags+3*words; soa.sinEl_valid = flags+4*words;
+	for (j = 0; j < sat_count; j++)
+		soa.eph_valid[j/32] |= 1u << (j%32);
+
+	// repetitions doubled until a tenth of the time is spent, then the best of three trials
+	for (reps = 1; ; reps *= 2) {
+		t0 = pony_stats_reference();
+		run->checksum += pony_bench_kepler_op(sat, &soa, pr, gnss_const, batch, reps);
+		if (pony_stats_reference() - t0 >= run->min_time/10 || reps > (1L << 30))
+			break;
+	}
+	reps = (reps*10)/3 + 1;
+	for (trial = 0; trial < 3; trial++) {
+		t0 = pony_stats_reference();
+		c0 = pony_stats_counter();
+		run->checksum += pony_bench_kepler_op(sat, &soa, pr, gnss_const, batch, reps);
+		c = pony_stats_counter() - c0;
+		t = pony_stats_reference() - t0;
+		if (best_t < 0 || t < best_t) {
+			best_t = t;
+			best_c = (double)c;
+		}
+	}
+	pony_bench_store(run, "kepler", batch ? "/batch" : "/scalar", sat_count, best_t, best_c, (double)reps*sat_count, 0);
+
+	free(sat); free(eph); free(x); free(pr); free(flags);
+}
+
+	// sweep satellite counts for the scalar loop and the batched routine
+void pony_bench_kepler_sweep(pony_bench_run *run)
+{
+	const int counts[] = {8, 16, 32, 64}, count_count = sizeof(counts)/sizeof(counts[0]);
+
+	pony_struct bus;
+	int i, batch;
+
+	pony_bus_setup(&bus);
+	if (!pony_bus_init(&bus, "")) {
+		fprintf(stderr, "# bus setup failed for kepler\n");
+		pony_bus_terminate(&bus);
+		return;
+	}
+	for (i = 0; i < count_count; i++)
+		for (batch = 0; batch < 2; batch++)
+			pony_bench_kepler_time(run, &(bus.gnss_const), counts[i], batch);
+	pony_bus_terminate(&bus);
+}
+
+
+
+// strapdown navigation
+#define pony_bench_imu_rate 2000	// imu sample rate, Hz
+
+	// run reps imu samples of a vehicle circling at 20 m/s from a fixed start, strapdown updated by each sample, or by increments pre-integrated over intervals if configured
+double pony_bench_strapdown_op(pony_imu *imu, const pony_imu_const *imu_const, const long reps)
+{
+	const double lat = 0.973, height = 150, speed = 20, turn = 0.1;
+
+	pony_imu_strapdown sd;
+	pony_sol *sol = &(imu->sol);
+	double s;
+	long r;
+	int i;
+
+	imu->t = 0;
+	sol->llh[0] = 0.656;
+	sol->llh[1] = lat;
+	sol->llh[2] = height;
+	sol->v[0] = 0;
+	sol->v[1] = speed;
+	sol->v[2] = 0;
+	for (i = 0; i < 3; i++)
+		sol->rpy[i] = 0;
+	sol->llh_valid = sol->v_valid = sol->rpy_valid = 1;
+	sol->q_valid = 0;
+	if (imu->preint != NULL)
+		pony_imu_preint_reset(imu->preint);
+	if (!pony_imu_strapdown_init(&sd, imu, imu_const))
+		return 0;
+
+	// turning left at a constant rate: centripetal acceleration to the left, normal gravity of the start point
+	s = sin(lat);
+	imu->w[0] = 0;
+	imu->w[1] = 0;
+	imu->w[2] = turn;
+	imu->f[0] = -speed*turn;
+	imu->f[1] = 0;
+	imu->f[2] = imu_const->ge*(1 + imu_const->fg*s*s)*(1 - 2*height/imu_const->a);
+	imu->w_valid = 1;
+	imu->f_valid = 1;
+	for (r = 1; r <= reps; r++) {
+		imu->t = (double)r/pony_bench_imu_rate;
+		if (imu->preint != NULL)
+			pony_imu_preint_step(imu);
+		pony_imu_strapdown_step(&sd, imu, imu_const);
+	}
+	return sol->llh[1] + sol->v[0];
+}
+
+	// time strapdown updates per imu sample at 2 kHz
+void pony_bench_strapdown_time(pony_bench_run *run, char *cfg, const char *variant)
+{
+	pony_struct bus;
+	double t0, t, best_t = -1, best_c = 0;
+	unsigned long long c0, c;
+	long reps;
+	int trial;
+
+	pony_bus_setup(&bus);
+	if (!pony_bus_init(&bus, cfg) || bus.imu == NULL) {
+		fprintf(stderr, "# bus setup failed for strapdown%s\n", variant);
+		pony_bus_terminate(&bus);
+		return;
+	}
+
+	// samples doubled until a tenth of the time is spent, then the best of three trials
+	for (reps = 100; ; reps *= 2) {
+		t0 = pony_stats_reference();
+		run->checksum += pony_bench_strapdown_op(bus.imu, &(bus.imu_const), reps);
+		if (pony_stats_reference() - t0 >= run->min_time/10 || reps > (1L << 30))
+			break;
+	}
+	reps = (reps*10)/3 + 1;
+	for (trial = 0; trial < 3; trial++) {
+		t0 = pony_stats_reference();
+		c0 = pony_stats_counter();
+		run->checksum += pony_bench_strapdown_op(bus.imu, &(bus.imu_const), reps);
+		c = pony_stats_counter() - c0;
+		t = pony_stats_reference() - t0;
+		if (best_t < 0 || t < best_t) {
+			best_t = t;
+			best_c = (double)c;
+		}
+	}
+	pony_bench_store(run, "strapdown", variant, pony_bench_imu_rate, best_t, best_c, (double)reps, 0);
+	pony_bus_terminate(&bus);
+}
+
+	// strapdown updated by every sample, and by increments pre-integrated to 200 Hz
+void pony_bench_strapdown_sweep(pony_bench_run *run)
+{
+	char rates[] = "{imu: }", preint[] = "{imu: preint_interval = 0.005}";
+
+	pony_bench_strapdown_time(run, rates, "/rates");
+	pony_bench_strapdown_time(run, preint, "/preint");
+}
+
+
+
+// output and baseline comparison
+	// read baseline results
+int pony_bench_read(pony_bench_result *res, const int max_count, const char *file_name)
+{
+	FILE *fp;
+	char line[256];
+	int count = 0;
+
+	fp = fopen(file_name, "r");
+	if (fp == NULL)
+		return -1;
+	while (count < max_count && fgets(line, sizeof(line), fp) != NULL) {
+		if (line[0] == '#')
+			continue;
+		if (sscanf(line, "%31s %d %lf %lf %lf", res[count].name, &(res[count].size), &(res[count].ns), &(res[count].gflops), &(res[count].cycles)) == 5)
+			count++;
+	}
+	fclose(fp);
+	return count;
+}
+
+	// print results, compared to baseline if given, output: number of benchmarks slower than baseline by more than tolerance
+int pony_bench_print(pony_bench_run *run, pony_bench_result *base, const int base_count, const double tol)
+{
+	pony_bench_result *r;
+	double ratio;
+	int i, j, slower = 0;
+
+	printf("# name\tsize\tns_op\tgflops\tcycles_op%s\n", (base != NULL) ? "\tbase_ns\tratio" : "");
+	for (i = 0; i < run->count; i++) {
+		r = run->res + i;
+		printf("%s\t%d\t%.3f\t%.4f\t%.1f", r->name, r->size, r->ns, r->gflops, r->cycles);
+		for (j = 0; base != NULL && j < base_count; j++)
+			if (base[j].size == r->size && pony_bench_same(base[j].name, r->name))
+				break;
+		if (base != NULL && j < base_count && base[j].ns > 0) {
+			ratio = r->ns/base[j].ns;
+			printf("\t%.3f\t%.3f%s", base[j].ns, ratio, (ratio > 1 + tol) ? "\tslower" : (ratio < 1/(1 + tol)) ? "\tfaster" : "");
+			if (ratio > 1 + tol)
+				slower++;
+		}
+		printf("\n");
+	}
+	return slower;
+}
+
+int main(int argc, char **argv)
+{
+	static pony_bench_run run;
+	static pony_bench_result base[pony_bench_max_results];
+	const char *base_name = NULL;
+	double tol = 0.1;
+	int i, max_level = -1, base_count = 0, slower;
+
+	run.min_time = 0.2;
+	run.max_size = 200;
+	run.count = 0;
+	run.checksum = 0;
+	for (i = 1; i < argc; i++) {
+		if (argv[i][0] == '-' && argv[i][1] == 'q')
+			run.min_time = 0.02, run.max_size = 50;
+		else if (argv[i][0] == '-' && argv[i][1] == 's' && i+1 < argc)
+			max_level = atoi(argv[++i]);
+		else if (argv[i][0] == '-' && argv[i][1] == 'b' && i+1 < argc)
+			base_name = argv[++i];
+		else if (argv[i][0] == '-' && argv[i][1] == 't' && i+1 < argc)
+			tol = atof(argv[++i]);
+		else {
+			fprintf(stderr, "usage: %s [-q] [-s max_simd_level] [-b baseline.tsv] [-t tolerance]\n", argv[0]);
+			return 2;
+		}
+	}
+	if (base_name != NULL && (base_count = pony_bench_read(base, pony_bench_max_results, base_name)) < 0) {
+		fprintf(stderr, "cannot read baseline %s\n", base_name);
+		return 2;
+	}
+
+	pony_bench_linal_sweep(&run, max_level);
+	pony_bench_step_sweep(&run);
+	pony_bench_kepler_sweep(&run);
+	pony_bench_strapdown_sweep(&run);
+
+	printf("# pony_bench: bus version %d, vector kernel level %d, checksum %g\n", pony_bus_version, pony_linal_simd(max_level), run.checksum);
+	slower = pony_bench_print(&run, (base_name != NULL) ? base : NULL, base_count, tol);
+	if (base_name != NULL)
+		fprintf(stderr, "# %d of %d benchmarks slower than baseline by more than %g\n", slower, run.count, tol);
+
+	return (slower > 0) ? 1 : 0;
+}
@@ -0,0 +1,1918 @@
+// PONY core tests
+//
+// build together with the core, e.g.:
+//		cc -O2 -std=c99 pony_test.c pony.c -lm -o pony_test
+//		(add -DPONY_THREADS -lpthread to test the core with its worker thread pool)
+// usage:
+//		pony_test, prints failed checks and the number of checks passed, exit code 1 if any failed
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <math.h>
+#ifdef PONY_THREADS
+#include <pthread.h>
+#endif
+
+#include "pony.h"
+
+int pony_test_checks = 0;	// checks made
+int pony_test_failed = 0;	// checks failed
+
+	// count a check, printing it if failed
+void pony_test_check(const char condition, const char *group, const char *what)
+{
+	pony_test_checks++;
+	if (condition)
+		return;
+	pony_test_failed++;
+	printf("FAIL %s: %s\n", group, what);
+}
+
+
+
+// plugin scheduling
+int pony_test_calls = 0;	// plugin calls in regular operation mode
+
+	// plugin scheduled as suspended, resuming itself at init
+void pony_test_self_resume(void)
+{
+	if (pony->mode == 0)
+		pony->resume_plugin(pony_test_self_resume);
+	else if (pony->mode > 0)
+		pony_test_calls++;
+}
+
+void pony_test_schedule(void)
+{
+	pony_struct bus;
+	int i;
+
+	pony_test_calls = 0;
+	pony_bus_setup(&bus);
+	pony_bus_schedule_plugin(&bus, pony_test_self_resume, -1, 0);
+	pony_bus_init(&bus, "");
+	pony_bus_step(&bus);	// init
+	for (i = 0; i < 10; i++)
+		pony_bus_step(&bus);
+	pony_test_check(pony_test_calls == 10, "schedule", "plugin scheduled suspended and resumed at init runs every step");
+	pony_bus_terminate(&bus);
+	pony_bus_step(&bus);
+}
+
+
+// vector kernels of linear algebra routines against the scalar ones
+#define pony_test_linal_max_m	130		// sizes m = 1..130, across every vector length remainder of all kernel levels
+#define pony_test_linal_tol		1e-12	// tolerance relative to the scalar result magnitude, plus one
+
+	// fill n numbers in [a, b], reproducible
+void pony_test_random(double *x, const int n, const double a, const double b)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		x[i] = a + (b - a)*rand()/RAND_MAX;
+}
+
+	// copy n numbers
+void pony_test_copy(double *y, double *x, const int n)
+{
+	int i;
+
+	for (i = 0; i < n; i++)
+		y[i] = x[i];
+}
+
+	// run the routines with vector kernels selected, out of place and in place, results lined up in res
+	//	input:
+	//		u - upper-triangular m x m, well-conditioned, m(m+1)/2 x 1
+	//		P - symmetric positive-definite m x m, upper-triangular part m(m+1)/2 x 1
+	//		v - m x m, row-major
+	//		x, F, q - state vector m x 1, transition matrix m x m and process noise m x 1 for prediction
+	//		t - m^2 x 1 copy array, work - 2m^2 x 1 work array
+	//	output:
+	//		res - results, 4m^2 + 8m(m+1)/2 + 3m
+	//		number of results
+int pony_test_linal_run(double *res, double *u, double *P, double *v, double *x, double *F, double *q, double *t, double *work, const int m)
+{
+	int n = 0, mu = m*(m+1)/2;
+
+	// U*V, m columns, and U*v, single column
+	pony_linal_u_mul(res+n, u, v, m, m);
+	n += m*m;
+	pony_test_copy(res+n, v, m*m);
+	pony_linal_u_mul(res+n, u, res+n, m, m);
+	n += m*m;
+	pony_linal_u_mul(res+n, u, v, m, 1);
+	n += m;
+	pony_test_copy(res+n, v, m);
+	pony_linal_u_mul(res+n, u, res+n, m, 1);
+	n += m;
+	// U^T*v
+	pony_linal_uT_mul_v(res+n, u, v, m);
+	n += m;
+	// U^-1
+	pony_linal_u_inv(res+n, u, m);
+	n += mu;
+	pony_test_copy(res+n, u, mu);
+	pony_linal_u_inv(res+n, res+n, m);
+	n += mu;
+	// U*U^T
+	pony_linal_uuT(res+n, u, m);
+	n += mu;
+	pony_test_copy(res+n, u, mu);
+	pony_linal_uuT(res+n, res+n, m);
+	n += mu;
+	// Cholesky factor
+	pony_linal_chol(res+n, P, m);
+	n += mu;
+	pony_test_copy(res+n, P, mu);
+	pony_linal_chol(res+n, res+n, m);
+	n += mu;
+	// Kalman prediction, with the state and with the state propagated by the caller
+	pony_test_copy(t, x, m);
+	pony_test_copy(res+n, u, mu);
+	pony_linal_kalman_predict(t, res+n, F, q, work, m);
+	n += mu;
+	pony_test_copy(res+n, t, m);
+	n += m;
+	pony_test_copy(res+n, u, mu);
+	pony_linal_kalman_predict(NULL, res+n, F, q, work, m);
+	n += mu;
+
+	return n;
+}
+
+void pony_test_linal(void)
+{
+	double *u, *P, *v, *x, *F, *q, *t, *work, *ref, *res;
+	int level, m, mu, i, j, k, n, fail;
+	char what[128];
+
+	pony_test_check(pony_linal_simd(-1) <= 2, "linal", "AVX-512 not selected unless asked for explicitly");
+	m = pony_test_linal_max_m;
+	mu = m*(m+1)/2;
+	u    = (double *)malloc(mu*sizeof(double));
+	P    = (double *)malloc(mu*sizeof(double));
+	v    = (double *)malloc(m*m*sizeof(double));
+	x    = (double *)malloc(m*sizeof(double));
+	F    = (double *)malloc(m*m*sizeof(double));
+	q    = (double *)malloc(m*sizeof(double));
+	t    = (double *)malloc(m*m*sizeof(double));
+	work = (double *)malloc(2*m*m*sizeof(double));
+	ref  = (double *)malloc((4*m*m + 8*mu + 3*m)*sizeof(double));
+	res  = (double *)malloc((4*m*m + 8*mu + 3*m)*sizeof(double));
+	if (u == NULL || P == NULL || v == NULL || x == NULL || F == NULL || q == NULL || t == NULL || work == NULL || ref == NULL || res == NULL) {
+		pony_test_check(0, "linal", "memory allocation");
+		free(u); free(P); free(v); free(x); free(F); free(q); free(t); free(work); free(ref); free(res);
+		return;
+	}
+
+	pony_test_check(pony_linal_simd(0) == 0, "linal", "scalar routines selected at level 0");
+	srand(1);
+	for (m = 1; m <= pony_test_linal_max_m; m++) {
+		// unit upper-triangular part plus diagonal in [1, 2], off-diagonal terms within 1/m, so that U and P = U*U^T are well-conditioned
+		mu = m*(m+1)/2;
+		for (i = 0, k = 0; i < m; i++) {
+			pony_test_random(u+k, m-i, -1.0/m, 1.0/m);
+			u[k] = 1 + fabs(u[k])*m;
+			k += m-i;
+		}
+		pony_test_random(v, m*m, -1, 1);
+		pony_test_random(x, m, -1, 1);
+		pony_test_random(F, m*m, -1.0/m, 1.0/m);
+		for (i = 0; i < m; i++)
+			F[i*m+i] += 1;
+		for (j = 0; j < m*m; j += 3)	// zero entries skipped by prediction
+			F[j] = 0;
+		pony_test_random(q, m, 0, 0.1);
+		pony_linal_simd(0);
+		pony_linal_uuT(P, u, m);
+
+		n = pony_test_linal_run(ref, u, P, v, x, F, q, t, work, m);
+		for (level = 1; level <= 3; level++) {
+			if (pony_linal_simd(level) != level)
+				continue;
+			pony_test_linal_run(res, u, P, v, x, F, q, t, work, m);
+			for (i = 0, fail = 0; i < n; i++)
+				if ( !(fabs(res[i] - ref[i]) <= pony_test_linal_tol*(1 + fabs(ref[i]))) )
+					fail = 1;
+			sprintf(what, "routines at level %d match scalar ones for m = %d", level, m);
+			pony_test_check(!fail, "linal", what);
+		}
+		pony_linal_simd(0);
+	}
+
+	pony_linal_simd(0);
+	free(u); free(P); free(v); free(x); free(F); free(q); free(t); free(work); free(ref); free(res);
+}
+
+
+// batch Kalman update against sequential scalar updates, bitwise
+void pony_test_kalman_batch(void)
+{
+	const int sizes[] = {10, 130}, n = 40;	// sequential updates inside and a pass through S per block of measurements, several blocks
+	double *S0, *S1, *x0, *x1, *K0, *K1, *res0, *res1, *z, *H, *sigma, *work;
+	int s, m, mu, i, l, w, same;
+	char what[128];
+
+	m = sizes[1];
+	mu = m*(m+1)/2;
+	S0    = (double *)malloc(mu*sizeof(double));
+	S1    = (double *)malloc(mu*sizeof(double));
+	x0    = (double *)malloc(m*sizeof(double));
+	x1    = (double *)malloc(m*sizeof(double));
+	K0    = (double *)malloc(n*m*sizeof(double));
+	K1    = (double *)malloc(n*m*sizeof(double));
+	res0  = (double *)malloc(n*sizeof(double));
+	res1  = (double *)malloc(n*sizeof(double));
+	z     = (double *)malloc(n*sizeof(double));
+	H     = (double *)malloc(n*m*sizeof(double));
+	sigma = (double *)malloc(n*sizeof(double));
+	work  = (double *)malloc(mu*sizeof(double));
+	if (S0 == NULL || S1 == NULL || x0 == NULL || x1 == NULL || K0 == NULL || K1 == NULL || res0 == NULL || res1 == NULL
+		|| z == NULL || H == NULL || sigma == NULL || work == NULL)
+		pony_test_check(0, "kalman", "memory allocation");
+	else
+		for (s = 0; s < 2; s++) {
+			m = sizes[s];
+			mu = m*(m+1)/2;
+			srand(3);
+			pony_test_random(z, n, -10, 10);
+			pony_test_random(H, n*m, -1, 1);
+			pony_test_random(sigma, n, 0.1, 1);
+			for (w = 0; w < 2; w++) {
+				pony_test_random(S0, mu, -0.1, 0.1);
+				for (i = 0, l = 0; i < m; l += m-i, i++)
+					S0[l] = 1 + S0[l];
+				pony_test_random(x0, m, -1, 1);
+				pony_test_copy(S1, S0, mu);
+				pony_test_copy(x1, x0, m);
+				for (l = 0; l < n; l++)
+					res0[l] = pony_linal_kalman_update(x0, S0, K0 + l*m, z[l], H + l*m, sigma[l], m);
+				pony_linal_kalman_update_batch(x1, S1, K1, res1, z, H, sigma, (w == 0) ? work : NULL, n, m);
+				for (i = 0, same = 1; i < mu; i++)
+					if (S1[i] != S0[i])
+						same = 0;
+				for (i = 0; i < m; i++)
+					if (x1[i] != x0[i])
+						same = 0;
+				for (i = 0; i < n*m; i++)
+					if (K1[i] != K0[i])
+						same = 0;
+				for (l = 0; l < n; l++)
+					if (res1[l] != res0[l])
+						same = 0;
+				sprintf(what, "batch update equals sequential ones for m = %d, n = %d, %s work array", m, n, (w == 0) ? "with" : "no");
+				pony_test_check(same, "kalman", what);
+			}
+		}
+	free(S0); free(S1); free(x0); free(x1); free(K0); free(K1); free(res0); free(res1); free(z); free(H); free(sigma); free(work);
+}
+
+
+
+// Keplerian orbits against reference values
+	// the reference computed independently for the ephemeris below, in double precision, with Kepler equation iterated to convergence,
+	// relativistic correction and emission time iterated to convergence, and velocities by central differences over 0.01 s
+#define pony_test_kepler_tol_x	1e-4	// coordinates, m
+#define pony_test_kepler_tol_v	1e-4	// velocities, m/s, as the reference ones are by differences
+#define pony_test_kepler_tol_t	1e-12	// emission time and clock offset, s
+#define pony_test_kepler_sats	20		// satellites per constellation, BeiDou GEO C01 first and MEO C19 as 19th, the rest without ephemeris
+
+	// compare satellite coordinates, velocity, emission time and clock offset with reference
+void pony_test_kepler_check(pony_gnss_sat *sat, const double *ref, const char *what)
+{
+	int i;
+	char ok = sat->x_valid && sat->v_valid && sat->t_em_valid;
+
+	for (i = 0; i < 3; i++) {
+		if ( !(fabs(sat->x[i] - ref[i]) <= pony_test_kepler_tol_x) )
+			ok = 0;
+		if ( !(fabs(sat->v[i] - ref[3+i]) <= pony_test_kepler_tol_v) )
+			ok = 0;
+	}
+	if ( !(fabs(sat->t_em - ref[6]) <= pony_test_kepler_tol_t) || !(fabs(sat->Deltatsv - ref[7]) <= pony_test_kepler_tol_t) )
+		ok = 0;
+	pony_test_check(ok, "kepler", what);
+}
+
+void pony_test_kepler(void)
+{
+	double gps_eph[] = {2020, 6, 9, 2, 0, 0,	// toc 2020/06/09 02:00:00, Tuesday
+		-1.5e-4, -6.0e-12, 0.0,  50, -40.5, 4.6e-9, 1.2,  -2.1e-6, 0.0105, 7.8e-6, 5153.65,  180000, 1.1e-7, -2.3, -9.3e-8,  0.96, 240.3, 0.7, -8.1e-9,  3.2e-10};
+	double geo_eph[] = {2020, 6, 9, 2, 0, 0,
+		5.0e-4, 4.0e-11, 0.0,  1, -460.2, 2.5e-9, -1.9,  -1.4e-5, 0.00065, -3.3e-6, 6493.45,  180000, 7.0e-9, 3.05, -4.1e-8,  0.065, -120.4, -2.7, 1.2e-9,  -4.0e-10};
+	double meo_eph[] = {2020, 6, 9, 2, 0, 0,
+		-3.0e-4, 2.0e-12, 0.0,  1, 35.1, 3.6e-9, 0.4,  1.7e-6, 0.0012, 9.9e-6, 5282.62,  180000, -2.5e-8, 1.1, 4.8e-8,  0.97, 155.7, -1.3, -6.6e-9,  1.9e-10};
+	const double gps_ref[] = {	// at reception time
+		16955362.779340848, -10014701.975262122, 17782371.357077461, 2239.8252898827195, 489.35858607292175, -1799.4882728904486, 181800.00015003473, -0.0001500347266302624};
+	const double gps_pr_ref[] = {	// for pseudorange 2.25e7 m
+		16955139.865942974, -10014831.49650158, 17782506.411061097, 2239.8429972395343, 489.35880379538185, -1799.4597911834717, 181799.92509811331, -0.00015003472615422522};
+	const double geo_ref[] = {	// for pseudorange 3.75e7 m
+		-21628202.017193448, -36194845.857921146, -717833.37956304569, -1.2503077630601509, 6.0303720141686377, -154.31286455132067, 181799.87441339047, 0.00050007383333520246};
+	const double meo_ref[] = {	// for pseudorange 2.4e7 m
+		24106213.441905141, -4932.0495591705203, -14005227.702281617, 1440.5927840497761, 715.02974020977513, 2473.8237442448735, 181799.92024461523, -0.00029999809221193177};
+	const double t = 181800;
+
+	pony_struct bus;
+	pony_gnss_sat sat[pony_test_kepler_sats];
+	pony_gnss_sat_soa soa;
+	double x[9*pony_test_kepler_sats], pr[pony_test_kepler_sats];
+	unsigned int flags[5];
+	pony_gps_const *gps;
+	pony_bds_const *bds;
+	int i, count;
+
+	pony_bus_setup(&bus);
+	pony_bus_init(&bus, "");
+	gps = &(bus.gnss_const.gps);
+	bds = &(bus.gnss_const.bds);
+	soa.count = pony_test_kepler_sats;
+	soa.x = x; soa.y = x+pony_test_kepler_sats; soa.z = x+2*pony_test_kepler_sats;
+	soa.vx = x+3*pony_test_kepler_sats; soa.vy = x+4*pony_test_kepler_sats; soa.vz = x+5*pony_test_kepler_sats;
+	soa.sinEl = x+6*pony_test_kepler_sats; soa.t_em = x+7*pony_test_kepler_sats; soa.Deltatsv = x+8*pony_test_kepler_sats;
+	soa.eph_valid = flags; soa.x_valid = flags+1; soa.v_valid = flags+2; soa.t_em_valid = flags+3; soa.sinEl_valid = flags+4;
+	for (i = 0; i < pony_test_kepler_sats; i++) {
+		sat[i].eph = gps_eph;
+		sat[i].eph_valid = 0;
+		pr[i] = 0;
+	}
+
+	// GPS, first satellite only
+	sat[0].eph_valid = 1;
+	count = pony_gnss_kepler(sat, &soa, t, NULL, gps->mu, gps->u, gps->F, bus.gnss_const.c, 0);
+	pony_test_check(count == 1 && !sat[1].x_valid, "kepler", "GPS satellites without ephemeris skipped");
+	pony_test_kepler_check(sat, gps_ref, "GPS satellite at reception time");
+	pr[0] = 2.25e7;
+	pony_gnss_kepler(sat, &soa, t, pr, gps->mu, gps->u, gps->F, bus.gnss_const.c, 0);
+	pony_test_kepler_check(sat, gps_pr_ref, "GPS satellite at emission time for pseudorange");
+
+	// BeiDou, GEO C01 and MEO C19
+	sat[0].eph = geo_eph;
+	sat[18].eph = meo_eph;
+	sat[18].eph_valid = 1;
+	pr[0] = 3.75e7;
+	pr[18] = 2.4e7;
+	count = pony_gnss_kepler(sat, &soa, t, pr, bds->mu, bds->u, bds->F, bus.gnss_const.c, 1);
+	pony_test_check(count == 2, "kepler", "BeiDou satellites without ephemeris skipped");
+	pony_test_kepler_check(sat, geo_ref, "BeiDou GEO satellite at emission time for pseudorange");
+	pony_test_kepler_check(sat+18, meo_ref, "BeiDou MEO satellite at emission time for pseudorange");
+
+	pony_bus_terminate(&bus);
+	pony_bus_step(&bus);
+}
+
+
+
+// GLONASS orbit integration against a full integration from ephemeris
+#define pony_test_glo_tol_x		1e-3	// coordinates, m
+#define pony_test_glo_tol_v		1e-6	// velocities, m/s
+#define pony_test_glo_tol_t		1e-12	// emission time and clock offset, s
+#define pony_test_glo_step		10		// reference integration step, s
+
+	// equations of motion in Earth-fixed frame as in ICD GLONASS Edition 5.1 2008 Appendix 3.1.2, state and derivative of 6 x 1, lunisolar accelerations of 3 x 1
+void pony_test_glo_motion(double *d, const double *s, const double *acc, const pony_glo_const *gc)
+{
+	double r = sqrt(s[0]*s[0] + s[1]*s[1] + s[2]*s[2]), mu = gc->mu/(r*r), rho = gc->a/r, x = s[0]/r, y = s[1]/r, z = s[2]/r;
+
+	d[0] = s[3];
+	d[1] = s[4];
+	d[2] = s[5];
+	d[3] = -mu*x - 1.5*gc->J02*mu*x*rho*rho*(1 - 5*z*z) + gc->u*gc->u*s[0] + 2*gc->u*s[4] + acc[0];
+	d[4] = -mu*y - 1.5*gc->J02*mu*y*rho*rho*(1 - 5*z*z) + gc->u*gc->u*s[1] - 2*gc->u*s[3] + acc[1];
+	d[5] = -mu*z - 1.5*gc->J02*mu*z*rho*rho*(3 - 5*z*z) + acc[2];
+}
+
+	// reference satellite state, emission time and clock offset by Runge-Kutta integration from ephemeris with short steps
+	// input:
+	//		eph - ephemeris as in RINEX navigation files, tb - its reference time, seconds of week
+	//		t - time of signal reception, seconds of week, pr - pseudorange, m, zero to compute at time t
+	// output:
+	//		ref - coordinates and velocity in Earth-fixed frame at reception time, emission time, clock offset
+void pony_test_glo_reference(double *ref, const double *eph, const double tb, const double t, const double pr, const pony_gnss_const *gnss_const)
+{
+	const pony_glo_const *gc = &(gnss_const->glo);
+
+	double s[6], s1[6], k1[6], k2[6], k3[6], k4[6], acc[3], tau, dt, dts, h, b;
+	int i, m, steps;
+
+	for (m = 0; m < 3; m++) {
+		s[m] = eph[9 + 4*m]*1e3;
+		s[3+m] = eph[10 + 4*m]*1e3;
+		acc[m] = eph[11 + 4*m]*1e3;
+	}
+	tau = pr/gnss_const->c;
+	dt = t - tau - tb;
+	dts = eph[6] + eph[7]*dt;
+	dt -= dts;
+	steps = (int)ceil(fabs(dt)/pony_test_glo_step);
+	h = (steps > 0) ? dt/steps : 0;
+	for (i = 0; i < steps; i++) {
+		pony_test_glo_motion(k1, s, acc, gc);
+		for (m = 0; m < 6; m++)
+			s1[m] = s[m] + h/2*k1[m];
+		pony_test_glo_motion(k2, s1, acc, gc);
+		for (m = 0; m < 6; m++)
+			s1[m] = s[m] + h/2*k2[m];
+		pony_test_glo_motion(k3, s1, acc, gc);
+		for (m = 0; m < 6; m++)
+			s1[m] = s[m] + h*k3[m];
+		pony_test_glo_motion(k4, s1, acc, gc);
+		for (m = 0; m < 6; m++)
+			s[m] += h/6*(k1[m] + 2*k2[m] + 2*k3[m] + k4[m]);
+	}
+	b = gc->u*tau;
+	ref[0] =  cos(b)*s[0] + sin(b)*s[1];
+	ref[1] = -sin(b)*s[0] + cos(b)*s[1];
+	ref[2] = s[2];
+	ref[3] =  cos(b)*s[3] + sin(b)*s[4];
+	ref[4] = -sin(b)*s[3] + cos(b)*s[4];
+	ref[5] = s[5];
+	ref[6] = t - tau - dts;
+	ref[7] = dts;
+}
+
+	// compare satellite coordinates, velocity, emission time and clock offset with reference
+char pony_test_glo_match(pony_gnss_sat *sat, const double *ref)
+{
+	int i;
+	char ok = sat->x_valid && sat->v_valid && sat->t_em_valid;
+
+	for (i = 0; i < 3; i++)
+		if ( !(fabs(sat->x[i] - ref[i]) <= pony_test_glo_tol_x) || !(fabs(sat->v[i] - ref[3+i]) <= pony_test_glo_tol_v) )
+			ok = 0;
+	if ( !(fabs(sat->t_em - ref[6]) <= pony_test_glo_tol_t) || !(fabs(sat->Deltatsv - ref[7]) <= pony_test_glo_tol_t) )
+		ok = 0;
+	return ok;
+}
+
+void pony_test_glo(void)
+{
+	double eph[2][21] = {
+		{2020, 6, 9, 2, 15, 0,	-4.5e-5, 9.1e-13, 180900,  10000.123, 3.0021, 9.3e-10, 0,  -15000.456, 0.6047, -2.8e-9, 1,  17500.789, -1.1993, -1.9e-9, 0},
+		{2020, 6, 9, 2, 15, 0,	 2.1e-5, -1.8e-12, 180900,  -19800.5, -0.8512, 1.9e-9, 0,  4100.25, -2.9633, 0, -2,  15600.75, -1.6604, -2.8e-9, 0}};
+	const double tb = 180900, pr[3] = {2.1e7, 0, 2.3e7};
+	char cfg[] = "{gnss: {glo: max_sat_count = 3}}";
+
+	pony_struct bus, *prev;
+	pony_gnss_glo *glo;
+	double ref[8], t;
+	int i, s, count;
+	char ok_x, ok_pr;
+
+	pony_bus_setup(&bus);
+	if (!pony_bus_init(&bus, cfg) || bus.gnss_count < 1 || bus.gnss[0].glo == NULL || bus.gnss[0].glo->max_sat_count != 3) {
+		pony_test_check(0, "glo", "bus with GLONASS constellation initialized");
+		pony_bus_terminate(&bus);
+		pony_bus_step(&bus);
+		return;
+	}
+	prev = pony_bus_select(&bus);
+	glo = bus.gnss[0].glo;
+	for (s = 0; s < 2; s++)
+		for (i = 0; i < 21; i++)
+			glo->sat[2*s].eph[i] = eph[s][i];
+	glo->sat[0].eph_valid = glo->sat[2].eph_valid = 1;
+
+	// forward across ephemeris reference time, then backward, each from the state cached by the previous call
+	for (t = tb - 900, ok_x = 1, count = 0; t <= tb + 2700; t += 97) {
+		count += pony_gnss_glo_orbit(glo, t, NULL);
+		for (s = 0; s < 2; s++) {
+			pony_test_glo_reference(ref, eph[s], tb, t, 0, &(bus.gnss_const));
+			if (!pony_test_glo_match(glo->sat + 2*s, ref))
+				ok_x = 0;
+		}
+	}
+	pony_test_check(count == 2*38 && !glo->sat[1].x_valid, "glo", "satellites without ephemeris skipped");
+	pony_test_check(ok_x, "glo", "state integrated forward from cache matches full integration from ephemeris");
+	for (t = tb + 2700, ok_x = 1; t >= tb + 300; t -= 131) {
+		pony_gnss_glo_orbit(glo, t, NULL);
+		for (s = 0; s < 2; s++) {
+			pony_test_glo_reference(ref, eph[s], tb, t, 0, &(bus.gnss_const));
+			if (!pony_test_glo_match(glo->sat + 2*s, ref))
+				ok_x = 0;
+		}
+	}
+	pony_test_check(ok_x, "glo", "state integrated backward from cache matches full integration from ephemeris");
+
+	// emission time for pseudoranges, from cache
+	t = tb + 1200;
+	pony_gnss_glo_orbit(glo, t, (double *)pr);
+	for (s = 0, ok_pr = 1; s < 2; s++) {
+		pony_test_glo_reference(ref, eph[s], tb, t, pr[2*s], &(bus.gnss_const));
+		if (!pony_test_glo_match(glo->sat + 2*s, ref))
+			ok_pr = 0;
+	}
+	pony_test_check(ok_pr, "glo", "state at emission time for pseudorange matches full integration from ephemeris");
+
+	// ephemeris invalidated and changed with reference time and x coordinate kept, cached state not to be used
+	glo->sat[0].eph_valid = 0;
+	pony_gnss_glo_orbit(glo, t, NULL);
+	pony_test_check(!glo->sat[0].x_valid, "glo", "satellite with ephemeris invalidated skipped");
+	eph[0][10] += 1e-3;
+	eph[0][14] -= 2e-3;
+	glo->sat[0].eph[10] = eph[0][10];
+	glo->sat[0].eph[14] = eph[0][14];
+	glo->sat[0].eph_valid = 1;
+	pony_gnss_glo_orbit(glo, t + 60, NULL);
+	pony_test_glo_reference(ref, eph[0], tb, t + 60, 0, &(bus.gnss_const));
+	pony_test_check(pony_test_glo_match(glo->sat, ref), "glo", "cached state dropped when ephemeris is invalidated");
+
+	pony_bus_select(prev);
+	pony_bus_terminate(&bus);
+	pony_bus_step(&bus);
+}
+
+
+
+// Chebyshev orbit cache against the orbit models
+#define pony_test_cheb_tol		0.01	// configured position accuracy bound, m
+#define pony_test_cheb_tol_t	1e-12	// clock offset, s
+
+	// orbit cache lookups and orbit models of constellations
+int pony_test_cheb_gps(void *system, const double t, double *pr)	{ return pony_gnss_gps_cheb((pony_gnss_gps *)system, t, pr); }
+int pony_test_cheb_glo(void *system, const double t, double *pr)	{ return pony_gnss_glo_cheb((pony_gnss_glo *)system, t, pr); }
+int pony_test_model_gps(void *system, const double t, double *pr)	{ return pony_gnss_gps_kepler((pony_gnss_gps *)system, t, pr); }
+int pony_test_model_glo(void *system, const double t, double *pr)	{ return pony_gnss_glo_orbit((pony_gnss_glo *)system, t, pr); }
+
+	// maximum position error of cache lookups against the model over reception times t0 to t1 with step dt, pseudoranges used at odd steps
+	// input:
+	//		sat - count satellites of the constellation system, up to 8, lookup - cache lookup, model - orbit model
+	// output:
+	//		maximum position error, m, or -1 if validity or clock offsets differ
+double pony_test_cheb_sweep(pony_gnss_sat *sat, const int count, void *system, int (*lookup)(void *, const double, double *), int (*model)(void *, const double, double *),
+	const double t0, const double t1, const double dt, double *pr)
+{
+	double x[3*8], dts[8], t, d, err = 0;
+	int i, k, m, n;
+	char valid[8];
+
+	for (t = t0, k = 0; t <= t1; t += dt, k++) {
+		n = lookup(system, t, (k%2) ? pr : NULL);
+		for (i = 0; i < count; i++) {
+			valid[i] = sat[i].x_valid;
+			dts[i] = sat[i].Deltatsv;
+			for (m = 0; m < 3; m++)
+				x[3*i + m] = sat[i].x[m];
+		}
+		if (model(system, t, (k%2) ? pr : NULL) != n)
+			return -1;
+		for (i = 0; i < count; i++) {
+			if (valid[i] != sat[i].x_valid)
+				return -1;
+			if (!valid[i])
+				continue;
+			if ( !(fabs(dts[i] - sat[i].Deltatsv) <= pony_test_cheb_tol_t) )
+				return -1;
+			for (m = 0, d = 0; m < 3; m++)
+				d += (x[3*i + m] - sat[i].x[m])*(x[3*i + m] - sat[i].x[m]);
+			if ( !(sqrt(d) <= err) )
+				err = sqrt(d);
+		}
+	}
+	return err;
+}
+
+	// lookup error against the model for ephemeris set, changed in a cache key field, and invalidated while changed in another field
+	//	input:
+	//		sat - count satellites of the constellation system with ephemeris, to be changed at index i, key and other
+	//		t - reception time in the middle of ephemeris validity interval, pr - pseudoranges
+void pony_test_cheb_constellation(pony_gnss_sat *sat, const int count, void *system, int (*lookup)(void *, const double, double *), int (*model)(void *, const double, double *),
+	const double t, double *pr, const int key, const int other, const double delta, const char *name)
+{
+	double err;
+	char what[128];
+
+	err = pony_test_cheb_sweep(sat, count, system, lookup, model, t - 1800, t + 1800, 37, pr);
+	sprintf(what, "%s lookups within accuracy bound", name);
+	pony_test_check(err >= 0 && err <= pony_test_cheb_tol, "cheb", what);
+	sprintf(what, "%s satellites without ephemeris skipped", name);
+	pony_test_check(err >= 0 && !sat[1].x_valid, "cheb", what);
+
+	// ephemeris changed in a cache key field
+	sat[0].eph[key] += delta;
+	err = pony_test_cheb_sweep(sat, count, system, lookup, model, t, t + 60, 30, pr);
+	sprintf(what, "%s segment refitted when ephemeris changes", name);
+	pony_test_check(err >= 0 && err <= pony_test_cheb_tol, "cheb", what);
+
+	// ephemeris invalidated, then changed in a field not in the key
+	sat[0].eph_valid = 0;
+	lookup(system, t, NULL);
+	sprintf(what, "%s satellite with ephemeris invalidated skipped", name);
+	pony_test_check(!sat[0].x_valid && sat[2].x_valid, "cheb", what);
+	sat[0].eph[other] += 0.01;
+	sat[0].eph_valid = 1;
+	err = pony_test_cheb_sweep(sat, count, system, lookup, model, t, t + 60, 30, pr);
+	sprintf(what, "%s segment refitted when ephemeris is invalidated", name);
+	pony_test_check(err >= 0 && err <= pony_test_cheb_tol, "cheb", what);
+}
+
+void pony_test_cheb(void)
+{
+	const double gps_eph[2][26] = {
+		{2020, 6, 9, 2, 0, 0,	-1.5e-4, -6.0e-12, 0.0,  50, -40.5, 4.6e-9, 1.2,  -2.1e-6, 0.0105, 7.8e-6, 5153.65,  180000, 1.1e-7, -2.3, -9.3e-8,  0.96, 240.3, 0.7, -8.1e-9,  3.2e-10},
+		{2020, 6, 9, 2, 0, 0,	 2.5e-4, 1.0e-12, 0.0,  12, 85.2, 4.9e-9, -2.6,  4.4e-6, 0.0042, 3.1e-6, 5153.71,  180000, -6.3e-8, 1.8, 2.2e-8,  0.95, 201.9, -1.4, -7.9e-9,  -1.1e-10}};
+	const double glo_eph[2][21] = {
+		{2020, 6, 9, 2, 15, 0,	-4.5e-5, 9.1e-13, 180900,  10000.123, 3.0021, 9.3e-10, 0,  -15000.456, 0.6047, -2.8e-9, 1,  17500.789, -1.1993, -1.9e-9, 0},
+		{2020, 6, 9, 2, 15, 0,	 2.1e-5, -1.8e-12, 180900,  -19800.5, -0.8512, 1.9e-9, 0,  4100.25, -2.9633, 0, -2,  15600.75, -1.6604, -2.8e-9, 0}};
+	double pr[3] = {2.1e7, 0, 2.3e7};
+	char cfg[] = "{gnss: {gps: max_sat_count = 3, orbit_cache_tol = 0.01}, {glo: max_sat_count = 3, orbit_cache_tol = 0.01}}";
+
+	pony_struct bus, *prev;
+	pony_gnss_gps *gps;
+	pony_gnss_glo *glo;
+	int i, s;
+
+	pony_bus_setup(&bus);
+	if (!pony_bus_init(&bus, cfg) || bus.gnss_count < 1 || bus.gnss[0].gps == NULL || bus.gnss[0].glo == NULL
+		|| bus.gnss[0].gps->max_sat_count != 3 || bus.gnss[0].glo->max_sat_count != 3) {
+		pony_test_check(0, "cheb", "bus with GPS and GLONASS constellations initialized");
+		pony_bus_terminate(&bus);
+		pony_bus_step(&bus);
+		return;
+	}
+	prev = pony_bus_select(&bus);
+	gps = bus.gnss[0].gps;
+	glo = bus.gnss[0].glo;
+	pony_test_check(gps->cheb.tol == pony_test_cheb_tol && glo->cheb.tol == pony_test_cheb_tol, "cheb", "accuracy bound configured");
+	for (s = 0; s < 2; s++) {
+		for (i = 0; i < 26; i++)
+			gps->sat[2*s].eph[i] = gps_eph[s][i];
+		for (i = 0; i < 21; i++)
+			glo->sat[2*s].eph[i] = glo_eph[s][i];
+		gps->sat[2*s].eph_valid = glo->sat[2*s].eph_valid = 1;
+	}
+
+	// GPS: clock bias in the key, mean anomaly not; GLONASS: x coordinate in the key, y velocity not
+	pony_test_cheb_constellation(gps->sat, 3, gps, pony_test_cheb_gps, pony_test_model_gps, 181800, pr, 6, 12, 1e-6, "GPS");
+	pony_test_cheb_constellation(glo->sat, 3, glo, pony_test_cheb_glo, pony_test_model_glo, 180900, pr, 9, 14, 1e-3, "GLONASS");
+
+	pony_bus_select(prev);
+	pony_bus_terminate(&bus);
+	pony_bus_step(&bus);
+}
+
+
+
+// RINEX observation and navigation files
+#define pony_test_rinex_file "pony_test_rinex.tmp"	// fixture file written to the current directory and removed afterwards
+
+	// write fixture file, output: OK/not OK (1/0)
+char pony_test_write(const char *file_name, const char *text)
+{
+	FILE *fp;
+	char ok;
+
+	fp = fopen(file_name, "wb");
+	if (fp == NULL)
+		return 0;
+	ok = (fputs(text, fp) >= 0);
+	return (char)(fclose(fp) == 0 && ok);
+}
+
+	// observable of a satellite valid and equal to a value
+char pony_test_obs(pony_gnss_sat *sat, const int j, const double value)
+{
+	return sat->obs_valid[j] && sat->obs[j] == value;
+}
+
+	// observable of a satellite not valid
+char pony_test_no_obs(pony_gnss_sat *sat, const int j)
+{
+	return !sat->obs_valid[j];
+}
+
+	// epoch read equal to given time
+char pony_test_epoch(pony_gnss *gnss, const int Y, const int M, const int D, const int h, const int m, const double s)
+{
+	return gnss->epoch.Y == Y && gnss->epoch.M == M && gnss->epoch.D == D && gnss->epoch.h == h && gnss->epoch.m == m && gnss->epoch.s == s;
+}
+
+void pony_test_rinex_obs(void)
+{
+	// RINEX 2 mixed file: L1 blank and P2 beyond the end of line for G05, event record with a comment line, G05 and R03 not observed in the last epoch
+	const char *obs2 =
+		"     2.11           OBSERVATION DATA    M (MIXED)           RINEX VERSION / TYPE\n"
+		"     3    C1    L1    P2                                    # / TYPES OF OBSERV \n"
+		"  2020     6     9     2     0    0.0000000     GPS         TIME OF FIRST OBS   \n"
+		"                                                            END OF HEADER       \n"
+		" 20  6  9  2  0  0.0000000  0  3G01G05R03\n"
+		"  20123456.789   105748123.45617  20123458.012  \n"
+		"  22345678.901                  \n"
+		"  21000000.500   112233445.667    21000001.250  \n"
+		" 20  6  9  2  0 15.0000000  4  1\n"
+		"EVENT RECORD                                                COMMENT             \n"
+		" 20  6  9  2  0 30.0000000  0  1G01\n"
+		"  20123466.789   105748175.500    20123468.125  \n";
+	// RINEX 3 mixed file with CRLF line ends: L1C blank for G01, S1C beyond the end of line for G07, GPS satellites not observed in the last epoch
+	const char *obs3 =
+		"     3.04           OBSERVATION DATA    M (MIXED)           RINEX VERSION / TYPE\r\n"
+		"G    3 C1C L1C S1C                                          SYS / # / OBS TYPES \r\n"
+		"R    2 C1C L1C                                              SYS / # / OBS TYPES \r\n"
+		"  2020     6     9     2     0    0.0000000     GPS         TIME OF FIRST OBS   \r\n"
+		"                                                            END OF HEADER       \r\n"
+		"> 2020 06 09 02 00  0.0000000  0  3\r\n"
+		"G01  20123456.789                          45.250  \r\n"
+		"G07  23456789.012   123265432.108  \r\n"
+		"R02  19876543.210   106234567.891  \r\n"
+		"> 2020 06 09 02 00 30.0000000  0  1\r\n"
+		"R02  19876600.500   106234867.125  \r\n";
+	char cfg[] = "{gnss: {gps: max_sat_count = 8}, {glo: max_sat_count = 4}}";
+	char type0[] = "L1C", type1[] = "C1C", *types[2];
+
+	pony_struct bus;
+	pony_gnss *gnss;
+	pony_gnss_sat *gps, *glo;
+	pony_rinex_obs rnx;
+	char ok;
+
+	pony_bus_setup(&bus);
+	if (!pony_bus_init(&bus, cfg) || bus.gnss_count < 1 || bus.gnss[0].gps == NULL || bus.gnss[0].glo == NULL) {
+		pony_test_check(0, "rinex", "bus with GPS and GLONASS constellations initialized");
+		pony_bus_terminate(&bus);
+		pony_bus_step(&bus);
+		return;
+	}
+	gnss = bus.gnss;
+
+	// RINEX 2, types adopted from file
+	ok = pony_test_write(pony_test_rinex_file, obs2) && pony_rinex_obs_open(&rnx, gnss, pony_test_rinex_file);
+	pony_test_check(ok, "rinex", "RINEX 2 observation file opened");
+	if (ok) {
+		gps = gnss->gps->sat;
+		glo = gnss->glo->sat;
+		pony_test_check(rnx.version == 2.11 && gnss->time.scale == pony_time_gps, "rinex", "RINEX 2 version and time scale");
+		ok = gnss->gps->obs_count == 3 && gnss->glo->obs_count == 3;
+		pony_test_check(ok, "rinex", "RINEX 2 observation types adopted");
+		if (ok) {
+			pony_test_check(gnss->gps->obs_types[0][0] == 'C' && gnss->gps->obs_types[0][2] == 'C' && gnss->gps->obs_types[2][0] == 'C' && gnss->gps->obs_types[2][2] == 'W'
+				&& gnss->glo->obs_types[2][2] == 'P', "rinex", "RINEX 2 observation types in RINEX 3 notation");
+			pony_test_check(pony_rinex_obs_read(&rnx) && pony_test_epoch(gnss, 2020, 6, 9, 2, 0, 0), "rinex", "RINEX 2 first epoch");
+			pony_test_check(pony_test_obs(gps, 0, 20123456.789) && pony_test_obs(gps, 1, 105748123.456) && pony_test_obs(gps, 2, 20123458.012),
+				"rinex", "RINEX 2 observables with loss of lock and signal strength indicators");
+			pony_test_check(pony_test_obs(gps+4, 0, 22345678.901) && pony_test_no_obs(gps+4, 1) && pony_test_no_obs(gps+4, 2),
+				"rinex", "RINEX 2 blank observables and those beyond the end of line invalid");
+			pony_test_check(pony_test_obs(glo+2, 0, 21000000.5) && pony_test_obs(glo+2, 2, 21000001.25), "rinex", "RINEX 2 GLONASS observables");
+			pony_test_check(pony_test_no_obs(gps+1, 0) && pony_test_no_obs(glo, 0), "rinex", "RINEX 2 satellites not listed invalid");
+			pony_test_check(pony_rinex_obs_read(&rnx) && pony_test_epoch(gnss, 2020, 6, 9, 2, 0, 30), "rinex", "RINEX 2 event record skipped");
+			pony_test_check(pony_test_obs(gps, 0, 20123466.789) && pony_test_obs(gps, 1, 105748175.5) && pony_test_obs(gps, 2, 20123468.125),
+				"rinex", "RINEX 2 observables of the next epoch");
+			pony_test_check(pony_test_no_obs(gps+4, 0) && pony_test_no_obs(glo+2, 0) && pony_test_no_obs(glo+2, 1) && pony_test_no_obs(glo+2, 2),
+				"rinex", "RINEX 2 observables cleared for satellites not in the next epoch");
+			pony_test_check(!pony_rinex_obs_read(&rnx), "rinex", "RINEX 2 end of file");
+		}
+		pony_rinex_obs_close(&rnx);
+		pony_test_check(gnss->gps->obs_types == NULL && gnss->gps->obs_count == 0 && gps[0].obs == NULL, "rinex", "RINEX 2 adopted types and observables detached");
+	}
+
+	// RINEX 3, GPS types set before and matched by name, GLONASS types adopted from file
+	types[0] = type0;
+	types[1] = type1;
+	gnss->gps->obs_types = types;
+	gnss->gps->obs_count = 2;
+	ok = pony_test_write(pony_test_rinex_file, obs3) && pony_rinex_obs_open(&rnx, gnss, pony_test_rinex_file);
+	pony_test_check(ok, "rinex", "RINEX 3 observation file opened");
+	if (ok) {
+		gps = gnss->gps->sat;
+		glo = gnss->glo->sat;
+		pony_test_check(rnx.version == 3.04 && gnss->gps->obs_count == 2 && gnss->glo->obs_count == 2, "rinex", "RINEX 3 observation types");
+		pony_test_check(pony_rinex_obs_read(&rnx) && pony_test_epoch(gnss, 2020, 6, 9, 2, 0, 0), "rinex", "RINEX 3 first epoch");
+		pony_test_check(pony_test_obs(gps, 1, 20123456.789) && pony_test_no_obs(gps, 0), "rinex", "RINEX 3 blank observable invalid, types set before matched by name");
+		pony_test_check(pony_test_obs(gps+6, 1, 23456789.012) && pony_test_obs(gps+6, 0, 123265432.108), "rinex", "RINEX 3 types set before in their own order");
+		pony_test_check(pony_test_obs(glo+1, 0, 19876543.21) && pony_test_obs(glo+1, 1, 106234567.891), "rinex", "RINEX 3 GLONASS observables");
+		pony_test_check(pony_rinex_obs_read(&rnx) && pony_test_epoch(gnss, 2020, 6, 9, 2, 0, 30), "rinex", "RINEX 3 next epoch");
+		pony_test_check(pony_test_obs(glo+1, 0, 19876600.5) && pony_test_obs(glo+1, 1, 106234867.125), "rinex", "RINEX 3 observables of the next epoch");
+		pony_test_check(pony_test_no_obs(gps, 1) && pony_test_no_obs(gps+6, 0) && pony_test_no_obs(gps+6, 1),
+			"rinex", "RINEX 3 observables cleared for satellites not in the next epoch");
+		pony_test_check(!pony_rinex_obs_read(&rnx), "rinex", "RINEX 3 end of file");
+		pony_rinex_obs_close(&rnx);
+		pony_test_check(gnss->gps->obs_types == types && gnss->glo->obs_types == NULL, "rinex", "RINEX 3 types set before kept, adopted ones detached");
+	}
+	gnss->gps->obs_types = NULL;
+	gnss->gps->obs_count = 0;
+	remove(pony_test_rinex_file);
+
+	pony_bus_terminate(&bus);
+	pony_bus_step(&bus);
+}
+
+	// selected ephemeris values equal to given ones, count values from index first
+char pony_test_eph(pony_gnss_sat *sat, const int first, const double *eph, const int count)
+{
+	int i;
+
+	if (!sat->eph_valid)
+		return 0;
+	for (i = 0; i < count; i++)
+		if (sat->eph[first + i] != eph[i])
+			return 0;
+	return 1;
+}
+
+	// change modification time recorded in binary ephemeris cache header, as if navigation file were modified, output: OK/not OK (1/0)
+char pony_test_nav_touch(const char *cache_name)
+{
+	FILE *fp;
+	double mtime;
+	char ok;
+
+	fp = fopen(cache_name, "r+b");
+	if (fp == NULL)
+		return 0;
+	ok = fseek(fp, 6*sizeof(double), SEEK_SET) == 0 && fread(&mtime, sizeof(double), 1, fp) == 1;
+	mtime += 1;
+	ok = ok && fseek(fp, 6*sizeof(double), SEEK_SET) == 0 && fwrite(&mtime, sizeof(double), 1, fp) == 1;
+	return (char)(fclose(fp) == 0 && ok);
+}
+
+	// open navigation file with cache, select ephemeris for an epoch and keep GPS PRN 1 ephemeris, output: loaded from cache (1), parsed (0), failed (-1)
+int pony_test_nav_load(pony_gnss *gnss, const char *file_name, const char *cache_name, pony_time_epoch epoch, double *eph)
+{
+	pony_rinex_nav nav;
+	int i, cached;
+
+	if (!pony_rinex_nav_open(&nav, file_name, cache_name))
+		return -1;
+	cached = nav.cached;
+	if (nav.count != 3 || pony_rinex_nav_select(&nav, gnss, epoch) != 2)
+		cached = -1;
+	for (i = 0; i < pony_rinex_nav_width; i++)
+		eph[i] = gnss->gps->sat[0].eph[i];
+	pony_rinex_nav_close(&nav);
+	return cached;
+}
+
+void pony_test_rinex_nav(void)
+{
+	// RINEX 2 GPS file: D exponents, one in lower case, blank field within a line, two records for PRN 1
+	const char *nav2 =
+		"     2.11           N: GPS NAV DATA                         RINEX VERSION / TYPE\n"
+		"    0.1118D-07 -0.7451D-08 -0.5960D-07  0.1192D-06          ION ALPHA           \n"
+		"    0.9011D+05 -0.6554D+05 -0.1311D+06  0.4588D+06          ION BETA            \n"
+		"   0.133179128170D-06 0.107469588780D-12   552960     2111  DELTA-UTC: A0,A1,T,W\n"
+		"    18                                                      LEAP SECONDS        \n"
+		"                                                            END OF HEADER       \n"
+		" 1 20  6  9  2  0  0.0-1.500000000000D-04-6.000000000000D-12 0.000000000000D+00\n"
+		"    5.000000000000D+01-4.050000000000D+01 4.600000000000D-09 1.200000000000D+00\n"
+		"   -2.100000000000D-06 1.050000000000D-02 7.800000000000D-06 5.153650000000D+03\n"
+		"    1.800000000000D+05 1.100000000000D-07-2.300000000000D+00-9.300000000000D-08\n"
+		"    9.600000000000D-01 2.403000000000D+02 7.000000000000D-01-8.100000000000D-09\n"
+		"    3.200000000000D-10 1.000000000000D+00 2.111000000000D+03 0.000000000000D+00\n"
+		"    2.000000000000D+00 0.000000000000D+00-1.100000000000D-08 5.000000000000D+01\n"
+		"    1.728000000000D+05 4.000000000000D+00\n"
+		" 1 20  6  9  4  0  0.0-1.500000100000D-04-6.000000000000D-12 0.000000000000D+00\n"
+		"    5.100000000000D+01-4.150000000000D+01 4.600000000000D-09 1.250000000000D+00\n"
+		"   -2.100000000000D-06 1.050000000000D-02 7.800000000000D-06 5.153650000000D+03\n"
+		"    1.872000000000D+05 1.100000000000D-07-2.300000000000D+00-9.300000000000D-08\n"
+		"    9.600000000000D-01 2.403000000000D+02 7.000000000000D-01-8.100000000000D-09\n"
+		"    3.200000000000D-10 1.000000000000D+00 2.111000000000D+03 0.000000000000D+00\n"
+		"    2.000000000000D+00 0.000000000000D+00-1.100000000000D-08 5.100000000000D+01\n"
+		"    1.800000000000D+05 4.000000000000D+00\n"
+		" 5 20  6  9  2  0  0.0 2.500000000000D-04 1.000000000000d-12 0.000000000000D+00\n"
+		"    1.200000000000D+01 8.520000000000D+01 4.900000000000D-09-2.600000000000D+00\n"
+		"    4.400000000000D-06 4.200000000000D-03 3.100000000000D-06 5.153710000000D+03\n"
+		"    1.800000000000D+05-6.300000000000D-08 1.800000000000D+00 2.200000000000D-08\n"
+		"    9.500000000000D-01 2.019000000000D+02-1.400000000000D+00-7.900000000000D-09\n"
+		"   -1.100000000000D-10 1.000000000000D+00 2.111000000000D+03 0.000000000000D+00\n"
+		"    2.000000000000D+00                    4.700000000000D-09 1.200000000000D+01\n"
+		"    1.728000000000D+05\n";
+	// RINEX 3 mixed file: GPS ionospheric model, clock corrections to UTC preferred to those to another system, GLONASS and BeiDou records
+	const char *nav3 =
+		"     3.04           N: GNSS NAV DATA    M: MIXED            RINEX VERSION / TYPE\n"
+		"GPSA   1.1176D-08 -7.4506D-09 -5.9605D-08  1.1921D-07       IONOSPHERIC CORR    \n"
+		"GPSB   9.0112D+04 -6.5536D+04 -1.3107D+05  4.5875D+05       IONOSPHERIC CORR    \n"
+		"GPGA  1.8626451492D-09-4.440892099D-15 432000 2111          TIME SYSTEM CORR    \n"
+		"GPUT  1.3317912817D-07 1.074695888D-13 552960 2111          TIME SYSTEM CORR    \n"
+		"GLUT -9.3132257462D-10 0.000000000D+00      0    0          TIME SYSTEM CORR    \n"
+		"    18                                                      LEAP SECONDS        \n"
+		"                                                            END OF HEADER       \n"
+		"G01 2020 06 09 02 00 00-1.500000000000D-04-6.000000000000D-12 0.000000000000D+00\n"
+		"     5.000000000000D+01-4.050000000000D+01 4.600000000000D-09 1.200000000000D+00\n"
+		"    -2.100000000000D-06 1.050000000000D-02 7.800000000000D-06 5.153650000000D+03\n"
+		"     1.800000000000D+05 1.100000000000D-07-2.300000000000D+00-9.300000000000D-08\n"
+		"     9.600000000000D-01 2.403000000000D+02 7.000000000000D-01-8.100000000000D-09\n"
+		"     3.200000000000D-10 1.000000000000D+00 2.111000000000D+03 0.000000000000D+00\n"
+		"     2.000000000000D+00 0.000000000000D+00-1.100000000000D-08 5.000000000000D+01\n"
+		"     1.728000000000D+05 4.000000000000D+00\n"
+		"R03 2020 06 09 02 15 00-4.500000000000D-05 9.100000000000D-13 1.809000000000D+05\n"
+		"     1.000012300000D+04 3.002100000000D+00 9.300000000000D-10 0.000000000000D+00\n"
+		"    -1.500045600000D+04 6.047000000000D-01-2.800000000000D-09 1.000000000000D+00\n"
+		"     1.750078900000D+04-1.199300000000D+00-1.900000000000D-09 0.000000000000D+00\n"
+		"C06 2020 06 09 02 00 00 5.000000000000D-04 4.000000000000D-11 0.000000000000D+00\n"
+		"     1.000000000000D+00-4.602000000000D+02 2.500000000000D-09-1.900000000000D+00\n"
+		"    -1.400000000000D-05 6.500000000000D-04-3.300000000000D-06 6.493450000000D+03\n"
+		"     1.800000000000D+05 7.000000000000D-09 3.050000000000D+00-4.100000000000D-08\n"
+		"     6.500000000000D-02-1.204000000000D+02-2.700000000000D+00 1.200000000000D-09\n"
+		"    -4.000000000000D-10 0.000000000000D+00 7.580000000000D+02 0.000000000000D+00\n"
+		"     2.000000000000D+00 0.000000000000D+00 1.200000000000D-08-2.900000000000D-09\n"
+		"     1.800000000000D+05 1.000000000000D+00\n";
+	const double prn1[] = {2020, 6, 9, 4, 0, 0, -1.5000001e-4, -6.0e-12, 0.0,  51, -41.5, 4.6e-9, 1.25,  -2.1e-6, 0.0105, 7.8e-6, 5153.65,  187200},
+		prn5[] = {2.5e-4, 1.0e-12, 0.0,  12, 85.2, 4.9e-9, -2.6,  4.4e-6, 0.0042, 3.1e-6, 5153.71,  180000, -6.3e-8, 1.8, 2.2e-8,  0.95, 201.9, -1.4, -7.9e-9,
+			-1.1e-10, 1, 2111, 0,  2.0, 0, 4.7e-9, 12,  172800},
+		g01[] = {2020, 6, 9, 2, 0, 0, -1.5e-4, -6.0e-12, 0.0,  50, -40.5, 4.6e-9, 1.2,  -2.1e-6, 0.0105, 7.8e-6, 5153.65,  180000},
+		r03[] = {2020, 6, 9, 2, 15, 0, -4.5e-5, 9.1e-13, 180900,  10000.123, 3.0021, 9.3e-10, 0,  -15000.456, 0.6047, -2.8e-9, 1,  17500.789, -1.1993, -1.9e-9, 0},
+		c06[] = {5.0e-4, 4.0e-11, 0.0,  1, -460.2, 2.5e-9, -1.9,  -1.4e-5, 0.00065, -3.3e-6, 6493.45,  180000, 7.0e-9, 3.05, -4.1e-8,  0.065, -120.4, -2.7, 1.2e-9,
+			-4.0e-10, 0, 758, 0,  2.0, 0, 1.2e-8, -2.9e-9,  180000, 1},
+		alpha2[] = {0.1118e-7, -0.7451e-8, -0.5960e-7, 0.1192e-6}, beta2[] = {0.9011e5, -0.6554e5, -0.1311e6, 0.4588e6},
+		utc2[] = {0.133179128170e-6, 0.107469588780e-12, 552960, 2111},
+		alpha3[] = {1.1176e-8, -7.4506e-9, -5.9605e-8, 1.1921e-7}, beta3[] = {9.0112e4, -6.5536e4, -1.3107e5, 4.5875e5},
+		utc3[] = {1.3317912817e-7, 1.074695888e-13, 552960, 2111};
+	const char *cache_name = pony_test_rinex_file ".bin";
+	char cfg[] = "{gnss: {gps: max_sat_count = 8, max_eph_count = 41}, {glo: max_sat_count = 4}, {bds: max_sat_count = 8}}";
+
+	pony_struct bus;
+	pony_gnss *gnss;
+	pony_rinex_nav nav;
+	pony_time_epoch epoch = {2020, 6, 9, 3, 50, 0};
+	double eph0[pony_rinex_nav_width], eph1[pony_rinex_nav_width];
+	char grown[4096];
+	int i;
+	char ok;
+
+	pony_bus_setup(&bus);
+	if (!pony_bus_init(&bus, cfg) || bus.gnss_count < 1 || bus.gnss[0].gps == NULL || bus.gnss[0].glo == NULL || bus.gnss[0].bds == NULL) {
+		pony_test_check(0, "rinex", "bus with GPS, GLONASS and BeiDou constellations initialized");
+		pony_bus_terminate(&bus);
+		pony_bus_step(&bus);
+		return;
+	}
+	gnss = bus.gnss;
+
+	// RINEX 2 parsed
+	ok = pony_test_write(pony_test_rinex_file, nav2) && pony_rinex_nav_open(&nav, pony_test_rinex_file, NULL);
+	pony_test_check(ok && !nav.cached && nav.count == 3, "rinex", "RINEX 2 navigation file parsed");
+	if (ok) {
+		gnss->gps->sat[4].eph[30] = 99;
+		pony_test_check(pony_rinex_nav_select(&nav, gnss, epoch) == 2, "rinex", "RINEX 2 ephemeris selected for two satellites");
+		pony_test_check(pony_test_eph(gnss->gps->sat, 0, prn1, sizeof(prn1)/sizeof(prn1[0])), "rinex", "RINEX 2 ephemeris nearest to epoch selected, D exponents");
+		pony_test_check(pony_test_eph(gnss->gps->sat + 4, 6, prn5, sizeof(prn5)/sizeof(prn5[0])), "rinex", "RINEX 2 lower case exponent and blank field as zero");
+		pony_test_check(!gnss->gps->sat[1].eph_valid, "rinex", "RINEX 2 satellite without records invalid");
+		for (i = 0, ok = gnss->gps->iono_valid && gnss->gps->clock_corr_valid; i < 4; i++)
+			if (gnss->gps->iono_a[i] != alpha2[i] || gnss->gps->iono_b[i] != beta2[i] || gnss->gps->clock_corr[i] != utc2[i])
+				ok = 0;
+		pony_test_check(ok && gnss->gps->clock_corr_to[0] == 'U' && gnss->gps->clock_corr_to[1] == 'T', "rinex", "RINEX 2 ionospheric model and UTC parameters");
+		pony_test_check(gnss->leap_sec_valid && gnss->leap_sec == 18, "rinex", "RINEX 2 leap seconds");
+		pony_rinex_nav_close(&nav);
+	}
+
+	// RINEX 3 parsed
+	epoch.h = 2;
+	epoch.m = 10;
+	gnss->gps->iono_valid = gnss->gps->clock_corr_valid = 0;
+	ok = pony_test_write(pony_test_rinex_file, nav3) && pony_rinex_nav_open(&nav, pony_test_rinex_file, NULL);
+	pony_test_check(ok && nav.count == 3, "rinex", "RINEX 3 navigation file parsed");
+	if (ok) {
+		pony_test_check(pony_rinex_nav_select(&nav, gnss, epoch) == 3, "rinex", "RINEX 3 ephemeris selected for three satellites");
+		pony_test_check(pony_test_eph(gnss->gps->sat, 0, g01, sizeof(g01)/sizeof(g01[0])), "rinex", "RINEX 3 GPS ephemeris");
+		pony_test_check(pony_test_eph(gnss->glo->sat + 2, 0, r03, sizeof(r03)/sizeof(r03[0])), "rinex", "RINEX 3 GLONASS ephemeris");
+		pony_test_check(pony_test_eph(gnss->bds->sat + 5, 6, c06, sizeof(c06)/sizeof(c06[0])), "rinex", "RINEX 3 BeiDou ephemeris");
+		for (i = 0, ok = gnss->gps->iono_valid && gnss->gps->clock_corr_valid; i < 4; i++)
+			if (gnss->gps->iono_a[i] != alpha3[i] || gnss->gps->iono_b[i] != beta3[i] || gnss->gps->clock_corr[i] != utc3[i])
+				ok = 0;
+		pony_test_check(ok && gnss->gps->clock_corr_to[0] == 'U' && gnss->gps->clock_corr_to[1] == 'T', "rinex", "RINEX 3 ionospheric model and correction to UTC preferred");
+		pony_test_check(gnss->glo->clock_corr_valid && gnss->glo->clock_corr[0] == -9.3132257462e-10, "rinex", "RINEX 3 GLONASS correction to UTC");
+		pony_rinex_nav_close(&nav);
+	}
+
+	// binary cache: written on parsing, loaded while the navigation file is unchanged, rejected when its size or time changes or the cache is truncated
+	epoch.h = 3;
+	epoch.m = 50;
+	remove(cache_name);
+	ok = pony_test_write(pony_test_rinex_file, nav2);
+	pony_test_check(ok && pony_test_nav_load(gnss, pony_test_rinex_file, cache_name, epoch, eph0) == 0, "rinex", "binary cache written after parsing");
+	pony_test_check(pony_test_nav_load(gnss, pony_test_rinex_file, cache_name, epoch, eph1) == 1, "rinex", "binary cache loaded for unchanged navigation file");
+	for (i = 0, ok = 1; i < pony_rinex_nav_width; i++)
+		if (eph0[i] != eph1[i])
+			ok = 0;
+	pony_test_check(ok && eph1[6] == prn1[6], "rinex", "ephemeris from binary cache equal to parsed ones");
+	sprintf(grown, "%s\n", nav2);
+	ok = pony_test_write(pony_test_rinex_file, grown) && pony_test_nav_load(gnss, pony_test_rinex_file, cache_name, epoch, eph1) == 0;
+	pony_test_check(ok && pony_test_nav_load(gnss, pony_test_rinex_file, cache_name, epoch, eph1) == 1, "rinex", "binary cache rejected after navigation file size changes, then rewritten");
+	ok = pony_test_nav_touch(cache_name) && pony_test_nav_load(gnss, pony_test_rinex_file, cache_name, epoch, eph1) == 0;
+	pony_test_check(ok && pony_test_nav_load(gnss, pony_test_rinex_file, cache_name, epoch, eph1) == 1, "rinex", "binary cache rejected after navigation file time changes, then rewritten");
+	ok = pony_test_write(cache_name, "PONYNAV") && pony_test_nav_load(gnss, pony_test_rinex_file, cache_name, epoch, eph1) == 0;
+	pony_test_check(ok, "rinex", "truncated binary cache rejected");
+	remove(cache_name);
+	remove(pony_test_rinex_file);
+
+	pony_bus_terminate(&bus);
+	pony_bus_step(&bus);
+}
+
+
+
+// journal record, replay and batch run, bus inputs reproduced bitwise
+#define pony_test_journal_file0 "pony_test_journal0.tmp"	// journals written to the current directory and removed afterwards
+#define pony_test_journal_file1 "pony_test_journal1.tmp"
+#define pony_test_journal_steps 60		// steps recorded to each journal
+#define pony_test_journal_values 160	// bus input values captured per step
+
+double pony_test_journal_seen[3][2*pony_test_journal_steps][pony_test_journal_values];	// bus inputs seen by plugin when recorded, replayed and batch run
+int pony_test_journal_run = 0;	// current run
+int pony_test_journal_step = 0;	// steps captured in the current run
+long pony_test_journal_sols = 0;	// solutions passed to batch output
+char pony_test_journal_order = 1;	// batch solutions passed in order, with file indices and times of the recorded steps
+
+	// append values to a capture
+void pony_test_journal_put(double *seen, int *k, const double *a, const int n)
+{
+	int i;
+
+	for (i = 0; i < n && *k < pony_test_journal_values; i++)
+		seen[(*k)++] = a[i];
+}
+
+void pony_test_journal_put_chars(double *seen, int *k, const char *a, const int n)
+{
+	int i;
+
+	for (i = 0; i < n && *k < pony_test_journal_values; i++)
+		seen[(*k)++] = a[i];
+}
+
+	// plugin capturing bus inputs at each step
+void pony_test_journal_capture(void)
+{
+	pony_gnss *gnss = pony->gnss;
+	pony_gnss_sat *sat;
+	double *seen, v;
+	int i, k = 0;
+
+	if (pony->mode < 0 || pony_test_journal_step >= 2*pony_test_journal_steps)
+		return;
+	seen = pony_test_journal_seen[pony_test_journal_run][pony_test_journal_step++];
+	for (i = 0; i < pony_test_journal_values; i++)
+		seen[i] = 0;
+
+	pony_test_journal_put      (seen, &k, &(pony->t), 1);
+	pony_test_journal_put      (seen, &k, &(pony->imu->t), 1);
+	pony_test_journal_put      (seen, &k, pony->imu->w, 3);
+	pony_test_journal_put_chars(seen, &k, &(pony->imu->w_valid), 1);
+	pony_test_journal_put      (seen, &k, pony->imu->f, 3);
+	pony_test_journal_put_chars(seen, &k, &(pony->imu->f_valid), 1);
+
+	v = gnss->epoch.Y;	pony_test_journal_put(seen, &k, &v, 1);
+	v = gnss->epoch.M;	pony_test_journal_put(seen, &k, &v, 1);
+	v = gnss->epoch.D;	pony_test_journal_put(seen, &k, &v, 1);
+	v = gnss->epoch.h;	pony_test_journal_put(seen, &k, &v, 1);
+	v = gnss->epoch.m;	pony_test_journal_put(seen, &k, &v, 1);
+	pony_test_journal_put(seen, &k, &(gnss->epoch.s), 1);
+	v = gnss->leap_sec;	pony_test_journal_put(seen, &k, &v, 1);
+	pony_test_journal_put_chars(seen, &k, &(gnss->leap_sec_valid), 1);
+
+	pony_test_journal_put      (seen, &k, gnss->gps->iono_a, 4);
+	pony_test_journal_put      (seen, &k, gnss->gps->iono_b, 4);
+	pony_test_journal_put_chars(seen, &k, &(gnss->gps->iono_valid), 1);
+	pony_test_journal_put      (seen, &k, gnss->gps->clock_corr, 4);
+	pony_test_journal_put_chars(seen, &k, gnss->gps->clock_corr_to, 2);
+	pony_test_journal_put_chars(seen, &k, &(gnss->gps->clock_corr_valid), 1);
+	pony_test_journal_put      (seen, &k, gnss->glo->clock_corr, 4);
+	pony_test_journal_put_chars(seen, &k, gnss->glo->clock_corr_to, 2);
+	pony_test_journal_put_chars(seen, &k, &(gnss->glo->clock_corr_valid), 1);
+
+	v = gnss->gps->obs_count;	pony_test_journal_put(seen, &k, &v, 1);
+	for (i = 0; i < gnss->gps->obs_count; i++)
+		pony_test_journal_put_chars(seen, &k, gnss->gps->obs_types[i], 3);
+	for (i = 0, sat = gnss->gps->sat; i < gnss->gps->max_sat_count; i++) {
+		pony_test_journal_put_chars(seen, &k, &(sat[i].eph_valid), 1);
+		pony_test_journal_put      (seen, &k, sat[i].eph, gnss->gps->max_eph_count);
+		if (sat[i].obs == NULL)
+			continue;
+		pony_test_journal_put_chars(seen, &k, sat[i].obs_valid, gnss->gps->obs_count);
+		pony_test_journal_put      (seen, &k, sat[i].obs, gnss->gps->obs_count);
+	}
+	for (i = 0, sat = gnss->glo->sat; i < gnss->glo->max_sat_count; i++) {
+		pony_test_journal_put_chars(seen, &k, &(sat[i].eph_valid), 1);
+		pony_test_journal_put      (seen, &k, sat[i].eph, gnss->glo->max_eph_count);
+	}
+}
+
+	// host writing bus inputs of a step: slowly and quickly changing values, negative zero, subnormal and NaN with payload, observation types changed in the middle of each journal
+void pony_test_journal_inputs(const int n, double *obs, char *obs_valid, char **types)
+{
+	pony_gnss *gnss = pony->gnss;
+	pony_gnss_sat *gps = gnss->gps->sat, *glo = gnss->glo->sat;
+	union {double d; unsigned long long u;} nan;
+	int i, j;
+
+	pony->t = 0.01*n;
+	pony->imu->t = pony->t;
+	for (i = 0; i < 3; i++) {
+		pony->imu->w[i] = 1e-3*sin(0.1*n + i);
+		pony->imu->f[i] = 9.81*cos(0.05*n + i);
+	}
+	pony->imu->w_valid = (char)(n%7 != 3);
+	pony->imu->f_valid = 1;
+	if (n == 5) {
+		pony->imu->w[0] = -0.0;
+		pony->imu->f[1] = 4.9e-324;
+	}
+
+	gnss->epoch.Y = 2020;
+	gnss->epoch.M = 6;
+	gnss->epoch.D = 9;
+	gnss->epoch.h = 2;
+	gnss->epoch.m = n/60;
+	gnss->epoch.s = n%60 + 0.25;
+	gnss->leap_sec = 18;
+	gnss->leap_sec_valid = (char)(n > 2);
+
+	for (i = 0; i < 4; i++) {
+		gnss->gps->iono_a[i] = 1e-8*(i + 1)*(1 + n/40);
+		gnss->gps->iono_b[i] = 1e5*(i + 1);
+		gnss->gps->clock_corr[i] = 1e-9*(i + 1)*(n/20);
+		gnss->glo->clock_corr[i] = (i == 0) ? -1e-8 : 0;
+	}
+	gnss->gps->iono_valid = (char)(n >= 10);
+	gnss->gps->clock_corr_to[0] = 'U';
+	gnss->gps->clock_corr_to[1] = 'T';
+	gnss->gps->clock_corr_valid = 1;
+	gnss->glo->clock_corr_to[0] = 'U';
+	gnss->glo->clock_corr_to[1] = 'T';
+	gnss->glo->clock_corr_valid = (char)(n%2);
+
+	if (n%pony_test_journal_steps < pony_test_journal_steps/2) {
+		gnss->gps->obs_types = types;
+		gnss->gps->obs_count = 2;
+	}
+	else {
+		gnss->gps->obs_types = types + 2;
+		gnss->gps->obs_count = 1;
+	}
+	for (i = 0; i < gnss->gps->max_sat_count; i++) {
+		gps[i].eph_valid = (char)(i != n%5);
+		for (j = 0; j < gnss->gps->max_eph_count; j++)
+			gps[i].eph[j] = 1e3*i + j + n/20;
+		gps[i].obs = obs + 2*i;
+		gps[i].obs_valid = obs_valid + 2*i;
+		for (j = 0; j < 2; j++) {
+			obs[2*i + j] = 2e7 + 1e3*i + 1e8*j + 0.1*n;
+			obs_valid[2*i + j] = (char)((i + j + n)%3 != 0);
+		}
+	}
+	if (n == 7) {
+		nan.u = 0x7ff8000000012345ULL;
+		obs[0] = nan.d;
+	}
+	for (i = 0; i < gnss->glo->max_sat_count; i++) {
+		glo[i].eph_valid = 1;
+		for (j = 0; j < gnss->glo->max_eph_count; j++)
+			glo[i].eph[j] = 1e4*(j + 1)*sin(0.01*n + i);
+	}
+}
+
+	// batch output checking solutions against recorded steps
+void pony_test_journal_output(const pony_batch_sol *sol, void *arg)
+{
+	union {double d; unsigned long long u;} a, b;
+	long *count = (long *)arg;
+
+	a.d = sol->t;
+	b.d = pony_test_journal_seen[0][(sol->step < 2*pony_test_journal_steps) ? sol->step : 0][0];
+	if (sol->step != (unsigned long)*count || sol->file != (int)(sol->step/pony_test_journal_steps) || a.u != b.u)
+		pony_test_journal_order = 0;
+	(*count)++;
+}
+
+	// captures of two runs equal bitwise for a number of steps
+char pony_test_journal_same(const int run0, const int run1, const int count)
+{
+	union {double d; unsigned long long u;} a, b;
+	int n, i;
+
+	for (n = 0; n < count; n++)
+		for (i = 0; i < pony_test_journal_values; i++) {
+			a.d = pony_test_journal_seen[run0][n][i];
+			b.d = pony_test_journal_seen[run1][n][i];
+			if (a.u != b.u)
+				return 0;
+		}
+	return 1;
+}
+
+	// bus with imu, GPS and GLONASS and the capturing plugin, output: OK/not OK (1/0)
+char pony_test_journal_bus(pony_struct *bus)
+{
+	char cfg[] = "{imu: dt = 0.01}, {gnss: {gps: max_sat_count = 4, max_eph_count = 8}, {glo: max_sat_count = 3, max_eph_count = 6}}";
+
+	pony_test_journal_step = 0;
+	pony_bus_setup(bus);
+	pony_bus_add_plugin(bus, pony_test_journal_capture);
+	if (!pony_bus_init(bus, cfg) || bus->imu == NULL || bus->gnss_count < 1 || bus->gnss[0].gps == NULL || bus->gnss[0].glo == NULL) {
+		pony_test_check(0, "journal", "bus with imu, GPS and GLONASS initialized");
+		pony_bus_terminate(bus);
+		pony_bus_step(bus);
+		return 0;
+	}
+	return 1;
+}
+
+void pony_test_journal(void)
+{
+	char type0[] = "C1C", type1[] = "L1C", type2[] = "C1W", *types[3];
+	const char *files[2] = {pony_test_journal_file0, pony_test_journal_file1};
+	double obs[8];
+	char obs_valid[8];
+
+	pony_struct bus, *prev;
+	pony_journal jrn;
+	pony_batch_stats stats;
+	int f, n, i;
+	char ok = 1;
+
+	types[0] = type0;
+	types[1] = type1;
+	types[2] = type2;
+
+	// recording to two journals, inputs written by host
+	pony_test_journal_run = 0;
+	if (!pony_test_journal_bus(&bus))
+		return;
+	prev = pony_bus_select(&bus);
+	for (f = 0; ok && f < 2; f++) {
+		ok = pony_journal_open(&jrn, files[f]);
+		for (n = f*pony_test_journal_steps; ok && n < (f + 1)*pony_test_journal_steps; n++) {
+			pony_test_journal_inputs(n, obs, obs_valid, types);
+			ok = pony_journal_record(&jrn) && pony_bus_step(&bus);
+		}
+		if (ok)
+			pony_journal_close(&jrn);
+	}
+	pony_test_check(ok && pony_test_journal_step == 2*pony_test_journal_steps, "journal", "bus inputs recorded to two journals");
+	for (i = 0; i < bus.gnss->gps->max_sat_count; i++)
+		bus.gnss->gps->sat[i].obs = NULL, bus.gnss->gps->sat[i].obs_valid = NULL;
+	bus.gnss->gps->obs_types = NULL;
+	bus.gnss->gps->obs_count = 0;
+	pony_bus_select(prev);
+	pony_bus_terminate(&bus);
+	pony_bus_step(&bus);
+	if (!ok) {
+		remove(pony_test_journal_file0);
+		remove(pony_test_journal_file1);
+		return;
+	}
+
+	// replay of both journals in sequence on a fresh bus, observables allocated and observation types set by replay
+	pony_test_journal_run = 1;
+	if (pony_test_journal_bus(&bus)) {
+		prev = pony_bus_select(&bus);
+		pony_test_check(pony_journal_replay(pony_test_journal_file0) == pony_test_journal_steps && pony_test_journal_step == pony_test_journal_steps
+			&& pony_test_journal_same(0, 1, pony_test_journal_steps), "journal", "replayed inputs equal to recorded bitwise");
+		pony_test_check(bus.gnss->gps->sat[0].obs == NULL && bus.gnss->gps->obs_types == NULL && bus.gnss->gps->obs_count == 0, "journal", "observables and types set by replay detached on close");
+		pony_test_check(pony_journal_replay(pony_test_journal_file1) == pony_test_journal_steps && pony_test_journal_step == 2*pony_test_journal_steps
+			&& pony_test_journal_same(0, 1, 2*pony_test_journal_steps), "journal", "second journal replayed on the same bus equal to recorded bitwise");
+		pony_bus_select(prev);
+		pony_bus_terminate(&bus);
+		pony_bus_step(&bus);
+	}
+
+	// batch run of both journals on a fresh bus, with two readers decoding a few steps ahead and solutions drained by the writer if built with PONY_THREADS
+	pony_test_journal_run = 2;
+	pony_test_journal_sols = 0;
+	pony_test_journal_order = 1;
+	if (pony_test_journal_bus(&bus)) {
+		prev = pony_bus_select(&bus);
+		pony_test_check(pony_batch_run(files, 2, 2, 4, pony_test_journal_output, &pony_test_journal_sols, &stats) == 2*pony_test_journal_steps
+			&& stats.steps == 2*pony_test_journal_steps && stats.files == 2, "journal", "batch run through both journals");
+		pony_test_check(pony_test_journal_step == 2*pony_test_journal_steps && pony_test_journal_same(0, 2, 2*pony_test_journal_steps), "journal", "batch run inputs equal to recorded bitwise");
+		pony_test_check(pony_test_journal_sols == 2*pony_test_journal_steps && pony_test_journal_order, "journal", "batch solutions output in order with journal indices and recorded times");
+		pony_bus_select(prev);
+		pony_bus_terminate(&bus);
+		pony_bus_step(&bus);
+	}
+
+	remove(pony_test_journal_file0);
+	remove(pony_test_journal_file1);
+}
+
+
+
+// imu sample ring: wraparound, overruns, and a driver thread pushing while the bus thread drains if built with PONY_THREADS
+#define pony_test_ring_pushes 200000	// samples pushed by the driver thread
+
+	// sample with all values derived from its number, to detect torn or reordered samples
+void pony_test_ring_sample(pony_imu_sample *s, const long n)
+{
+	int i;
+
+	s->t = (double)n;
+	for (i = 0; i < 3; i++) {
+		s->w[i] = n + 0.25*i;
+		s->f[i] = -n - 0.5*i;
+	}
+	s->w_valid = 1;
+	s->f_valid = 1;
+}
+
+	// sample intact and of a given number
+char pony_test_ring_is(const pony_imu_sample *s, const long n)
+{
+	int i;
+
+	if (s->t != (double)n || !s->w_valid || !s->f_valid)
+		return 0;
+	for (i = 0; i < 3; i++)
+		if (s->w[i] != n + 0.25*i || s->f[i] != -n - 0.5*i)
+			return 0;
+	return 1;
+}
+
+	// push samples from a number on, output: number of samples pushed
+int pony_test_ring_push(pony_imu_ring *ring, const long from, const int count)
+{
+	pony_imu_sample s;
+	int i, pushed = 0;
+
+	for (i = 0; i < count; i++) {
+		pony_test_ring_sample(&s, from + i);
+		pushed += pony_imu_ring_push(ring, &s);
+	}
+	return pushed;
+}
+
+#ifdef PONY_THREADS
+pthread_mutex_t pony_test_ring_lock = PTHREAD_MUTEX_INITIALIZER;
+char pony_test_ring_done = 0;	// driver thread finished pushing
+
+	// driver thread pushing samples as fast as it can
+void *pony_test_ring_driver(void *arg)
+{
+	pony_test_ring_push((pony_imu_ring *)arg, 0, pony_test_ring_pushes);
+	pthread_mutex_lock(&pony_test_ring_lock);
+	pony_test_ring_done = 1;
+	pthread_mutex_unlock(&pony_test_ring_lock);
+	return NULL;
+}
+#endif
+
+void pony_test_ring(void)
+{
+	char cfg[] = "{imu: ring_size = 5}";
+
+	pony_struct bus;
+	pony_imu_ring *ring;
+	pony_imu_sample out[8], *p;
+	int i, k;
+	char ok;
+
+	pony_bus_setup(&bus);
+	if (!pony_bus_init(&bus, cfg) || bus.imu == NULL || bus.imu->ring == NULL) {
+		pony_test_check(0, "ring", "imu with sample ring initialized");
+		pony_bus_terminate(&bus);
+		pony_bus_step(&bus);
+		return;
+	}
+	ring = bus.imu->ring;
+	pony_test_check(ring->mask == 7, "ring", "ring size rounded up to a power of two");
+
+	// wraparound: samples 6-7 at the ring end, 8-10 continuing from the ring start
+	ok = (pony_test_ring_push(ring, 0, 6) == 6 && pony_imu_ring_drain(ring, out, 8) == 6 && pony_test_ring_is(out + 5, 5));
+	ok = ok && pony_test_ring_push(ring, 6, 5) == 5;
+	k = pony_imu_ring_peek(ring, &p);
+	ok = ok && k == 2 && p == ring->sample + 6 && pony_test_ring_is(p, 6) && pony_test_ring_is(p + 1, 7);
+	pony_imu_ring_consume(ring, k);
+	k = pony_imu_ring_peek(ring, &p);
+	ok = ok && k == 3 && p == ring->sample && pony_test_ring_is(p, 8) && pony_test_ring_is(p + 2, 10);
+	pony_imu_ring_consume(ring, k);
+	pony_test_check(ok && ring->overruns == 0, "ring", "peek split at the ring end, continued from the ring start");
+	pony_test_check(pony_imu_ring_peek(ring, &p) == 0 && pony_imu_ring_drain(ring, out, 8) == 0, "ring", "ring empty after all samples consumed");
+
+	// pushing into a full ring: samples dropped and counted, the oldest ones kept
+	pony_test_check(pony_test_ring_push(ring, 11, 10) == 8 && ring->overruns == 2, "ring", "samples pushed into a full ring dropped and counted as overruns");
+	k = pony_imu_ring_drain(ring, out, 8);
+	for (i = 0, ok = (k == 8); ok && i < k; i++)
+		ok = pony_test_ring_is(out + i, 11 + i);
+	pony_test_check(ok && pony_imu_ring_drain(ring, out, 8) == 0, "ring", "oldest samples drained in order across the ring end");
+
+	// counters wrapping around zero
+	ring->head = ring->tail = ring->head_cache = ring->tail_cache = (unsigned long)0 - 3;
+	ring->overruns = 0;
+	ok = (pony_test_ring_push(ring, 100, 9) == 8 && ring->overruns == 1 && ring->head == 5);
+	k = pony_imu_ring_drain(ring, out, 8);
+	for (i = 0, ok = ok && (k == 8); ok && i < k; i++)
+		ok = pony_test_ring_is(out + i, 100 + i);
+	pony_test_check(ok && pony_imu_ring_drain(ring, out, 8) == 0, "ring", "full ring and overruns detected with counters wrapping around zero");
+
+#ifdef PONY_THREADS
+	// driver thread: every sample either drained intact and in order, or counted as overrun
+	{
+		pthread_t driver;
+		long drained = 0, last = -1;
+		char started, done;
+
+		ring->head = ring->tail = ring->head_cache = ring->tail_cache = 0;
+		ring->overruns = 0;
+		started = (pthread_create(&driver, NULL, pony_test_ring_driver, ring) == 0);
+		pony_test_check(started, "ring", "driver thread started");
+		for (ok = 1; started; ) {
+			pthread_mutex_lock(&pony_test_ring_lock);
+			done = pony_test_ring_done;
+			pthread_mutex_unlock(&pony_test_ring_lock);
+			k = pony_imu_ring_drain(ring, out, 8);
+			for (i = 0; i < k; i++) {
+				if ((long)out[i].t <= last || !pony_test_ring_is(out + i, (long)out[i].t))
+					ok = 0;
+				last = (long)out[i].t;
+				drained++;
+			}
+			if (k == 0 && done) {
+				pthread_join(driver, NULL);
+				break;
+			}
+		}
+		pony_test_check(started && ok && drained + (long)ring->overruns == pony_test_ring_pushes && drained > 0, "ring", "samples from driver thread drained intact and in order, the rest counted as overruns");
+	}
+#endif
+
+	pony_bus_terminate(&bus);
+	pony_bus_step(&bus);
+}
+
+
+
+// imu pre-integration on pure coning motion against the analytic attitude
+	// unit quaternion for a rotation vector
+void pony_test_rotvec2quat(double *q, const double *r)
+{
+	double n = sqrt(r[0]*r[0] + r[1]*r[1] + r[2]*r[2]), s;
+	int i;
+
+	s = (n > 0) ? sin(n/2)/n : 0.5;
+	q[0] = cos(n/2);
+	for (i = 0; i < 3; i++)
+		q[i + 1] = s*r[i];
+}
+
+	// rotation vector of a unit quaternion
+void pony_test_quat2rotvec(double *r, const double *q)
+{
+	double n = sqrt(q[1]*q[1] + q[2]*q[2] + q[3]*q[3]), k;
+	int i;
+
+	k = (n > 0) ? 2*atan2(n, q[0])/n : 2;
+	for (i = 0; i < 3; i++)
+		r[i] = k*q[i + 1];
+}
+
+	// body attitude in coning motion with half-angle a at rate W: body z axis sweeping a cone about the reference z axis
+void pony_test_cone(double *q, const double a, const double W, const double t)
+{
+	q[0] = cos(a/2);
+	q[1] = sin(a/2)*cos(W*t);
+	q[2] = sin(a/2)*sin(W*t);
+	q[3] = 0;
+}
+
+	// rotation from one attitude to another as a rotation vector in the body frame of the first one
+void pony_test_rotation(double *r, double *q0, double *q1)
+{
+	double c[4], d[4];
+
+	c[0] = q0[0];
+	c[1] = -q0[1];
+	c[2] = -q0[2];
+	c[3] = -q0[3];
+	pony_linal_qmul(d, c, q1);
+	pony_test_quat2rotvec(r, d);
+}
+
+void pony_test_preint(void)
+{
+	const double
+		a = 0.1,			// cone half-angle, rad
+		W = 4*3.14159265358979323846,	// cone rate, rad/s
+		h = 0.001,			// sample step, s
+		interval = 0.02,	// pre-integration interval, s
+		T = 10;				// run time, s
+
+	pony_imu_preint pre;
+	pony_imu_sample s;
+	double qp[4], qa[4], q0[4], q1[4], r[4], tmp[4], phi[3], alpha[3], e[3], drift, z_err = 0, z_corr = 1e300;
+	long k, K = (long)(T/h + 0.5);
+	int i, n = 0;
+	char counts = 1;
+
+	pre.interval = interval;
+	pony_imu_preint_reset(&pre);
+	pony_test_cone(qp, a, W, 0);
+	pony_test_cone(qa, a, W, 0);
+	for (k = 0; k <= K; k++) {
+		// body rate: w = 2 q^-1 x dq/dt, no specific force
+		s.t = k*h;
+		s.w[0] = -W*sin(a)*sin(W*s.t);
+		s.w[1] =  W*sin(a)*cos(W*s.t);
+		s.w[2] = -W*(1 - cos(a));
+		for (i = 0; i < 3; i++)
+			s.f[i] = 0;
+		s.w_valid = 1;
+		s.f_valid = 1;
+		if (!pony_imu_preint_add(&pre, &s))
+			continue;
+		n++;
+		counts = counts && pre.count == (int)(interval/h + 0.5);
+
+		// true rotation over the interval, and the angle increment without coning compensation integrated exactly
+		pony_test_cone(q0, a, W, pre.t0);
+		pony_test_cone(q1, a, W, pre.t);
+		pony_test_rotation(phi, q0, q1);
+		alpha[0] = sin(a)*(cos(W*pre.t) - cos(W*pre.t0));
+		alpha[1] = sin(a)*(sin(W*pre.t) - sin(W*pre.t0));
+		alpha[2] = -W*(1 - cos(a))*(pre.t - pre.t0);
+		if (fabs(pre.dtheta[2] - phi[2]) > z_err)
+			z_err = fabs(pre.dtheta[2] - phi[2]);
+		if (fabs(phi[2] - alpha[2]) < z_corr)
+			z_corr = fabs(phi[2] - alpha[2]);
+
+		// attitudes by pre-integrated and uncompensated increments
+		pony_test_rotvec2quat(r, pre.dtheta);
+		pony_linal_qmul(tmp, qp, r);
+		for (i = 0; i < 4; i++)
+			qp[i] = tmp[i];
+		pony_test_rotvec2quat(r, alpha);
+		pony_linal_qmul(tmp, qa, r);
+		for (i = 0; i < 4; i++)
+			qa[i] = tmp[i];
+	}
+	pony_test_check(n == (int)(T/interval + 0.5) && counts, "preint", "intervals completed with the configured number of samples");
+	pony_test_check(z_err < 1e-3*z_corr, "preint", "coning compensated delta-angle matching the true rotation about the cone axis in each interval");
+
+	// classical coning drift of uncompensated increments: W sin(a)^2/2 (1 - sin(W interval)/(W interval)) rad/s about the cone axis
+	drift = W*sin(a)*sin(a)/2*(1 - sin(W*interval)/(W*interval))*T;
+	pony_test_cone(q1, a, W, K*h);
+	pony_test_rotation(e, q1, qa);
+	pony_test_check(fabs(fabs(e[2]) - drift) < 0.02*drift, "preint", "uncompensated increments drifting about the cone axis as predicted analytically");
+	pony_test_rotation(e, q1, qp);
+	pony_test_check(sqrt(e[0]*e[0] + e[1]*e[1] + e[2]*e[2]) < 0.01*drift, "preint", "pre-integrated attitude error below a hundredth of the coning drift");
+}
+
+
+
+// strapdown navigation at rest, velocity, position and attitude errors growing from rounding only
+	// stationary run from a given position and attitude, imu measuring Earth rotation and normal gravity
+	// output:
+	//		err - maximum velocity, m/s, position and attitude errors at the end, m and rad
+void pony_test_strapdown_run(double *err, pony_imu *imu, const pony_imu_const *imu_const, const double h, const double T)
+{
+	const double lon = 0.656, lat = 0.973, height = 150;
+
+	pony_imu_strapdown sd;
+	pony_sol *sol = &(imu->sol);
+	double q[4], u[3], f[3], w_b[3], f_b[3], Q0[4], e[3], s, g, v;
+	long k, K = (long)(T/h + 0.5);
+	int i;
+
+	err[0] = err[1] = err[2] = 1e300;
+	imu->t = 0;
+	sol->llh[0] = lon;
+	sol->llh[1] = lat;
+	sol->llh[2] = height;
+	sol->rpy[0] = 0.01;
+	sol->rpy[1] = -0.02;
+	sol->rpy[2] = 1;
+	for (i = 0; i < 3; i++)
+		sol->v[i] = 0;
+	sol->llh_valid = sol->v_valid = sol->rpy_valid = 1;
+	sol->q_valid = 0;
+	if (!pony_imu_strapdown_init(&sd, imu, imu_const))
+		return;
+
+	// Earth rotation and normal gravity in local-level frame, rotated to the body frame
+	s = sin(lat);
+	g = imu_const->ge*(1 + imu_const->fg*s*s)*(1 - 2*height/imu_const->a + 3*height*height/(imu_const->a*imu_const->a));
+	u[0] = 0;
+	u[1] = imu_const->u*cos(lat);
+	u[2] = imu_const->u*s;
+	f[0] = 0;
+	f[1] = 0;
+	f[2] = g;
+	q[0] = sd.Q[0];
+	for (i = 1; i < 4; i++)
+		q[i] = -sd.Q[i];
+	pony_linal_qrot(w_b, q, u);
+	pony_linal_qrot(f_b, q, f);
+	for (i = 0; i < 4; i++)
+		Q0[i] = sd.Q[i];
+
+	err[0] = 0;
+	for (k = 0; k <= K; k++) {
+		imu->t = k*h;
+		for (i = 0; i < 3; i++) {
+			imu->w[i] = w_b[i];
+			imu->f[i] = f_b[i];
+		}
+		imu->w_valid = 1;
+		imu->f_valid = 1;
+		if (imu->preint != NULL)
+			pony_imu_preint_step(imu);
+		pony_imu_strapdown_step(&sd, imu, imu_const);
+		v = sqrt(sol->v[0]*sol->v[0] + sol->v[1]*sol->v[1] + sol->v[2]*sol->v[2]);
+		if (v > err[0])
+			err[0] = v;
+	}
+	e[0] = (sol->llh[0] - lon)*sd.Re*cos(lat);
+	e[1] = (sol->llh[1] - lat)*sd.Rn;
+	e[2] = sol->llh[2] - height;
+	err[1] = sqrt(e[0]*e[0] + e[1]*e[1] + e[2]*e[2]);
+	pony_test_rotation(e, Q0, sd.Q);
+	err[2] = sqrt(e[0]*e[0] + e[1]*e[1] + e[2]*e[2]);
+}
+
+void pony_test_strapdown(void)
+{
+	char cfg0[] = "{imu: }", cfg1[] = "{imu: preint_interval = 0.01}";
+
+	pony_struct bus;
+	double err[3];
+
+	// imu rates at 100 Hz
+	pony_bus_setup(&bus);
+	if (pony_bus_init(&bus, cfg0) && bus.imu != NULL) {
+		pony_test_strapdown_run(err, bus.imu, &(bus.imu_const), 0.01, 600);
+		pony_test_check(err[0] < 1e-6 && err[1] < 1e-4 && err[2] < 1e-9, "strapdown", "staying at rest for 10 minutes updated by imu rates");
+	}
+	else
+		pony_test_check(0, "strapdown", "imu initialized");
+	pony_bus_terminate(&bus);
+	pony_bus_step(&bus);
+
+	// 1 kHz samples pre-integrated over 0.01 s
+	pony_bus_setup(&bus);
+	if (pony_bus_init(&bus, cfg1) && bus.imu != NULL && bus.imu->preint != NULL) {
+		pony_test_strapdown_run(err, bus.imu, &(bus.imu_const), 0.001, 600);
+		pony_test_check(err[0] < 1e-6 && err[1] < 1e-4 && err[2] < 1e-9, "strapdown", "staying at rest for 10 minutes updated by pre-integrated increments");
+	}
+	else
+		pony_test_check(0, "strapdown", "imu with pre-integration initialized");
+	pony_bus_terminate(&bus);
+	pony_bus_step(&bus);
+}
+
+
+
+// time scales: week origins, GLONASS day numbers, calendar round trip, continuous time refreshed on clock corrections set by journal replay
+#define pony_test_time_file "pony_test_time.tmp"	// journal written to the current directory and removed afterwards
+
+double pony_test_time_utc[2];	// UTC offsets from GPS time seen by plugin in regular steps
+int pony_test_time_steps = 0;	// regular steps seen
+
+	// set gnss epoch in a time scale
+void pony_test_time_set(pony_gnss *gnss, const int scale, const int Y, const int M, const int D, const int h, const int m, const double s)
+{
+	gnss->epoch.Y = Y;
+	gnss->epoch.M = M;
+	gnss->epoch.D = D;
+	gnss->epoch.h = h;
+	gnss->epoch.m = m;
+	gnss->epoch.s = s;
+	gnss->time.scale = scale;
+}
+
+	// seconds of week and week number in a time scale equal to given ones
+char pony_test_time_sow(pony_gnss *gnss, const int scale, const double sow, const int week)
+{
+	double s;
+	int w;
+
+	return pony_time_sow(gnss, scale, &s, &w) && fabs(s - sow) < 1e-6 && w == week;
+}
+
+	// GLONASS day numbers and Moscow time of day equal to given ones
+char pony_test_time_glo(pony_gnss *gnss, const int N4, const int NT, const double tod)
+{
+	double t;
+	int n4, nt;
+
+	return pony_time_glo_day(gnss, &n4, &nt, &t) && n4 == N4 && nt == NT && fabs(t - tod) < 1e-6;
+}
+
+	// calendar epoch in a time scale equal to a given one
+char pony_test_time_calendar(pony_gnss *gnss, const int scale, const int Y, const int M, const int D, const int h, const int m, const double s)
+{
+	pony_time_epoch e;
+
+	return pony_time_calendar(&e, gnss, scale) && e.Y == Y && e.M == M && e.D == D && e.h == h && e.m == m && fabs(e.s - s) < 1e-6;
+}
+
+	// plugin recording UTC offset from GPS time
+void pony_test_time_offset(void)
+{
+	double t = 0;
+
+	if (pony->mode <= 0 || pony_test_time_steps >= 2)
+		return;
+	pony_test_time_utc[pony_test_time_steps++] = pony_time_convert(pony->gnss, &t, pony_time_gps, pony_time_utc) ? t : 1;
+}
+
+void pony_test_time(void)
+{
+	const int dates[][3] = {{1970, 1, 1}, {1980, 1, 6}, {1999, 8, 22}, {2000, 2, 29}, {2006, 1, 1}, {2016, 12, 31}, {2024, 2, 29}, {2100, 3, 1}},
+		date_count = sizeof(dates)/sizeof(dates[0]);
+	char cfg[] = "{gnss: {gps: max_sat_count = 4}}";
+
+	pony_struct bus, *prev;
+	pony_gnss *gnss;
+	pony_journal jrn;
+	int i, scale;
+	char ok;
+
+	pony_bus_setup(&bus);
+	if (!pony_bus_init(&bus, cfg) || bus.gnss_count < 1 || bus.gnss[0].gps == NULL) {
+		pony_test_check(0, "time", "bus with GPS constellation initialized");
+		pony_bus_terminate(&bus);
+		pony_bus_step(&bus);
+		return;
+	}
+	prev = pony_bus_select(&bus);
+	gnss = bus.gnss;
+	gnss->leap_sec = 18;
+	gnss->leap_sec_valid = 1;
+
+	// week origins: Galileo 1999/08/22, i.e. GPS week 1024, BeiDou 2006/01/01, i.e. GPS week 1356, 14 s behind GPS time
+	pony_test_time_set(gnss, pony_time_gps, 2020, 6, 9, 2, 0, 0);
+	pony_test_check(pony_test_time_sow(gnss, pony_time_gps, 180000, 2109), "time", "GPS week and seconds of week");
+	pony_test_check(pony_test_time_sow(gnss, pony_time_gal, 180000, 2109 - 1024), "time", "Galileo week counted from GPS week 1024");
+	pony_test_check(pony_test_time_sow(gnss, pony_time_bds, 180000 - 14, 2109 - 1356), "time", "BeiDou week counted from GPS week 1356, seconds of week 14 s behind");
+	pony_test_time_set(gnss, pony_time_gps, 2020, 6, 7, 0, 0, 5);
+	pony_test_check(pony_test_time_sow(gnss, pony_time_gps, 5, 2109) && pony_test_time_sow(gnss, pony_time_bds, 604800 - 9, 2108 - 1356), "time", "BeiDou time in the previous week 5 s after GPS week start");
+	pony_test_time_set(gnss, pony_time_bds, 2020, 6, 9, 1, 59, 46);
+	pony_test_check(pony_test_time_sow(gnss, pony_time_gps, 180000, 2109), "time", "GPS week and seconds of week for BeiDou epoch");
+
+	// GLONASS day numbers: four-year intervals from 1996, Moscow time 3 hours ahead of UTC
+	pony_test_time_set(gnss, pony_time_gps, 2020, 6, 9, 2, 0, 0);
+	pony_test_check(pony_test_time_glo(gnss, 7, 161, 4*3600 + 59*60 + 42), "time", "GLONASS N4 and NT within a leap year");
+	pony_test_time_set(gnss, pony_time_gps, 2019, 12, 31, 20, 0, 0);
+	pony_test_check(pony_test_time_glo(gnss, 6, 1461, 22*3600 + 59*60 + 42), "time", "GLONASS NT on the last day of a four-year interval");
+	pony_test_time_set(gnss, pony_time_gps, 2019, 12, 31, 22, 0, 0);
+	pony_test_check(pony_test_time_glo(gnss, 7, 1, 59*60 + 42), "time", "GLONASS N4 and NT starting over in Moscow time before UTC midnight");
+	pony_test_time_set(gnss, pony_time_glo, 2020, 6, 9, 21, 30, 0);
+	pony_test_check(pony_test_time_glo(gnss, 7, 162, 30*60), "time", "GLONASS day numbers for GLONASS epoch");
+
+	// calendar round trip in each time scale, and across scales over a leap year end
+	for (scale = 0, ok = 1; scale < pony_time_scales; scale++)
+		for (i = 0; i < date_count; i++) {
+			pony_test_time_set(gnss, scale, dates[i][0], dates[i][1], dates[i][2], 23, 59, 59.5);
+			ok = ok && pony_test_time_calendar(gnss, scale, dates[i][0], dates[i][1], dates[i][2], 23, 59, 59.5);
+			pony_test_time_set(gnss, scale, dates[i][0], dates[i][1], dates[i][2], 0, 0, 0);
+			ok = ok && pony_test_time_calendar(gnss, scale, dates[i][0], dates[i][1], dates[i][2], 0, 0, 0);
+		}
+	pony_test_check(ok, "time", "calendar epochs reproduced in each time scale from 1970 to 2100");
+	pony_test_time_set(gnss, pony_time_gps, 2017, 1, 1, 0, 0, 10);
+	pony_test_check(pony_test_time_calendar(gnss, pony_time_utc, 2016, 12, 31, 23, 59, 52) && pony_test_time_calendar(gnss, pony_time_bds, 2016, 12, 31, 23, 59, 56),
+		"time", "UTC and BeiDou calendar epochs before GPS new year");
+
+	// clock corrections changing with the epoch and leap seconds unchanged: recorded, then replayed with continuous time refreshed
+	ok = pony_journal_open(&jrn, pony_test_time_file);
+	for (i = 0; ok && i < 3; i++) {
+		gnss->gps->clock_corr[0] = 1e-7*i;
+		gnss->gps->clock_corr[1] = 0;
+		gnss->gps->clock_corr_to[0] = 'U';
+		gnss->gps->clock_corr_to[1] = 'T';
+		gnss->gps->clock_corr_valid = 1;
+		ok = pony_journal_record(&jrn) && pony_bus_step(&bus);
+	}
+	if (ok)
+		pony_journal_close(&jrn);
+	pony_bus_select(prev);
+	pony_bus_terminate(&bus);
+	pony_bus_step(&bus);
+	pony_test_check(ok, "time", "clock corrections recorded");
+
+	pony_test_time_steps = 0;
+	pony_bus_setup(&bus);
+	pony_bus_add_plugin(&bus, pony_test_time_offset);
+	if (ok && pony_bus_init(&bus, cfg)) {
+		prev = pony_bus_select(&bus);
+		pony_test_check(pony_journal_replay(pony_test_time_file) == 3 && pony_test_time_steps == 2
+			&& fabs(pony_test_time_utc[0] + 18 + 1e-7) < 1e-12 && fabs(pony_test_time_utc[1] + 18 + 2e-7) < 1e-12, "time", "UTC offset refreshed for clock corrections changed by journal replay");
+		pony_bus_select(prev);
+	}
+	pony_bus_terminate(&bus);
+	pony_bus_step(&bus);
+	remove(pony_test_time_file);
+}
+
+
+
+// vector kernels of geodetic routines against the scalar ones
+#define pony_test_geo_max_n		130		// batches of n = 1..130 points
+#define pony_test_geo_tol_xyz	1e-7	// cartesian coordinates, meters
+#define pony_test_geo_tol_llh	1e-14	// longitude and latitude, rad, heights as cartesian coordinates
+#define pony_test_geo_tol_g		1e-11	// normal gravity, m/s^2
+
+	// run the batched routines, out of place and in place, for 3n coordinates of n points in llh, results lined up in res
+	//	input:
+	//		llh - geodetic coordinates of n points, t - 3n x 1 copy array
+	//	output:
+	//		res - cartesian coordinates, geodetic coordinates back from them and normal gravity, twice, 14n
+void pony_test_geo_run(double *res, double *llh, double *t, const pony_imu_const *imu_const, const int n)
+{
+	pony_geo_llh2xyz_soa(res, llh, imu_const, n);
+	pony_geo_xyz2llh_soa(res+3*n, res, imu_const, n);
+	pony_geo_gravity_soa(res+6*n, llh, imu_const, n);
+	pony_test_copy(res+7*n, llh, 3*n);
+	pony_geo_llh2xyz_soa(res+7*n, res+7*n, imu_const, n);
+	pony_test_copy(res+10*n, res+7*n, 3*n);
+	pony_geo_xyz2llh_soa(res+10*n, res+10*n, imu_const, n);
+	pony_test_copy(t, llh, 3*n);
+	pony_geo_gravity_soa(t, t, imu_const, n);	// in place, overwriting longitudes
+	pony_test_copy(res+13*n, t, n);
+}
+
+void pony_test_geo(void)
+{
+	pony_struct bus;
+	double llh[3*pony_test_geo_max_n], t[3*pony_test_geo_max_n], ref[14*pony_test_geo_max_n], res[14*pony_test_geo_max_n], tol;
+	int level, n, i, j, fail;
+	char what[128];
+
+	pony_bus_setup(&bus);
+	pony_bus_init(&bus, "");
+	pony_test_check(pony_geo_simd(0) == 0, "geo", "scalar loops selected at level 0");
+	srand(2);
+	for (n = 1; n <= pony_test_geo_max_n; n++) {
+		pony_test_random(llh, n, -bus.imu_const.pi, bus.imu_const.pi);
+		pony_test_random(llh+n, n, -bus.imu_const.pi/2, bus.imu_const.pi/2);
+		pony_test_random(llh+2*n, n, -1e3, 3e7);
+		pony_geo_simd(0);
+		pony_test_geo_run(ref, llh, t, &(bus.imu_const), n);
+		for (level = 1; level <= 3; level++) {
+			if (pony_geo_simd(level) != level)
+				continue;
+			pony_test_geo_run(res, llh, t, &(bus.imu_const), n);
+			for (i = 0, fail = 0; i < 14*n; i++) {
+				j = i/n;
+				tol = (j == 6 || j == 13) ? pony_test_geo_tol_g : ((j == 3 || j == 4 || j == 10 || j == 11) ? pony_test_geo_tol_llh : pony_test_geo_tol_xyz);
+				if ( !(fabs(res[i] - ref[i]) <= tol) )
+					fail = 1;
+			}
+			sprintf(what, "routines at level %d match scalar ones for n = %d", level, n);
+			pony_test_check(!fail, "geo", what);
+		}
+	}
+
+	pony_geo_simd(-1);
+	pony_bus_terminate(&bus);
+	pony_bus_step(&bus);
+}
+
+
+
+// configuration tokens, looked up in the configuration tree and by scanning a string outside of the bus configuration
+	// value of a token followed by '=', -1 if not found
+int pony_test_token_value(const char *token, char *src, const int len)
+{
+	char *ptr = pony_locate_token(token, src, len, '=');
+
+	return (ptr == NULL) ? -1 : atoi(ptr);
+}
+
+void pony_test_cfg(void)
+{
+	char cfg[] = "dtx = 2, dt = 1, key=3, {imu: dtxy = 4}";
+	char scan[] = "dtx = 2, dt = 1, key=3, {imu: dtxy = 4}";	// the same outside of the bus configuration
+	char *src[2];
+	const char *path[2] = {"tree", "scan"};
+	pony_struct bus, *prev;
+	int p;
+
+	pony_bus_setup(&bus);
+	pony_bus_init(&bus, cfg);
+	prev = pony_bus_select(&bus);
+	src[0] = bus.cfg;
+	src[1] = scan;
+	for (p = 0; p < 2; p++) {
+		pony_test_check(pony_test_token_value("dt",  src[p], bus.cfglength) == 1, path[p], "token is not matched as a prefix of a longer one");
+		pony_test_check(pony_test_token_value("dtx", src[p], bus.cfglength) == 2, path[p], "token longer than another one");
+		pony_test_check(pony_test_token_value("key", src[p], bus.cfglength) == 3, path[p], "key=value with no blanks before the delimiter");
+		pony_test_check(pony_test_token_value("dtxy", src[p], bus.cfglength) == -1, path[p], "token within a group is skipped");
+		pony_test_check(pony_test_token_value("x", src[p], bus.cfglength) == -1, path[p], "token is not matched as a suffix of a longer one");
+	}
+	pony_bus_select(prev);
+	pony_bus_terminate(&bus);
+	pony_bus_step(&bus);
+}
+
+
+
+
+int main(void)
+{
+	pony_test_schedule();
+	pony_test_cfg();
+	pony_test_linal();
+	pony_test_kalman_batch();
+	pony_test_geo();
+	pony_test_kepler();
+	pony_test_glo();
+	pony_test_cheb();
+	pony_test_rinex_obs();
+	pony_test_rinex_nav();
+	pony_test_journal();
+	pony_test_ring();
+	pony_test_preint();
+	pony_test_strapdown();
+	pony_test_time();
+
+	printf("%d of %d checks passed\n", pony_test_checks - pony_test_failed, pony_test_checks);
+	return (pony_test_failed > 0) ? 1 : 0;
+}